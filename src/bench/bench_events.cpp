@@ -0,0 +1,302 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file bench_events.cpp
+ *
+ *  Standalone benchmark of codecs of events sent through network. It is not
+ *  a part of the game, it is compiled with doevents.cpp of the game, build
+ *  and run it by:
+ *
+ *  @code
+ *  g++ -O2 -DUNIX=1 -DDEBUG=0 -I.. -I../../libs/glfw-legacy/include/GL -o bench_events bench_events.cpp ../doevents.cpp && ./bench_events
+ *  @endcode
+ *
+ *  Events are packed into messages in the same way as batches of events are
+ *  packed by SendBatchEvent(). Both codecs are checked, that they give the
+ *  same events back, before they are measured.
+ *
+ *  @date 2026
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "doevents.h"
+#include "dologs.h"
+#include "donet.h"
+#include "doplayers.h"
+#include "dounits.h"
+
+
+//=========================================================================
+// Definitions
+//=========================================================================
+
+#define BENCH_EVENTS        (1 << 16) //!< Count of events.
+#define BENCH_ROUNDS        50        //!< Count of rounds of encoding and decoding.
+#define BENCH_RAW_SIZE      128       //!< Size of buffer for one event.
+
+
+/**
+ *  Generator of pseudorandom numbers, same on all platforms.
+ */
+static unsigned int random_state = 1;
+
+static unsigned int Random(void)
+{
+  random_state = random_state * 1103515245u + 12345u;
+  return random_state >> 8;
+}
+
+
+//=========================================================================
+// Stubs of the game
+//=========================================================================
+
+// doevents.cpp needs only these parts of the game, they do nothing here
+
+GLFWmutex log_mutex = NULL;
+void (*log_callback)(int, const char *, const char *) = NULL;
+
+char *LogMsg(const char *msg, ...)
+{
+  static char text[1024];
+  va_list arg;
+
+  va_start(arg, msg);
+  vsnprintf(text, sizeof(text), msg, arg);
+  va_end(arg);
+
+  return text;
+}
+
+void LogWrite(int level, const char *header, const char *file, int line, const char *msg)
+{
+  fprintf(stderr, "%s%s\n", header, msg);
+}
+
+GLFWmutex glfwCreateMutex(void) { return (GLFWmutex)&log_mutex; }
+void glfwDestroyMutex(GLFWmutex mutex) {}
+void glfwLockMutex(GLFWmutex mutex) {}
+void glfwUnlockMutex(GLFWmutex mutex) {}
+double glfwGetTime(void) { return double(clock()) / CLOCKS_PER_SEC; }
+
+TPLAYER_ARRAY::TPLAYER_ARRAY() { count = PL_MAX_PLAYERS; lock = NULL; }
+TPLAYER_ARRAY::~TPLAYER_ARRAY() {}
+
+TPLAYER_ARRAY player_array;
+TPLAYER **players = NULL;
+
+
+//=========================================================================
+// Benchmark
+//=========================================================================
+
+static TEVENT events[BENCH_EVENTS];
+static TEVENT decoded[BENCH_EVENTS];
+
+static int message_first[BENCH_EVENTS + 1];   //!< Index of the first event of each message.
+static double message_base[BENCH_EVENTS];     //!< Base time of each message.
+static int message_count;
+
+static char data[BENCH_EVENTS * BENCH_RAW_SIZE];
+static int data_size;
+
+
+/**
+ *  Fills events like the ones sent by units during the game. Time stamps
+ *  grow in small steps, positions are small numbers and the most of other
+ *  fields are zero.
+ */
+static void GenerateEvents(void)
+{
+  static const int states[] = {US_MOVE, US_NEXT_STEP, US_STAY, US_ATTACKING, US_MINING, US_LEFT_ROTATING};
+  double time = 120.0;
+
+  random_state = 1;
+
+  for (int i = 0; i < BENCH_EVENTS; i++) {
+    int state = states[Random() % (sizeof(states) / sizeof(states[0]))];
+
+    time += (Random() % 1000) / 100000.0;
+
+    events[i].SetEventProps(Random() % 8, Random() % 2000 + 1, false, time, state,
+      (Random() % 4) ? US_NONE : US_STAY, i + 1,
+      T_SIMPLE(Random() % 256), T_SIMPLE(Random() % 256), T_SIMPLE(Random() % 3), T_SIMPLE(Random() % 8),
+      0, 0, (state == US_ATTACKING) ? int(Random() % 2000 + 1) : 0);
+  }
+}
+
+
+/**
+ *  Tests if both events have the same values.
+ */
+static bool SameEvents(TEVENT *a, TEVENT *b)
+{
+  return a->GetPlayerID() == b->GetPlayerID() && a->GetUnitID() == b->GetUnitID()
+    && a->GetTimeStamp() == b->GetTimeStamp() && a->GetEvent() == b->GetEvent()
+    && a->GetLastEvent() == b->GetLastEvent() && a->GetRequestID() == b->GetRequestID()
+    && a->simple1 == b->simple1 && a->simple2 == b->simple2 && a->simple3 == b->simple3
+    && a->simple4 == b->simple4 && a->simple5 == b->simple5 && a->simple6 == b->simple6
+    && a->int1 == b->int1 && a->int2 == b->int2;
+}
+
+
+/**
+ *  Packs all events into messages with compact codec. Each message starts
+ *  with player byte and base time, as messages of SendBatchEvent(), which are
+ *  not stored here.
+ */
+static void EncodeCompact(void)
+{
+  const int header = TNET_MESSAGE::GetHeaderSize() + sizeof(T_BYTE) + sizeof(double);
+  char buf[BENCH_RAW_SIZE];
+  int message_size = max_net_message_size;
+  int size;
+
+  data_size = 0;
+  message_count = 0;
+
+  for (int i = 0; i < BENCH_EVENTS; i++) {
+    if (message_size < max_net_message_size) {
+      size = events[i].LinearizeEventCompact(buf, message_base[message_count - 1]);
+
+      if (message_size + size <= max_net_message_size) {
+        memcpy(data + data_size, buf, size);
+        data_size += size;
+        message_size += size;
+        continue;
+      }
+    }
+
+    message_base[message_count] = events[i].GetTimeStamp();
+    message_first[message_count++] = i;
+
+    size = events[i].LinearizeEventCompact(data + data_size, message_base[message_count - 1]);
+    data_size += size;
+    message_size = header + size;
+  }
+
+  message_first[message_count] = BENCH_EVENTS;
+}
+
+
+/**
+ *  Unpacks events packed by EncodeCompact().
+ *
+ *  @return @c false if data are not valid.
+ */
+static bool DecodeCompact(void)
+{
+  int pos = 0;
+  int len;
+
+  for (int m = 0; m < message_count; m++)
+    for (int i = message_first[m]; i < message_first[m + 1]; i++) {
+      if (!(len = decoded[i].DelinearizeEventCompact(data + pos, data_size - pos, message_base[m])))
+        return false;
+      pos += len;
+    }
+
+  return pos == data_size;
+}
+
+
+/**
+ *  Packs all events with raw codec, one event in each message.
+ */
+static void EncodeRaw(void)
+{
+  data_size = 0;
+
+  for (int i = 0; i < BENCH_EVENTS; i++)
+    data_size += events[i].LinearizeEvent(data + data_size);
+}
+
+
+/**
+ *  Unpacks events packed by EncodeRaw().
+ */
+static bool DecodeRaw(void)
+{
+  int size = data_size / BENCH_EVENTS;
+
+  for (int i = 0; i < BENCH_EVENTS; i++)
+    decoded[i].DelinearizeEvent(data + i * size, size);
+
+  return true;
+}
+
+
+/**
+ *  Checks codec and measures its encoding and decoding.
+ */
+static bool Measure(const char *name, void (*Encode)(void), bool (*Decode)(void))
+{
+  clock_t start;
+  double encode_time, decode_time;
+  int r, i;
+
+  Encode();
+  if (!Decode()) {
+    printf("%s: data are not valid\n", name);
+    return false;
+  }
+
+  for (i = 0; i < BENCH_EVENTS; i++)
+    if (!SameEvents(&events[i], &decoded[i])) {
+      printf("%s: wrong event %d\n", name, i);
+      return false;
+    }
+
+  start = clock();
+  for (r = 0; r < BENCH_ROUNDS; r++) Encode();
+  encode_time = double(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  for (r = 0; r < BENCH_ROUNDS; r++) Decode();
+  decode_time = double(clock() - start) / CLOCKS_PER_SEC;
+
+  printf("%-8s %5.1f bytes per event, encode %6.1f ns (%6.1f MB/s), decode %6.1f ns (%6.1f MB/s)\n",
+    name, double(data_size) / BENCH_EVENTS,
+    1e9 * encode_time / (double(BENCH_ROUNDS) * BENCH_EVENTS), double(BENCH_ROUNDS) * data_size / encode_time / 1e6,
+    1e9 * decode_time / (double(BENCH_ROUNDS) * BENCH_EVENTS), double(BENCH_ROUNDS) * data_size / decode_time / 1e6);
+
+  return true;
+}
+
+
+int main(void)
+{
+  GenerateEvents();
+
+  printf("%d events, %d rounds\n", BENCH_EVENTS, BENCH_ROUNDS);
+
+  if (!Measure("raw", EncodeRaw, DecodeRaw) || !Measure("compact", EncodeCompact, DecodeCompact))
+    return 1;
+
+  printf("compact: %.1f events per message\n", double(BENCH_EVENTS) / message_count);
+
+  return 0;
+}
+
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
@@ -0,0 +1,378 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file bench_hashtable.cpp
+ *
+ *  Standalone benchmark of hashtable of units. It is not a part of the game,
+ *  it is compiled with dohashunits.cpp of the game, build and run it by:
+ *
+ *  @code
+ *  g++ -O2 -DUNIX=1 -DDEBUG=0 -I.. -I../../libs/glfw-legacy/include/GL -o bench_hashtable bench_hashtable.cpp ../dohashunits.cpp && ./bench_hashtable
+ *  @endcode
+ *
+ *  THASHTABLE_UNITS is compared with the table with sorted lists in fixed
+ *  count of buckets, which was used before. Both tables are checked against
+ *  @c std::map first. Then events of units are processed in the same way as
+ *  ProcessFunction() processes them: each event is taken from the queue, its
+ *  unit is found in the table of its player and the event is dispatched to
+ *  the unit.
+ *
+ *  @date 2026
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+#include <map>
+
+#include "dohashunits.h"
+#include "dologs.h"
+
+
+//=========================================================================
+// Definitions
+//=========================================================================
+
+#define BENCH_PLAYERS       8         //!< Count of players.
+#define BENCH_UNITS         2000      //!< Count of units of each player.
+#define BENCH_EVENTS        (1 << 20) //!< Count of events in one round.
+#define BENCH_ROUNDS        10        //!< Count of rounds of processing of events.
+#define BENCH_CHECK_OPS     200000    //!< Count of random operations checked against std::map.
+
+#define LIST_TABLE_SIZE     100       //!< Count of buckets of TLIST_TABLE.
+
+#define RQ_FIRST            1000      //!< Same as in dounits.h.
+
+
+/** Event of unit, only values used by ProcessFunction() are stored. */
+struct TBENCH_EVENT {
+  int player_id;
+  int unit_id;
+  int event;
+  double time_stamp;
+};
+
+
+/**
+ *  Unit, which processes events. Its address is stored in tables instead of
+ *  address of TPLAYER_UNIT, so it is cast as in ProcessFunction().
+ */
+class TBENCH_UNIT {
+public:
+  TBENCH_EVENT *pevent;
+  double last_event_time_stamp;
+  int state;
+
+  virtual void ProcessEvent(TBENCH_EVENT *event);
+
+  TBENCH_UNIT(void) { pevent = NULL; last_event_time_stamp = 0; state = 0; };
+  virtual ~TBENCH_UNIT(void) {};
+};
+
+
+void TBENCH_UNIT::ProcessEvent(TBENCH_EVENT *event)
+{
+  if (event->event < RQ_FIRST) {
+    state = event->event;
+    last_event_time_stamp = event->time_stamp;
+  }
+  else state ^= event->event;
+}
+
+
+/**
+ *  Generator of pseudorandom numbers, same on all platforms.
+ */
+static unsigned int random_state = 1;
+
+static unsigned int Random(void)
+{
+  random_state = random_state * 1103515245u + 12345u;
+  return random_state >> 8;
+}
+
+
+//=========================================================================
+// Table with lists
+//=========================================================================
+
+/**
+ *  Hashtable of units with sorted lists of nodes in fixed count of buckets.
+ */
+class TLIST_TABLE {
+public:
+  TPLAYER_UNIT * GetUnitPointer(int g_unit_id);
+  void AddToHashTable(int a_unit_id, TPLAYER_UNIT * a_player_unit);
+  void RemoveFromHashTable(int r_unit_id);
+
+  TLIST_TABLE(void) { for (int i = 0; i < LIST_TABLE_SIZE; i++) table[i] = NULL; };
+  ~TLIST_TABLE(void);
+
+private:
+  struct TNODE {
+    int unit_id;
+    TPLAYER_UNIT * player_unit;
+    TNODE * next;
+  };
+
+  TNODE * table[LIST_TABLE_SIZE];
+
+  int HashFunction(int h_unit_id) { return abs(h_unit_id) % LIST_TABLE_SIZE; };
+};
+
+
+TLIST_TABLE::~TLIST_TABLE(void)
+{
+  TNODE * act, * next;
+
+  for (int i = 0; i < LIST_TABLE_SIZE; i++)
+    for (act = table[i]; act; act = next) {
+      next = act->next;
+      delete act;
+    }
+}
+
+
+void TLIST_TABLE::AddToHashTable(int a_unit_id, TPLAYER_UNIT * a_player_unit)
+{
+  TNODE ** act;
+  TNODE * node;
+
+  for (act = &table[HashFunction(a_unit_id)]; *act && (*act)->unit_id < a_unit_id; act = &(*act)->next);
+
+  if (*act && (*act)->unit_id == a_unit_id) return;
+
+  node = new TNODE;
+  node->unit_id = a_unit_id;
+  node->player_unit = a_player_unit;
+  node->next = *act;
+  *act = node;
+}
+
+
+void TLIST_TABLE::RemoveFromHashTable(int r_unit_id)
+{
+  TNODE ** act;
+  TNODE * node;
+
+  for (act = &table[HashFunction(r_unit_id)]; *act && (*act)->unit_id < r_unit_id; act = &(*act)->next);
+
+  if (*act && (*act)->unit_id == r_unit_id) {
+    node = *act;
+    *act = node->next;
+    delete node;
+  }
+}
+
+
+TPLAYER_UNIT * TLIST_TABLE::GetUnitPointer(int g_unit_id)
+{
+  TNODE * act;
+
+  for (act = table[HashFunction(g_unit_id)]; act && act->unit_id < g_unit_id; act = act->next);
+
+  return (act && act->unit_id == g_unit_id) ? act->player_unit : NULL;
+}
+
+
+//=========================================================================
+// Stubs of the game
+//=========================================================================
+
+// dohashunits.cpp needs only these parts of the game, they do nothing here
+
+GLFWmutex log_mutex = NULL;
+void (*log_callback)(int, const char *, const char *) = NULL;
+
+char *LogMsg(const char *msg, ...)
+{
+  static char text[1024];
+  va_list arg;
+
+  va_start(arg, msg);
+  vsnprintf(text, sizeof(text), msg, arg);
+  va_end(arg);
+
+  return text;
+}
+
+void LogWrite(int level, const char *header, const char *file, int line, const char *msg)
+{
+  fprintf(stderr, "%s%s\n", header, msg);
+}
+
+void glfwLockMutex(GLFWmutex mutex) {}
+void glfwUnlockMutex(GLFWmutex mutex) {}
+
+
+//=========================================================================
+// Benchmark
+//=========================================================================
+
+static TBENCH_UNIT units[BENCH_PLAYERS * BENCH_UNITS];
+static TBENCH_EVENT events[BENCH_EVENTS];
+
+
+/** Returns unit as it is stored in tables. */
+static TPLAYER_UNIT *Unit(int index)
+{
+  return (TPLAYER_UNIT *)&units[index];
+}
+
+
+/**
+ *  Compares the table with @c std::map after random adds, removes and
+ *  lookups of positive and negative identificators.
+ *
+ *  @return @c true if the table gives the same results.
+ */
+template <class TTABLE> static bool Check(const char *name)
+{
+  TTABLE table;
+  std::map<int, TPLAYER_UNIT *> reference;
+  std::map<int, TPLAYER_UNIT *>::iterator it;
+  TPLAYER_UNIT *expected;
+  int id;
+
+  random_state = 1;
+
+  for (int i = 0; i < BENCH_CHECK_OPS; i++) {
+    id = int(Random() % 6000) - 1000;
+
+    switch (Random() % 3) {
+    case 0:
+      if (reference.find(id) == reference.end()) {
+        reference[id] = Unit((id + 1000) % (BENCH_PLAYERS * BENCH_UNITS));
+        table.AddToHashTable(id, reference[id]);
+      }
+      break;
+
+    case 1:
+      reference.erase(id);
+      table.RemoveFromHashTable(id);
+      break;
+
+    default:
+      it = reference.find(id);
+      expected = it == reference.end() ? NULL : it->second;
+
+      if (table.GetUnitPointer(id) != expected) {
+        printf("%s: wrong unit %d after %d operations\n", name, id, i);
+        return false;
+      }
+      break;
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ *  Fills queue of events of random units of all players. Some events belong
+ *  to units, which do not exist any more, some of them are requests.
+ */
+static void GenerateEvents(void)
+{
+  double time = 0;
+
+  random_state = 2;
+
+  for (int i = 0; i < BENCH_EVENTS; i++) {
+    time += (Random() % 100) / 100000.0;
+
+    events[i].player_id = Random() % BENCH_PLAYERS;
+    events[i].unit_id = Random() % (BENCH_UNITS + BENCH_UNITS / 50) + 1;
+    events[i].event = (Random() % 10) ? int(Random() % 30) : RQ_FIRST + int(Random() % 20);
+    events[i].time_stamp = time;
+  }
+}
+
+
+/**
+ *  Measures average time of processing of one event. Events are processed
+ *  as in ProcessFunction(), the first half of players is local, the other
+ *  one is remote.
+ *
+ *  @return Time of processing of one event. [ns]
+ */
+template <class TTABLE> static double Measure(void)
+{
+  TTABLE tables[BENCH_PLAYERS];
+  TBENCH_EVENT *act_event;
+  TBENCH_UNIT *act_unit;
+  unsigned long processed = 0;
+  clock_t start;
+  int p, i, r;
+
+  for (p = 0; p < BENCH_PLAYERS * BENCH_UNITS; p++) units[p] = TBENCH_UNIT();
+
+  for (p = 0; p < BENCH_PLAYERS; p++)
+    for (i = 1; i <= BENCH_UNITS; i++)
+      tables[p].AddToHashTable(i, Unit(p * BENCH_UNITS + i - 1));
+
+  start = clock();
+
+  for (r = 0; r < BENCH_ROUNDS; r++)
+    for (i = 0; i < BENCH_EVENTS; i++) {
+      act_event = &events[i];
+
+      act_unit = ((TBENCH_UNIT *)tables[act_event->player_id].GetUnitPointer(act_event->unit_id));
+
+      // process event only in case that unit exists
+      if (!act_unit) continue;
+
+      // local units
+      if (act_event->player_id < BENCH_PLAYERS / 2) {
+        if (act_event->event < RQ_FIRST) act_unit->pevent = NULL;
+
+        act_unit->ProcessEvent(act_event);
+        processed++;
+      }
+
+      // remote units, events must come in order of time stamps
+      else if (act_unit->last_event_time_stamp <= act_event->time_stamp || act_event->event >= RQ_FIRST) {
+        act_unit->ProcessEvent(act_event);
+        processed++;
+      }
+    }
+
+  if (!processed) printf("No event was processed\n");
+
+  return 1e9 * double(clock() - start) / CLOCKS_PER_SEC / (double(BENCH_ROUNDS) * BENCH_EVENTS);
+}
+
+
+int main(void)
+{
+  if (!Check<TLIST_TABLE>("lists") || !Check<THASHTABLE_UNITS>("THASHTABLE_UNITS")) return 1;
+
+  GenerateEvents();
+
+  printf("%d players with %d units, %d events\n", BENCH_PLAYERS, BENCH_UNITS, BENCH_ROUNDS * BENCH_EVENTS);
+  printf("lists:            %.1f ns per event\n", Measure<TLIST_TABLE>());
+  printf("THASHTABLE_UNITS: %.1f ns per event\n", Measure<THASHTABLE_UNITS>());
+
+  return 0;
+}
+
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
@@ -0,0 +1,188 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file bench_sections.cpp
+ *
+ *  Standalone benchmark of lookups of items in large sections of
+ *  configuration files. It is not a part of the game, it is compiled with
+ *  dofile.cpp of the game, build and run it by:
+ *
+ *  @code
+ *  g++ -O2 -DUNIX=1 -DDEBUG=0 -I.. -I../../libs/glfw-legacy/include/GL -o bench_sections bench_sections.cpp ../dofile.cpp && ./bench_sections
+ *  @endcode
+ *
+ *  Add @c -DFE_INDEX_MIN_ENTRIES=0x7FFFFFFF to build it without hash index of
+ *  sections, so all sections are searched sequentially.
+ *
+ *  Map file with section of units is generated and each unit is read in the
+ *  same way as TMAP::LoadMapUnit() reads it.
+ *
+ *  @date 2026
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "dofile.h"
+#include "dologs.h"
+
+
+//=========================================================================
+// Definitions
+//=========================================================================
+
+#define BENCH_UNITS         5000      //!< Count of units in the section.
+#define BENCH_ROUNDS        10        //!< Count of rounds of reading all units.
+#define BENCH_FILE          "bench_sections.map"  //!< Generated map file.
+
+
+//=========================================================================
+// Stubs of the game
+//=========================================================================
+
+// dofile.cpp needs only these parts of the game, they do nothing here
+
+GLFWmutex log_mutex = NULL;
+void (*log_callback)(int, const char *, const char *) = NULL;
+
+char *LogMsg(const char *msg, ...)
+{
+  static char text[1024];
+  va_list arg;
+
+  va_start(arg, msg);
+  vsnprintf(text, sizeof(text), msg, arg);
+  va_end(arg);
+
+  return text;
+}
+
+void LogWrite(int level, const char *header, const char *file, int line, const char *msg)
+{
+  fprintf(stderr, "%s%s\n", header, msg);
+}
+
+void glfwLockMutex(GLFWmutex mutex) {}
+void glfwUnlockMutex(GLFWmutex mutex) {}
+
+
+//=========================================================================
+// Benchmark
+//=========================================================================
+
+/**
+ *  Writes map file with one section of units.
+ *
+ *  @return @c true on success.
+ */
+static bool GenerateFile(void)
+{
+  FILE *fh = fopen(BENCH_FILE, "wt");
+
+  if (!fh) return false;
+
+  fprintf(fh, "<Units>\n  count %d\n", BENCH_UNITS);
+
+  for (int i = 0; i < BENCH_UNITS; i++)
+    fprintf(fh, "  unit_%d \"footman\" %d %d 1 %d 100\n", i, i % 100, i / 100, i % 8);
+
+  fprintf(fh, "</Units>\n");
+
+  return fclose(fh) == 0;
+}
+
+
+/**
+ *  Reads all units from the section as TMAP::LoadMapUnit() does and checks
+ *  their values.
+ *
+ *  @return @c true if all units were read.
+ */
+static bool ReadUnits(TCONF_FILE *file)
+{
+  TFILE_LINE item;
+  char strval[1024];
+  int count, x, y, z, dir, life;
+  bool ok;
+
+  ok = file->SelectSection(const_cast<char*>("Units"), true);
+
+  if (ok) ok = file->ReadIntGE(&count, const_cast<char*>("count"), 0, 0) && count == BENCH_UNITS;
+
+  for (int i = 0; ok && i < count; i++) {
+    sprintf(item, "unit_%d", i);
+
+    file->GetActSection()->ResetValue(item);
+
+    ok = file->ReadStr(strval, item, const_cast<char*>(""), false)
+      && file->ReadInt(&x, item, 0) && file->ReadInt(&y, item, 0)
+      && file->ReadIntGE(&z, item, 0, 0) && file->ReadIntRange(&dir, item, 0, 7, 0)
+      && file->ReadIntRange(&life, item, 0, 100, 100)
+      && x == i % 100 && y == i / 100 && dir == i % 8;
+  }
+
+  file->GetActSection()->ResetValue(const_cast<char*>("count"));
+  file->UnselectSection();
+
+  return ok;
+}
+
+
+int main(void)
+{
+  TCONF_FILE *file;
+  clock_t start;
+  double parse_time, read_time;
+
+  if (!GenerateFile()) {
+    printf("Can not write '%s'\n", BENCH_FILE);
+    return 1;
+  }
+
+  file = new TCONF_FILE(BENCH_FILE);
+
+  start = clock();
+  if (!file->Reload()) {
+    printf("Can not read '%s'\n", BENCH_FILE);
+    return 1;
+  }
+  parse_time = double(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  for (int r = 0; r < BENCH_ROUNDS; r++)
+    if (!ReadUnits(file)) {
+      printf("Units were not read correctly\n");
+      return 1;
+    }
+  read_time = double(clock() - start) / CLOCKS_PER_SEC / BENCH_ROUNDS;
+
+  delete file;
+  remove(BENCH_FILE);
+
+  printf("%d units, index from %d entries\n", BENCH_UNITS, FE_INDEX_MIN_ENTRIES);
+  printf("parse:           %.2f ms\n", 1e3 * parse_time);
+  printf("read all units:  %.2f ms\n", 1e3 * read_time);
+
+  return 0;
+}
+
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
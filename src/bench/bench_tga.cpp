@@ -0,0 +1,213 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file bench_tga.cpp
+ *
+ *  Standalone benchmark of decoding of TGA images stored in data files. It is
+ *  not a part of the game, it is compiled with tga.cpp of the game, build and
+ *  run it by:
+ *
+ *  @code
+ *  g++ -O2 -I.. -o bench_tga bench_tga.cpp ../tga.cpp && ./bench_tga
+ *  @endcode
+ *
+ *  Add @c -mssse3 or @c -mavx2 to measure the other paths of conversion of
+ *  pixels. Data files are given as arguments, the shipped ones in ../../dat
+ *  are used by default. Images are decoded with the same flags as textures
+ *  are decoded by the game.
+ *
+ *  @date 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "tga.h"
+
+
+//=========================================================================
+// Definitions
+//=========================================================================
+
+#define BENCH_ROUNDS        200       //!< Count of rounds of decoding of all images.
+
+#define DAT_FILE_HEADER     "Dark Oberon data file"   //!< Same as in dodata.h.
+
+
+/** Image stored in data file. */
+struct TBENCH_IMAGE {
+  const unsigned char *data;  //!< TGA data.
+  unsigned int size;          //!< Size of TGA data. [bytes]
+};
+
+
+//=========================================================================
+// Data files
+//=========================================================================
+
+/**
+ *  Reader of data file in memory, same as TDAT_FILE.
+ */
+struct TBENCH_FILE {
+  unsigned char *data;
+  unsigned int size;
+  unsigned int pos;
+
+  bool Read(void *dest, unsigned int count) {
+    if (count > size - pos) return false;
+    memcpy(dest, data + pos, count);
+    pos += count;
+    return true;
+  }
+
+  bool Skip(unsigned int count) {
+    if (count > size - pos) return false;
+    pos += count;
+    return true;
+  }
+
+  bool SkipString(void) {
+    unsigned char len;
+    return Read(&len, sizeof(len)) && Skip(len);
+  }
+};
+
+
+/**
+ *  Reads data file into memory and finds its images. Directory of textures
+ *  is read in the same way as TTEX_TABLE::Load() reads it.
+ *
+ *  @return @c true on success.
+ */
+static bool ReadDataFile(const char *file_name, std::vector<TBENCH_IMAGE> &images)
+{
+  TBENCH_FILE file;
+  FILE *fh;
+  char header[sizeof(DAT_FILE_HEADER)];
+  unsigned char version, hcount, vcount, ttype;
+  unsigned int textures_seek;
+  int groups_count, count, atime, pointx, pointy;
+  TBENCH_IMAGE image;
+  bool ok;
+
+  if (!(fh = fopen(file_name, "rb"))) return false;
+
+  fseek(fh, 0, SEEK_END);
+  file.size = (unsigned int)ftell(fh);
+  file.pos = 0;
+  fseek(fh, 0, SEEK_SET);
+
+  file.data = (unsigned char *)malloc(file.size);
+  ok = file.data && fread(file.data, 1, file.size, fh) == file.size;
+  fclose(fh);
+
+  if (!ok) return false;
+
+  header[sizeof(header) - 1] = 0;
+
+  ok = file.Read(header, sizeof(header) - 1) && !strcmp(header, DAT_FILE_HEADER)
+    && file.Read(&version, sizeof(version))
+    && file.Read(&textures_seek, sizeof(textures_seek)) && textures_seek < file.size;
+
+  if (ok) {
+    file.pos = textures_seek;
+    ok = file.Read(&groups_count, sizeof(groups_count));
+  }
+
+  for (int gid = 0; ok && gid < groups_count; gid++) {
+    ok = file.SkipString() && file.Read(&count, sizeof(count));
+
+    for (int tid = 0; ok && tid < count; tid++) {
+      ok = file.SkipString()
+        && file.Read(&hcount, sizeof(hcount))
+        && file.Read(&vcount, sizeof(vcount))
+        && file.Read(&atime, sizeof(atime))
+        && file.Read(&pointx, sizeof(pointx))
+        && file.Read(&pointy, sizeof(pointy))
+        && file.Read(&ttype, sizeof(ttype))
+        && file.Read(&image.size, sizeof(image.size));
+
+      image.data = file.data + file.pos;
+      ok = ok && file.Skip(image.size);
+
+      if (ok) images.push_back(image);
+    }
+  }
+
+  return ok;
+}
+
+
+//=========================================================================
+// Benchmark
+//=========================================================================
+
+int main(int argc, char *argv[])
+{
+  static const char *default_files[] = {"../../dat/cursors.dat", "../../dat/fonts.dat"};
+  const char **files = argc > 1 ? (const char **)argv + 1 : default_files;
+  int files_count = argc > 1 ? argc - 1 : sizeof(default_files) / sizeof(default_files[0]);
+
+  std::vector<TBENCH_IMAGE> images;
+  TGA_INFO tga;
+  double input_size = 0, output_size = 0;
+  double decode_time;
+  clock_t start;
+  size_t i;
+
+  for (int f = 0; f < files_count; f++)
+    if (!ReadDataFile(files[f], images)) {
+      printf("Can not read images from '%s'\n", files[f]);
+      return 1;
+    }
+
+  // all images must be decoded before measuring
+  for (i = 0; i < images.size(); i++) {
+    if (!tgaReadMemory(images[i].data, images[i].size, &tga, TGA_RESCALE)) {
+      printf("Can not decode image %d\n", int(i));
+      return 1;
+    }
+
+    input_size += images[i].size;
+    output_size += double(tga.width) * tga.height * tga.bytesperpixel;
+    free(tga.data);
+  }
+
+  start = clock();
+
+  for (int r = 0; r < BENCH_ROUNDS; r++)
+    for (i = 0; i < images.size(); i++) {
+      tgaReadMemory(images[i].data, images[i].size, &tga, TGA_RESCALE);
+      free(tga.data);
+    }
+
+  decode_time = double(clock() - start) / CLOCKS_PER_SEC / BENCH_ROUNDS;
+
+  printf("%d images, %.1f MB of TGA data, %.1f MB of pixels\n", int(images.size()), input_size / 1e6, output_size / 1e6);
+  printf("decode: %.2f ms, %.1f MB/s of pixels\n", 1e3 * decode_time, output_size / decode_time / 1e6);
+
+  return 0;
+}
+
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
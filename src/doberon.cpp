@@ -157,6 +157,7 @@ bool InitAll(void)
   init_sockets ();
 
   pool_net_messages = NEW TPOOL<TNET_MESSAGE>(1000, 0, 100);
+  pool_net_large_buffers = NEW TNET_LARGE_POOL ();
 
   // initialize memory checking system
   // must be called after initializing log files and GLWF
@@ -171,6 +172,12 @@ bool InitAll(void)
 
   // configuration
   LoadConfig();                               // load configuration from file
+  net_reactor_mode = config.net_reactor;
+  net_simulation.delay = config.net_sim_delay;
+  net_simulation.jitter = config.net_sim_jitter;
+  net_simulation.reorder = config.net_sim_reorder;
+  net_simulation.loss = config.net_sim_loss;
+  net_simulation.bandwidth = config.net_sim_bandwidth;
 
 #ifdef NEW_GLFW3
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
@@ -238,6 +245,7 @@ bool InitAll(void)
   process_mutex = NEW TRECURSIVE_LOCK();
 
   CreateLogMutex();
+  StartLogWriter();
 
   /* MUST be called after glfwInit(), but before InitIO(). */
   need_redraw = NEW TSAFE_BOOL_SWITCH (true);
@@ -281,6 +289,7 @@ void DestroyAll(void)
   // destroy gui
   if (gui) delete gui;
 
+  StopLogWriter();
   DestroyLogMutex();
   delete process_mutex;
 
@@ -608,7 +608,7 @@ bool TBUILDING_UNIT::AddToMap(bool to_segment, bool set_view)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++)
-          map.segments[k].surface[pos.x + i][pos.y + j].ghost = this;
+          map.segments[k].surface.SetGhost(pos.x + i, pos.y + j, this);
   }
 
   else {
@@ -616,15 +616,15 @@ bool TBUILDING_UNIT::AddToMap(bool to_segment, bool set_view)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++)
-          if (map.segments[k].surface[pos.x + i][pos.y + j].unit) return false;
+          if (map.segments[k].surface.GetUnit(pos.x + i, pos.y + j)) return false;
 
     // update terrain ID and in each segment of map
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++)
         {
-          map.segments[k].surface[pos.x + i][pos.y + j].t_id += MAP_BUILDING_COEF;
-          map.segments[k].surface[pos.x + i][pos.y + j].unit = this;
+          map.segments[k].surface.SetTerrainId(pos.x + i, pos.y + j, map.segments[k].surface.GetTerrainId(pos.x + i, pos.y + j) + MAP_BUILDING_COEF);
+          map.segments[k].surface.SetUnit(pos.x + i, pos.y + j, this);
         }
 
     // updating local maps for each player
@@ -657,7 +657,7 @@ void TBUILDING_UNIT::DeleteFromMap(bool from_segment)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++) {
-          map.segments[k].surface[pos.x + i][pos.y + j].ghost = NULL;
+          map.segments[k].surface.SetGhost(pos.x + i, pos.y + j, NULL);
         }
   }
 
@@ -666,8 +666,8 @@ void TBUILDING_UNIT::DeleteFromMap(bool from_segment)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++) {
-          map.segments[k].surface[pos.x + i][pos.y + j].t_id -= MAP_BUILDING_COEF;
-          map.segments[k].surface[pos.x + i][pos.y + j].unit = NULL;
+          map.segments[k].surface.SetTerrainId(pos.x + i, pos.y + j, map.segments[k].surface.GetTerrainId(pos.x + i, pos.y + j) - MAP_BUILDING_COEF);
+          map.segments[k].surface.SetUnit(pos.x + i, pos.y + j, NULL);
         }
     
     if (selected) selection->DeleteUnit(this);
@@ -80,6 +80,7 @@ TCONFIG::TCONFIG()
 
   tex_mag_filter = CFG_DEF_TEX_MAG_FILTER;
   tex_min_filter = CFG_DEF_TEX_MIN_FILTER;
+  tex_prefetch = CFG_DEF_TEX_PREFETCH;
   
   warfog_intensity = CFG_DEF_WARFOG_ALPHA;
   warfog_color[0] = CFG_DEF_WARFOG_COLOR_R;
@@ -105,6 +106,15 @@ TCONFIG::TCONFIG()
   snd_game_music = CFG_DEF_SND_GAME_MUSIC;
 
   net_server_port = CFG_DEF_NET_SERVER_PORT;
+  net_reactor = CFG_DEF_NET_REACTOR;
+  net_sim_delay = CFG_DEF_NET_SIM_DELAY;
+  net_sim_jitter = CFG_DEF_NET_SIM_JITTER;
+  net_sim_reorder = CFG_DEF_NET_SIM_REORDER;
+  net_sim_loss = CFG_DEF_NET_SIM_LOSS;
+  net_sim_bandwidth = CFG_DEF_NET_SIM_BANDWIDTH;
+  net_world_hash_period = CFG_DEF_NET_WORLD_HASH_PERIOD;
+  net_world_snapshot = CFG_DEF_NET_WORLD_SNAPSHOT;
+  net_input_delay = CFG_DEF_NET_INPUT_DELAY;
 
   ComputePrecompiled();
 }
@@ -252,6 +262,7 @@ void WriteDefConfig(void)
   config.file->WriteLine(const_cast<char*>("# *** Graphics ***"));
   config.file->WriteStr(const_cast<char*>("texture_filter"), const_cast<char*>(CFG_DEF_TEXTURE_FILTER));
   config.file->WriteStr(const_cast<char*>("mipmap_filter"), const_cast<char*>(CFG_DEF_MIPMAP_FILTER));
+  config.file->WriteBool(const_cast<char*>("tex_prefetch"), CFG_DEF_TEX_PREFETCH);
   config.file->WriteInt(const_cast<char*>("warfog_color"), CFG_DEF_WARFOG_COLOR_R);
   config.file->WriteInt(const_cast<char*>("warfog_color"), CFG_DEF_WARFOG_COLOR_G);
   config.file->WriteInt(const_cast<char*>("warfog_color"), CFG_DEF_WARFOG_COLOR_B);
@@ -286,6 +297,15 @@ void WriteDefConfig(void)
   // Networking options.
   config.file->WriteLine(const_cast<char*>("# *** Networking options ***"));
   config.file->WriteInt(const_cast<char*>("net_server_port"), CFG_DEF_NET_SERVER_PORT);
+  config.file->WriteBool(const_cast<char*>("net_reactor"), CFG_DEF_NET_REACTOR);
+  config.file->WriteInt(const_cast<char*>("net_sim_delay"), CFG_DEF_NET_SIM_DELAY);
+  config.file->WriteInt(const_cast<char*>("net_sim_jitter"), CFG_DEF_NET_SIM_JITTER);
+  config.file->WriteInt(const_cast<char*>("net_sim_reorder"), CFG_DEF_NET_SIM_REORDER);
+  config.file->WriteInt(const_cast<char*>("net_sim_loss"), CFG_DEF_NET_SIM_LOSS);
+  config.file->WriteInt(const_cast<char*>("net_sim_bandwidth"), CFG_DEF_NET_SIM_BANDWIDTH);
+  config.file->WriteInt(const_cast<char*>("net_world_hash_period"), CFG_DEF_NET_WORLD_HASH_PERIOD);
+  config.file->WriteBool(const_cast<char*>("net_world_snapshot"), CFG_DEF_NET_WORLD_SNAPSHOT);
+  config.file->WriteInt(const_cast<char*>("net_input_delay"), CFG_DEF_NET_INPUT_DELAY);
 }
 
 
@@ -319,6 +339,7 @@ bool LoadConfig(void)
   // graphics
   LoadCfgTextureFilter();
   LoadCfgMipmapFilter();
+  config.file->ReadBool(&config.tex_prefetch, const_cast<char*>("tex_prefetch"), CFG_DEF_TEX_PREFETCH);
 
   config.file->ReadByteRange(config.warfog_color, const_cast<char*>("warfog_color"), 0, 255, CFG_DEF_WARFOG_COLOR_R);
   config.file->ReadByteRange(config.warfog_color+1, const_cast<char*>("warfog_color"), 0, 255, CFG_DEF_WARFOG_COLOR_G);
@@ -350,6 +371,15 @@ bool LoadConfig(void)
 
   // Networking options.
   config.file->ReadIntRange(&config.net_server_port, const_cast<char*>("net_server_port"), 1024, 65535, CFG_DEF_NET_SERVER_PORT);
+  config.file->ReadBool(&config.net_reactor, const_cast<char*>("net_reactor"), CFG_DEF_NET_REACTOR);
+  config.file->ReadIntRange(&config.net_sim_delay, const_cast<char*>("net_sim_delay"), 0, 10000, CFG_DEF_NET_SIM_DELAY);
+  config.file->ReadIntRange(&config.net_sim_jitter, const_cast<char*>("net_sim_jitter"), 0, 10000, CFG_DEF_NET_SIM_JITTER);
+  config.file->ReadIntRange(&config.net_sim_reorder, const_cast<char*>("net_sim_reorder"), 0, 10000, CFG_DEF_NET_SIM_REORDER);
+  config.file->ReadIntRange(&config.net_sim_loss, const_cast<char*>("net_sim_loss"), 0, 100, CFG_DEF_NET_SIM_LOSS);
+  config.file->ReadIntGE(&config.net_sim_bandwidth, const_cast<char*>("net_sim_bandwidth"), 0, CFG_DEF_NET_SIM_BANDWIDTH);
+  config.file->ReadIntRange(&config.net_world_hash_period, const_cast<char*>("net_world_hash_period"), 0, 3600, CFG_DEF_NET_WORLD_HASH_PERIOD);
+  config.file->ReadBool(&config.net_world_snapshot, const_cast<char*>("net_world_snapshot"), CFG_DEF_NET_WORLD_SNAPSHOT);
+  config.file->ReadIntRange(&config.net_input_delay, const_cast<char*>("net_input_delay"), 0, 1000, CFG_DEF_NET_INPUT_DELAY);
   
   ComputePrecompiled();
 
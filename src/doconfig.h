@@ -57,6 +57,9 @@ struct TCONFIG;
  *  @sa TCONFIG::player_name */
 #define CFG_DEF_TEX_MAG_FILTER GL_LINEAR
 #define CFG_DEF_TEX_MIN_FILTER GL_LINEAR
+/** Default configuration's prefetching of race textures.
+ *  @sa TCONFIG::tex_prefetch */
+#define CFG_DEF_TEX_PREFETCH    true
 #define CFG_DEF_PLAYER_NAME     "Player"
 /** Default IP address.
  *  @sa TCONFIG::address */
@@ -131,6 +134,33 @@ struct TCONFIG;
 /** Default configuration's server port.
  *  @sa TCONFIG::net_server_port */
 #define CFG_DEF_NET_SERVER_PORT  17000
+/** Default configuration's network reactor toogle.
+ *  @sa TCONFIG::net_reactor */
+#define CFG_DEF_NET_REACTOR  false
+/** Default configuration's delay of simulated network.
+ *  @sa TCONFIG::net_sim_delay */
+#define CFG_DEF_NET_SIM_DELAY  0
+/** Default configuration's jitter of simulated network.
+ *  @sa TCONFIG::net_sim_jitter */
+#define CFG_DEF_NET_SIM_JITTER  0
+/** Default configuration's reordering of simulated network.
+ *  @sa TCONFIG::net_sim_reorder */
+#define CFG_DEF_NET_SIM_REORDER  0
+/** Default configuration's loss of simulated network.
+ *  @sa TCONFIG::net_sim_loss */
+#define CFG_DEF_NET_SIM_LOSS  0
+/** Default configuration's bandwidth of simulated network.
+ *  @sa TCONFIG::net_sim_bandwidth */
+#define CFG_DEF_NET_SIM_BANDWIDTH  0
+/** Default configuration's period of world hash exchange.
+ *  @sa TCONFIG::net_world_hash_period */
+#define CFG_DEF_NET_WORLD_HASH_PERIOD  5
+/** Default configuration's world snapshot toogle.
+ *  @sa TCONFIG::net_world_snapshot */
+#define CFG_DEF_NET_WORLD_SNAPSHOT  true
+/** Default configuration's maximal input delay.
+ *  @sa TCONFIG::net_input_delay */
+#define CFG_DEF_NET_INPUT_DELAY  0
 
 
 //========================================================================
@@ -176,6 +206,7 @@ struct TCONFIG {
 
   int tex_mag_filter;     //!< Magnification texture filter. [GL_NEAREST, GL_LINEAR]
   int tex_min_filter;     //!< Minification texture filter. [GL_NEAREST, GL_LINEAR, GL_LINEAR_MIPMAP_NEAREST, ...]
+  bool tex_prefetch;      //!< Specifies, if not yet used race textures are loaded in spare time of frames.
   
   T_BYTE warfog_intensity; //!< Warfog intensity (alfa-channel). [0..100]
   T_BYTE warfog_color[3];  //!< Warfog color. [R: 0..255, G: 0..255, B: 0..255]
@@ -209,6 +240,15 @@ struct TCONFIG {
 
   // Network
   int net_server_port;          //!< Server port.
+  bool net_reactor;             //!< Receive messages from all connections in one thread (not supported on Windows).
+  int net_sim_delay;            //!< One-way delay of simulated network. [0..10000 ms]
+  int net_sim_jitter;           //!< Maximal random addition to delay of simulated network. [0..10000 ms]
+  int net_sim_reorder;          //!< Maximal time by which data may overtake older data on simulated network. [0..10000 ms]
+  int net_sim_loss;             //!< Probability of retransmission on simulated network. [0..100 %]
+  int net_sim_bandwidth;        //!< Bandwidth of simulated network, 0 for unlimited. [kB/s]
+  int net_world_hash_period;    //!< Period of exchange of hashes of world with remote computers, 0 to disable. [seconds]
+  bool net_world_snapshot;      //!< Request snapshot of units from remote computer, whose hash of world differs.
+  int net_input_delay;          //!< Maximal delay of events of remote units chosen from round trip times, 0 to disable. [0..1000 ms]
 
   // Precomputed values
   int pr_wnd_mode;                    //!< Precomputed window mode. [GLFW_WINDOW, GLFW_FULLSCREEN]
@@ -28,14 +28,25 @@
 #include <stdlib.h>
 #include <string.h>
 
-#ifdef __MINGW32__
-#include <GL/glu.h>
+#include <vector>
+
+#include "cfg.h"
+
+#ifdef WINDOWS
+ #include <windows.h>
+#else // on UNIX
+ #include <sys/types.h>
+ #include <sys/stat.h>
+ #include <sys/mman.h>
+ #include <fcntl.h>
+ #include <unistd.h>
 #endif
 
 #include "doconfig.h"
 #include "dodata.h"
 #include "doengine.h"
 #include "domouse.h"
+#include "dothreadpool.h"
 #include "tga.h"
 
 
@@ -48,6 +59,13 @@
 #define DAT_ST_SAMPLE   0
 #define DAT_ST_STREAM   1
 
+// count of pending textures allocated at once while packing atlases
+#define DAT_PENDING_STEP  64
+
+// decoding of textures
+#define DAT_MAX_DECODE_THREADS  8       // maximal count of threads decoding textures
+#define DAT_DECODE_WAIT         0.001   // time to sleep while waiting for decoded texture [seconds]
+
 
 //=========================================================================
 // Global variables
@@ -84,131 +102,715 @@ bool fReadString(char **txt, FILE *fr)
 
 
 //=========================================================================
-// TTEX_TABLE
+// TDAT_FILE
 //=========================================================================
 
 /**
- *  Load textures from *.dat.
+ *  Opens data file and maps it to memory. If mapping fails, the whole file is
+ *  read to memory.
  *
- *  @param file_name  Filename of the dat file.
+ *  @param file_name  Filename of the data file.
  *
  *  @return @c true on success, @c false otherwise.
  */
-bool TTEX_TABLE::Load(const char *file_name, int mag_filter, int min_filter)
+bool TDAT_FILE::Open(const char *file_name)
 {
   FILE *fr;
-  
-  Info(LogMsg("Loading textures from '%s'", file_name));
+  long fsize;
 
-  if (!(fr = fopen(file_name, "rb"))) {
-    Error(LogMsg("Can not open file '%s'", file_name));
-    return false;
+  Close();
+
+#ifdef WINDOWS
+  HANDLE file, map;
+  DWORD high = 0;
+  DWORD low;
+
+  file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if (file != INVALID_HANDLE_VALUE) {
+    low = GetFileSize(file, &high);
+
+    if (low != INVALID_FILE_SIZE && low > 0 && !high && (map = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL))) {
+      if ((data = (const unsigned char *)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0))) {
+        size = low;
+        mapping = map;
+        mapped = true;
+      }
+      else CloseHandle(map);
+    }
+
+    // mapping holds its own reference to the file
+    CloseHandle(file);
   }
+#else
+  struct stat st;
+  void *map;
+  int fd;
+
+  if ((fd = open(file_name, O_RDONLY)) >= 0) {
+    if (!fstat(fd, &st) && st.st_size > 0 && (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED) {
+      data = (const unsigned char *)map;
+      size = (unsigned int)st.st_size;
+      mapped = true;
+    }
+
+    // mapping holds its own reference to the file
+    close(fd);
+  }
+#endif
+
+  if (data) return true;
+
+  // read whole file at once
+  if (!(fr = fopen(file_name, "rb"))) return false;
+
+  fseek(fr, 0, SEEK_END);
+  fsize = ftell(fr);
+  fseek(fr, 0, SEEK_SET);
+
+  if (fsize > 0 && (data = (const unsigned char *)malloc(fsize))) {
+    if (fread((void *)data, 1, fsize, fr) == (size_t)fsize) size = (unsigned int)fsize;
+    else Close();
+  }
+
+  fclose(fr);
+
+  return data != NULL;
+}
+
+
+/**
+ *  Unmaps or frees data of the file.
+ */
+void TDAT_FILE::Close(void)
+{
+  if (data) {
+    if (mapped) {
+#ifdef WINDOWS
+      UnmapViewOfFile(data);
+      CloseHandle((HANDLE)mapping);
+#else
+      munmap((void *)data, size);
+#endif
+    }
+    else free((void *)data);
+  }
+
+  data = NULL;
+  size = pos = 0;
+  mapped = false;
+  mapping = NULL;
+}
+
+
+/**
+ *  Sets actual position in the file.
+ *
+ *  @return @c false if position is behind the end of the file.
+ */
+bool TDAT_FILE::Seek(unsigned int seek)
+{
+  if (seek > size) return false;
+
+  pos = seek;
+  return true;
+}
+
+
+/**
+ *  Reads @p size bytes from actual position in the file.
+ *
+ *  @return @c false if there is not enough data in the file.
+ */
+bool TDAT_FILE::Read(void *dest, unsigned int size)
+{
+  if (size > this->size - pos) return false;
+
+  memcpy(dest, data + pos, size);
+  pos += size;
+
+  return true;
+}
+
+
+/**
+ *  Reads string stored with its length in one byte. Memory for the string is
+ *  allocated only for non empty strings.
+ *
+ *  @return @c false if there is not enough data in the file.
+ */
+bool TDAT_FILE::ReadString(char **txt)
+{
+  unsigned char len = 0;
+
+  if (!Read(&len, sizeof(len))) return false;
+  if (!len) return true;
+
+  *txt = NEW char[len+1];
+  (*txt)[len] = 0;
+
+  return Read(*txt, len);
+}
+
+
+/**
+ *  Moves actual position in the file by @p size bytes forward.
+ *
+ *  @return @c false if there is not enough data in the file.
+ */
+bool TDAT_FILE::Skip(unsigned int size)
+{
+  if (size > this->size - pos) return false;
+
+  pos += size;
+  return true;
+}
+
+
+//=========================================================================
+// Textures atlases
+//=========================================================================
+
+/**
+ *  Decoded texture waiting to be packed into atlas.
+ */
+struct TTEX_PENDING {
+  TGUI_TEXTURE *tex;        //!< Texture which will be placed to atlas.
+  TGA_INFO tga;             //!< Decoded image of the texture.
+  int index;                //!< Order of the texture in data file.
+
+  int atlas;                //!< Index of the atlas.
+  int x;                    //!< X position in the atlas. [pixels]
+  int y;                    //!< Y position in the atlas. [pixels]
+};
+
+
+/**
+ *  Compares pending textures by their order in data file.
+ */
+static int ComparePendingIndex(const void *a, const void *b)
+{
+  return ((TTEX_PENDING *)a)->index - ((TTEX_PENDING *)b)->index;
+}
+
+
+/**
+ *  Compares pending textures by their height, higher first.
+ */
+static int ComparePendingHeight(const void *a, const void *b)
+{
+  return ((TTEX_PENDING *)b)->tga.original_height - ((TTEX_PENDING *)a)->tga.original_height;
+}
+
+
+/**
+ *  Places pending textures to atlases. Textures are sorted by height and
+ *  placed to shelves, a new atlas is started when the actual one is full.
+ *  The first atlas continues from the position @p x, @p y on the shelf of
+ *  height @p shelf, zeros start an empty atlas.
+ *
+ *  @param pending  Table of pending textures.
+ *  @param count    Count of pending textures.
+ *  @param size     Width and maximal height of atlases. [pixels]
+ *  @param heights  Used heights of atlases (output, at least @p count + 1 items).
+ *  @param x        X position on the actual shelf (input and output). [pixels]
+ *  @param y        Y position of the actual shelf (input and output). [pixels]
+ *  @param shelf    Height of the actual shelf (input and output). [pixels]
+ *
+ *  @return Count of used atlases.
+ */
+static int PackAtlases(TTEX_PENDING *pending, int count, int size, int *heights, int *x, int *y, int *shelf)
+{
+  int atlas = 0;
+  int w, h;
+  int i;
+
+  if (!count) return 0;
+
+  qsort(pending, count, sizeof(TTEX_PENDING), ComparePendingHeight);
+
+  for (i = 0; i < count; i++) {
+    w = pending[i].tga.original_width + DAT_ATLAS_PADDING;
+    h = pending[i].tga.original_height + DAT_ATLAS_PADDING;
+
+    // next shelf
+    if (*x + w > size) {
+      *y += *shelf;
+      *x = *shelf = 0;
+    }
+
+    // next atlas
+    if (*y + h > size) {
+      heights[atlas++] = *y;
+      *x = *y = *shelf = 0;
+    }
+
+    pending[i].atlas = atlas;
+    pending[i].x = *x;
+    pending[i].y = *y;
+
+    *x += w;
+    if (h > *shelf) *shelf = h;
+  }
+
+  heights[atlas++] = *y + *shelf;
+
+  return atlas;
+}
+
+
+/**
+ *  Copies decoded image of pending texture to RGBA image.
+ *
+ *  @param p       Pending texture.
+ *  @param dst     Position of the texture in RGBA image.
+ *  @param stride  Width of RGBA image. [pixels]
+ */
+static void CopyPending(TTEX_PENDING *p, unsigned char *dst, int stride)
+{
+  unsigned char *src, *d;
+  int bpp = p->tga.bytesperpixel;
+  int m, n;
+
+  for (m = 0; m < p->tga.original_height; m++) {
+    src = p->tga.data + m * p->tga.width * bpp;
+    d = dst + m * stride * 4;
+
+    for (n = 0; n < p->tga.original_width; n++, src += bpp, d += 4) {
+      switch (bpp) {
+      case 4:
+        d[0] = src[0]; d[1] = src[1]; d[2] = src[2]; d[3] = src[3];
+        break;
+      case 3:
+        d[0] = src[0]; d[1] = src[1]; d[2] = src[2]; d[3] = 255;
+        break;
+      default:
+        d[0] = d[1] = d[2] = src[0]; d[3] = 255;
+        break;
+      }
+    }
+  }
+}
+
+
+/**
+ *  Sets placement of pending texture in the atlas and frees its decoded
+ *  image.
+ */
+static void PlacePending(TTEX_PENDING *p, GLuint gl_id, int width, int height)
+{
+  p->tex->gl_id = gl_id;
+  p->tex->in_atlas = true;
+  p->tex->width = width;
+  p->tex->height = height;
+  p->tex->offset_x = p->x;
+  p->tex->offset_y = p->y;
+
+  free(p->tga.data);
+  p->tga.data = NULL;
+}
+
+
+/**
+ *  Copies pending textures of one atlas to RGBA image and uploads it to
+ *  graphic memory. Decoded images of copied textures are freed.
+ */
+static bool UploadAtlas(GLuint gl_id, TTEX_PENDING *pending, int count, int atlas, int width, int height, int mag_filter, int min_filter)
+{
+  unsigned char *data;
+  TTEX_PENDING *p;
+  int i;
+
+  if (!(data = (unsigned char *)calloc(width * height * 4, 1))) return false;
+
+  for (i = 0; i < count; i++) {
+    p = pending + i;
+    if (p->atlas != atlas) continue;
+
+    CopyPending(p, data + (p->y * width + p->x) * 4, width);
+    PlacePending(p, gl_id, width, height);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, gl_id);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void *)data);
+
+  free(data);
+
+  return true;
+}
+
+
+/**
+ *  Copies pending textures of one atlas to already uploaded atlas of size
+ *  @p size. Only rectangles of the textures are uploaded, free space of the
+ *  atlas is left untouched. Decoded images of copied textures are freed.
+ */
+static bool AddToAtlas(GLuint gl_id, TTEX_PENDING *pending, int count, int atlas, int size)
+{
+  unsigned char *data;
+  TTEX_PENDING *p;
+  int i;
+
+  glBindTexture(GL_TEXTURE_2D, gl_id);
+
+  for (i = 0; i < count; i++) {
+    p = pending + i;
+    if (p->atlas != atlas) continue;
+
+    if (!(data = (unsigned char *)malloc(p->tga.original_width * p->tga.original_height * 4))) return false;
+
+    CopyPending(p, data, p->tga.original_width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, p->x, p->y, p->tga.original_width, p->tga.original_height, GL_RGBA, GL_UNSIGNED_BYTE, (void *)data);
+    PlacePending(p, gl_id, size, size);
+
+    free(data);
+  }
+
+  return true;
+}
+
+
+/**
+ *  Frees decoded images of pending textures.
+ */
+static void FreePending(TTEX_PENDING *pending, int count)
+{
+  for (int i = 0; i < count; i++)
+    if (pending[i].tga.data) free(pending[i].tga.data);
+
+  delete[] pending;
+}
 
-  TGA_INFO tga;
-  int format, iformat;
 
+/**
+ *  Computes average colour of opaque pixels of decoded image. The colour is
+ *  used when map terrain is drawn to radar.
+ */
+static void SetAverageColor(TGUI_TEXTURE *tex, TGA_INFO *tga)
+{
+  unsigned long sum[3] = {0, 0, 0};
+  unsigned long count = 0;
+  unsigned char *src;
+  int bpp = tga->bytesperpixel;
+  int m, n;
+
+  for (m = 0; m < tga->original_height; m++) {
+    src = tga->data + m * tga->width * bpp;
+
+    for (n = 0; n < tga->original_width; n++, src += bpp) {
+      if (bpp == 4 && src[3] < 128) continue;
+
+      if (bpp >= 3) {
+        sum[0] += src[0]; sum[1] += src[1]; sum[2] += src[2];
+      }
+      else {
+        sum[0] += src[0]; sum[1] += src[0]; sum[2] += src[0];
+      }
+      count++;
+    }
+  }
+
+  if (count) for (m = 0; m < 3; m++) tex->average_color[m] = (GLubyte)(sum[m] / count);
+}
+
+
+//=========================================================================
+// Textures decoding
+//=========================================================================
+
+/**
+ *  Texture read from data file. Its TGA image is decoded by one of the
+ *  threads from #decode_pool and the texture is created in graphic memory by
+ *  the main thread, which owns OpenGL context.
+ */
+struct TTEX_DECODE {
+  TGUI_TEXTURE *tex;        //!< Filled texture.
+  int index;                //!< Order of the texture in data file.
+
+  const unsigned char *raw; //!< TGA image in data file mapped to memory.
+  unsigned int raw_size;    //!< Size of #raw. [bytes]
+
+  bool mipmapping;          //!< If mipmaps of the image should be built.
+
+  TGA_INFO tga;             //!< Decoded image.
+  unsigned char *mipmaps;   //!< Mipmaps of the image from level 1 (allocated by malloc), or @c NULL.
+  bool ok;                  //!< If image was decoded successfully.
+  double decode_time;       //!< Time spent by decoding. [seconds]
+};
+
+
+/**
+ *  Auxiliary data of threads decoding textures.
+ */
+class TTEX_DECODER {
+public:
+  TTEX_DECODE *Decode(TTEX_DECODE *job);
+};
+
+
+/** Pool of threads decoding textures. It is @c NULL, when textures are decoded by main thread. */
+static TTHREAD_POOL<TTEX_DECODE, TTEX_DECODE, TTEX_DECODER> *decode_pool = NULL;
+static int decode_threads = 0;    //!< Count of threads in #decode_pool.
+
+
+/**
+ *  Builds mipmaps of decoded image. Every pixel of next level is average of
+ *  2x2 pixels of previous level (same box filter as gluBuild2DMipmaps() uses
+ *  for images with 2^N sizes). Levels are stored one after another, smaller
+ *  size of the last level is 1.
+ *
+ *  @return Mipmaps from level 1 (allocated by malloc), or @c NULL if there is
+ *          not enough memory or the image has only one level.
+ */
+static unsigned char *BuildMipmaps(TGA_INFO *tga)
+{
+  int bpp = tga->bytesperpixel;
+  int w = tga->width, h = tga->height;
+  int next_w, next_h;
+  int dx, dy;                 // offsets of right and upper neighbouring pixel
+  int size = 0;
+  int x, y, k;
+  unsigned char *mipmaps, *dst;
+  const unsigned char *src = tga->data, *p;
+
+  // size of all levels
+  for (next_w = w, next_h = h; next_w > 1 || next_h > 1; size += next_w * next_h * bpp) {
+    next_w = MAX(next_w >> 1, 1);
+    next_h = MAX(next_h >> 1, 1);
+  }
+
+  if (!size || !(mipmaps = (unsigned char *)malloc(size))) return NULL;
+
+  for (dst = mipmaps; w > 1 || h > 1; w = next_w, h = next_h) {
+    next_w = MAX(w >> 1, 1);
+    next_h = MAX(h >> 1, 1);
+    dx = w > 1 ? bpp : 0;
+    dy = h > 1 ? w * bpp : 0;
+
+    for (y = 0; y < next_h; y++) {
+      p = src + (h > 1 ? 2 * y : y) * w * bpp;
+
+      for (x = 0; x < next_w; x++, p += dx + bpp)
+        for (k = 0; k < bpp; k++)
+          *dst++ = (unsigned char)((p[k] + p[k + dx] + p[k + dy] + p[k + dx + dy] + 2) >> 2);
+    }
+
+    src = dst - next_w * next_h * bpp;
+  }
+
+  return mipmaps;
+}
+
+
+/**
+ *  Decodes TGA image of the texture and builds its mipmaps, if they are used.
+ */
+static void DecodeTexture(TTEX_DECODE *job)
+{
+  double start_time = glfwGetTime();
+
+  job->tga.data = NULL;
+  job->mipmaps = NULL;
+  job->ok = tgaReadMemory(job->raw, job->raw_size, &job->tga, TGA_RESCALE) != 0;
+
+  if (job->ok) SetAverageColor(job->tex, &job->tga);
+
+  if (job->ok && job->mipmapping && (job->tga.width > 1 || job->tga.height > 1))
+    job->ok = (job->mipmaps = BuildMipmaps(&job->tga)) != NULL;
+
+  job->decode_time = glfwGetTime() - start_time;
+}
+
+
+/**
+ *  Decodes texture in thread from #decode_pool.
+ *
+ *  @return Decoded texture, which is put to queue of responses.
+ */
+TTEX_DECODE *TTEX_DECODER::Decode(TTEX_DECODE *job)
+{
+  DecodeTexture(job);
+
+  return job;
+}
+
+
+/**
+ *  Creates pool of threads decoding textures. One thread is used for each
+ *  processor, textures are decoded by main thread on one processor computers.
+ */
+static void CreateDecodePool(void)
+{
+  if (decode_pool) return;
+
+  decode_threads = glfwGetNumberOfProcessors();
+  if (decode_threads > DAT_MAX_DECODE_THREADS) decode_threads = DAT_MAX_DECODE_THREADS;
+
+  if (decode_threads > 1)
+    decode_pool = decode_pool->CreateNewThreadPool(decode_threads, THP_QUEUE_SIZE, true);
+
+  if (!decode_pool) decode_threads = 0;
+}
+
+
+/**
+ *  Destroys pool of threads decoding textures.
+ */
+static void DestroyDecodePool(void)
+{
+  if (decode_pool) delete decode_pool;
+
+  decode_pool = NULL;
+  decode_threads = 0;
+}
+
+
+//=========================================================================
+// TTEX_TABLE
+//=========================================================================
+
+/**
+ *  Load textures from *.dat.
+ *
+ *  Data file is mapped to memory and directory of texture groups is read from
+ *  it. Sizes and frames of all textures are known after that, but their images
+ *  are not decoded yet. When @p lazy is @c false, images of all groups are
+ *  loaded immediately by LoadGroups(). Otherwise images of a group are loaded
+ *  when some texture of the group is drawn for the first time, or by
+ *  LoadNextGroup() in spare time. Data file stays mapped until all groups are
+ *  loaded.
+ *
+ *  @param file_name  Filename of the dat file.
+ *  @param pack       If textures could be packed to atlases.
+ *  @param lazy       If images of groups are loaded on first use.
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool TTEX_TABLE::Load(const char *file_name, int mag_filter, int min_filter, bool pack, bool lazy)
+{
   char   header[257];
   T_BYTE version;
-  long   textures_seek = 0;
+  unsigned int textures_seek = 0;
 
   int   tid, gid;   // texture id, group id
   TGUI_TEXTURE *tex;
+  TTEX_ENTRY *entry;
+  TGA_INFO tga;
+  int hlen = strlen(DAT_FILE_HEADER);
+  bool ok = true;
+
+  // values of texture
+  int    atime;
+  T_BYTE ttype, hcount, vcount;
+  int    pointx, pointy;
+
+  double start_time = glfwGetTime();
+
+  Info(LogMsg("Loading textures from '%s'", file_name));
+
+  Clear();
 
-  int    atime;                            // animation time [miliseconds]
-  T_BYTE ttype;                            // texture type
-  T_BYTE hcount;                           // horizontal frames count
-  T_BYTE vcount;                           // vertical frames count
-  int   pointx, pointy;
-  unsigned int dsize;                     // data size
+  if (!file.Open(file_name)) {
+    Error(LogMsg("Can not open file '%s'", file_name));
+    return false;
+  }
+
+  strncpy(dat_name, file_name, DAT_MAX_FILENAME_LENGTH - 1);
+  dat_name[DAT_MAX_FILENAME_LENGTH - 1] = 0;
 
   // file header
-  fread(header, sizeof(char), strlen(DAT_FILE_HEADER), fr);
-  header[strlen(DAT_FILE_HEADER)] = 0;
+  if (!file.Read(header, hlen)) hlen = 0;
+  header[hlen] = 0;
   if (strcmp(header, DAT_FILE_HEADER)) {
-    fclose(fr);
+    file.Close();
     return false;
   }
 
   // file version
-  fread(&version, sizeof(version), 1, fr);
-
-  if (version > DAT_MAX_VERSION || version < DAT_MIN_VERSION) {
+  if (!file.Read(&version, sizeof(version)) || version > DAT_MAX_VERSION || version < DAT_MIN_VERSION) {
     Error(LogMsg("Version of data file '%s' is not allowed", file_name));
-    fclose(fr);
+    file.Close();
     return false;
   }
 
   // seeks
-  fread(&textures_seek, sizeof(textures_seek), 1, fr);
-
-  if (!textures_seek) {
+  if (!file.Read(&textures_seek, sizeof(textures_seek)) || !textures_seek) {
     Error(LogMsg("Data file '%s' does not contain any textures", file_name));
-    fclose(fr);
+    file.Close();
     return false;
   }
 
   glEnable(GL_TEXTURE_2D);
 
+  // atlases are not used with mipmaps
+  this->mag_filter = mag_filter;
+  this->min_filter = min_filter;
+  this->pack = pack && (min_filter == GL_NEAREST || min_filter == GL_LINEAR);
+  atlas_size = DAT_ATLAS_SIZE;
+
+  if (this->pack) {
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &atlas_size);
+    if (atlas_size > DAT_ATLAS_SIZE || atlas_size <= 0) atlas_size = DAT_ATLAS_SIZE;
+  }
+
   // texture groups table
-  fseek(fr, textures_seek, SEEK_SET);
-  fread(&count, sizeof(count), 1, fr);
+  if (!file.Seek(textures_seek) || !file.Read(&count, sizeof(count)) || count < 0) {
+    Error(LogMsg("Error reading texture groups table from '%s'", file_name));
+    file.Close();
+    count = 0;
+    return false;
+  }
 
   if (!(groups = NEW TTEX_GROUP[count])) {
     Critical(LogMsg("Can not allocate memory for texture groups table from '%s'", file_name));
-    fclose(fr);
+    file.Close();
+    count = 0;
     return false;
   }
 
   // texture groups
-  for (gid = 0; gid < count; gid++) {
+  for (gid = 0; ok && gid < count; gid++) {
 
-    fReadString(&groups[gid].name, fr);
-    fread(&groups[gid].count, sizeof(groups[gid].count), 1, fr);
-    
-    if (!(groups[gid].textures = NEW TGUI_TEXTURE[groups[gid].count])) {
+    if (!file.ReadString(&groups[gid].name) || !file.Read(&groups[gid].count, sizeof(groups[gid].count)) || groups[gid].count < 0) {
+      Error(LogMsg("Error reading texture groups table from '%s'", file_name));
+      groups[gid].count = 0;
+      ok = false;
+      break;
+    }
+
+    if (!(groups[gid].textures = NEW TGUI_TEXTURE[groups[gid].count]) || !(groups[gid].entries = NEW TTEX_ENTRY[groups[gid].count])) {
       Critical(LogMsg("Can not allocate memory for texture table from '%s'", file_name));
-      fclose(fr);
-      return false;
+      ok = false;
+      break;
     }
 
     // textures
     for (tid = 0; tid < groups[gid].count; tid++) {
       tex = groups[gid].textures + tid;
-
-      // read values from file
-      fReadString(&tex->id, fr);
-      fread(&hcount, sizeof(hcount), 1, fr);
-      fread(&vcount, sizeof(vcount), 1, fr);     
-      fread(&atime, sizeof(atime), 1, fr);
-      fread(&pointx, sizeof(pointx), 1, fr);
-      fread(&pointy, sizeof(pointy), 1, fr);
-      fread(&ttype, sizeof(ttype), 1, fr);
-      fread(&dsize, sizeof(dsize), 1, fr);
-
-      // generate id for texture
-      glGenTextures(1, &tex->gl_id);
-
-      // read TGA image
-      if (!tgaRead(fr, &tga, TGA_RESCALE)) {
+      entry = groups[gid].entries + tid;
+
+      // read values from file, only header of TGA image is read
+      ok = file.ReadString(&tex->id)
+        && file.Read(&hcount, sizeof(hcount))
+        && file.Read(&vcount, sizeof(vcount))
+        && file.Read(&atime, sizeof(atime))
+        && file.Read(&pointx, sizeof(pointx))
+        && file.Read(&pointy, sizeof(pointy))
+        && file.Read(&ttype, sizeof(ttype))
+        && file.Read(&entry->size, sizeof(entry->size));
+
+      entry->seek = file.Tell();
+      ok = ok && file.Skip(entry->size) && tgaReadInfo(file.GetData(entry->seek), entry->size, &tga, TGA_RESCALE);
+
+      if (!ok) {
         Error(LogMsg("Error reading TGA data from '%s'", file_name));
-        return false;
+        break;
       }
 
-      if (tga.bytesperpixel == 3) format = iformat = GL_RGB;
-      else format = iformat = GL_RGBA;
-
-      // generate texture
-      glBindTexture(GL_TEXTURE_2D, tex->gl_id);
-    
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
-
-      // upload to memory
-      if (min_filter == GL_NEAREST || min_filter == GL_LINEAR)
-        glTexImage2D(GL_TEXTURE_2D, 0, iformat, tga.width, tga.height, 0, format, GL_UNSIGNED_BYTE, (void *)tga.data);
-      else gluBuild2DMipmaps(GL_TEXTURE_2D, iformat, tga.width, tga.height, format, GL_UNSIGNED_BYTE, (void *)tga.data);
-
       // fill texture
       tex->type = (TGUI_TEX_TYPE)ttype;
       tex->point_x = -(GLfloat)pointx;
@@ -225,19 +827,352 @@ bool TTEX_TABLE::Load(const char *file_name, int mag_filter, int min_filter)
 
       tex->frame_time = (double)atime / (1000 * tex->frames_count);
 
-      // free memory
-      free(tga.data);
-      tga.data = NULL;
+      // image will be loaded on first use
+      tex->source = this;
+    } // for tid
+  } // for gid
+
+  if (!ok) {
+    Clear();
+    return false;
+  }
+
+  Info(LogMsg("Read directory of %d texture groups in %.0f ms", count, (glfwGetTime() - start_time) * 1000));
+
+  if (!lazy) return LoadGroups(0, count);
+
+  return true;
+}
+
+
+/**
+ *  Loads images of not loaded groups from @p first to @p last (exclusive).
+ *
+ *  TGA images are decoded in parallel by threads from #decode_pool directly
+ *  from the mapped data file. Decoded images are taken from queue of the pool
+ *  and created in graphic memory by main thread, which owns OpenGL context.
+ *
+ *  Textures which fit into #DAT_ATLAS_SIZE are packed to few large atlases
+ *  to lower the count of texture objects and texture switches while drawing.
+ *  Packing is not used with mipmapping filters, because the mipmaps would
+ *  blend neighbouring textures. While some groups are not loaded, the last
+ *  atlas is created in full size and stays open, so textures of groups
+ *  loaded later are added to its free space, before a new atlas is appended
+ *  to #atlases.
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool TTEX_TABLE::LoadGroups(int first, int last)
+{
+  int format, iformat;
 
+  int   tid, gid;   // texture id, group id
+  TGUI_TEXTURE *tex;
+  TTEX_ENTRY *entry;
+
+  std::vector<TTEX_DECODE *> decoded;      // textures decoded by main thread
+  TTEX_DECODE *job;
+  int submitted = 0;                       // count of textures sent to decoding
+  int done = 0;                            // count of processed decoded textures
+  bool ok = true;
+
+  TTEX_PENDING *pending = NULL;            // textures waiting for atlas
+  int pending_count = 0;
+  int pending_size = 0;
+  int *heights;                            // used heights of atlases
+  GLuint *tmp_atlases;
+  int used_count;                          // count of atlases used by pending textures
+  int new_count;                           // count of new atlases
+  int first_new;                           // index of the first new atlas in pending textures
+  int i;
+
+  double start_time = glfwGetTime();       // timing of the loading
+  double read_time, wait_time = 0, upload_time = 0, decode_time = 0;
+  double time;
+  double decoded_size = 0;                 // size of decoded images [bytes]
+
+  if (first < 0) first = 0;
+  if (last > count) last = count;
+
+  if (!file.IsOpened()) return false;
+
+  CreateDecodePool();
+
+  // send images to decoding
+  for (gid = first; gid < last; gid++) {
+    if (groups[gid].loaded) continue;
+
+    for (tid = 0; tid < groups[gid].count; tid++) {
+      entry = groups[gid].entries + tid;
+
+      job = NEW TTEX_DECODE;
+      job->tex = groups[gid].textures + tid;
+      job->index = submitted;
+      job->raw = file.GetData(entry->seek);
+      job->raw_size = entry->size;
+      job->mipmapping = !(min_filter == GL_NEAREST || min_filter == GL_LINEAR);
+
+      if (decode_pool) decode_pool->AddRequest(job, &TTEX_DECODER::Decode);
+      else {
+        DecodeTexture(job);
+        decoded.push_back(job);
+      }
+      submitted++;
     } // for tid
   } // for gid
 
-  fclose(fr);
+  read_time = glfwGetTime() - start_time;
+
+  // create decoded textures, all textures are taken even on error
+  while (done < submitted) {
+    if (decode_pool) {
+      time = glfwGetTime();
+      while (!(job = decode_pool->TakeOutResponse())) glfwSleep(DAT_DECODE_WAIT);
+      wait_time += glfwGetTime() - time;
+    }
+    else job = decoded[done];
+
+    done++;
+    decode_time += job->decode_time;
+
+    if (ok && !job->ok) {
+      Error(LogMsg("Error reading TGA data from '%s'", dat_name));
+      ok = false;
+    }
+
+    if (!ok) {
+      if (job->tga.data) free(job->tga.data);
+      if (job->mipmaps) free(job->mipmaps);
+      delete job;
+      continue;
+    }
+
+    decoded_size += job->tga.width * job->tga.height * job->tga.bytesperpixel;
+
+    time = glfwGetTime();
+
+    tex = job->tex;
+
+    // texture will be packed to atlas later
+    if (pack && job->tga.original_width + DAT_ATLAS_PADDING <= atlas_size &&
+        job->tga.original_height + DAT_ATLAS_PADDING <= atlas_size)
+    {
+      if (pending_count == pending_size) {
+        TTEX_PENDING *tmp = NEW TTEX_PENDING[pending_size + DAT_PENDING_STEP];
+
+        if (pending) {
+          memcpy(tmp, pending, pending_count * sizeof(TTEX_PENDING));
+          delete[] pending;
+        }
+        pending = tmp;
+        pending_size += DAT_PENDING_STEP;
+      }
+
+      pending[pending_count].tex = tex;
+      pending[pending_count].tga = job->tga;
+      pending[pending_count].index = job->index;
+      pending_count++;
+    }
+
+    else {
+      if (job->tga.bytesperpixel == 3) format = iformat = GL_RGB;
+      else format = iformat = GL_RGBA;
+
+      // generate texture
+      glGenTextures(1, &tex->gl_id);
+      glBindTexture(GL_TEXTURE_2D, tex->gl_id);
+    
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+
+      // upload to memory
+      glTexImage2D(GL_TEXTURE_2D, 0, iformat, job->tga.width, job->tga.height, 0, format, GL_UNSIGNED_BYTE, (void *)job->tga.data);
+
+      // mipmaps built by decoding thread
+      if (job->mipmaps) {
+        unsigned char *level_data = job->mipmaps;
+        int w = job->tga.width, h = job->tga.height;
+
+        for (i = 1; w > 1 || h > 1; i++) {
+          w = MAX(w >> 1, 1);
+          h = MAX(h >> 1, 1);
+
+          glTexImage2D(GL_TEXTURE_2D, i, iformat, w, h, 0, format, GL_UNSIGNED_BYTE, (void *)level_data);
+          level_data += w * h * job->tga.bytesperpixel;
+        }
+
+        free(job->mipmaps);
+      }
+
+      // free memory
+      free(job->tga.data);
+    }
+
+    delete job;
+
+    upload_time += glfwGetTime() - time;
+  }
+
+  // groups are not loaded again, even on error
+  for (gid = first; gid < last; gid++) {
+    if (groups[gid].loaded) continue;
+
+    for (tid = 0; tid < groups[gid].count; tid++) groups[gid].textures[tid].source = NULL;
+
+    delete[] groups[gid].entries;
+    groups[gid].entries = NULL;
+    groups[gid].loaded = true;
+    loaded_count++;
+  }
+
+  // images of all groups are loaded
+  if (loaded_count == count) file.Close();
+
+  if (!ok) {
+    if (pending) FreePending(pending, pending_count);
+    return false;
+  }
+
+  time = glfwGetTime();
+
+  // pack pending textures to atlases
+  if (pending_count) {
+    // textures are decoded in random order, atlases should be always the same
+    qsort(pending, pending_count, sizeof(TTEX_PENDING), ComparePendingIndex);
+
+    // textures are added to free space of the open atlas
+    if (open_atlas < 0) open_x = open_y = open_shelf = 0;
+
+    heights = NEW int[pending_count + 1];
+    used_count = PackAtlases(pending, pending_count, atlas_size, heights, &open_x, &open_y, &open_shelf);
+
+    first_new = open_atlas < 0 ? 0 : 1;
+    new_count = used_count - first_new;
+
+    if (first_new && !AddToAtlas(atlases[open_atlas], pending, pending_count, 0, atlas_size)) {
+      Critical(LogMsg("Can not allocate memory for texture atlas from '%s'", dat_name));
+      open_atlas = -1;
+      delete[] heights;
+      FreePending(pending, pending_count);
+      return false;
+    }
+
+    if (new_count) {
+      tmp_atlases = NEW GLuint[atlas_count + new_count];
+      if (atlases) {
+        memcpy(tmp_atlases, atlases, atlas_count * sizeof(GLuint));
+        delete[] atlases;
+      }
+      atlases = tmp_atlases;
+
+      glGenTextures(new_count, atlases + atlas_count);
+      atlas_count += new_count;
+    }
+
+    for (i = 0; i < new_count; i++) {
+      int height;
+
+      // closest larger 2^N height, open atlas has to have space for next groups
+      if (i == new_count - 1 && loaded_count < count) height = atlas_size;
+      else for (height = 1; height < heights[first_new + i]; height <<= 1);
+
+      if (!UploadAtlas(atlases[atlas_count - new_count + i], pending, pending_count, first_new + i, atlas_size, height, mag_filter, min_filter)) {
+        Critical(LogMsg("Can not allocate memory for texture atlas from '%s'", dat_name));
+        open_atlas = -1;
+        delete[] heights;
+        FreePending(pending, pending_count);
+        return false;
+      }
+    }
+
+    // last atlas stays open until all groups are loaded
+    if (loaded_count == count) open_atlas = -1;
+    else if (new_count) open_atlas = atlas_count - 1;
+
+    Info(LogMsg("Packed %d textures to %d atlases (%d new)", pending_count, used_count, new_count));
+
+    delete[] heights;
+  }
+
+  if (pending) FreePending(pending, pending_count);
+
+  upload_time += glfwGetTime() - time;
+
+  // expected time of next prefetching
+  if (submitted) texture_time = (glfwGetTime() - start_time) / submitted;
+
+  Info(LogMsg("Loaded %d textures in %.0f ms (read %.0f ms, decode %.0f ms at %.0f MB/s on %d threads, waiting %.0f ms, upload %.0f ms)",
+    submitted, (glfwGetTime() - start_time) * 1000, read_time * 1000, decode_time * 1000,
+    decode_time > 0 ? decoded_size / (decode_time * 1024 * 1024) : 0.0, MAX(decode_threads, 1),
+    wait_time * 1000, upload_time * 1000));
 
   return true;
 }
 
 
+/**
+ *  Loads images of the first not loaded group. It is used to prefetch
+ *  textures in spare time, before they are drawn. The group is loaded only
+ *  if it is expected to be loaded in @p time_left, according to the average
+ *  time of loading of previous textures.
+ *
+ *  @param time_left  Time, which could be spent by loading. [seconds]
+ *
+ *  @return @c true if some group was loaded.
+ */
+bool TTEX_TABLE::LoadNextGroup(double time_left)
+{
+  if (loaded_count == count) return false;
+
+  for (int gid = 0; gid < count; gid++)
+    if (!groups[gid].loaded) {
+      if (groups[gid].count * texture_time > time_left) return false;
+
+      LoadGroups(gid, gid + 1);
+      return true;
+    }
+
+  return false;
+}
+
+
+/**
+ *  Loads images of the group of the texture, which is going to be drawn.
+ */
+void TTEX_TABLE::LoadTexture(TGUI_TEXTURE *tex)
+{
+  for (int gid = 0; gid < count; gid++)
+    if (tex >= groups[gid].textures && tex < groups[gid].textures + groups[gid].count) {
+      LoadGroups(gid, gid + 1);
+      break;
+    }
+
+  // texture is not loaded again, even on error
+  tex->source = NULL;
+}
+
+
+/**
+ *  Deletes all groups and atlases and closes data file.
+ */
+void TTEX_TABLE::Clear(void)
+{
+  if (groups) delete[] groups;
+  groups = NULL;
+  count = loaded_count = 0;
+
+  if (atlases) {
+    glDeleteTextures(atlas_count, atlases);
+    delete[] atlases;
+  }
+  atlases = NULL;
+  atlas_count = 0;
+  open_atlas = -1;
+
+  file.Close();
+}
+
+
 //=========================================================================
 // TSND_TABLE
 //=========================================================================
@@ -249,6 +1184,7 @@ bool TSND_TABLE::Load(const char *file_name)
 
   Info(LogMsg("Loading sounds from '%s'", file_name));
 
+  double start_time = glfwGetTime();
   char   header[257];
   T_BYTE version;
   int    sounds_seek = 0;
@@ -374,6 +1310,8 @@ bool TSND_TABLE::Load(const char *file_name)
 
   fclose(fr);
 
+  Info(LogMsg("Loaded %d sounds in %.0f ms", count, (glfwGetTime() - start_time) * 1000));
+
   return true;
 }
 
@@ -415,7 +1353,8 @@ bool LoadData(void)
 {
   Info("Loading data");
 
-  if (fonts_table.Load(DAT_FONTS_NAME, config.tex_mag_filter, config.tex_min_filter) &&
+  // fonts are not packed to atlas, glfont uses the whole texture
+  if (fonts_table.Load(DAT_FONTS_NAME, config.tex_mag_filter, config.tex_min_filter, false) &&
       gui_table.Load(DAT_GUI_NAME, GL_LINEAR, GL_LINEAR) &&
       mouse.LoadData(DAT_CURSORS_NAME)
 #if SOUND
@@ -442,6 +1381,8 @@ bool LoadData(void)
  */
 void DeleteData(void)
 {
+  DestroyDecodePool();
+
   fonts_table.Clear();
   mouse.DeleteData();
   gui_table.Clear();
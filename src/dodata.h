@@ -32,6 +32,9 @@
 // Forvard declarations
 //=========================================================================
 
+class TDAT_FILE;
+
+struct TTEX_ENTRY;
 struct TTEX_GROUP;
 struct TTEX_TABLE;
 
@@ -71,6 +74,11 @@ struct TSND_TABLE;
 
 #define DAT_MAX_FILENAME_LENGTH 256   //!< Maximal length of filename.
 
+#define DAT_ATLAS_SIZE      1024    //!< Maximal width and height of texture atlas. [pixels]
+#define DAT_ATLAS_PADDING   2       //!< Empty space between textures packed in atlas. [pixels]
+
+#define DAT_PREFETCH_TEXTURE_TIME 0.002 //!< Expected time of loading of one texture, before some group is loaded. [seconds]
+
 /** File header of data file. Every data file must start with this. */
 #define DAT_FILE_HEADER     "Dark Oberon data file"
 #define DAT_MAX_VERSION     3       //!< Max. allowed file version.
@@ -122,36 +130,96 @@ typedef char TAUTHOR[20];
 typedef char TVERSION[10];
 
 
+//=========================================================================
+// Data file
+//=========================================================================
+
+/**
+ *  Data file mapped to memory. If the file can not be mapped, it is read to
+ *  memory at once. Values are read from the memory same as by @c fread(), but
+ *  stored images could be decoded directly from the memory without copying.
+ */
+class TDAT_FILE {
+public:
+  bool Open(const char *file_name);
+  void Close(void);
+
+  bool Seek(unsigned int seek);
+  bool Read(void *dest, unsigned int size);
+  bool ReadString(char **txt);
+  bool Skip(unsigned int size);
+
+  /** Returns @c true if the file is opened. */
+  bool IsOpened(void) { return data != NULL; };
+  /** Returns actual position in the file. [bytes] */
+  unsigned int Tell(void) { return pos; };
+  /** Returns pointer to the file data at position @p seek. */
+  const unsigned char *GetData(unsigned int seek) { return data + seek; };
+
+  /** Constructor. */
+  TDAT_FILE(void) { data = NULL; size = pos = 0; mapped = false; mapping = NULL; };
+  /** Destructor. */
+  ~TDAT_FILE(void) { Close(); };
+
+private:
+  const unsigned char *data;  //!< Data of the file.
+  unsigned int size;          //!< Size of the file. [bytes]
+  unsigned int pos;           //!< Actual position in the file. [bytes]
+  bool mapped;                //!< If #data are mapped file, otherwise they are allocated by malloc.
+  void *mapping;              //!< Handle of file mapping (used on Windows only).
+};
+
+
 //=========================================================================
 // Textures table
 //=========================================================================
 
+/**
+ *  Position of TGA image of one texture in data file.
+ */
+struct TTEX_ENTRY {
+  unsigned int seek;        //!< Position of the image in data file. [bytes]
+  unsigned int size;        //!< Size of the image. [bytes]
+};
+
+
 /**
  *  Group of textures. It is used in textures table.
  */
 struct TTEX_GROUP {
   char *name;               //!< Group name.
   TGUI_TEXTURE *textures;   //!< Pointer to table of textures.
+  TTEX_ENTRY *entries;      //!< Positions of images of not loaded textures in data file.
 
   int count;                //!< Count of the textures in the group.
+  bool loaded;              //!< If the textures are created in graphic memory.
 
   /** Constructor. */
-  TTEX_GROUP(void) { name = NULL; textures = NULL; count = 0; };
+  TTEX_GROUP(void) { name = NULL; textures = NULL; entries = NULL; count = 0; loaded = false; };
   /** Destructor */
-  ~TTEX_GROUP(void) { if (name) delete[] name; if (textures) delete[] textures; };
+  ~TTEX_GROUP(void) { if (name) delete[] name; if (textures) delete[] textures; if (entries) delete[] entries; };
 };
 
 
 /**
- *  Table of textures groups.
+ *  Table of textures groups. Directory of groups and sizes of textures are
+ *  read from data file at once, but images of groups could be loaded lazily,
+ *  when some texture of the group is drawn for the first time.
  */
-struct TTEX_TABLE {
+struct TTEX_TABLE: public TGUI_TEXTURE_SOURCE {
   TTEX_GROUP *groups;       //!< Pointer to table of textures groups.
 
   int count;                //!< Count of the groups in the table.
+  int loaded_count;         //!< Count of the groups with loaded textures.
 
-  bool Load(const char *file_name, int mag_filter, int min_filter);
-  void Clear(void) { if (groups) delete[] groups; groups = NULL; count = 0; };
+  GLuint *atlases;          //!< Identifiers of textures atlases shared by textures of all groups.
+  int atlas_count;          //!< Count of the atlases.
+
+  bool Load(const char *file_name, int mag_filter, int min_filter, bool pack = true, bool lazy = false);
+  bool LoadGroups(int first, int last);
+  bool LoadNextGroup(double time_left);
+  void LoadTexture(TGUI_TEXTURE *tex);
+  void Clear(void);
 
   TGUI_TEXTURE *GetTexture(int group_id, int tex_id) { 
     if (tex_id == DAT_TEX_RANDOM) tex_id = GetRandomInt(groups[group_id].count);
@@ -160,9 +228,25 @@ struct TTEX_TABLE {
   };
 
   /** Constructor. */
-  TTEX_TABLE(void) { groups = NULL; count = 0; };
+  TTEX_TABLE(void) { groups = NULL; count = loaded_count = 0; atlases = NULL; atlas_count = 0; *dat_name = 0; open_atlas = -1; texture_time = DAT_PREFETCH_TEXTURE_TIME; };
   /** Destructor */
   ~TTEX_TABLE(void) { Clear(); };
+
+private:
+  TDAT_FILE file;           //!< Data file, which is opened until all groups are loaded.
+  char dat_name[DAT_MAX_FILENAME_LENGTH];   //!< Filename of the data file.
+
+  int mag_filter;           //!< Magnification filter of textures.
+  int min_filter;           //!< Minification filter of textures.
+  bool pack;                //!< If textures are packed to atlases.
+  GLint atlas_size;         //!< Width and maximal height of atlases. [pixels]
+
+  int open_atlas;           //!< Index of the atlas, to which textures of next loaded groups are added, or -1.
+  int open_x;               //!< X position of free space on the actual shelf of #open_atlas. [pixels]
+  int open_y;               //!< Y position of the actual shelf of #open_atlas. [pixels]
+  int open_shelf;           //!< Height of the actual shelf of #open_atlas. [pixels]
+
+  double texture_time;      //!< Average time of loading of one texture. [seconds]
 };
 
 
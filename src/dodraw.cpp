@@ -52,6 +52,7 @@
 
 TFPS fps;             //!< Variable to compute count of frames per second.
 TFPS fps_of_update;   //!< Variable to compute count of frames per second of UpdateFunction().
+TFRAME_TIMES frame_times; //!< Durations of phases of drawn frames.
 
 /** On screen text. Shows text messages in the left corner of the screen. If
  *  #LOG_TO_OST is @c 1, log messages are also displayed. */
@@ -78,7 +79,6 @@ bool show_all = false;          //!< Displays whole map without warfog and unvis
 void TPROJECTION::SetProjection(TPROJECTION_TYPE projection)
 {
   GLfloat zoom = 1.0f;
-  GLfloat dx;
 
   type = projection;
 
@@ -106,20 +106,6 @@ void TPROJECTION::SetProjection(TPROJECTION_TYPE projection)
     width = PRO_DEF_WIDTH * zoom;
     height = PRO_DEF_HEIGHT * zoom;
     break;
-
-  case PRO_RENDER_RADAR:
-    dx = ((GLfloat)(map.height) * DRW_RADAR_TEX_SIZE) / (map.height + map.width);
-    zoom = DAT_MAPEL_DIAGONAL_SIZE * map.height / dx;
-
-    left = -dx * zoom;
-    right = (config.scr_width) * zoom + left;
-
-    top = config.scr_height * zoom / 2;
-    bottom = 0;
-
-    width = config.scr_width * zoom;
-    height = config.scr_height * zoom / 2;
-    break;
   }
 
   Update();
@@ -188,6 +174,61 @@ void TFPS::Reset(void)
 }
 
 
+//=========================================================================
+// TFRAME_TIMES
+//=========================================================================
+
+/**
+ *  Ends actual phase of frame and starts the next one.
+ *
+ *  @param phase  Phase which was just finished.
+ */
+void TFRAME_TIMES::Mark(TFRAME_PHASE phase)
+{
+  double now = glfwGetTime();
+
+  sum[phase] += now - phase_start;
+  phase_start = now;
+}
+
+
+/**
+ *  Computes new averages of phases durations.
+ *  This computation is done only after standart time shift stored in DRW_FPS_DELAY.
+ *
+ *  @param time_shift  Time shift from the last update.
+ */
+void TFRAME_TIMES::Update(double time_shift)
+{
+  frames_count++;
+  shift_time += time_shift;
+
+  if (shift_time >= DRW_FPS_DELAY) {
+    for (int i = 0; i < FT_PHASES_COUNT; i++) {
+      ms[i] = sum[i] * 1000 / frames_count;
+      sum[i] = 0.0;
+    }
+
+    // reset counters
+    shift_time = 0.0;
+    frames_count = 0;
+  }
+}
+
+
+/**
+ *  Resets phases information.
+ */
+void TFRAME_TIMES::Reset(void)
+{
+  for (int i = 0; i < FT_PHASES_COUNT; i++) sum[i] = ms[i] = 0.0;
+
+  shift_time = 0.0;
+  frames_count = 0;
+  phase_start = glfwGetTime();
+}
+
+
 //=========================================================================
 // Drawing
 //=========================================================================
@@ -224,6 +265,13 @@ void DrawFps(void)
     glColor3f(1.0f, 1.0f, 1.0f);
     sprintf(txt, "FPS: %d", fps.fps);
     glfPrint(font0, 10.0f, config.scr_height - 23.0f, txt, true);
+
+    // frame time breakdown
+    glColor3f(0.7f, 0.7f, 0.7f);
+    sprintf(txt, "Frame: input %.1f, units %.1f, map %.1f, draw %.1f, swap %.1f ms",
+      frame_times.ms[FT_INPUT], frame_times.ms[FT_UNITS], frame_times.ms[FT_MAP],
+      frame_times.ms[FT_DRAW], frame_times.ms[FT_SWAP]);
+    glfPrint(font0, 10.0f, config.scr_height - 49.0f, txt, true);
   }
 }
 
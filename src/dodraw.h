@@ -37,6 +37,8 @@
 
 struct TPROJECTION;
 struct TFPS;
+struct TFRAME_TIMES;
+struct TRADAR_DOT;
 struct TOST_TEXT;
 class TOST;
 struct TPANEL_INFO;
@@ -53,15 +55,26 @@ class TTIME;
 #define DRW_MIN_RADAR_SIZE    1.0f    //!< Minimal size of units squares on radar.
 #define DRW_RADAR_SIZE        170     //!< Size of radar window. [pixels]
 #define DRW_RADAR_TEX_SIZE    256     //!< Size of radar texture. [pixels]
+#define DRW_RADAR_TILE_SIZE   16      //!< Size of tiles of radar units texture, which are painted and uploaded separately. [pixels]
+#define DRW_RADAR_TILES       (DRW_RADAR_TEX_SIZE / DRW_RADAR_TILE_SIZE)   //!< Count of tiles in one row of radar units texture.
 #define DRW_BUILD_MAP_ALPHA   0.3f    //!< Alpha channel for drawing build map.
 #define DRW_CURSOR_HEIGHT     24      //!< Height of mouse cursor. [pixels]
 
 
+// phases of one game frame
+enum TFRAME_PHASE {
+  FT_INPUT,                           //!< Gui, mouse, selection and map moving.
+  FT_UNITS,                           //!< Graphics update of players units.
+  FT_MAP,                             //!< Graphics update of map, radar and scheme.
+  FT_DRAW,                            //!< Drawing of the game.
+  FT_SWAP,                            //!< Swapping of buffers and polling events.
+  FT_PHASES_COUNT
+};
+
 // projections
 enum TPROJECTION_TYPE {
   PRO_MENU,                           //!< Projection used for menu and for panels in game.
-  PRO_GAME,                           //!< Projection used for drawing game (map).
-  PRO_RENDER_RADAR                    //!< Projection used for rendering radar textures (map).
+  PRO_GAME                            //!< Projection used for drawing game (map).
 };
 
 #define PRO_DEF_WIDTH     1024.0f     //!< Default projection width.
@@ -161,6 +174,39 @@ struct TFPS {
   void Reset(void);
 };
 
+/**
+ *  Structure to compute average duration of phases of drawn frames.
+ */
+struct TFRAME_TIMES {
+  int frames_count;                   //!< Actual count of frames.
+  double shift_time;                  //!< Time shift.
+  double phase_start;                 //!< Time when actual phase started. [seconds]
+  double sum[FT_PHASES_COUNT];        //!< Summary duration of phases. [seconds]
+
+  double ms[FT_PHASES_COUNT];         //!< Average duration of phases in one frame. [miliseconds]
+
+  /** Starts measuring of the first phase of frame. */
+  void Start(void) { phase_start = glfwGetTime(); };
+  void Mark(TFRAME_PHASE phase);
+  void Update(double time_shift);
+  void Reset(void);
+};
+
+/**
+ *  Dot of one unit in radar units texture.
+ */
+struct TRADAR_DOT {
+  GLfloat x, y;           //!< Position of the unit. [mapels]
+  GLfloat w, h;           //!< Size of the dot. [radar pixels]
+  const GLubyte *color;   //!< Colour of the dot (RGB). The dot is not painted, if it is @c NULL.
+
+  int x1, y1;             //!< Left top texel covered by the dot.
+  int x2, y2;             //!< Right bottom texel covered by the dot (exclusive).
+
+  /** Constructor. */
+  TRADAR_DOT(void) { x = y = w = h = 0; color = NULL; x1 = y1 = x2 = y2 = 0; };
+};
+
 /**
  *  One text item (text line) in TOST.
  */
@@ -285,6 +331,11 @@ class TTIME {
       
     }
 
+    /** Returns time left to the end of frame of expected duration @p
+     *  expected_frame_duration. [seconds] */
+    double GetFrameTimeLeft (double expected_frame_duration)
+      { return expected_frame_duration - (glfwGetTime() - time_actual); }
+
     //! Updates #time_actual and #time_shift.
     void Update ()
     {
@@ -309,6 +360,7 @@ class TTIME {
 
 extern TFPS fps;
 extern TFPS fps_of_update;
+extern TFRAME_TIMES frame_times;
 extern TOST* ost;
 extern TGUI* gui;
 
@@ -51,7 +51,10 @@
 #endif
 
 #include <cmath>
+#include <list>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "dofollower.h"
 #include "doengine.h"
@@ -62,6 +65,7 @@
 #include "doleader.h"
 #include "doselection.h"
 #include "dosimpletypes.h"
+#include "dosnapshot.h"
 #include "doevents.h"
 #include "glgui.h"
 #include "dopool.h"
@@ -264,12 +268,15 @@ static void ProcessPlayerArray (TNET_MESSAGE *msg);
 static void ProcessHello (TNET_MESSAGE *msg);
 static void ProcessPingRequest (TNET_MESSAGE *msg);
 static void ProcessPingReply (TNET_MESSAGE *msg);
+static void ProcessClockPing (TNET_MESSAGE *msg);
 static void ProcessConnectRequest (TNET_MESSAGE *msg);
 static void ProcessChangeRace (TNET_MESSAGE *msg);
 static void ProcessChatMessage (TNET_MESSAGE *msg);
 static void ProcessSynchronise (TNET_MESSAGE *msg);
 static void ProcessAllowProcessFunction (TNET_MESSAGE *msg);
 static void ProcessDisconnect (TNET_MESSAGE *msg);
+static void ProcessWorldHash (TNET_MESSAGE *msg);
+static void ProcessSnapshot (TNET_MESSAGE *msg);
 
 static void ProcessDisconnect (int player_id);
 static void OnDisconnect (in_addr address, in_port_t port);
@@ -369,6 +376,70 @@ bool won_lose = false;
  *  structures. This is used by synchronisation of start of the game. */
 bool leader_ready;
 
+/**
+ *  Hashes of regions of world taken at some time.
+ */
+struct TWORLD_SNAPSHOT {
+  T_BYTE player_id;             //!< Player, whose computer took the hashes.
+  int time;                     //!< Time of hashes. [seconds]
+  bool sent;                    //!< If hashes were sent to remote computers.
+  std::vector<unsigned> hashes; //!< Hashes of regions.
+  std::vector<bool> skipped;    //!< Regions changed by late events, which can not be compared.
+};
+
+/**
+ *  Hash of one unit of region of world.
+ */
+struct TWORLD_UNIT_HASH {
+  T_BYTE player_id;             //!< Owner of the unit.
+  int unit_id;                  //!< Identificator of the unit.
+  unsigned hash;                //!< Hash of the unit.
+};
+
+/**
+ *  Request for units of regions or units of one region received from remote
+ *  computer.
+ */
+struct TWORLD_REGIONS {
+  T_BYTE player_id;             //!< Player, whose computer sent the message.
+  std::vector<int> regions;     //!< Requested regions or the region of units.
+  std::vector<TWORLD_UNIT_HASH> units;  //!< Units of the region.
+};
+
+// batches of events
+static GLFWmutex batch_mutex = NULL;    //!< Mutex for batches of events.
+static bool batch_open = false;         //!< If events are collected into batches.
+static TNET_MESSAGE *batch_message = NULL;  //!< Collected events. Only one batch is open, so events are sent in order.
+static int batch_destination;           //!< Destination of #batch_message (player or all_players).
+static double batch_base_time;          //!< Base time of events in #batch_message.
+
+// world hash exchange
+static GLFWmutex world_mutex = NULL;    //!< Mutex for received hashes of world.
+static int world_hash_time = 0;         //!< Time when next hashes of world will be taken. [seconds]
+static std::list<TWORLD_SNAPSHOT> world_snapshots;          //!< Hashes of world taken here. Used only by update thread.
+static std::list<TWORLD_SNAPSHOT> world_remote_snapshots;   //!< Hashes of world received from remote computers.
+static std::list<TWORLD_SNAPSHOT> world_pending_snapshots;  //!< Received hashes of world waiting for local ones. Used only by update thread.
+static std::list<TWORLD_REGIONS> world_requests;            //!< Received requests for units of regions.
+static std::list<TWORLD_REGIONS> world_region_units;        //!< Received units of regions.
+static unsigned long world_compared = 0;      //!< Count of compared hashes of world.
+static unsigned long world_differed = 0;      //!< Count of hashes of world which differ from remote ones.
+static unsigned long world_regions_differed = 0;  //!< Count of differing regions.
+
+// clock synchronisation
+static GLFWmutex clock_mutex = NULL;    //!< Mutex for estimators of clocks.
+static TCLOCK_SYNC clock_syncs[PL_MAX_PLAYERS];  //!< Estimators of clocks of computers of remote players.
+static double clock_ping_time = 0;      //!< Time of next ping of remote computers. [seconds]
+static double clock_slew_time = 0;      //!< Time of next correction of local clock. [seconds]
+static double clock_slewed = 0;         //!< Sum of corrections of local clock. [seconds]
+static double clock_max_input_delay = 0;  //!< Maximal chosen input delay. [seconds]
+
+// world snapshots
+static int snapshot_id = 0;             //!< Identificator of last snapshot sent to remote computers.
+static std::list<T_BYTE> snapshot_requests;             //!< Players, who requested snapshot. Guarded by #world_mutex.
+static TSNAPSHOT snapshot_received[PL_MAX_PLAYERS];     //!< Snapshots received from computers of players. Guarded by #world_mutex.
+static int snapshot_received_ids[PL_MAX_PLAYERS];       //!< Identificators of #snapshot_received.
+static int snapshot_request_times[PL_MAX_PLAYERS];      //!< Times of last requests for snapshot. Used only by update thread. [seconds]
+
 /**
  *  Specifies, whether we need to redraw the screen. This saves a lot of
  *  processor time. This is used only in menu. The reason, why it is not used in
@@ -420,6 +491,7 @@ static void connecting_in_menu_thread (void *_data) {
     gui->ShowMessageBox (message.c_str (), GUI_MB_CANCEL);
 
     // Start follower. It will listen on config.net_server_port.
+    event_codec = EVN_CODEC_RAW;
     host = follower = NEW TFOLLOWER (follower_in_queue_size, config.net_server_port, follower_out_queue_size, ip_address, port);
     connected = true;
 
@@ -432,6 +504,8 @@ static void connecting_in_menu_thread (void *_data) {
     host->RegisterExtendedFunction (net_protocol_synchronise, ProcessAllowProcessFunction);
     host->RegisterExtendedFunction (net_protocol_ping, ProcessPingReply);
     host->RegisterExtendedFunction (net_protocol_disconnect, ProcessDisconnect);
+    host->RegisterExtendedFunction (net_protocol_world_hash, ProcessWorldHash);
+    host->RegisterExtendedFunction (net_protocol_snapshot, ProcessSnapshot);
 
     host->RegisterOnDisconnect (OnDisconnect);
 
@@ -638,7 +712,7 @@ bool TMAP_INFO_LIST::LoadMapInfo(bool basic, const char *file_name){
   char id_name[1024], full_name[1024], schemes_name[1024]; //buffer for name, fullname and schemes ids
 
   sprintf(mapname, "%s%s", MAP_PATH, file_name);
-  if (!(cf = OpenConfFile(mapname)))
+  if (!(cf = OpenConfFile(mapname, true)))
     return false;
   
   if (basic){ // fill list of basic info of map
@@ -673,7 +747,7 @@ bool TMAP_INFO_LIST::LoadMapInfo(bool basic, const char *file_name){
     if (ok) {
       char pom[1024];
       sprintf(pom, "%s%s%s", SCH_PATH, map_ext_info.scheme_id_name, ".sch");
-      if ((cf_sch = OpenConfFile(pom))) {
+      if ((cf_sch = OpenConfFile(pom, true))) {
         cf_sch->ReadStr(map_ext_info.scheme_name, const_cast<char*>("name"), const_cast<char*>(map_ext_info.scheme_id_name), false);
         CloseConfFile(cf_sch);
         cf_sch = NULL;
@@ -728,7 +802,7 @@ bool TMAP_INFO_LIST::LoadMapInfo(bool basic, const char *file_name){
         
         // find out if file race.rac exists and read full name and scheme from it
         sprintf(racname, "%s%s/%s.rac", RAC_PATH, id_name, id_name);
-        if (!(cf_rac = OpenConfFile(racname))){
+        if (!(cf_rac = OpenConfFile(racname, true))){
           ok_race = false;
           warn_race = true;
         }
@@ -804,6 +878,70 @@ bool TMAP_INFO_LIST::LoadMapInfo(bool basic, const char *file_name){
 }
 
 
+/**
+ *  Fills basic info of map from index of maps, if the map file was not changed
+ *  since it was indexed. Otherwise the map file is parsed. Basic info of the map
+ *  is written into new index in both cases.
+ *
+ *  @param file_name    Map filename.
+ *  @param index        Index of maps, or @c NULL.
+ *  @param new_index    New index of maps.
+ *  @param parsed_count Count of parsed map files.
+ */
+bool TMAP_INFO_LIST::LoadIndexedMapInfo(const char *file_name, TCONF_FILE *index, TCONF_FILE *new_index, int *parsed_count){
+
+  TFILE_NAME mapname;
+  TMAP_BASIC_INFO_NODE * basic_node = NULL;
+  long size, time;
+  int index_size, index_time;
+  char *section = const_cast<char*>(file_name);
+
+  sprintf(mapname, "%s%s", MAP_PATH, file_name);
+  if (!GetFileStamp(mapname, &size, &time))
+    return false;
+
+  // use index entry, if the map was not changed
+  if (index && index->GetActSection()->GetSection(section)) {
+    index->SelectSection(section, false);
+
+    if (index->ReadInt(&index_size, const_cast<char*>("size"), -1) && index_size == int(size)
+      && index->ReadInt(&index_time, const_cast<char*>("time"), -1) && index_time == int(time)) {
+      if (!(basic_node = NEW TMAP_BASIC_INFO_NODE)){
+        Critical("Can not allocate memory for menu structures.");
+        return false;
+      }
+
+      strcpy(basic_node->id_name, file_name);
+      if (index->ReadStr(basic_node->name, const_cast<char*>("name"), const_cast<char*>(""), true)) {
+        basic_node->next = map_list;
+        map_list = basic_node;
+      }
+      else {
+        delete basic_node;
+        basic_node = NULL;
+      }
+    }
+
+    index->UnselectSection();
+  }
+
+  // map was changed, parse it
+  if (!basic_node) {
+    (*parsed_count)++;
+    if (!LoadMapInfo(true, file_name)) return false;
+    basic_node = map_list;
+  }
+
+  new_index->SelectSection(section, false);
+  new_index->WriteInt(const_cast<char*>("size"), int(size));
+  new_index->WriteInt(const_cast<char*>("time"), int(time));
+  new_index->WriteStr(const_cast<char*>("name"), basic_node->name);
+  new_index->UnselectSection();
+
+  return true;
+}
+
+
 /**
  *  Delete list of maps.
  */
@@ -972,9 +1110,22 @@ bool TMAP_INFO_LIST::LoadMapList() {
 
   bool ok = true;
   char * extension;
+  TCONF_FILE *index = NULL, *new_index;
+  long size, time;
+  int maps_count = 0, parsed_count = 0;
+  double start_time = glfwGetTime();
 
   ClearMapList(); // if exists any list of maps, clears it
 
+  // open old index of maps and create new one, which contains only existing maps
+  if (GetFileStamp(MAP_INDEX_FILE, &size, &time)) index = OpenConfFile(MAP_INDEX_FILE);
+
+  if (!(new_index = CreateConfFile(MAP_INDEX_FILE))) {
+    CloseConfFile(index);
+    return false;
+  }
+  new_index->WriteLine(const_cast<char*>("# Index of maps. It is updated automatically."));
+
 #ifdef WINDOWS  // on WINDOWS systems
   _finddata_t file;         // file in directory 
   long file_handler;        // handler to first find file in directory
@@ -988,13 +1139,17 @@ bool TMAP_INFO_LIST::LoadMapList() {
 #ifdef WINDOWS  // on WINDOWS systems
   if ((file_handler = _findfirst((string(MAP_PATH) + "*.map").c_str(), &file)) == -1L) {  // gets handler to first file with mask "*.map"
     _findclose(file_handler); // no file exists
+    CloseConfFile(index);
+    CloseConfFile(new_index);
     return ok;
   }
 
   while (ok && next_file) { // loop over all files and directories id MAP_PATH diectory
     extension = strrchr(file.name, '.');
-    if (!(strcmp(extension, ".map"))) // filter in _findfirst is not correct (accepts files *.map*)
-      ok = LoadMapInfo(true, file.name);  // loads map info for each *.map file
+    if (!(strcmp(extension, ".map"))) { // filter in _findfirst is not correct (accepts files *.map*)
+      ok = LoadIndexedMapInfo(file.name, index, new_index, &parsed_count);  // loads map info for each *.map file
+      maps_count++;
+    }
     next_file = (!_findnext(file_handler, &file));
   }
 
@@ -1003,6 +1158,8 @@ bool TMAP_INFO_LIST::LoadMapList() {
 #else  // on UNIX systems
   if (!(dir = opendir (MAP_PATH))) {
     Critical( LogMsg ("%s%s%s", "Error opening directory '", MAP_PATH, "'"));
+    CloseConfFile(index);
+    CloseConfFile(new_index);
     return false;
   }
 
@@ -1011,14 +1168,21 @@ bool TMAP_INFO_LIST::LoadMapList() {
     {
       extension = strrchr(entry->d_name, '.');
       /** XXX: TU TO ASI MOZE SPADNUT, ked tam bude subor bez pripony **/
-      if (!(strcmp(extension, ".map")))
-        ok = LoadMapInfo(true, entry->d_name); // loads map info for each *.map file
+      if (!(strcmp(extension, ".map"))) {
+        ok = LoadIndexedMapInfo(entry->d_name, index, new_index, &parsed_count); // loads map info for each *.map file
+        maps_count++;
+      }
     }
   }
   
   closedir(dir);
 #endif
 
+  CloseConfFile(index);
+  CloseConfFile(new_index);   // save new index
+
+  Info(LogMsg("Map list loaded in %.0f ms, %d of %d maps parsed", (glfwGetTime() - start_time) * 1000, parsed_count, maps_count));
+
   SortMapList ();
 
   return ok;
@@ -1333,7 +1497,8 @@ bool CreateGame()
 
   player_array.AddLocalPlayer (config.player_name);
 
-  // start leader
+  // start leader, codec of events is lowered by followers
+  event_codec = EVN_CODEC_VERSION;
   host = NEW TLEADER (leader_in_queue_size, config.net_server_port,
                       leader_out_queue_size);
 
@@ -1344,6 +1509,8 @@ bool CreateGame()
   host->RegisterExtendedFunction (net_protocol_synchronise, ProcessSynchronise);
   host->RegisterExtendedFunction (net_protocol_ping, ProcessPingRequest);
   host->RegisterExtendedFunction (net_protocol_disconnect, ProcessDisconnect);
+  host->RegisterExtendedFunction (net_protocol_world_hash, ProcessWorldHash);
+  host->RegisterExtendedFunction (net_protocol_snapshot, ProcessSnapshot);
 
   host->RegisterOnDisconnect (OnDisconnect);
 
@@ -2471,6 +2638,19 @@ void GameBuildOnTooltip(TGUI_BOX *sender)
 // Game Key Callbacks
 //========================================================================
 
+/**
+ *  Wakes units of all players, their graphics is updated in the next frame.
+ *  It is used after active area or visibility of units is changed.
+ */
+static void WakeAllUnits(void)
+{
+  int pl_count = player_array.GetCount();
+
+  for (int i = 0; i < pl_count; i++)
+    if (players[i]->active) players[i]->WakeAllUnits();
+}
+
+
 /**
  *  This function is called when we are in game (#state == #ST_GAME) and a key
  *  was pressed.
@@ -2571,6 +2751,7 @@ void GameOnKeyDown(int key)
 
   case 'G':
     reduced_drawing = !reduced_drawing;
+    WakeAllUnits();
     break;
 
   /*
@@ -2656,6 +2837,7 @@ void GameOnKeyDown(int key)
 
   case GLFW_KEY_BACKSPACE:
     show_all = !show_all;
+    WakeAllUnits();
     break;
 #endif
 
@@ -2808,6 +2990,12 @@ static void ProcessConnectRequest (TNET_MESSAGE *msg) {
   msg->Extract (&port, sizeof (port));
   player_name = msg->ExtractString ();
 
+  /* Older followers don't send their codec of events and understand only raw
+   * events. */
+  T_BYTE codec = (msg->GetRemaining () > 0) ? msg->ExtractByte () : EVN_CODEC_RAW;
+  if (codec < event_codec)
+    event_codec = codec;
+
   player_array.Lock ();
 
   dynamic_cast<TLEADER *>(host)->ConnectFollower (msg->GetAddress (), port, msg->GetFileDescriptor ());
@@ -2912,6 +3100,10 @@ static void ProcessPlayerArray (TNET_MESSAGE *msg) {
     player_array.SetRaceIdName (i, race);
   }
 
+  /* Codec of events used in the game. Older leaders don't send it. */
+  T_BYTE codec = (msg->GetRemaining () > 0) ? msg->ExtractByte () : EVN_CODEC_RAW;
+  event_codec = MIN(codec, EVN_CODEC_VERSION);
+
   UpdatePlayersAndMenu ();
 
   /* Start the game if requested. */
@@ -2998,6 +3190,13 @@ static void ProcessHello (TNET_MESSAGE *msg) {
   double time;
   msg->Extract (&time, sizeof time);
 
+  /* Codec of events offered by leader. Final codec is sent with the array of
+   * players. */
+  if (msg->GetRemaining () > 0) {
+    T_BYTE codec = msg->ExtractByte ();
+    event_codec = MIN(codec, EVN_CODEC_VERSION);
+  }
+
   /* Time shift is time that the request took divided by 2 (we beleive both
    * parts of the communication took the same amount of time. */
   double time_shift = (received - follower->GetPingRequestTime ()) / 2;
@@ -3021,6 +3220,12 @@ static void ProcessPingRequest (TNET_MESSAGE *msg) {
     return;
   }
 
+  if (msg->GetSubtype () >= net_ping_clock_request) {
+    ProcessClockPing (msg);
+    giant->Unlock ();
+    return;
+  }
+
   TLEADER *leader = dynamic_cast<TLEADER *>(host);
 
   double request_time;
@@ -3039,6 +3244,12 @@ static void ProcessPingReply (TNET_MESSAGE *msg) {
     return;
   }
 
+  if (msg->GetSubtype () >= net_ping_clock_request) {
+    ProcessClockPing (msg);
+    giant->Unlock ();
+    return;
+  }
+
   double received = glfwGetTime ();
 
   TFOLLOWER *follower = dynamic_cast<TFOLLOWER *>(host);
@@ -3064,6 +3275,44 @@ static void ProcessPingReply (TNET_MESSAGE *msg) {
   giant->Unlock ();
 }
 
+/**
+ *  Answers request for time of this computer or adds reply to the estimator
+ *  of clock of remote computer. Target player of the request is echoed in
+ *  the reply, so the reply is assigned to the right estimator.
+ *
+ *  @note giant must be locked.
+ */
+static void ProcessClockPing (TNET_MESSAGE *msg) {
+  if (!clock_mutex) return;
+
+  double received = glfwGetTime ();
+  double sent, remote;
+
+  T_BYTE player_id = msg->ExtractByte ();
+  T_BYTE target_id = msg->ExtractByte ();
+  msg->Extract (&sent, sizeof sent);
+
+  if (msg->GetSubtype () == net_ping_clock_request) {
+    TNET_MESSAGE *reply = pool_net_messages->GetFromPool ();
+    reply->Init_send (net_protocol_ping, net_ping_clock_reply);
+    reply->PackByte (T_BYTE (player_array.GetMyPlayerID ()));
+    reply->PackByte (target_id);
+    reply->Pack (&sent, sizeof sent);
+    reply->Pack (&received, sizeof received);
+
+    host->SendMessage (reply, player_id);
+    return;
+  }
+
+  msg->Extract (&remote, sizeof remote);
+
+  if (target_id < player_array.GetCount () && player_array.IsRemote (target_id)) {
+    glfwLockMutex (clock_mutex);
+    clock_syncs[target_id].AddSample (sent, remote, received);
+    glfwUnlockMutex (clock_mutex);
+  }
+}
+
 static void ProcessChatMessage (TNET_MESSAGE *msg) {
   giant->Lock ();
 
@@ -3091,6 +3340,36 @@ static void ProcessChatMessage (TNET_MESSAGE *msg) {
   giant->Unlock ();
 }
 
+/**
+ *  Translates time stamp of received event from clock of the computer, which
+ *  sent it, to local clock. The sender is not always the owner of the unit,
+ *  requests are sent to the owner by other computers. Events of remote units
+ *  are delayed by input delay, so they arrive before their time stamp.
+ *
+ *  @param event   Received event.
+ *  @param sender  Player of the computer, which sent the event.
+ */
+static void TranslateNetEvent (TEVENT *event, int sender) {
+  int owner = event->GetPlayerID ();
+
+  if (!clock_mutex || sender >= player_array.GetCount () || !player_array.IsRemote (sender))
+    return;
+
+  glfwLockMutex (clock_mutex);
+
+  double shift = 0;
+
+  if (owner < player_array.GetCount () && player_array.IsRemote (owner))
+    shift += event_input_delay;
+
+  if (clock_syncs[sender].IsValid ())
+    shift -= clock_syncs[sender].GetOffset (glfwGetTime ());
+
+  glfwUnlockMutex (clock_mutex);
+
+  event->SetTimeStamp (event->GetTimeStamp () + shift);
+}
+
 static void ProcessNetEvent (TNET_MESSAGE *msg) {
   giant->Lock ();
 
@@ -3099,15 +3378,184 @@ static void ProcessNetEvent (TNET_MESSAGE *msg) {
     return;
   }
 
-  int size = msg->GetSize();
-  char data[128];
+  T_BYTE sender = msg->ExtractByte ();
+  int size = msg->GetRemaining ();
+  char data[max_net_message_size];
   TEVENT *pevent;
 
+  if (size > max_net_message_size) {
+    Warning ("Received event message is too long");
+    giant->Unlock ();
+    return;
+  }
+
   msg->Extract(data, size);
-  
-  pevent = pool_events->GetFromPool();
-  pevent->DelinearizeEvent(data, size);
-  queue_events->PutEvent(pevent);
+
+  if (msg->GetSubtype () == EVN_CODEC_COMPACT) {
+    double base_time;
+    int pos, len;
+
+    if (size < int(sizeof(base_time))) {
+      Warning ("Received event message is too short");
+      giant->Unlock ();
+      return;
+    }
+
+    memcpy(&base_time, data, sizeof(base_time));
+
+    for (pos = sizeof(base_time); pos < size; pos += len) {
+      pevent = pool_events->GetFromPool();
+
+      if (!(len = pevent->DelinearizeEventCompact(data + pos, size - pos, base_time))) {
+        Warning ("Received event message is corrupted");
+        pool_events->PutToPool(pevent);
+        break;
+      }
+
+      TranslateNetEvent(pevent, sender);
+      NoteReceivedNetEvent(pevent);
+      queue_events->PutEvent(pevent);
+    }
+  }
+  else {
+    pevent = pool_events->GetFromPool();
+    pevent->DelinearizeEvent(data, size);
+    TranslateNetEvent(pevent, sender);
+    NoteReceivedNetEvent(pevent);
+    queue_events->PutEvent(pevent);
+  }
+
+  giant->Unlock ();
+}
+
+static void ProcessWorldHash (TNET_MESSAGE *msg) {
+  giant->Lock ();
+
+  if (host == NULL || !world_mutex) {
+    giant->Unlock ();
+    return;
+  }
+
+  TWORLD_SNAPSHOT snapshot;
+  TWORLD_REGIONS regions;
+  std::vector<T_BYTE> skipped;
+  int count, region;
+
+  switch (msg->GetSubtype ()) {
+  case net_world_hash_regions:
+    snapshot.player_id = msg->ExtractByte ();
+    snapshot.sent = true;
+    msg->Extract (&snapshot.time, sizeof snapshot.time);
+    msg->Extract (&count, sizeof count);
+
+    if (count < 0 || msg->GetRemaining () != count * int(sizeof (unsigned)) + (count + 7) / 8) {
+      Warning ("Received hash of world is corrupted");
+      break;
+    }
+
+    snapshot.hashes.resize (count);
+    snapshot.skipped.resize (count);
+    skipped.resize ((count + 7) / 8);
+
+    if (count) {
+      msg->Extract (&snapshot.hashes[0], count * sizeof (unsigned));
+      msg->Extract (&skipped[0], int(skipped.size ()));
+    }
+
+    for (int i = 0; i < count; i++)
+      snapshot.skipped[i] = (skipped[i / 8] & (1 << (i % 8))) != 0;
+
+    glfwLockMutex (world_mutex);
+    world_remote_snapshots.push_back (snapshot);
+    glfwUnlockMutex (world_mutex);
+    break;
+
+  case net_world_hash_request:
+    regions.player_id = msg->ExtractByte ();
+    count = msg->ExtractByte ();
+
+    for (int i = 0; i < count && msg->GetRemaining () >= int(sizeof region); i++) {
+      msg->Extract (&region, sizeof region);
+      regions.regions.push_back (region);
+    }
+
+    glfwLockMutex (world_mutex);
+    world_requests.push_back (regions);
+    glfwUnlockMutex (world_mutex);
+    break;
+
+  case net_world_hash_units:
+    regions.player_id = msg->ExtractByte ();
+    msg->Extract (&region, sizeof region);
+    msg->Extract (&count, sizeof count);
+    regions.regions.push_back (region);
+
+    for (int i = 0; i < count && msg->GetRemaining () >= int(1 + sizeof (int) + sizeof (unsigned)); i++) {
+      TWORLD_UNIT_HASH unit;
+
+      unit.player_id = msg->ExtractByte ();
+      msg->Extract (&unit.unit_id, sizeof unit.unit_id);
+      msg->Extract (&unit.hash, sizeof unit.hash);
+      regions.units.push_back (unit);
+    }
+
+    glfwLockMutex (world_mutex);
+    world_region_units.push_back (regions);
+    glfwUnlockMutex (world_mutex);
+    break;
+  }
+
+  giant->Unlock ();
+}
+
+static void ProcessSnapshot (TNET_MESSAGE *msg) {
+  giant->Lock ();
+
+  if (host == NULL || !world_mutex) {
+    giant->Unlock ();
+    return;
+  }
+
+  std::vector<T_BYTE> chunk;
+  int id, size, index, chunk_size;
+  T_BYTE player_id = msg->ExtractByte ();
+
+  if (player_id >= player_array.GetCount ()) {
+    giant->Unlock ();
+    return;
+  }
+
+  switch (msg->GetSubtype ()) {
+  case net_snapshot_request:
+    glfwLockMutex (world_mutex);
+    snapshot_requests.push_back (player_id);
+    glfwUnlockMutex (world_mutex);
+    break;
+
+  case net_snapshot_chunk:
+    msg->Extract (&id, sizeof id);
+    msg->Extract (&size, sizeof size);
+    msg->Extract (&index, sizeof index);
+
+    chunk_size = msg->GetRemaining ();
+    chunk.resize (MAX (chunk_size, 1));
+    msg->Extract (&chunk[0], chunk_size);
+
+    glfwLockMutex (world_mutex);
+
+    if (snapshot_received_ids[player_id] != id) {
+      snapshot_received[player_id].Clear ();
+      snapshot_received_ids[player_id] = id;
+    }
+
+    if (!snapshot_received[player_id].AddChunk (size, index, &chunk[0], chunk_size)) {
+      Warning ("Received chunk of snapshot is corrupted");
+      snapshot_received[player_id].Clear ();
+    }
+
+    glfwUnlockMutex (world_mutex);
+    break;
+  }
 
   giant->Unlock ();
 }
@@ -4447,6 +4895,614 @@ void Menu()
 }
 
 
+//========================================================================
+// Batches of events
+//========================================================================
+
+/**
+ *  Starts collecting of events sent to remote computers. Consecutive events
+ *  with the same destination are sent in one message.
+ */
+static void BeginEventBatch()
+{
+  glfwLockMutex(batch_mutex);
+  batch_open = true;
+  glfwUnlockMutex(batch_mutex);
+}
+
+
+/**
+ *  Sends collected events.
+ *
+ *  @note batch_mutex must be locked.
+ */
+static void FlushEventBatch()
+{
+  if (!batch_message) return;
+
+  host->SendMessage(batch_message, batch_destination);
+  batch_message = NULL;
+}
+
+
+/**
+ *  Sends all collected events and stops collecting.
+ */
+static void EndEventBatch()
+{
+  glfwLockMutex(batch_mutex);
+
+  FlushEventBatch();
+
+  batch_open = false;
+
+  glfwUnlockMutex(batch_mutex);
+}
+
+
+/**
+ *  Adds event to the batch, if events are collected. All events of the batch
+ *  are linearized relatively to base time of the first one, so only the first
+ *  message of the batch carries full time. The batch is sent, when the event
+ *  has other destination, because receivers drop events older than the ones
+ *  they have already got and so the events must be sent in order.
+ *
+ *  @param event Event which will be sent.
+ *  @param player_id Identificator of player. (all_players is to all)
+ *  @return @c false if events are not collected, event must be sent alone.
+ */
+bool SendBatchEvent(TEVENT *event, int player_id)
+{
+  int size = 0;
+  char data[128];
+
+  if (!batch_mutex || event_codec != EVN_CODEC_COMPACT) return false;
+
+  glfwLockMutex(batch_mutex);
+
+  if (!batch_open) {
+    glfwUnlockMutex(batch_mutex);
+    return false;
+  }
+
+  if (batch_message && batch_destination != player_id)
+    FlushEventBatch();
+
+  // message does not fit into small frame, send it and start next one
+  if (batch_message) {
+    size = event->LinearizeEventCompact(data, batch_base_time);
+    if (batch_message->GetSize() + size > max_net_message_size)
+      FlushEventBatch();
+  }
+
+  if (!batch_message) {
+    batch_destination = player_id;
+    batch_base_time = event->GetTimeStamp();
+    batch_message = pool_net_messages->GetFromPool();
+    batch_message->Init_send(net_protocol_event, EVN_CODEC_COMPACT);
+    batch_message->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+    batch_message->Pack(&batch_base_time, sizeof(batch_base_time));
+    size = event->LinearizeEventCompact(data, batch_base_time);
+
+    net_events_messages++;
+    net_events_bytes += sizeof(T_BYTE) + sizeof(batch_base_time);
+  }
+
+  batch_message->Pack(data, size);
+
+  net_events_count++;
+  net_events_bytes += size;
+
+  glfwUnlockMutex(batch_mutex);
+
+  return true;
+}
+
+
+//========================================================================
+// World hash exchange
+//========================================================================
+
+/**
+ *  Returns true, if hashes of world are exchanged with remote computers.
+ *  Hashes are sent in large messages, which are understood only by hosts
+ *  supporting compact codec of events.
+ */
+static bool IsWorldHashExchanged()
+{
+  return host && config.net_world_hash_period > 0 && event_codec == EVN_CODEC_COMPACT;
+}
+
+
+/**
+ *  Marks regions around the unit as changed by late event in all hashes of
+ *  world taken after the time stamp of the event.
+ *
+ *  @param event  Processed event.
+ *  @param unit   Unit of the event.
+ *  @note process_mutex must be locked.
+ */
+static void CheckLateWorldEvent(TEVENT *event, TPLAYER_UNIT *unit)
+{
+  std::list<TWORLD_SNAPSHOT>::iterator iter;
+  TPOSITION_3D pos = unit->GetPosition();
+  int x, y;
+
+  if (world_snapshots.empty() || event->GetTimeStamp() >= world_snapshots.back().time || !map.IsInMap(pos))
+    return;
+
+  for (iter = world_snapshots.begin(); iter != world_snapshots.end(); iter++) {
+    if (iter->sent || iter->time <= event->GetTimeStamp()) continue;
+
+    // unit could move to neighbouring region
+    for (x = MAX(0, pos.x - MAP_AREA_SIZE); x <= MIN(map.width - 1, pos.x + MAP_AREA_SIZE); x += MAP_AREA_SIZE)
+      for (y = MAX(0, pos.y - MAP_AREA_SIZE); y <= MIN(map.height - 1, pos.y + MAP_AREA_SIZE); y += MAP_AREA_SIZE)
+        iter->skipped[map.world_hash.GetRegion(x, y)] = true;
+  }
+}
+
+
+/**
+ *  Takes hashes of world of all periods, which ended before the time.
+ *
+ *  @param time  Time stamp of the next processed event or actual time.
+ *  @note process_mutex must be locked.
+ */
+static void TakeWorldHashes(double time)
+{
+  if (!IsWorldHashExchanged()) return;
+
+  while (world_hash_time <= time) {
+    TWORLD_SNAPSHOT snapshot;
+
+    snapshot.player_id = T_BYTE(player_array.GetMyPlayerID());
+    snapshot.time = world_hash_time;
+    snapshot.sent = false;
+    snapshot.hashes.resize(map.world_hash.GetRegionsCount());
+    snapshot.skipped.assign(map.world_hash.GetRegionsCount(), false);
+
+    if (!snapshot.hashes.empty())
+      map.world_hash.GetRegions(&snapshot.hashes[0]);
+
+    world_snapshots.push_back(snapshot);
+    world_hash_time += config.net_world_hash_period;
+  }
+}
+
+
+/**
+ *  Sends hashes of units of the regions to remote computer.
+ */
+static void SendWorldRegionUnits(TWORLD_REGIONS &request)
+{
+  std::vector<TPLAYER_UNIT *> units;
+  TNET_MESSAGE *msg;
+  int count;
+  unsigned hash;
+
+  for (unsigned r = 0; r < request.regions.size(); r++) {
+    units.clear();
+
+    for (int i = 0; i < player_array.GetCount(); i++)
+      players[i]->GetRegionUnits(request.regions[r], units);
+
+    msg = pool_net_messages->GetFromPool();
+    msg->Init_send(net_protocol_world_hash, net_world_hash_units);
+    msg->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+    msg->Pack(&request.regions[r], sizeof(request.regions[r]));
+
+    count = int(units.size());
+    msg->Pack(&count, sizeof(count));
+
+    for (int i = 0; i < count; i++) {
+      int unit_id = units[i]->GetUnitID();
+
+      hash = units[i]->GetWorldHash();
+      msg->PackByte(units[i]->GetPlayerID());
+      msg->Pack(&unit_id, sizeof(unit_id));
+      msg->Pack(&hash, sizeof(hash));
+    }
+
+    host->SendMessage(msg, request.player_id);
+  }
+}
+
+
+/**
+ *  Compares units of region with units received from remote computer and logs
+ *  the differences.
+ */
+static void DiffWorldRegion(TWORLD_REGIONS &remote)
+{
+  std::map<std::pair<int, int>, unsigned> remote_units;
+  std::map<std::pair<int, int>, unsigned>::iterator found;
+  std::vector<TPLAYER_UNIT *> units;
+  TMAP_UNIT *unit;
+  TPOSITION_3D pos;
+  int region = remote.regions[0];
+  int differences = 0;
+
+  for (unsigned i = 0; i < remote.units.size(); i++)
+    remote_units[std::make_pair(int(remote.units[i].player_id), remote.units[i].unit_id)] = remote.units[i].hash;
+
+  for (int i = 0; i < player_array.GetCount(); i++)
+    players[i]->GetRegionUnits(region, units);
+
+  for (unsigned i = 0; i < units.size(); i++) {
+    unit = static_cast<TMAP_UNIT *>(units[i]);
+    pos = unit->GetPosition();
+    found = remote_units.find(std::make_pair(int(unit->GetPlayerID()), unit->GetUnitID()));
+
+    if (found == remote_units.end()) {
+      Warning(LogMsg("Region %d: unit %d of player %d at [%d,%d,%d] is not there on computer of player %d", region, unit->GetUnitID(), unit->GetPlayerID(), pos.x, pos.y, pos.segment, remote.player_id));
+      differences++;
+      continue;
+    }
+
+    if (found->second != unit->GetWorldHash()) {
+      Warning(LogMsg("Region %d: unit %d of player %d at [%d,%d,%d] with life %d and state %u differs on computer of player %d", region, unit->GetUnitID(), unit->GetPlayerID(), pos.x, pos.y, pos.segment, int(unit->GetLife()), unit->GetState(), remote.player_id));
+      differences++;
+    }
+
+    remote_units.erase(found);
+  }
+
+  for (found = remote_units.begin(); found != remote_units.end(); found++) {
+    Warning(LogMsg("Region %d: unit %d of player %d is only on computer of player %d", region, found->first.second, found->first.first, remote.player_id));
+    differences++;
+  }
+
+  if (!differences)
+    Info(LogMsg("Region %d: no differences from computer of player %d any more", region, remote.player_id));
+}
+
+
+/**
+ *  Compares hashes of world with hashes received from remote computer. Units
+ *  of differing regions are requested from the remote computer.
+ */
+static void CompareWorldHashes(TWORLD_SNAPSHOT &local, TWORLD_SNAPSHOT &remote)
+{
+  std::vector<int> differing;
+
+  if (local.hashes.size() != remote.hashes.size()) {
+    Warning(LogMsg("Hash of world of player %d has %d regions instead of %d", remote.player_id, int(remote.hashes.size()), int(local.hashes.size())));
+    return;
+  }
+
+  world_compared++;
+
+  for (unsigned i = 0; i < local.hashes.size(); i++) {
+    if (!local.skipped[i] && !remote.skipped[i] && local.hashes[i] != remote.hashes[i])
+      differing.push_back(i);
+  }
+
+  if (differing.empty()) return;
+
+  world_differed++;
+  world_regions_differed += differing.size();
+
+  Warning(LogMsg("Hash of world at %d s differs from computer of player %d in %d regions", local.time, remote.player_id, int(differing.size())));
+
+  // ask for units of first differing regions
+  if (int(differing.size()) > MAP_WORLD_HASH_DIFF)
+    differing.resize(MAP_WORLD_HASH_DIFF);
+
+  TNET_MESSAGE *msg = pool_net_messages->GetFromPool();
+  msg->Init_send(net_protocol_world_hash, net_world_hash_request);
+  msg->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+  msg->PackByte(T_BYTE(differing.size()));
+
+  for (unsigned i = 0; i < differing.size(); i++)
+    msg->Pack(&differing[i], sizeof(differing[i]));
+
+  host->SendMessage(msg, remote.player_id);
+
+  // ask for snapshot of units of players of the remote computer
+  if (config.net_world_snapshot && local.time >= snapshot_request_times[remote.player_id] + SNP_REQUEST_PERIOD) {
+    snapshot_request_times[remote.player_id] = local.time;
+
+    msg = pool_net_messages->GetFromPool();
+    msg->Init_send(net_protocol_snapshot, net_snapshot_request);
+    msg->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+
+    host->SendMessage(msg, remote.player_id);
+  }
+}
+
+
+/**
+ *  Sends hashes of world, which can not be changed by late events any more,
+ *  compares them with received ones and answers requests for units of
+ *  regions.
+ *
+ *  @param time  Actual time.
+ *  @note process_mutex must be locked.
+ */
+static void ExchangeWorldHashes(double time)
+{
+  std::list<TWORLD_SNAPSHOT>::iterator iter, local;
+  std::list<TWORLD_REGIONS> requests, region_units;
+  std::vector<T_BYTE> skipped;
+  TNET_MESSAGE *msg;
+  int count;
+
+  if (!IsWorldHashExchanged()) return;
+
+  // send settled hashes
+  for (iter = world_snapshots.begin(); iter != world_snapshots.end(); iter++) {
+    if (iter->sent || time < iter->time + MAP_WORLD_HASH_SETTLE) continue;
+
+    count = int(iter->hashes.size());
+    skipped.assign((count + 7) / 8, 0);
+    for (int i = 0; i < count; i++)
+      if (iter->skipped[i]) skipped[i / 8] |= 1 << (i % 8);
+
+    msg = pool_net_messages->GetFromPool();
+    msg->Init_send(net_protocol_world_hash, net_world_hash_regions);
+    msg->PackByte(iter->player_id);
+    msg->Pack(&iter->time, sizeof(iter->time));
+    msg->Pack(&count, sizeof(count));
+    if (count) {
+      msg->Pack(&iter->hashes[0], count * sizeof(unsigned));
+      msg->Pack(&skipped[0], int(skipped.size()));
+    }
+
+    host->SendMessage(msg);
+    iter->sent = true;
+  }
+
+  while (!world_snapshots.empty() && world_snapshots.front().time + MAP_WORLD_HASH_KEEP < time)
+    world_snapshots.pop_front();
+
+  glfwLockMutex(world_mutex);
+  world_pending_snapshots.splice(world_pending_snapshots.end(), world_remote_snapshots);
+  requests.swap(world_requests);
+  region_units.swap(world_region_units);
+  glfwUnlockMutex(world_mutex);
+
+  // compare received hashes with settled local ones
+  for (iter = world_pending_snapshots.begin(); iter != world_pending_snapshots.end(); ) {
+    for (local = world_snapshots.begin(); local != world_snapshots.end() && local->time != iter->time; local++);
+
+    if (local != world_snapshots.end() && local->sent) {
+      CompareWorldHashes(*local, *iter);
+      iter = world_pending_snapshots.erase(iter);
+    }
+    else if (iter->time + MAP_WORLD_HASH_KEEP < time)
+      iter = world_pending_snapshots.erase(iter);
+    else iter++;
+  }
+
+  for (std::list<TWORLD_REGIONS>::iterator req = requests.begin(); req != requests.end(); req++)
+    SendWorldRegionUnits(*req);
+
+  for (std::list<TWORLD_REGIONS>::iterator reg = region_units.begin(); reg != region_units.end(); reg++)
+    DiffWorldRegion(*reg);
+}
+
+
+/**
+ *  Sends snapshot of local players to computers, which requested it, and
+ *  restores snapshots received from remote computers. Received snapshot is
+ *  kept until #MAP_WORLD_HASH_SETTLE seconds after its capture, so events
+ *  sent before the capture are processed before the restore.
+ *
+ *  @param time  Actual time of the game.
+ *  @note process_mutex must be locked.
+ */
+static void ExchangeWorldSnapshots(double time)
+{
+  std::list<T_BYTE> requests;
+  std::list<T_BYTE>::iterator iter;
+  TSNAPSHOT snapshot;
+  TNET_MESSAGE *msg;
+  const T_BYTE *chunk;
+  int size, chunk_size;
+
+  if (!IsWorldHashExchanged()) return;
+
+  glfwLockMutex(world_mutex);
+
+  requests.swap(snapshot_requests);
+
+  for (int i = 0; i < player_array.GetCount(); i++) {
+    if (!snapshot_received[i].IsComplete()) continue;
+    if (time < snapshot_received[i].GetTime() + MAP_WORLD_HASH_SETTLE) continue;
+
+    Info(LogMsg("Restoring snapshot %d from computer of player %d", snapshot_received_ids[i], i));
+    snapshot_received[i].Restore();
+    snapshot_received[i].Clear();
+  }
+
+  glfwUnlockMutex(world_mutex);
+
+  if (requests.empty()) return;
+
+  snapshot.Capture(time);
+  snapshot_id++;
+  size = snapshot.GetSize();
+
+  requests.sort();
+  requests.unique();
+
+  for (iter = requests.begin(); iter != requests.end(); iter++) {
+    for (int i = 0; i < snapshot.GetChunksCount(); i++) {
+      chunk = snapshot.GetChunk(i, &chunk_size);
+
+      msg = pool_net_messages->GetFromPool();
+      msg->Init_send(net_protocol_snapshot, net_snapshot_chunk);
+      msg->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+      msg->Pack(&snapshot_id, sizeof(snapshot_id));
+      msg->Pack(&size, sizeof(size));
+      msg->Pack(&i, sizeof(i));
+      msg->Pack(chunk, chunk_size);
+
+      host->SendMessage(msg, *iter);
+    }
+
+    Info(LogMsg("Snapshot %d sent to computer of player %d in %d chunks", snapshot_id, *iter, snapshot.GetChunksCount()));
+  }
+}
+
+
+/**
+ *  Starts exchange of hashes of world at the time.
+ */
+static void StartWorldHashes(double time)
+{
+  int period = MAX(config.net_world_hash_period, 1);
+
+  world_hash_time = (int(floor(time)) / period + 1) * period;
+  world_snapshots.clear();
+  world_pending_snapshots.clear();
+  world_compared = world_differed = world_regions_differed = 0;
+
+  for (int i = 0; i < PL_MAX_PLAYERS; i++)
+    snapshot_request_times[i] = -int(SNP_REQUEST_PERIOD);
+}
+
+
+/**
+ *  Stops exchange of hashes of world and logs statistics of comparisons.
+ */
+static void StopWorldHashes()
+{
+  world_snapshots.clear();
+  world_pending_snapshots.clear();
+
+  glfwLockMutex(world_mutex);
+  world_remote_snapshots.clear();
+  world_requests.clear();
+  world_region_units.clear();
+  snapshot_requests.clear();
+  for (int i = 0; i < PL_MAX_PLAYERS; i++)
+    snapshot_received[i].Clear();
+  glfwUnlockMutex(world_mutex);
+
+  if (world_compared)
+    Info(LogMsg("World hashes: %lu compared, %lu differed in %lu regions", world_compared, world_differed, world_regions_differed));
+}
+
+
+//========================================================================
+// Clock synchronisation
+//========================================================================
+
+/**
+ *  Pings computers of remote players, moves local clock towards the clock
+ *  of leader and chooses input delay from round trip times. Clock of leader
+ *  is the shared timeline of the game, which followers set when connecting.
+ *  The clock is corrected in small steps, so time never jumps.
+ *
+ *  @param time  Actual time.
+ *  @note process_mutex must be locked.
+ */
+static void SyncClocks(double time)
+{
+  TNET_MESSAGE *msg;
+  double correction, delay = 0;
+  int i;
+
+  if (!host || !clock_mutex) return;
+
+  if (time >= clock_ping_time) {
+    for (i = 0; i < player_array.GetCount(); i++) {
+      if (!player_array.IsRemote(i)) continue;
+
+      double sent = glfwGetTime();
+
+      msg = pool_net_messages->GetFromPool();
+      msg->Init_send(net_protocol_ping, net_ping_clock_request);
+      msg->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+      msg->PackByte(T_BYTE(i));
+      msg->Pack(&sent, sizeof(sent));
+
+      host->SendMessage(msg, i);
+    }
+
+    clock_ping_time = time + EVN_CLOCK_PING_PERIOD;
+  }
+
+  if (time < clock_slew_time) return;
+
+  clock_slew_time = time + EVN_CLOCK_SLEW_PERIOD;
+
+  glfwLockMutex(clock_mutex);
+
+  // hyper player is owned by leader
+  if (player_array.IsRemote(0) && clock_syncs[0].IsValid()) {
+    correction = clock_syncs[0].GetOffset(time);
+
+    if (fabs(correction) > EVN_CLOCK_PRECISION) {
+      correction = MAX(-EVN_CLOCK_SLEW, MIN(EVN_CLOCK_SLEW, correction));
+
+      glfwSetTime(glfwGetTime() + correction);
+      clock_slewed += fabs(correction);
+
+      for (i = 0; i < player_array.GetCount(); i++)
+        clock_syncs[i].Shift(correction);
+    }
+  }
+
+  // input delay covers one way trip with its variation to the farthest computer
+  if (config.net_input_delay) {
+    for (i = 0; i < player_array.GetCount(); i++)
+      if (player_array.IsRemote(i) && clock_syncs[i].IsValid())
+        delay = MAX(delay, clock_syncs[i].GetRtt() / 2 + 2 * clock_syncs[i].GetRttVariation());
+
+    event_input_delay = MIN(delay, config.net_input_delay / 1000.0);
+    clock_max_input_delay = MAX(clock_max_input_delay, event_input_delay);
+  }
+
+  glfwUnlockMutex(clock_mutex);
+}
+
+
+/**
+ *  Starts synchronisation of clocks at the time.
+ */
+static void StartClocks(double time)
+{
+  glfwLockMutex(clock_mutex);
+
+  for (int i = 0; i < PL_MAX_PLAYERS; i++)
+    clock_syncs[i].Clear();
+
+  event_input_delay = 0;
+  glfwUnlockMutex(clock_mutex);
+
+  clock_ping_time = clock_slew_time = time;
+  clock_slewed = clock_max_input_delay = 0;
+}
+
+
+/**
+ *  Stops synchronisation of clocks and logs estimated clocks of remote
+ *  computers.
+ */
+static void StopClocks()
+{
+  double time = glfwGetTime();
+
+  glfwLockMutex(clock_mutex);
+
+  for (int i = 0; i < player_array.GetCount(); i++) {
+    if (!player_array.IsRemote(i) || !clock_syncs[i].IsValid()) continue;
+
+    Info(LogMsg("Clock of player %d: offset %.2f ms, drift %.1f ppm, round trip %.1f ms +- %.1f ms", i,
+      1000 * clock_syncs[i].GetOffset(time), 1000000 * clock_syncs[i].GetDrift(),
+      1000 * clock_syncs[i].GetRtt(), 1000 * clock_syncs[i].GetRttVariation()));
+  }
+
+  event_input_delay = 0;
+  glfwUnlockMutex(clock_mutex);
+
+  if (clock_slewed > 0 || clock_max_input_delay > 0)
+    Info(LogMsg("Local clock corrected by %.2f ms in total, input delay %.1f ms at most", 1000 * clock_slewed, 1000 * clock_max_input_delay));
+}
+
+
 /**
  *  Update thread function. It is runned by glfwCreateThread() from Game().
  *
@@ -4476,20 +5532,30 @@ static void GLFWCALL ProcessFunction(void *arg)
 
   Info ("Update: Running");
 
+  StartWorldHashes (glfwGetTime ());
+  StartClocks (glfwGetTime ());
+
   while (started) {
     time.Update ();
     fps_of_update.Update (time.GetShift ());
 
+    // events sent while processing events of this cycle are sent together
+    BeginEventBatch();
+
     // cycle which get from queue all events with time_stamp <= actual time.
     while ((queue_events->GetFirstEventTimeStamp() != -1) && (queue_events->GetFirstEventTimeStamp() <= time.GetActual())) {
       process_mutex->Lock();
 
+      // periods of world hash which ended before the event must be closed first
+      TakeWorldHashes(queue_events->GetFirstEventTimeStamp());
+
       act_event = queue_events->GetFirstEvent();
 
       act_unit = ((TPLAYER_UNIT *)players[act_event->GetPlayerID()]->hash_table_units.GetUnitPointer(act_event->GetUnitID()));
 
       // process event only in case that unit exists
       if (act_unit) {
+        if (IsWorldHashExchanged()) CheckLateWorldEvent(act_event, act_unit);
       
 
         // local (not remote) units
@@ -4509,10 +5575,15 @@ static void GLFWCALL ProcessFunction(void *arg)
         
         // units of not local players must be checked for right order of events according to time stamp
         if (player_array.IsRemote(act_event->GetPlayerID())) {
+          net_events_remote++;
+          if ((act_unit->last_event_time_stamp > act_event->GetTimeStamp()) && (act_event->GetEvent() < RQ_FIRST))
+            net_events_out_of_order++;
+
           // test if timestamp of las processed event is smaller than actual event time stamp
           if ((act_unit->last_event_time_stamp <= act_event->GetTimeStamp()) || (act_event->GetEvent() >= RQ_FIRST)){
             
             if (act_event->GetEvent() < RQ_FIRST) act_unit->last_event_time_stamp = act_event->GetTimeStamp();
+            act_unit->last_sync_time_stamp = MAX(act_unit->last_sync_time_stamp, act_event->GetTimeStamp());
 
             #if DEBUG_EVENTS
               if (act_unit->pevent)
@@ -4531,6 +5602,15 @@ static void GLFWCALL ProcessFunction(void *arg)
       pool_events->PutToPool(act_event);
     }
 
+    process_mutex->Lock();
+    TakeWorldHashes(time.GetActual());
+    ExchangeWorldHashes(time.GetActual());
+    ExchangeWorldSnapshots(time.GetActual());
+    SyncClocks(time.GetActual());
+    process_mutex->Unlock();
+
+    EndEventBatch();
+
     // sleep that long, we get 50 fps
     time.SleepToGetExpectedFrameDuration (0.02);
   }
@@ -4562,8 +5642,11 @@ bool StartGame(double stime)
 
   // create mutexes
   delete_mutex  = glfwCreateMutex ();
+  if (!batch_mutex) batch_mutex = glfwCreateMutex ();
+  if (!world_mutex) world_mutex = glfwCreateMutex ();
+  if (!clock_mutex) clock_mutex = glfwCreateMutex ();
 
-  if (!delete_mutex) {
+  if (!delete_mutex || !batch_mutex || !world_mutex || !clock_mutex) {
     Critical ("Could not create mutex");
     goto error;
   }
@@ -4685,6 +5768,9 @@ void StopGame()
   // wait for Update thread to finish
   glfwWaitThread(process_thread, GLFW_WAIT);
 
+  if (world_mutex) StopWorldHashes();
+  if (clock_mutex) StopClocks();
+
   // delete selection
   if (selection) {
     delete selection;
@@ -4711,6 +5797,8 @@ void StopGame()
 
   // queue is only cleared (it is destroyed in the end of program)
   queue_events->Clear();
+
+  LogNetEventsStats();
 }
 
 /**
@@ -4762,6 +5850,7 @@ void Game(void)
   CreateGameGUI();
 
   fps.Reset();
+  frame_times.Reset();
   mouse.ResetCursor();
   gui->MouseMove(GLfloat(mouse.x), GLfloat(mouse.y));  // update gui under mouse
   myself->update_info = true;                         // update myself information on panels
@@ -4779,12 +5868,14 @@ void Game(void)
   while (state == ST_GAME) 
   {
     clock.Update();
+    frame_times.Start();
 
     // gui environment
     gui->Update(clock.GetShift());
 
     // infos
     fps.Update(clock.GetShift());
+    frame_times.Update(clock.GetShift());
     ost->Update(clock.GetActual());
 
     // mouse (MUST be called before selection update)
@@ -4801,18 +5892,25 @@ void Game(void)
 
     // active area
     map.UpdateActiveArea();
+    frame_times.Mark(FT_INPUT);
 
     if (!reduced_drawing) {
-      // units and buildings (have to be called after updating active area)
+      // units and buildings (have to be called after updating active area),
+      // units could come into the changed active area
+      if (map.active_area.IsChanged()) WakeAllUnits();
+
       int pl_count = player_array.GetCount();
       for (i = 0; i < pl_count; i++) 
       {
         if (players[i]->active) players[i]->UpdateGraphics(clock.GetShift());
       }
+      frame_times.Mark(FT_UNITS);
+
       // map graphics (with sorting of units -> have to be called after updating units)
       map.UpdateGraphics(clock.GetShift());
 
       scheme.UpdateGraphics(clock.GetShift ());
+      frame_times.Mark(FT_MAP);
     }
 
     // myself information
@@ -4820,13 +5918,18 @@ void Game(void)
 
     // draw game
     DrawGame();
+    frame_times.Mark(FT_DRAW);
 
     // change buffers
     glfwSwapBuffers();
     gui->PollEvents();
+    frame_times.Mark(FT_SWAP);
     
     if (!glfwGetWindowParam(GLFW_OPENED)) state = ST_QUIT;
 
+    // load textures of races in spare time of the frame
+    if (config.tex_prefetch) PrefetchRacesTextures(clock.GetFrameTimeLeft(config.pr_expected_frame_duration));
+
     // sleep to get expected frame duration
     clock.SleepToGetExpectedFrameDuration (config.pr_expected_frame_duration);
 
@@ -197,6 +197,9 @@ public:
   // Loads Info. If basic is true load basic info, else load ext. map info of map with given name.
   bool LoadMapInfo(bool basic, const char *file_name); 
 
+  // Loads basic info from index of maps, if the map was not changed, and writes it into new index.
+  bool LoadIndexedMapInfo(const char *file_name, TCONF_FILE *index, TCONF_FILE *new_index, int *parsed_count);
+
   // Delete list of maps information.
   void ClearMapList();
 
@@ -424,6 +427,9 @@ void SetOrderVisibility(bool vis);
 // preparing methods
 void PrepareSounds();
 
+// network methods
+bool SendBatchEvent(TEVENT *event, int player_id);
+
 
 //========================================================================
 // Variables
@@ -29,6 +29,7 @@
 //========================================================================
 // Included files
 //========================================================================
+#include <math.h>
 #include <stdio.h>
 
 #include "doevents.h"
@@ -46,6 +47,19 @@ TPOOL<TSEL_NODE> * pool_sel_node;
 TPOOL<TNEAREST_INFO> *pool_nearest_info;
 TQUEUE_EVENTS * queue_events;
 
+T_BYTE event_codec = EVN_CODEC_RAW;   //!< Codec used for events sent through network. Negotiated with remote hosts.
+unsigned long net_events_count = 0;   //!< Count of events sent through network.
+unsigned long net_events_bytes = 0;   //!< Size of linearized events sent through network. [bytes]
+unsigned long net_events_messages = 0;  //!< Count of messages with events sent through network.
+unsigned long net_events_remote = 0;        //!< Count of events of remote units taken from queue.
+unsigned long net_events_out_of_order = 0;  //!< Count of events of remote units ignored because they were older than the last processed event.
+double event_input_delay = 0;         //!< Delay added to time stamps of received events of remote units. Chosen from round trip times. [seconds]
+
+static unsigned long net_events_received = 0;   //!< Count of events received from network.
+static unsigned long net_events_late = 0;       //!< Count of received events with time stamp in the past.
+static double net_events_lateness = 0;          //!< Sum of lateness of late events. [seconds]
+static double net_events_max_lateness = 0;      //!< Maximal lateness of received event. [seconds]
+
 /**
  *  Mutex to assure safe data sharing between graphic thread and update thread.
  */
@@ -236,6 +250,198 @@ void TEVENT::DelinearizeEvent(char *char_event, int lin_event_len)
 }
 
 
+/**
+ *  Writes @p value as zig-zag varint (7 bits in each byte, highest bit set if
+ *  more bytes follow).
+ *
+ *  @return Count of written bytes.
+ */
+static int PackVarint(char *buf, long long value)
+{
+  unsigned long long v = (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+  int size = 0;
+
+  while (v >= 0x80) {
+    buf[size++] = static_cast<char>((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  buf[size++] = static_cast<char>(v);
+
+  return size;
+}
+
+/**
+ *  Reads zig-zag varint written by PackVarint().
+ *
+ *  @return Count of read bytes or @c 0 if the varint is not complete.
+ */
+static int UnpackVarint(const char *buf, int len, long long *value)
+{
+  unsigned long long v = 0;
+  int size = 0;
+  int shift = 0;
+
+  do {
+    if (size >= len || shift > 63) return 0;
+    v |= static_cast<unsigned long long>(buf[size] & 0x7F) << shift;
+    shift += 7;
+  } while (buf[size++] & 0x80);
+
+  *value = static_cast<long long>(v >> 1) ^ -static_cast<long long>(v & 1);
+
+  return size;
+}
+
+/**
+ *  Returns bits of double value as integer. Difference of bits of two near
+ *  time stamps is a small number.
+ */
+static long long DoubleBits(double value)
+{
+  long long bits;
+
+  memcpy (&bits, &value, sizeof (bits));
+  return bits;
+}
+
+/**
+ *  Linearize event with compact codec. Only non zero fields are stored, their
+ *  presence is given by a bit mask. All values are stored as zig-zag varints,
+ *  time stamp is stored exactly as difference of its bits from @p base_time.
+ *
+ *  @param char_event Output buffer, it must have at least as many bytes as
+ *                    LinearizeEvent() uses.
+ *  @param base_time  Base time of the network message.
+ *
+ *  @return Size of linearized event.
+ */
+int TEVENT::LinearizeEventCompact(char *char_event, double base_time)
+{
+  long long values[12] = {unit_id, event, last_event, request_id,
+    simple1, simple2, simple3, simple4, simple5, simple6, int1, int2};
+  long long mask = 0;
+  int size = 0;
+  int i;
+
+  for (i = 0; i < 12; i++)
+    if (values[i]) mask |= 1 << i;
+
+  size += PackVarint(char_event + size, mask);
+  size += PackVarint(char_event + size, player_id);
+  size += PackVarint(char_event + size, DoubleBits(time_stamp) - DoubleBits(base_time));
+
+  for (i = 0; i < 12; i++)
+    if (values[i]) size += PackVarint(char_event + size, values[i]);
+
+  return size;
+}
+
+/**
+ *  Delinearize event linearized by LinearizeEventCompact().
+ *
+ *  @param char_event    Linearized event where data are taken from.
+ *  @param lin_event_len Size of data in @p char_event.
+ *  @param base_time     Base time of the network message.
+ *
+ *  @return Count of read bytes or @c 0 when the data are not valid.
+ */
+int TEVENT::DelinearizeEventCompact(char *char_event, int lin_event_len, double base_time)
+{
+  long long values[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  long long mask, value;
+  int pos = 0;
+  int len, i;
+
+#define unpack(variable) \
+  if (!(len = UnpackVarint(char_event + pos, lin_event_len - pos, &variable))) return 0; \
+  pos += len;
+
+  unpack (mask);
+  unpack (value);
+  player_id = static_cast<int>(value);
+
+  unpack (value);
+  value += DoubleBits(base_time);
+  memcpy (&time_stamp, &value, sizeof (time_stamp));
+
+  for (i = 0; i < 12; i++)
+    if (mask & (1 << i)) {
+      unpack (values[i]);
+    }
+
+#undef unpack
+
+  unit_id = static_cast<int>(values[0]);
+  event = static_cast<int>(values[1]);
+  last_event = static_cast<int>(values[2]);
+  request_id = static_cast<int>(values[3]);
+  simple1 = static_cast<T_SIMPLE>(values[4]);
+  simple2 = static_cast<T_SIMPLE>(values[5]);
+  simple3 = static_cast<T_SIMPLE>(values[6]);
+  simple4 = static_cast<T_SIMPLE>(values[7]);
+  simple5 = static_cast<T_SIMPLE>(values[8]);
+  simple6 = static_cast<T_SIMPLE>(values[9]);
+  int1 = static_cast<int>(values[10]);
+  int2 = static_cast<int>(values[11]);
+
+  priority = false;
+
+  return pos;
+}
+
+
+//========================================================================
+// Global functions
+//========================================================================
+
+/**
+ *  Counts event received from network. Event is late when it arrives after
+ *  its time stamp, i.e. it should have been already processed.
+ */
+void NoteReceivedNetEvent(TEVENT *event)
+{
+  double lateness = glfwGetTime() - event->GetTimeStamp();
+
+  net_events_received++;
+
+  if (lateness > 0) {
+    net_events_late++;
+    net_events_lateness += lateness;
+    if (lateness > net_events_max_lateness) net_events_max_lateness = lateness;
+  }
+}
+
+/**
+ *  Logs count and average size of events sent through network, lateness of
+ *  received events and count of events of remote units processed out of order.
+ */
+void LogNetEventsStats(void)
+{
+  if (net_events_count) {
+    TEVENT event;
+    char data[128];
+
+    Info(LogMsg("Sent %lu events through network in %lu messages, %.1f bytes per event (%s codec, raw codec uses %d bytes)",
+      net_events_count, net_events_messages, double(net_events_bytes) / net_events_count,
+      event_codec == EVN_CODEC_COMPACT ? "compact" : "raw", event.LinearizeEvent(data)));
+  }
+
+  if (net_events_received)
+    Info(LogMsg("Received %lu events through network, %lu (%.1f %%) late by %.1f ms in average, %.1f ms at most",
+      net_events_received, net_events_late, 100.0 * net_events_late / net_events_received,
+      net_events_late ? 1000 * net_events_lateness / net_events_late : 0.0, 1000 * net_events_max_lateness));
+
+  if (net_events_remote)
+    Info(LogMsg("Processed %lu events of remote units, %lu (%.2f %%) ignored because they came out of order",
+      net_events_remote, net_events_out_of_order, 100.0 * net_events_out_of_order / net_events_remote));
+
+  net_events_count = net_events_bytes = net_events_messages = 0;
+  net_events_received = net_events_late = 0;
+  net_events_lateness = net_events_max_lateness = 0;
+  net_events_remote = net_events_out_of_order = 0;
+}
+
+
 //========================================================================
 // class QUEUE_EVENTS
 //========================================================================
@@ -575,6 +781,128 @@ void TQUEUE_EVENTS::LogQueue(void)
 #endif
 
 
+//========================================================================
+// class TCLOCK_SYNC
+//========================================================================
+
+/**
+ *  Forgets all samples.
+ */
+void TCLOCK_SYNC::Clear()
+{
+  count = next = 0;
+  offset = offset_time = drift = 0;
+  rtt = rtt_variation = 0;
+}
+
+
+/**
+ *  Adds ping to the samples. Remote time is expected in the middle of round
+ *  trip.
+ *
+ *  @param sent      Local time when ping was sent.
+ *  @param remote    Remote time when ping was received by remote computer.
+ *  @param received  Local time when reply was received.
+ */
+void TCLOCK_SYNC::AddSample(double sent, double remote, double received)
+{
+  TSAMPLE &sample = samples[next];
+
+  sample.rtt = MAX(received - sent, 0.0);
+  sample.time = (sent + received) / 2;
+  sample.offset = remote - sample.time;
+
+  // smoothing of round trip time is the same as in TCP
+  if (!count) {
+    rtt = sample.rtt;
+    rtt_variation = sample.rtt / 2;
+  }
+  else {
+    rtt_variation = 0.75 * rtt_variation + 0.25 * fabs(rtt - sample.rtt);
+    rtt = 0.875 * rtt + 0.125 * sample.rtt;
+  }
+
+  next = (next + 1) % EVN_CLOCK_SAMPLES;
+  if (count < EVN_CLOCK_SAMPLES) count++;
+
+  Update();
+}
+
+
+/**
+ *  Moves all samples after local clock was moved by delta.
+ */
+void TCLOCK_SYNC::Shift(double delta)
+{
+  for (int i = 0; i < count; i++) {
+    samples[i].time += delta;
+    samples[i].offset -= delta;
+  }
+
+  offset -= delta;
+  offset_time += delta;
+}
+
+
+/**
+ *  Returns estimated offset of remote clock from local one at the time.
+ *
+ *  @param time  Local time.
+ */
+double TCLOCK_SYNC::GetOffset(double time)
+{
+  return offset + drift * (time - offset_time);
+}
+
+
+/**
+ *  Estimates offset and drift from the samples.
+ */
+void TCLOCK_SYNC::Update()
+{
+  double min_rtt = samples[0].rtt;
+  int i, best = 0, used = 0;
+  double mean_time = 0, mean_offset = 0, first = 0, last = 0;
+  double sxx = 0, sxy = 0;
+
+  for (i = 1; i < count; i++)
+    if (samples[i].rtt < min_rtt) {
+      min_rtt = samples[i].rtt;
+      best = i;
+    }
+
+  offset = samples[best].offset;
+  offset_time = samples[best].time;
+
+  // samples with round trip time close to the smallest one
+  for (i = 0; i < count; i++) {
+    if (samples[i].rtt > 2 * min_rtt + EVN_CLOCK_PRECISION) continue;
+
+    if (!used || samples[i].time < first) first = samples[i].time;
+    if (!used || samples[i].time > last) last = samples[i].time;
+
+    mean_time += samples[i].time;
+    mean_offset += samples[i].offset;
+    used++;
+  }
+
+  if (used < 4 || last - first < EVN_CLOCK_DRIFT_SPAN) return;
+
+  mean_time /= used;
+  mean_offset /= used;
+
+  for (i = 0; i < count; i++) {
+    if (samples[i].rtt > 2 * min_rtt + EVN_CLOCK_PRECISION) continue;
+
+    sxx += (samples[i].time - mean_time) * (samples[i].time - mean_time);
+    sxy += (samples[i].time - mean_time) * (samples[i].offset - mean_offset);
+  }
+
+  drift = sxy / sxx;
+  drift = MAX(-EVN_CLOCK_MAX_DRIFT, MIN(EVN_CLOCK_MAX_DRIFT, drift));
+}
+
+
 //=========================================================================
 // END
 //=========================================================================
@@ -35,6 +35,7 @@
 
 class TEVENT;
 class TQUEUE_EVENTS;
+class TCLOCK_SYNC;
 
 //========================================================================
 // Definitions & typedefs
@@ -82,6 +83,20 @@ class TQUEUE_EVENTS;
 //time stamps
 #define TS_MIN_EVENTS_DIFF              0.000001f //time between two events which are send through network (with same TS) (TS of secon will be TS + TS_MIN_EVENTS_DIFF)
 
+//network codecs of events (used as subtype of net_protocol_event message)
+#define EVN_CODEC_RAW                   0     //all fields are copied to message
+#define EVN_CODEC_COMPACT               1     //presence mask, zig-zag varints and time stamps relative to message base time
+#define EVN_CODEC_VERSION               EVN_CODEC_COMPACT  //newest codec supported by this version
+
+//clock synchronisation
+#define EVN_CLOCK_PING_PERIOD           1.0   //period of pings measuring clocks of remote computers [s]
+#define EVN_CLOCK_SAMPLES               16    //count of last pings used for estimation of clock of remote computer
+#define EVN_CLOCK_DRIFT_SPAN            8.0   //minimal time span of samples used for estimation of drift [s]
+#define EVN_CLOCK_MAX_DRIFT             0.001 //maximal accepted drift of clocks [s/s]
+#define EVN_CLOCK_SLEW                  0.002 //maximal correction of local clock at once [s]
+#define EVN_CLOCK_SLEW_PERIOD           0.1   //minimal time between two corrections of local clock [s]
+#define EVN_CLOCK_PRECISION             0.0005  //offsets smaller than this are not corrected [s]
+
 //========================================================================
 // Included files
 //========================================================================
@@ -182,6 +197,8 @@ public:
   
   int LinearizeEvent(char * char_event); // Linearize event to array of chars (prepare event for net).
   void DelinearizeEvent(char * char_event, int lin_event_len); // Delinearize event from array of chars (fill event with data in char).
+  int LinearizeEventCompact(char * char_event, double base_time); // Linearize event with compact codec.
+  int DelinearizeEventCompact(char * char_event, int lin_event_len, double base_time); // Delinearize event linearized with compact codec.
   
   TEVENT(void);   // Constructor only zeroize all data.
 };
@@ -221,6 +238,48 @@ public:
   ~TQUEUE_EVENTS();       // Destructor.
 };
 
+//========================================================================
+// class TCLOCK_SYNC
+//========================================================================
+
+/**
+ *  Estimator of clock of a remote computer from repeated pings, similar to
+ *  NTP. Offset is taken from the ping with the smallest round trip time,
+ *  which was delayed least by queues. Drift is the slope of offsets of
+ *  the pings with round trip time close to the smallest one.
+ */
+class TCLOCK_SYNC {
+public:
+  TCLOCK_SYNC() { Clear(); };   //!< Constructor.
+
+  void Clear();
+  void AddSample(double sent, double remote, double received);
+  void Shift(double delta);
+  double GetOffset(double time);
+
+  bool IsValid() { return count > 0; };         //!< Returns true if clock was measured at least once.
+  double GetDrift() { return drift; };          //!< Returns drift of remote clock. [s/s]
+  double GetRtt() { return rtt; };              //!< Returns smoothed round trip time. [s]
+  double GetRttVariation() { return rtt_variation; };  //!< Returns mean deviation of round trip time. [s]
+
+private:
+  struct TSAMPLE {
+    double time;        //!< Local time of the sample. [s]
+    double offset;      //!< Remote time minus local time. [s]
+    double rtt;         //!< Round trip time of the ping. [s]
+  } samples[EVN_CLOCK_SAMPLES];   //!< Circular buffer of the last samples.
+
+  int count;            //!< Count of samples in #samples.
+  int next;             //!< Index of next sample in #samples.
+  double offset;        //!< Estimated offset at #offset_time. [s]
+  double offset_time;   //!< Local time, when #offset was measured. [s]
+  double drift;         //!< Estimated drift of remote clock. [s/s]
+  double rtt;           //!< Smoothed round trip time. [s]
+  double rtt_variation; //!< Mean deviation of round trip time. [s]
+
+  void Update();
+};
+
 //========================================================================
 // Global variables
 //========================================================================
@@ -228,6 +287,14 @@ public:
 extern TPOOL<TEVENT> * pool_events;
 extern TQUEUE_EVENTS * queue_events;
 
+extern T_BYTE event_codec;
+extern unsigned long net_events_count;
+extern unsigned long net_events_bytes;
+extern unsigned long net_events_messages;
+extern unsigned long net_events_remote;
+extern unsigned long net_events_out_of_order;
+extern double event_input_delay;
+
 #ifdef NEW_GLFW3
 extern mtx_t delete_mutex;
 #else
@@ -239,6 +306,9 @@ extern GLFWmutex delete_mutex;
 // Global functions
 //========================================================================
 
+void NoteReceivedNetEvent(TEVENT *event);
+void LogNetEventsStats(void);
+
 #endif // __doevents_h__
 
 //========================================================================
@@ -28,12 +28,37 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "dofile.h"
 
 using std::string;
 
 
+/**
+ *  Header of the cache of configuration file.
+ */
+struct TFILE_CACHE_HEADER {
+  unsigned magic;       //!< Magic number [#FILE_CACHE_MAGIC].
+  unsigned version;     //!< Version of format [#FILE_CACHE_VERSION].
+  long source_size;     //!< Size of the cached file. [bytes]
+  long source_time;     //!< Modification time of the cached file.
+  unsigned source_hash; //!< Hash of contents of the cached file.
+  int lines_count;      //!< Count of all lines in the cached file.
+  int records_count;    //!< Count of records.
+  int strings_size;     //!< Size of interned strings. [bytes]
+  unsigned hash;        //!< Hash of records and strings.
+};
+
+
+/** Marker of deleted slot in hash index of section. */
+static char index_deleted;
+
+/** Deleted slot in hash index of section. */
+#define FE_INDEX_DELETED  ((TFE_LINE *)&index_deleted)
+
+
 //=========================================================================
 // Chop, GetWord
 //=========================================================================
@@ -297,6 +322,17 @@ void TFE_LINE::Write(void)
 }
 
 
+/**
+ *  Packs line content into cache of the file.
+ *
+ *  @param cache Cache of the file.
+ */
+void TFE_LINE::PackCache(TFILE_CACHE *cache)
+{
+  cache->AddRecord(FE_LINE, NULL, values);
+}
+
+
 //=========================================================================
 // Classe TFE_ITEM
 //=========================================================================
@@ -437,6 +473,17 @@ void TFE_ITEM::Write(void)
 }
 
 
+/**
+ *  Packs item into cache of the file.
+ *
+ *  @param cache Cache of the file.
+ */
+void TFE_ITEM::PackCache(TFILE_CACHE *cache)
+{
+  cache->AddRecord(FE_ITEM, name, values);
+}
+
+
 //=========================================================================
 // Class TFE_SECTION
 //=========================================================================
@@ -460,6 +507,10 @@ TFE_SECTION::TFE_SECTION(TFE_SECTION *powner, char *sname)
   }
 
   fst_entry = last_entry = NULL;
+  entries_count = 0;
+
+  index = NULL;
+  index_size = index_used = 0;
 }
 
 
@@ -494,6 +545,22 @@ void TFE_SECTION::Write(void)
 }
 
 
+/**
+ *  Packs whole section into cache of the file inluded with all entries in it.
+ *
+ *  @param cache Cache of the file.
+ */
+void TFE_SECTION::PackCache(TFILE_CACHE *cache)
+{
+  if (name) cache->AddRecord(FE_SECTION, name, NULL);
+
+  // pack all section entries
+  for (TFE_LINE *line = fst_entry; line; line = line->next) line->PackCache(cache);
+
+  if (name) cache->AddRecord(FE_SECTION_END, NULL, NULL);
+}
+
+
 /**
  *  Deletes all section entries.
  */
@@ -501,31 +568,193 @@ void TFE_SECTION::Clear(void)
 {
   TFE_LINE *entry = fst_entry;
 
+  ClearIndex();
+
   // while is there any entry, delete it
   while (entry) {
     fst_entry = fst_entry->next;
     delete entry;
     entry = fst_entry;
   }
+
+  last_entry = NULL;
+  entries_count = 0;
 }
 
 
 /**
- *  Finds and returns section.
+ *  Returns name of item or section entry.
+ */
+static inline const char *GetEntryName(TFE_LINE *entry)
+{
+  if (entry->type == FE_ITEM) return ((TFE_ITEM *)entry)->name;
+  else return ((TFE_SECTION *)entry)->name;
+}
+
+
+/**
+ *  Computes hash of name of the entry (FNV-1a).
  *
- *  @param section section name.
+ *  @param etype  Type of the entry [FE_ITEM, FE_SECTION].
+ *  @param ename  Name of the entry.
+ */
+static inline unsigned GetEntryHash(int etype, const char *ename)
+{
+  unsigned hash = 2166136261u ^ unsigned(etype);
+
+  for (const unsigned char *p = (const unsigned char *)ename; *p; p++)
+    hash = (hash ^ *p) * 16777619u;
+
+  return hash;
+}
+
+
+/**
+ *  Deletes hash index of the section.
+ */
+void TFE_SECTION::ClearIndex(void)
+{
+  if (index) delete []index;
+
+  index = NULL;
+  index_size = index_used = 0;
+}
+
+
+/**
+ *  Builds hash index of all items and sections in the section.
+ */
+void TFE_SECTION::BuildIndex(void)
+{
+  ClearIndex();
+
+  // index is at most half full after build
+  for (index_size = FE_INDEX_MIN_SIZE; index_size < 2 * entries_count; index_size <<= 1);
+
+  index = NEW TFE_LINE *[index_size];
+  memset(index, 0, index_size * sizeof(TFE_LINE *));
+
+  for (TFE_LINE *entry = fst_entry; entry; entry = entry->next) IndexEntry(entry);
+}
+
+
+/**
+ *  Finds slot of the entry in hash index.
  *
- *  @return Handler to section on success, otherwise @c NULL.
+ *  @param etype  Type of the entry [FE_ITEM, FE_SECTION].
+ *  @param ename  Name of the entry.
+ *
+ *  @return Slot with the entry, if it is indexed, otherwise free slot, where
+ *          it could be stored.
  */
-TFE_SECTION *TFE_SECTION::GetSection(char *section)
+TFE_LINE **TFE_SECTION::FindSlot(int etype, const char *ename)
+{
+  unsigned mask = index_size - 1;
+  TFE_LINE **free_slot = NULL;
+  TFE_LINE *entry;
+
+  for (unsigned i = GetEntryHash(etype, ename) & mask;; i = (i + 1) & mask) {
+    entry = index[i];
+
+    if (!entry) return free_slot ? free_slot : &index[i];
+
+    if (entry == FE_INDEX_DELETED) {
+      if (!free_slot) free_slot = &index[i];
+    }
+    else if (entry->type == etype && !strcmp(GetEntryName(entry), ename)) return &index[i];
+  }
+}
+
+
+/**
+ *  Adds entry into hash index. Only the first entry of each name is indexed.
+ *
+ *  @param entry Entry, which is already in list of entries.
+ */
+void TFE_SECTION::IndexEntry(TFE_LINE *entry)
+{
+  if (entry->type != FE_ITEM && entry->type != FE_SECTION) return;
+
+  // index is too full, rebuild it with all entries
+  if (4 * (index_used + 1) > 3 * index_size) {
+    BuildIndex();
+    return;
+  }
+
+  TFE_LINE **slot = FindSlot(entry->type, GetEntryName(entry));
+
+  if (*slot && *slot != FE_INDEX_DELETED) return;   // name is already indexed
+
+  if (!*slot) index_used++;
+  *slot = entry;
+}
+
+
+/**
+ *  Removes entry from hash index. If there is other entry with the same name,
+ *  it is indexed instead. The entry must be already unlinked from list of
+ *  entries, because indexing of the other entry may rebuild whole index.
+ *
+ *  @param entry Entry, which was removed from list of entries.
+ */
+void TFE_SECTION::UnindexEntry(TFE_LINE *entry)
+{
+  if (!index || (entry->type != FE_ITEM && entry->type != FE_SECTION)) return;
+
+  const char *ename = GetEntryName(entry);
+  TFE_LINE **slot = FindSlot(entry->type, ename);
+
+  if (*slot != entry) return;   // entry is not the first one with its name
+
+  *slot = FE_INDEX_DELETED;
+
+  for (TFE_LINE *bl = fst_entry; bl; bl = bl->next) {
+    if (bl->type == entry->type && !strcmp(GetEntryName(bl), ename)) {
+      IndexEntry(bl);
+      break;
+    }
+  }
+}
+
+
+/**
+ *  Finds the first item or section with given name.
+ *
+ *  @param etype  Type of the entry [FE_ITEM, FE_SECTION].
+ *  @param ename  Name of the entry.
+ *
+ *  @return Handler to entry on success, otherwise @c NULL.
+ */
+TFE_LINE *TFE_SECTION::FindEntry(int etype, char *ename)
 {
   TFE_LINE *bl;
 
+  if (!index && entries_count >= FE_INDEX_MIN_ENTRIES) BuildIndex();
+
+  if (index) {
+    bl = *FindSlot(etype, ename);
+    return bl == FE_INDEX_DELETED ? NULL : bl;
+  }
+
+  // small sections are searched sequentially
   for (bl = fst_entry; bl; bl = bl->next) {
-    if (bl->type == FE_SECTION && !strcmp(((TFE_SECTION *)bl)->name, section)) break;
+    if (bl->type == etype && !strcmp(GetEntryName(bl), ename)) break;
   }
 
-  return (TFE_SECTION *)bl;
+  return bl;
+}
+
+
+/**
+ *  Finds and returns section.
+ *
+ *  @param section section name.
+ *
+ *  @return Handler to section on success, otherwise @c NULL.
+ */
+TFE_SECTION *TFE_SECTION::GetSection(char *section)
+{
+  return (TFE_SECTION *)FindEntry(FE_SECTION, section);
 }
 
 
@@ -538,11 +767,7 @@ TFE_SECTION *TFE_SECTION::GetSection(char *section)
  */
 TFE_ITEM *TFE_SECTION::GetItem(char *item, bool warn)
 {
-  TFE_LINE *bl;
-
-  for (bl = fst_entry; bl; bl = bl->next) {
-    if (bl->type == FE_ITEM && !strcmp(((TFE_ITEM *)bl)->name, item)) break;
-  }
+  TFE_LINE *bl = FindEntry(FE_ITEM, item);
 
   // item is not found
   if (!bl && warn) {
@@ -593,10 +818,7 @@ void TFE_SECTION::DeleteSection(char *section)
   TFE_SECTION *sect = GetSection(section);
 
   if (sect) {
-    // remove section from list of entries
-    if (sect->next) sect->next->prev = sect->prev;
-    if (sect->prev) sect->prev->next = sect->next;
-
+    RemoveEntry(sect);
     delete sect;
   }
 }
@@ -612,14 +834,7 @@ void TFE_SECTION::DeleteItem(char *item)
   TFE_ITEM *it = GetItem(item, false);
 
   if (it) {
-    
-    if (it == this->fst_entry) fst_entry = it->next;
-    if (it == this->last_entry) last_entry = it->prev;
-    
-    // remove entry from list of entries
-    if (it->next) it->next->prev = it->prev;
-    if (it->prev) it->prev->next = it->next;
-
+    RemoveEntry(it);
     delete it;
   }
 }
@@ -648,6 +863,31 @@ void TFE_SECTION::AddEntry(TFE_LINE *entry)
 
     entry->line_num = entry->prev->line_num + 1;
   }
+
+  entries_count++;
+
+  if (index) IndexEntry(entry);
+}
+
+
+/**
+ *  Removes entry from entry list. The entry is not deleted.
+ *
+ *  @param entry entry in the list.
+ */
+void TFE_SECTION::RemoveEntry(TFE_LINE *entry)
+{
+  if (entry == fst_entry) fst_entry = entry->next;
+  if (entry == last_entry) last_entry = entry->prev;
+
+  // remove entry from list of entries
+  if (entry->next) entry->next->prev = entry->prev;
+  if (entry->prev) entry->prev->next = entry->next;
+
+  entry->next = entry->prev = NULL;
+  entries_count--;
+
+  UnindexEntry(entry);
 }
 
 
@@ -877,9 +1117,15 @@ void TCONF_FILE::Clear(void)
 
 /**
  *  Reloads entries from file. All previous entries and changes will be lost.
+ *
+ *  @param cached  If @c true, entries are loaded from the cache of the file
+ *                 when it is valid. Otherwise the file is parsed and the cache
+ *                 is written. Use it only for files, which are not modified.
  */
-int TCONF_FILE::Reload(void)
+int TCONF_FILE::Reload(bool cached)
 {
+  if (cached && LoadCache()) return 1;
+
   // open file for reading
   if (!Open(const_cast<char*>("rt"))) return 0;
 
@@ -971,6 +1217,8 @@ int TCONF_FILE::Reload(void)
   modified = false;  // we have no changes, we only read a file
   Close();          // close file
 
+  if (cached) SaveCache();
+
   return 1;
 }
 
@@ -996,6 +1244,136 @@ void TCONF_FILE::Save(void)
 }
 
 
+/**
+ *  Gets size and modification time of the file.
+ *
+ *  @param fname  File name (with path).
+ *  @param size   Size of the file will be stored here.
+ *  @param time   Modification time of the file will be stored here.
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool GetFileStamp(const char *fname, long *size, long *time)
+{
+  struct stat st;
+
+  if (stat(fname, &st)) return false;
+
+  *size = long(st.st_size);
+  *time = long(st.st_mtime);
+
+  return true;
+}
+
+
+/**
+ *  Computes hash of contents of the file (FNV-1a). The file is read in
+ *  blocks, it is much faster than parsing of it.
+ *
+ *  @param fname  File name (with path).
+ *  @param hash   Hash of the file will be stored here.
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool GetFileHash(const char *fname, unsigned *hash)
+{
+  T_BYTE block[4096];
+  FILE *fh;
+  size_t count;
+  bool ok;
+
+  if (!(fh = fopen(fname, "rb"))) return false;
+
+  *hash = 2166136261u;
+
+  while ((count = fread(block, 1, sizeof(block), fh)) > 0)
+    for (size_t i = 0; i < count; i++)
+      *hash = (*hash ^ block[i]) * 16777619u;
+
+  ok = !ferror(fh);
+  fclose(fh);
+
+  return ok;
+}
+
+
+/**
+ *  Loads entries from the cache of the file, if the cache is valid.
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool TCONF_FILE::LoadCache(void)
+{
+  TFILE_CACHE cache;
+  TFILE_CACHE_RECORD *record;
+  string cache_name = string(name) + FILE_CACHE_EXTENSION;
+  long size, time;
+  unsigned hash;
+#if DEBUG
+  double start_time = glfwGetTime();
+#endif
+
+  if (!GetFileStamp(name, &size, &time) || !GetFileHash(name, &hash)) return false;
+  if (!cache.Load(cache_name.c_str(), size, time, hash)) return false;
+
+  // if there are any entries, clear all
+  Clear();
+
+  for (int i = 0; i < cache.GetRecordsCount(); i++) {
+    record = cache.GetRecord(i);
+
+    switch (record->type) {
+    case FE_LINE:
+      act_section->AddLine(cache.GetString(record->value));
+      break;
+
+    case FE_ITEM:
+      act_section->AddLoadedValue(cache.GetString(record->name), cache.GetString(record->value));
+      break;
+
+    case FE_SECTION:
+      SelectSection(cache.GetString(record->name), false);
+      break;
+
+    case FE_SECTION_END:
+      UnselectSection();
+      break;
+    }
+  }
+
+  act_section = base_section;
+  lines_count = cache.lines_count;
+  file_exists = true;
+  modified = false;
+
+#if DEBUG
+  Debug(LogMsg("Loaded '%s' from cache in %.2f ms", name, (glfwGetTime() - start_time) * 1000));
+#endif
+
+  return true;
+}
+
+
+/**
+ *  Writes all entries into the cache of the file.
+ */
+void TCONF_FILE::SaveCache(void)
+{
+  TFILE_CACHE cache;
+  string cache_name = string(name) + FILE_CACHE_EXTENSION;
+  long size, time;
+  unsigned hash;
+
+  if (!GetFileStamp(name, &size, &time) || !GetFileHash(name, &hash)) return;
+
+  base_section->PackCache(&cache);
+  cache.lines_count = lines_count;
+
+  if (!cache.Save(cache_name.c_str(), size, time, hash))
+    Debug(LogMsg("Can not write cache '%s'", cache_name.c_str()));
+}
+
+
 /**
  *  Selects section as an actual. If section is not found, new one will be created.
  *
@@ -1607,7 +1985,7 @@ bool TCONF_FILE::ReadSimple(T_SIMPLE *value, char *item, T_SIMPLE def_value)
 
   // check for TSIMPLE type range
   if (ok){
-    if ((v < 0) && (v > MAX_T_SIMPLE)){
+    if ((v < 0) || (v > MAX_T_SIMPLE)){
       Warning(LogMsg("Value of item '%s' is not in T_SIMPLE range", item));
       ok = false;
     }
@@ -1651,7 +2029,7 @@ bool TCONF_FILE::ReadSimpleGE(T_SIMPLE *value, char *item, T_SIMPLE min, T_SIMPL
 
   // check for TSIMPLE type range
   if (ok){
-    if ((v < 0) && (v > MAX_T_SIMPLE)){
+    if ((v < 0) || (v > MAX_T_SIMPLE)){
       Warning(LogMsg("Value of item '%s' is not in T_SIMPLE range", item));
       ok = false;
     }
@@ -1702,7 +2080,7 @@ bool TCONF_FILE::ReadSimpleRange(T_SIMPLE *value, char *item, T_SIMPLE min, T_SI
   
   // check for TSIMPLE type range
   if (ok){
-    if ((v < 0) && (v > MAX_T_SIMPLE)){
+    if ((v < 0) || (v > MAX_T_SIMPLE)){
       Warning(LogMsg("Value of item '%s' is not in T_SIMPLE range", item));
       ok = false;
     }
@@ -1749,7 +2127,7 @@ bool TCONF_FILE::ReadByte(T_BYTE *value, char *item, T_BYTE def_value)
   
   // check for T_BYTE type range
   if (ok){
-    if ((v < 0) && (v > MAX_T_BYTE)){
+    if ((v < 0) || (v > MAX_T_BYTE)){
       Warning(LogMsg("Value of item '%s' is not in T_BYTE range", item));
       ok = false;
     }
@@ -1793,7 +2171,7 @@ bool TCONF_FILE::ReadByteGE(T_BYTE *value, char *item, T_BYTE min, T_BYTE def_va
 
   // check for T_BYTE type range
   if (ok){
-    if ((v < 0) && (v > MAX_T_BYTE)){
+    if ((v < 0) || (v > MAX_T_BYTE)){
       Warning(LogMsg("Value of item '%s' is not in T_BYTE range", item));
       ok = false;
     }
@@ -1843,7 +2221,7 @@ bool TCONF_FILE::ReadByteRange(T_BYTE *value, char *item, T_BYTE min, T_BYTE max
 
   // check for T_BYTE type range
   if (ok){
-    if ((v < 0) && (v > MAX_T_BYTE)){
+    if ((v < 0) || (v > MAX_T_BYTE)){
       Warning(LogMsg("Value of item '%s' is not in T_BYTE range", item));
       ok = false;
     }
@@ -2060,6 +2438,191 @@ void TCONF_FILE::SetIndentString(char *str)
 }
 
 
+//=========================================================================
+// Class TFILE_CACHE
+//=========================================================================
+
+/**
+ *  Deletes all records and strings of the cache.
+ */
+void TFILE_CACHE::Clear(void)
+{
+  records.clear();
+  strings.clear();
+  offsets.clear();
+
+  lines_count = 0;
+}
+
+
+/**
+ *  Adds record of one entry to the cache.
+ *
+ *  @param type   Type of file entry [FE_...].
+ *  @param name   Name of the entry, or @c NULL.
+ *  @param value  Values of the entry, or @c NULL.
+ */
+void TFILE_CACHE::AddRecord(int type, const char *name, const char *value)
+{
+  TFILE_CACHE_RECORD record;
+
+  record.type = type;
+  record.name = name ? Intern(name) : -1;
+  record.value = value ? Intern(value) : -1;
+
+  records.push_back(record);
+}
+
+
+/**
+ *  Stores string among strings of the cache. Each string is stored only once.
+ *
+ *  @param str String to store.
+ *
+ *  @return Offset of the string.
+ */
+int TFILE_CACHE::Intern(const char *str)
+{
+  std::map<string, int>::iterator it = offsets.find(str);
+
+  if (it != offsets.end()) return it->second;
+
+  int offset = int(strings.size());
+
+  strings.insert(strings.end(), str, str + strlen(str) + 1);
+  offsets[str] = offset;
+
+  return offset;
+}
+
+
+/**
+ *  Computes hash of records and strings of the cache (FNV-1a).
+ */
+unsigned TFILE_CACHE::GetHash(void)
+{
+  unsigned hash = 2166136261u;
+  const T_BYTE *p, *end;
+
+  if (!records.empty()) {
+    p = (const T_BYTE *)&records[0];
+    for (end = p + records.size() * sizeof(TFILE_CACHE_RECORD); p < end; p++)
+      hash = (hash ^ *p) * 16777619u;
+  }
+
+  if (!strings.empty()) {
+    p = (const T_BYTE *)&strings[0];
+    for (end = p + strings.size(); p < end; p++)
+      hash = (hash ^ *p) * 16777619u;
+  }
+
+  return hash;
+}
+
+
+/**
+ *  Loads the cache from the file. The whole file is read at once and the
+ *  records are only checked, no entries are parsed.
+ *
+ *  @param fname        Name of the cache (with path).
+ *  @param source_size  Actual size of the cached file.
+ *  @param source_time  Actual modification time of the cached file.
+ *  @param source_hash  Actual hash of contents of the cached file.
+ *
+ *  @return @c true if the cache was loaded and it is valid, @c false otherwise.
+ */
+bool TFILE_CACHE::Load(const char *fname, long source_size, long source_time, unsigned source_hash)
+{
+  TFILE_CACHE_HEADER header;
+  FILE *fh;
+  bool ok;
+
+  Clear();
+
+  if (!(fh = fopen(fname, "rb"))) return false;
+
+  ok = (fread(&header, sizeof(header), 1, fh) == 1);
+
+  // check whether the cache belongs to the actual version of the file
+  ok = ok && header.magic == FILE_CACHE_MAGIC && header.version == FILE_CACHE_VERSION
+    && header.source_size == source_size && header.source_time == source_time
+    && header.source_hash == source_hash
+    && header.records_count >= 0 && header.strings_size >= 0;
+
+  if (ok) {
+    records.resize(header.records_count);
+    strings.resize(header.strings_size);
+
+    if (header.records_count)
+      ok = (fread(&records[0], sizeof(TFILE_CACHE_RECORD), header.records_count, fh) == size_t(header.records_count));
+    if (ok && header.strings_size)
+      ok = (fread(&strings[0], header.strings_size, 1, fh) == 1);
+  }
+
+  fclose(fh);
+
+  ok = ok && GetHash() == header.hash && (strings.empty() || strings.back() == 0);
+
+  // check offsets of all strings
+  for (int i = 0; ok && i < int(records.size()); i++)
+    ok = records[i].name >= -1 && records[i].name < header.strings_size
+      && records[i].value >= -1 && records[i].value < header.strings_size;
+
+  if (!ok) {
+    Clear();
+    return false;
+  }
+
+  lines_count = header.lines_count;
+
+  return true;
+}
+
+
+/**
+ *  Saves the cache into the file.
+ *
+ *  @param fname        Name of the cache (with path).
+ *  @param source_size  Size of the cached file.
+ *  @param source_time  Modification time of the cached file.
+ *  @param source_hash  Hash of contents of the cached file.
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool TFILE_CACHE::Save(const char *fname, long source_size, long source_time, unsigned source_hash)
+{
+  TFILE_CACHE_HEADER header;
+  FILE *fh;
+  bool ok;
+
+  memset(&header, 0, sizeof(header));
+  header.magic = FILE_CACHE_MAGIC;
+  header.version = FILE_CACHE_VERSION;
+  header.source_size = source_size;
+  header.source_time = source_time;
+  header.source_hash = source_hash;
+  header.lines_count = lines_count;
+  header.records_count = int(records.size());
+  header.strings_size = int(strings.size());
+  header.hash = GetHash();
+
+  if (!(fh = fopen(fname, "wb"))) return false;
+
+  ok = (fwrite(&header, sizeof(header), 1, fh) == 1);
+  if (ok && !records.empty())
+    ok = (fwrite(&records[0], sizeof(TFILE_CACHE_RECORD), records.size(), fh) == records.size());
+  if (ok && !strings.empty())
+    ok = (fwrite(&strings[0], strings.size(), 1, fh) == 1);
+
+  if (fclose(fh)) ok = false;
+
+  // do not leave incomplete cache
+  if (!ok) remove(fname);
+
+  return ok;
+}
+
+
 //========================================================================
 // Create, Delete
 //========================================================================
@@ -2081,12 +2644,13 @@ TCONF_FILE *CreateConfFile(const char *name)
 /**
  *  Creates new configuration file structure and reloads the file.
  *
- *  @param name File name (with path).
+ *  @param name   File name (with path).
+ *  @param cached If @c true, binary cache of the file is used.
  *  @return Pointer to new structure on success, otherwise @c NULL.
  *
  *  @see TCONF_FILE::Reload()
  */
-TCONF_FILE *OpenConfFile(const char *name)
+TCONF_FILE *OpenConfFile(const char *name, bool cached)
 {
   TCONF_FILE *cf;
 
@@ -2095,7 +2659,7 @@ TCONF_FILE *OpenConfFile(const char *name)
     return NULL;
 
   // reload data from file to structure
-  if (cf->Reload())
+  if (cf->Reload(cached))
     return cf;
   else {
     CloseConfFile(cf);
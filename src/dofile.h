@@ -37,6 +37,7 @@ class TFE_LINE;
 class TFE_ITEM;
 class TFE_SECTION;
 class TCONF_FILE;
+class TFILE_CACHE;
 
 
 //========================================================================
@@ -62,12 +63,38 @@ class TCONF_FILE;
 #define FE_ITEM     1
 /** Special entry of the file that contains list of more entries. */
 #define FE_SECTION  2
+/** End of the section. It is used only in the cache of the file. */
+#define FE_SECTION_END  3
+
+
+// binary cache of configuration files
+
+/** Extension appended to the file name to get the name of its cache. */
+#define FILE_CACHE_EXTENSION      ".cache"
+/** Magic number at the start of the cache ("DOFC"). */
+#define FILE_CACHE_MAGIC          0x43464F44
+/** Version of format of the cache. */
+#define FILE_CACHE_VERSION        2
+
+
+// hash index of section entries
+
+/** Minimal count of entries in section, for which the hash index is built. */
+#ifndef FE_INDEX_MIN_ENTRIES
+#define FE_INDEX_MIN_ENTRIES      16
+#endif
+/** Minimal size of the hash index. */
+#define FE_INDEX_MIN_SIZE         32
 
 
 //========================================================================
 // Included files
 //========================================================================
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "cfg.h"
 #include "doalloc.h"
 
@@ -119,6 +146,7 @@ public:
 
   void WriteIndent(void);
   virtual void Write(void);
+  virtual void PackCache(TFILE_CACHE *cache);
   void ResetValue() {act_value = values;};
   
   TFE_LINE(TFE_SECTION *powner, char *line);
@@ -159,6 +187,7 @@ public:
   bool modified;
 
   virtual void Write(void);
+  virtual void PackCache(TFILE_CACHE *cache);
 
   void WriteValue(char *value);
   void SetValue(char *value);
@@ -199,6 +228,7 @@ public:
   char *name;                           //!< Section name.
 
   virtual void Write(void);
+  virtual void PackCache(TFILE_CACHE *cache);
 
   void Clear(void);
   TFE_SECTION *SelectSection(char *name, bool mandatory);
@@ -225,8 +255,26 @@ public:
 private:
   TFE_LINE *fst_entry;          //!< First entry in section.
   TFE_LINE *last_entry;         //!< Last entry in section.
+  int entries_count;            //!< Count of entries in section.
+
+  /**
+   *  Hash index of items and sections in this section (open addressing with
+   *  linear probing). It contains the first entry of each name and it is built
+   *  lazily, when the section has at least #FE_INDEX_MIN_ENTRIES entries.
+   */
+  TFE_LINE **index;
+  int index_size;               //!< Size of #index (power of two).
+  int index_used;               //!< Count of used and deleted slots in #index.
 
   void AddEntry(TFE_LINE *entry);
+  void RemoveEntry(TFE_LINE *entry);
+  TFE_LINE *FindEntry(int etype, char *ename);
+
+  void BuildIndex(void);
+  void ClearIndex(void);
+  void IndexEntry(TFE_LINE *entry);
+  void UnindexEntry(TFE_LINE *entry);
+  TFE_LINE **FindSlot(int etype, const char *ename);
 };
 
 
@@ -249,7 +297,7 @@ public:
   char *indent_string;      //!< Indent string.
 
   void Clear(void);
-  int Reload(void);
+  int Reload(bool cached = false);
   void Save(void);
 
   bool SelectSection(char *section, bool mandatory);
@@ -313,6 +361,56 @@ private:
 
   bool Open(char *attr);
   void Close(void);
+
+  bool LoadCache(void);
+  void SaveCache(void);
+};
+
+
+/**
+ *  Record of one entry in the cache of configuration file.
+ */
+struct TFILE_CACHE_RECORD {
+  int type;       //!< Type of file entry [FE_...].
+  int name;       //!< Offset of name of the entry in strings of the cache, or -1.
+  int value;      //!< Offset of values of the entry in strings of the cache, or -1.
+};
+
+
+/**
+ *  Binary cache of parsed configuration file. It is written next to the file
+ *  and contains all entries in flat list of records, which refer to interned
+ *  strings. The cache is valid only while the size, modification time and
+ *  hash of contents of the file are the same as when it was written.
+ *
+ *  @sa TCONF_FILE::Reload()
+ */
+class TFILE_CACHE {
+public:
+  TFILE_CACHE(void) { Clear(); };   //!< Constructor.
+
+  void Clear(void);
+  void AddRecord(int type, const char *name, const char *value);
+
+  bool Load(const char *fname, long source_size, long source_time, unsigned source_hash);
+  bool Save(const char *fname, long source_size, long source_time, unsigned source_hash);
+
+  /** Returns count of records in the cache. */
+  int GetRecordsCount(void) { return int(records.size()); };
+  /** Returns record of the cache. */
+  TFILE_CACHE_RECORD *GetRecord(int index) { return &records[index]; };
+  /** Returns string stored at the offset @p offset, or @c NULL. */
+  char *GetString(int offset) { return offset < 0 ? NULL : &strings[offset]; };
+
+  int lines_count;                      //!< Count of all lines in cached file.
+
+private:
+  int Intern(const char *str);
+  unsigned GetHash(void);
+
+  std::vector<TFILE_CACHE_RECORD> records;  //!< Records of all entries.
+  std::vector<char> strings;                //!< Interned strings terminated by zero.
+  std::map<std::string, int> offsets;       //!< Offsets of interned strings.
 };
 
 //========================================================================
@@ -320,9 +418,12 @@ private:
 //========================================================================
 
 TCONF_FILE *CreateConfFile(const char *name);
-TCONF_FILE *OpenConfFile(const char *name);
+TCONF_FILE *OpenConfFile(const char *name, bool cached = false);
 void CloseConfFile(TCONF_FILE *&cf);
 
+bool GetFileStamp(const char *fname, long *size, long *time);
+bool GetFileHash(const char *fname, unsigned *hash);
+
 
 #endif // __dofile_h__
 
@@ -36,6 +36,7 @@
 
 #include "dofollower.h"
 #include "donet.h"
+#include "doevents.h"
 
 using std::string;
 
@@ -76,6 +77,7 @@ void TFOLLOWER::Connect (string player_name) {
   m->Init_send(net_protocol_connect, 0);
   m->Pack (&listener_port, sizeof (in_port_t));
   m->PackString (player_name);
+  m->PackByte (EVN_CODEC_VERSION);   // Newest codec of events we understand.
 
   ping_request_time = glfwGetTime ();
 
@@ -110,7 +112,7 @@ void TFOLLOWER::SetMyAddress (in_addr address, in_port_t port) {
 
 void TFOLLOWER::SendPingRequest () {
   TNET_MESSAGE *msg = pool_net_messages->GetFromPool();
-  msg->Init_send(net_protocol_ping, 0);
+  msg->Init_send(net_protocol_ping, net_ping_request);
 
   ping_request_time = glfwGetTime ();
   msg->Pack (&ping_request_time, sizeof ping_request_time);
@@ -337,14 +337,14 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
         // update global map
         for (i = last_ps.x; i < last_ps.x + GetUnitWidth(); i++)
           for (j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
-            map.segments[last_ps.segment].surface[i][j].unit = NULL;   //updating global map - leaving old position
+            map.segments[last_ps.segment].surface.SetUnit(i, j, NULL);   //updating global map - leaving old position
 
         for (i = pos.x; i < pos.x + GetUnitWidth(); i++)
           for (j = pos.y; j < pos.y + GetUnitHeight(); j++)
           {
-            map.segments[pos.segment].surface[i][j].unit = this;   //updating global map - taking up new position
-            map.segments[pos.segment].surface[i][j].GetAimersList()->AttackEnemy(this, false);
-            map.segments[pos.segment].surface[i][j].GetWatchersList()->AttackEnemy(this, true);
+            map.segments[pos.segment].surface.SetUnit(i, j, this);   //updating global map - taking up new position
+            map.segments[pos.segment].surface.GetAimersList(i, j)->AttackEnemy(this, false);
+            map.segments[pos.segment].surface.GetWatchersList(i, j)->AttackEnemy(this, true);
           }
 
         // update local map of all local players
@@ -448,7 +448,7 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
           for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
             for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
             {
-              if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+              if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
               {
                 all_moveable = false;
                 break;
@@ -466,8 +466,8 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
       // find out hardest terrain
       for (i = pos.x; i < pos.x + GetUnitWidth(); i++)
         for (j = pos.y; j < pos.y + GetUnitHeight(); j++)
-          hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty > hardest)?
-                    scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][this->pos.y].t_id].difficulty : hardest;
+          hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty > hardest)?
+                    scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, this->pos.y)].difficulty : hardest;
 
       // set speed
       //actual speed in dependence to difficulty of the terrain - terrain with difficulty 500 reduce speed to half
@@ -501,8 +501,8 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
     
     for (i = pos.x; i < (pos.x + GetUnitWidth()); i++)
       for (j = pos.y; j < (pos.y + GetUnitHeight()); j++)   //find hardest terrain
-        hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty > hardest)?
-                  scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty : hardest;
+        hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty > hardest)?
+                  scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty : hardest;
 
     // set rotation speed
     rotation_speed = itm->GetMaximumRotation(pos.segment)*(1.001f - hardest / 1000.0f);
@@ -877,7 +877,7 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
         for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
           for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
           {
-            if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+            if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
             {
               all_moveable = false;
               break;
@@ -1034,7 +1034,7 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
               for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
                 for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
                 {
-                  if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+                  if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
                   {
                     all_moveable = false;
                     break;
@@ -1169,7 +1169,7 @@ void TFORCE_UNIT::ProcessEvent(TEVENT * proc_event)
                   for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
                     for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
                     {
-                      if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+                      if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
                       {
                         all_moveable = false;
                         break;
@@ -1685,6 +1685,16 @@ bool TFORCE_UNIT::UpdateGraphics(double time_shift)
 }
 
 
+/**
+ *  Returns @c true while the unit is moving or rotating, its real position
+ *  and animation must be updated in every frame.
+ */
+bool TFORCE_UNIT::IsBusy()
+{
+  return TestState(US_MOVE) || TestState(US_LANDING) || TestState(US_UNLANDING) || TestState(US_LEFT_ROTATING) || TestState(US_RIGHT_ROTATING);
+}
+
+
 /**
  *  Method draws line to unit's destination.
  */
@@ -1941,15 +1951,15 @@ void TFORCE_UNIT::SetViewDirection(int direction)
 
             if (map.IsInMap(i, j))
             {
-              local_map->map[seg_num][i][j].terrain_id = map.segments[seg_num].surface[i][j].t_id;
-              if (p_gun != NULL) map.segments[seg_num].surface[i][j].GetWatchersList()->AddNode(this);
+              local_map->map[seg_num][i][j].terrain_id = map.segments[seg_num].surface.GetTerrainId(i, j);
+              if (p_gun != NULL) map.segments[seg_num].surface.GetWatchersList(i, j)->AddNode(this);
     
               //field has been hidden in warfog or unknown => updating infor.
               if (local_map->map[seg_num][i][j].state == (WLK_WARFOG + 1)) {
 
                 //there is some unit
-                if (map.segments[seg_num].surface[i][j].unit != NULL) {
-                    local_map->map[seg_num][i][j].player_id = map.segments[seg_num].surface[i][j].unit->GetPlayerID();
+                if (map.segments[seg_num].surface.GetUnit(i, j) != NULL) {
+                    local_map->map[seg_num][i][j].player_id = map.segments[seg_num].surface.GetUnit(i, j)->GetPlayerID();
                 }
               }
             } // is in map
@@ -1984,7 +1994,7 @@ void TFORCE_UNIT::SetViewDirection(int direction)
               Critical("!!!!!!!!!!!!!!!!!!!!!");
             }*/
             if (map.IsInMap(i, j))
-              if (p_gun != NULL) map.segments[seg_num].surface[i][j].GetWatchersList()->RemoveNode(this);
+              if (p_gun != NULL) map.segments[seg_num].surface.GetWatchersList(i, j)->RemoveNode(this);
 
             if (!local_map->map[seg_num][i][j].state) {
               if (player == myself) {
@@ -2019,6 +2029,11 @@ void TFORCE_UNIT::SetViewDirection(int direction)
     } // for j
   } // for i
 
+  if (player == myself) {
+    map.war_fog.SetDirty(x_start + 1, y_start + 1, x_stop + 1, y_stop + 1);
+    map.WakeUnits(x_start, y_start, x_stop, y_stop);
+  }
+
   if (p_gun != NULL) 
   {
 
@@ -2031,11 +2046,11 @@ void TFORCE_UNIT::SetViewDirection(int direction)
           {
             if (!(IsAimableByUnit(pos, i, j, u_width, u_height, range_min, range_max)) && (IsAimableByUnit(pos_new, i, j, u_width, u_height, range_min, range_max)))
             {
-              map.segments[k].surface[i][j].GetAimersList()->AddNode(this);
+              map.segments[k].surface.GetAimersList(i, j)->AddNode(this);
             }
             else if (!(IsAimableByUnit(pos_new, i, j, u_width, u_height, range_min, range_max)) && (IsAimableByUnit(pos, i, j, u_width, u_height, range_min, range_max)))
             {
-              map.segments[k].surface[i][j].GetAimersList()->RemoveNode(this);
+              map.segments[k].surface.GetAimersList(i, j)->RemoveNode(this);
             }
           }
         }
@@ -2408,20 +2423,20 @@ bool TFORCE_UNIT::MoveInDirection(int direct)
 
     for (i = pos.x; i < pos.x + GetUnitWidth(); i++)
       for (j = pos.y; j < pos.y + GetUnitHeight(); j++)
-        map.segments[pos.segment].surface[i][j].unit = NULL;   //updating global map - leaving old position
+        map.segments[pos.segment].surface.SetUnit(i, j, NULL);   //updating global map - leaving old position
     for (i = ps.x; i < ps.x + GetUnitWidth(); i++)
       for (j = ps.y; j < ps.y + GetUnitHeight(); j++)
       {
-        map.segments[ps.segment].surface[i][j].unit = this;   //updating global map - taking up new position
-        map.segments[ps.segment].surface[i][j].GetAimersList()->AttackEnemy(this, false);
-        map.segments[ps.segment].surface[i][j].GetWatchersList()->AttackEnemy(this, true);
+        map.segments[ps.segment].surface.SetUnit(i, j, this);   //updating global map - taking up new position
+        map.segments[ps.segment].surface.GetAimersList(i, j)->AttackEnemy(this, false);
+        map.segments[ps.segment].surface.GetWatchersList(i, j)->AttackEnemy(this, true);
       }
 
     SetPosition(ps);         //seting new position
 
     move_shift = 0.0;
 
-    speed = kind->max_speed[pos.segment]*(1.001f - scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty / 1000.0f);
+    speed = kind->max_speed[pos.segment]*(1.001f - scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty / 1000.0f);
     //actual speed in dependence to difficulty of the terrain - terrain with difficulty 500 reduce speed to half
 
     if (direct == LAY_EAST || direct == LAY_NORTH || direct == LAY_WEST || direct == LAY_SOUTH)
@@ -2448,7 +2463,9 @@ bool TFORCE_UNIT::MoveInDirection(int direct)
 unsigned int TFORCE_UNIT::IsAdjacentPositionAvailable(const int direct)
 {
   TPOSITION_3D new_pos;
-  TMAP_SURFACE *field;
+  TMAP_SURFACE *surface;
+  TMAP_UNIT *unit;
+  TTERRAIN_ID t_id;
   TFORCE_ITEM *kind = static_cast<TFORCE_ITEM*>(GetPointerToItem());
   unsigned int result = 0;
   
@@ -2459,15 +2476,19 @@ unsigned int TFORCE_UNIT::IsAdjacentPositionAvailable(const int direct)
     if (kind->GetExistSegments().IsMember(new_pos.segment))     //it is in existable segment
     {
       TTERRAIN_PROPS* terrains = scheme.terrain_props[new_pos.segment];     //terrain types in the segment
+      surface = &map.segments[new_pos.segment].surface;
       for (int i = pos.x; i < pos.x + GetUnitWidth(); i++)
         for (int j = pos.y; j < pos.y + GetUnitHeight(); j++)
         {         //testing through new position
-          field = &map.segments[new_pos.segment].surface[i][j];
-          if ((!map.IsInMap(i, j)) || (!kind->moveable[new_pos.segment].IsMember(field->t_id)) 
-              || ((field->unit != NULL)&&(field->unit != this))) //it isn't in the map, moveable terrain and empty field (or with me)
+          if (!map.IsInMap(i, j)) return 0;   //it isn't in the map
+
+          t_id = surface->GetTerrainId(i, j);
+          unit = surface->GetUnit(i, j);
+          if ((!kind->moveable[new_pos.segment].IsMember(t_id)) 
+              || ((unit != NULL)&&(unit != this))) //it isn't moveable terrain and empty field (or with me)
             return 0;
 
-          result = (terrains[field->t_id].difficulty > result) ? terrains[field->t_id].difficulty : result;
+          result = (terrains[t_id].difficulty > result) ? terrains[t_id].difficulty : result;
                     //difficulty of the hardest terrain
         }
     }
@@ -2486,17 +2507,17 @@ unsigned int TFORCE_UNIT::IsAdjacentPositionAvailable(const int direct)
  */
 bool TFORCE_UNIT::IsSelectedPositionAvailable(const TPOSITION_3D new_pos)
 {
-  TMAP_SURFACE *field;
+  TMAP_SURFACE *surface;
   TFORCE_ITEM *kind = static_cast<TFORCE_ITEM*>(GetPointerToItem());
 
   if (kind->GetExistSegments().IsMember(new_pos.segment))     //it is in existable segment
   {
+    surface = &map.segments[new_pos.segment].surface;
     for (int i = new_pos.x; i < new_pos.x + GetUnitWidth(); i++)
       for (int j = new_pos.y; j < new_pos.y + GetUnitHeight(); j++)
       {         //testing through new position
-        field = &map.segments[new_pos.segment].surface[i][j];
-        if ((!map.IsInMap(i, j)) || (!kind->moveable[new_pos.segment].IsMember(field->t_id) && !kind->landable[new_pos.segment].IsMember(field->t_id)) 
-          || ((field->unit != NULL)&&(field->unit != this))) {//it isn't in the map, moveable terrain and empty field (or with me)
+        if ((!map.IsInMap(i, j)) || (!kind->moveable[new_pos.segment].IsMember(surface->GetTerrainId(i, j)) && !kind->landable[new_pos.segment].IsMember(surface->GetTerrainId(i, j))) 
+          || ((surface->GetUnit(i, j) != NULL)&&(surface->GetUnit(i, j) != this))) {//it isn't in the map, moveable terrain and empty field (or with me)
           #if DEBUG_EVENTS
             Debug(LogMsg("Tested position: %d, %d, %d. Restlt:false", new_pos.x, new_pos.y, new_pos.segment));
           #endif
@@ -0,0 +1,224 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file dohashunits.cpp
+ *
+ *  Hashtable of units of player.
+ *
+ *  @author Martin Kosalko
+ *  @author Jiri Krejsa
+ *  @author Michal Kral
+ *
+ *  @date 2003, 2004, 2005, 2026
+ */
+
+
+//=========================================================================
+// Included files
+//=========================================================================
+
+#include "cfg.h"
+#include "doalloc.h"
+
+#include "dohashunits.h"
+#include "dologs.h"
+#include "dounits.h"
+
+
+//=========================================================================
+// class THASHTABLE_UNITS
+//=========================================================================
+
+//!< Constructor.
+THASHTABLE_UNITS::THASHTABLE_UNITS(void)
+{
+  table = NULL;
+  size = count = 0;
+}
+
+
+//!< Destructor.
+THASHTABLE_UNITS::~THASHTABLE_UNITS(void)
+{
+  if (table) delete[] table;
+}
+
+
+/**
+ *  Finds entry of unit with identificator @param f_unit_id or empty entry,
+ *  where the unit should be added.
+ *
+ *  @return Index of the entry in table.
+ */
+int THASHTABLE_UNITS::FindIndex(int f_unit_id)
+{
+  int i;
+
+  for (i = HashFunction(f_unit_id); table[i].player_unit && table[i].unit_id != f_unit_id; i = (i + 1) & (size - 1));
+
+  return i;
+}
+
+
+/**
+ *  Doubles size of table and moves all units to new entries.
+ *
+ *  @return @c true on success, @c false if memory could not be allocated.
+ */
+bool THASHTABLE_UNITS::Grow(void)
+{
+  THASH_UNIT * old_table = table;
+  int old_size = size;
+  int i;
+
+  size = old_size ? 2 * old_size : PL_HASHTABLE_UNITS_SIZE;
+
+  if (!(table = NEW THASH_UNIT[size])) {
+    table = old_table;
+    size = old_size;
+    return false;
+  }
+
+  for (i = 0; i < size; i++) {
+    table[i].unit_id = 0;
+    table[i].player_unit = NULL;
+  }
+
+  for (i = 0; i < old_size; i++)
+    if (old_table[i].player_unit) table[FindIndex(old_table[i].unit_id)] = old_table[i];
+
+  if (old_table) delete[] old_table;
+
+  return true;
+}
+
+
+/** 
+ *  Add new hash unit to table (if unit is not in table).
+ *
+ *  @param a_unit_id unique identificator of unit.
+ *  @param a_player_unit pointer to added unit.
+ *
+ *  @sa TPLAYER_UNIT, THASH_UNIT
+ */
+void THASHTABLE_UNITS::AddToHashTable(int a_unit_id, TPLAYER_UNIT * a_player_unit)
+{
+  int i;
+
+  // keep at least one half of entries empty
+  if (2 * (count + 1) > size && !Grow()) {
+    Error(LogMsg("Could not add unit %d to hashtable", a_unit_id));
+    return;
+  }
+
+  i = FindIndex(a_unit_id);
+
+  // if unit with identificator exists in table, return
+  if (table[i].player_unit) return;
+
+  table[i].unit_id = a_unit_id;
+  table[i].player_unit = a_player_unit;
+  count++;
+
+  #if DEBUG_HASHTABLE_UNITS
+    Debug(LogMsg("ADDED UID1:%d UID2:%d PID:%d", a_unit_id, a_player_unit->GetUnitID(), a_player_unit->GetPlayerID()));
+  #endif
+}
+
+/**
+ *  Removes THASH_UNIT specified in @param r_player_unit by identificator of unit.
+ *
+ *  Following entries of the same cluster are moved back, so that no unit
+ *  is separated from its hash position by empty entry.
+ *
+ *  @sa THASH_UNIT
+ */
+void THASHTABLE_UNITS::RemoveFromHashTable(int r_unit_id)
+{
+  int i, j, h;
+
+  if (!table) return;
+
+  i = FindIndex(r_unit_id);
+
+  // test unit
+  if (table[i].player_unit) {
+    for (j = (i + 1) & (size - 1); table[j].player_unit; j = (j + 1) & (size - 1)) {
+      h = HashFunction(table[j].unit_id);
+
+      // entry j may fill the hole at i, if its hash position is not in (i, j]
+      if (((j - h) & (size - 1)) >= ((j - i) & (size - 1))) {
+        table[i] = table[j];
+        i = j;
+      }
+    }
+
+    table[i].unit_id = 0;
+    table[i].player_unit = NULL;
+    count--;
+  }
+  
+  #if DEBUG_HASHTABLE_UNITS
+    Debug(LogMsg("REMOVED UID:%d PID:??", r_unit_id));
+  #endif
+}
+
+/**
+ *  Returns pointer to unit specifird in @param g_unit_id.
+ *
+ *  If unit with identificator @param g_unit_id does not exists, returns NULL.
+ *  @sa TPLAYER_UNIT
+ */
+TPLAYER_UNIT * THASHTABLE_UNITS::GetUnitPointer(int g_unit_id)
+{
+  int i;
+
+  // finds THASH_UNIT
+  if (table) {
+    i = FindIndex(g_unit_id);
+
+    // test unit
+    if (table[i].player_unit) return table[i].player_unit;
+  }
+  
+  #if DEBUG_EVENTS || DEBUG_HASHTABLE_UNITS
+    Warning(LogMsg("Does not exist unit with requested unit_id: U:%d", g_unit_id));
+  #endif
+
+  // in case that unit with requested id doesn't exists return NULL
+  return NULL;
+}
+
+/**
+ *  Returns identificator of unit specifird in @param g_player_unit.
+ *
+ *  If unit does not exists, returns 0.
+ *  @sa TPLAYER_UNIT
+ */
+int THASHTABLE_UNITS::GetUnitID(TPLAYER_UNIT * g_player_unit)
+{
+  if (g_player_unit){
+    return g_player_unit->GetUnitID();
+  }
+  else return 0;
+}
+
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
@@ -0,0 +1,97 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file dohashunits.h
+ *
+ *  Hashtable of units of player. It does not depend on the rest of the game,
+ *  so it is compiled also to the benchmark in bench/bench_hashtable.cpp.
+ *
+ *  @author Martin Kosalko
+ *  @author Jiri Krejsa
+ *  @author Michal Kral
+ *
+ *  @date 2003, 2004, 2005, 2026
+ */
+
+#ifndef __dohashunits_h__
+#define __dohashunits_h__
+
+
+//=========================================================================
+// Forward declarations
+//=========================================================================
+
+class TPLAYER_UNIT;
+struct THASH_UNIT;
+class THASHTABLE_UNITS;
+
+
+//=========================================================================
+// Definitions
+//=========================================================================
+
+/** Initial count of entries in hashtable of units (power of two). */
+#define PL_HASHTABLE_UNITS_SIZE  256
+
+
+//=========================================================================
+// Classes
+//=========================================================================
+
+/** Entry of hashtable of units. Contians unique identificator of unit and pointer to unit. */
+struct THASH_UNIT {
+  int unit_id;                  //!< Unique identificator of unit.
+  TPLAYER_UNIT * player_unit;   //!< Pointer to unit. Empty entries have @c NULL here.
+};
+
+/**
+ *  Hashtable for quick translation between unit identificator and pointer to unit.
+ *
+ *  Entries are stored directly in the table (open addressing with linear
+ *  probing), so adding a unit does not allocate memory until the table grows.
+ *  The table is doubled, when it is filled more than to one half, so unit is
+ *  usually found at the first or second probe.
+ */
+class THASHTABLE_UNITS {
+private:
+  THASH_UNIT * table;           //!< Array of entries.
+  int size;                     //!< Count of entries in #table (power of two).
+  int count;                    //!< Count of units in #table.
+
+  /** Hash function. Sequential identificators get different entries, positive and negative ones are mixed. */
+  int HashFunction(int h_unit_id) { return (int)(((unsigned int)h_unit_id * 2654435761u) & (size - 1)); };
+  int FindIndex(int f_unit_id);
+  bool Grow(void);
+
+public: 
+  TPLAYER_UNIT * GetUnitPointer(int g_unit_id);   // Returns pointer to unit identified by unit_id.
+  int GetUnitID(TPLAYER_UNIT * g_player_unit);    // Returns identificator of unit identified by pointer.
+
+  void AddToHashTable(int a_unit_id, TPLAYER_UNIT * a_player_unit); // Add new hash unit to table.
+  void RemoveFromHashTable(int r_unit_id);                          // Remove hash unit from table.
+
+  THASHTABLE_UNITS(void);   // Constructor.
+  ~THASHTABLE_UNITS(void);  // Destructor.
+};
+
+
+#endif  // __dohashunits_h__
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
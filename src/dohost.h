@@ -57,9 +57,38 @@ enum NetworkingProtocolMessage {
   net_protocol_synchronise  = 0x07,   //!< Synchronisation.
   net_protocol_disconnect   = 0x08,   //!< Disconnect message.
   net_protocol_ping         = 0x09,   //!< Ping request.
+  net_protocol_world_hash   = 0x0A,   //!< Hashes of regions of world and their units.
+  net_protocol_snapshot     = 0x0B,   //!< Snapshot of units of players.
   net_protocol_end
 };
 
+/**
+ *  Subtypes of #net_protocol_ping message.
+ */
+enum NetworkingPingSubtype {
+  net_ping_request          = 0x00,   //!< Ping request of follower connecting to leader.
+  net_ping_reply            = 0x01,   //!< Reply of leader with its time.
+  net_ping_clock_request    = 0x02,   //!< Request for time of remote computer during the game.
+  net_ping_clock_reply      = 0x03,   //!< Reply with time of remote computer.
+};
+
+/**
+ *  Subtypes of #net_protocol_world_hash message.
+ */
+enum NetworkingWorldHashSubtype {
+  net_world_hash_regions    = 0x00,   //!< Hashes of all regions of the world.
+  net_world_hash_request    = 0x01,   //!< Request for units of differing regions.
+  net_world_hash_units      = 0x02,   //!< Hashes of units of one region.
+};
+
+/**
+ *  Subtypes of #net_protocol_snapshot message.
+ */
+enum NetworkingSnapshotSubtype {
+  net_snapshot_request      = 0x00,   //!< Request for snapshot.
+  net_snapshot_chunk        = 0x01,   //!< Chunk of snapshot.
+};
+
 
 //=========================================================================
 // THOST
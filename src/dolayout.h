@@ -39,7 +39,7 @@ class TPOSITION_3D;
 // Definitions
 //========================================================================
 
-#define LAY_UNAVAILABLE_POSITION  255     //!<  Special value that indicates unavailable position.
+#define LAY_UNAVAILABLE_POSITION  MAX_T_SIMPLE  //!<  Special value that indicates unavailable position.
 
 // layout
 #define LAY_SOUTH                   0     //!<  Constants that says direction of moving unit.
@@ -37,6 +37,7 @@
 #include "doleader.h"
 #include "dohost.h"
 #include "doplayers.h"
+#include "doevents.h"
 
 using std::string;
 
@@ -72,12 +73,15 @@ void TLEADER::ConnectFollower (in_addr remote_address, in_port_t remote_port, in
 
   m->Pack (&time, sizeof time);
 
+  /* Codec of events offered by leader. Older followers ignore it. */
+  m->PackByte (event_codec);
+
   SendMessage (m, dest);
 }
 
 void TLEADER::SendPingReply (double request_time) {
   TNET_MESSAGE *m = pool_net_messages->GetFromPool();
-  m->Init_send(net_protocol_ping, 1);
+  m->Init_send(net_protocol_ping, net_ping_reply);
 
   double time = glfwGetTime ();
 
@@ -122,6 +126,9 @@ void TLEADER::SendPlayerArray (string map_name, bool start_game) {
 
   player_array.Unlock ();
 
+  /* Codec of events used in the game, agreed with all followers. */
+  m->PackByte (event_codec);
+
   SendMessage (m);
 }
 
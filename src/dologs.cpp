@@ -38,16 +38,48 @@
 #include "utils.h"
 
 
+//=========================================================================
+// Definitions
+//=========================================================================
+
+/** Storage class of variables, which have separate instance in each thread. */
+#ifdef _MSC_VER
+# define LOG_THREAD_LOCAL __declspec(thread)
+#else
+# define LOG_THREAD_LOCAL __thread
+#endif
+
+/** Time to wait for free space in the ring buffer of the log writer. [seconds] */
+#define LOG_FULL_WAIT   0.001
+
+
+//=========================================================================
+// Structures
+//=========================================================================
+
+/**
+ *  Message waiting in the ring buffer for the log writer.
+ */
+struct TLOG_RECORD {
+  volatile unsigned sequence; //!< Position in the ring buffer, which the record is ready for.
+  int level;                  //!< Log level.
+  const char *header;         //!< Header of the message (static string).
+  const char *file;           //!< Source file, where the message was logged (static string).
+  int line;                   //!< Line in the source file.
+  TLOG_MESSAGE text;          //!< Text of the message.
+};
+
+
 //=========================================================================
 // Variables
 //=========================================================================
 
 
 /**
- *  String for function LogMsg().
+ *  String for function LogMsg(). Each thread has its own string.
  */
-TLOG_MESSAGE log_msg;
-GLFWmutex log_mutex = NULL;            //!< Mutex for LogMsg function.
+static LOG_THREAD_LOCAL TLOG_MESSAGE log_msg;
+GLFWmutex log_mutex = NULL;            //!< Mutex for writing to log files and for log callback.
 
 /**
  *  Error log file. By default, only errors come here. This can be changed by
@@ -67,6 +99,21 @@ FILE *full_log;
  */
 void (*log_callback)(int, const char *, const char *) = NULL;
 
+/**
+ *  Ring buffer of messages for the log writer. Messages are added by any
+ *  thread without locking and are taken only by the log writer thread.
+ */
+static TLOG_RECORD *log_ring = NULL;
+static volatile unsigned log_enqueue_pos = 0;   //!< Position of next added record.
+static unsigned log_dequeue_pos = 0;            //!< Position of next taken record.
+
+static volatile bool log_writer_running = false;  //!< If messages are written by the log writer thread.
+static volatile bool log_writer_quit = false;     //!< Request for the log writer thread to end.
+static volatile int log_writer_producers = 0;     //!< Count of threads, which are using the ring buffer in LogWrite().
+static GLFWthread log_writer_thread = -1;         //!< The log writer thread.
+static GLFWmutex log_writer_mutex = NULL;         //!< Mutex used with #log_writer_cond.
+static GLFWcond log_writer_cond = NULL;           //!< Condition signaled when messages should be written.
+
 
 //=========================================================================
 // LogMsg
@@ -74,8 +121,8 @@ void (*log_callback)(int, const char *, const char *) = NULL;
 
 /**
  *  Construct the log message. This function is similar to sprintf, but the
- *  output is always in @c log_msg, so you don't need to care about memory
- *  allocation.
+ *  output is always in @c log_msg of calling thread, so you don't need to care
+ *  about memory allocation.
  *
  *  @param msg Format of the message
  *  @param ... Arguments
@@ -100,6 +147,309 @@ char *LogMsg(const char *msg, ...)
 }
 
 
+//=========================================================================
+// LogWrite
+//=========================================================================
+
+/**
+ *  Writes one message to a log file. If #DEBUG is defined, information about
+ *  source file and line number, where the message was logged, is printed
+ *  before the message.
+ */
+static void LogToFile(FILE *logfile, const char *header, const char *file, int line, const char *msg)
+{
+#if DEBUG
+# ifdef WINDOWS
+  // On Windows we change (for example) '\Projects\dark-oberon\src\dodata.cpp' to
+  // 'dodata.cpp'.
+  const char *name;
+
+  name = strrchr(file, '\\');
+  if (!name) name = strrchr(file, '/');
+  if (name) file = name + 1;
+# endif
+
+  fprintf(logfile, "[%13s:%4d] ", file, line);
+#endif
+
+  fprintf(logfile, "%s ", header);
+  fprintf(logfile, "%s\n", msg);
+}
+
+
+/**
+ *  Writes one message to all log files and @c stderr according to its level.
+ *  Log files are not flushed.
+ *
+ *  @note Macro #LOG_TO_LOGFILES must be defined, to enable logging to
+ *        logfiles.
+ *  @note Macro #LOG_TO_STDERR must be defined, to enable logging to stderr.
+ */
+static void LogToFiles(int level, const char *header, const char *file, int line, const char *msg)
+{
+#if LOG_TO_STDERR
+  if (level & STDERR_LOG_LEVELS) LogToFile(stderr, header, file, line, msg);
+#endif
+
+#if LOG_TO_LOGFILES
+  if ((level & ERR_LOG_LEVELS) && err_log) LogToFile(err_log, header, file, line, msg);
+  if ((level & FULL_LOG_LEVELS) && full_log) LogToFile(full_log, header, file, line, msg);
+#endif
+}
+
+
+/**
+ *  Flushes log files.
+ */
+static void FlushLogFiles(void)
+{
+#if LOG_TO_LOGFILES
+  if (err_log) fflush(err_log);
+  if (full_log) fflush(full_log);
+#endif
+}
+
+
+/**
+ *  Adds message to the ring buffer of the log writer. Free record is reserved
+ *  by atomic increment of #log_enqueue_pos, so more threads could add
+ *  messages at once.
+ *
+ *  @return @c false if the ring buffer is full.
+ */
+static bool LogPush(int level, const char *header, const char *file, int line, const char *msg)
+{
+  TLOG_RECORD *record;
+  unsigned pos = log_enqueue_pos;
+  size_t len;
+  int diff;
+
+  // reserve record
+  for (;;) {
+    record = log_ring + (pos & (LOG_RING_SIZE - 1));
+    diff = (int)(record->sequence - pos);
+
+    if (!diff) {
+      if (__sync_bool_compare_and_swap(&log_enqueue_pos, pos, pos + 1)) break;
+    }
+    else if (diff < 0) return false;
+
+    pos = log_enqueue_pos;
+  }
+
+  __sync_synchronize();
+
+  record->level = level;
+  record->header = header;
+  record->file = file;
+  record->line = line;
+
+  if ((len = strlen(msg)) >= MAX_LOG_MESSAGE_SIZE) len = MAX_LOG_MESSAGE_SIZE - 1;
+  memcpy(record->text, msg, len);
+  record->text[len] = 0;
+
+  // publish record
+  __sync_synchronize();
+  record->sequence = pos + 1;
+
+  return true;
+}
+
+
+/**
+ *  Writes all messages from the ring buffer. It is called only by one thread
+ *  at once.
+ *
+ *  @return Count of written messages.
+ */
+static int LogDrain(void)
+{
+  TLOG_RECORD *record;
+  int count = 0;
+
+  glfwLockMutex(log_mutex);
+
+  for (;;) {
+    record = log_ring + (log_dequeue_pos & (LOG_RING_SIZE - 1));
+    if ((int)(record->sequence - (log_dequeue_pos + 1)) < 0) break;
+
+    __sync_synchronize();
+    LogToFiles(record->level, record->header, record->file, record->line, record->text);
+    __sync_synchronize();
+
+    // release record for next round of the ring
+    record->sequence = log_dequeue_pos + LOG_RING_SIZE;
+    log_dequeue_pos++;
+    count++;
+  }
+
+  if (count) FlushLogFiles();
+
+  glfwUnlockMutex(log_mutex);
+
+  return count;
+}
+
+
+/**
+ *  Function of the log writer thread. Queued messages are written in batches
+ *  every #LOG_WRITE_PERIOD, or immediately when the thread is signaled.
+ */
+static void GLFWCALL LogWriterThread(void *arg)
+{
+  glfwLockMutex(log_writer_mutex);
+
+  while (!log_writer_quit) {
+    glfwWaitCond(log_writer_cond, log_writer_mutex, LOG_WRITE_PERIOD);
+    glfwUnlockMutex(log_writer_mutex);
+
+    LogDrain();
+
+    glfwLockMutex(log_writer_mutex);
+  }
+
+  glfwUnlockMutex(log_writer_mutex);
+}
+
+
+/**
+ *  Writes log message to log files and @c stderr. When the log writer is
+ *  running, the message is only copied to its ring buffer and the calling
+ *  thread does not wait for any lock or file operation. Errors are written
+ *  immediately together with all queued messages, so they are in the files
+ *  even if the program crashes. Otherwise the message is written
+ *  immediately.
+ *
+ *  @param level   Log level (#LOG_DEBUG, #LOG_INFO, #LOG_WARNING, #LOG_ERROR, #LOG_CRITICAL).
+ *  @param header  Header to be printed before message (static string).
+ *  @param file    Source file, where the message was logged (static string).
+ *  @param line    Line in the source file.
+ *  @param msg     Log message.
+ */
+void LogWrite(int level, const char *header, const char *file, int line, const char *msg)
+{
+  int levels = 0;
+
+#if LOG_TO_STDERR
+  levels |= STDERR_LOG_LEVELS;
+#endif
+#if LOG_TO_LOGFILES
+  levels |= ERR_LOG_LEVELS | FULL_LOG_LEVELS;
+#endif
+
+  if (!(level & levels) || !msg) return;
+
+  if (log_writer_running) {
+    // ring buffer and condition are not destroyed by StopLogWriter() until all producers leave
+    __sync_fetch_and_add(&log_writer_producers, 1);
+
+    while (log_writer_running) {
+      if (LogPush(level, header, file, line, msg)) {
+        if (level & (LOG_ERROR | LOG_CRITICAL)) LogDrain();
+        else if (level & LOG_WARNING) glfwSignalCond(log_writer_cond);
+
+        __sync_fetch_and_sub(&log_writer_producers, 1);
+        return;
+      }
+
+      // ring buffer is full, wait for the log writer
+      glfwSignalCond(log_writer_cond);
+      glfwSleep(LOG_FULL_WAIT);
+    }
+
+    __sync_fetch_and_sub(&log_writer_producers, 1);
+  }
+
+  if (log_mutex) glfwLockMutex(log_mutex);
+
+  LogToFiles(level, header, file, line, msg);
+  FlushLogFiles();
+
+  if (log_mutex) glfwUnlockMutex(log_mutex);
+}
+
+
+/**
+ *  Starts the log writer thread. Must be called after CreateLogMutex().
+ *
+ *  @return @c true on success, @c false if messages will be written
+ *          immediately by logging threads.
+ */
+bool StartLogWriter(void)
+{
+  unsigned i;
+
+  if (log_writer_running || !log_mutex) return false;
+
+  // ring buffer is not allocated by NEW, because memory system logs
+  if (!(log_ring = (TLOG_RECORD *)malloc(LOG_RING_SIZE * sizeof(TLOG_RECORD)))) {
+    Error("Could not allocate log ring buffer");
+    return false;
+  }
+
+  for (i = 0; i < LOG_RING_SIZE; i++) log_ring[i].sequence = i;
+  log_enqueue_pos = log_dequeue_pos = 0;
+
+  log_writer_mutex = glfwCreateMutex();
+  log_writer_cond = glfwCreateCond();
+  log_writer_quit = false;
+
+  if (!log_writer_mutex || !log_writer_cond ||
+      (log_writer_thread = glfwCreateThread(LogWriterThread, NULL)) < 0)
+  {
+    if (log_writer_cond) glfwDestroyCond(log_writer_cond);
+    if (log_writer_mutex) glfwDestroyMutex(log_writer_mutex);
+    log_writer_cond = NULL;
+    log_writer_mutex = NULL;
+    free(log_ring);
+    log_ring = NULL;
+
+    Error("Could not start log writer thread");
+    return false;
+  }
+
+  __sync_synchronize();
+  log_writer_running = true;
+
+  return true;
+}
+
+
+/**
+ *  Stops the log writer thread. All queued messages are written and next
+ *  messages are written immediately by logging threads.
+ */
+void StopLogWriter(void)
+{
+  if (!log_writer_running) return;
+
+  log_writer_running = false;
+  __sync_synchronize();
+
+  // wait for threads, which are just adding messages
+  while (log_writer_producers > 0) glfwSleep(LOG_FULL_WAIT);
+
+  glfwLockMutex(log_writer_mutex);
+  log_writer_quit = true;
+  glfwSignalCond(log_writer_cond);
+  glfwUnlockMutex(log_writer_mutex);
+
+  glfwWaitThread(log_writer_thread, GLFW_WAIT);
+  log_writer_thread = -1;
+
+  // messages added while the thread was ending
+  LogDrain();
+
+  glfwDestroyCond(log_writer_cond);
+  glfwDestroyMutex(log_writer_mutex);
+  log_writer_cond = NULL;
+  log_writer_mutex = NULL;
+
+  free(log_ring);
+  log_ring = NULL;
+}
+
+
 //=========================================================================
 // LogFiles
 //=========================================================================
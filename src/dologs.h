@@ -111,6 +111,18 @@
  */
 #define MAX_LOG_MESSAGE_SIZE 1024
 
+/**
+ *  Count of messages in the ring buffer of the log writer. It must be a power
+ *  of two.
+ */
+#define LOG_RING_SIZE        512
+
+/**
+ *  Period, in which the log writer writes queued messages. Warnings and more
+ *  severe messages are written immediately. [seconds]
+ */
+#define LOG_WRITE_PERIOD     0.02
+
 
 //========================================================================
 // Included files
@@ -154,118 +166,10 @@ extern GLFWmutex log_mutex;
 // Macros
 //========================================================================
 
-/**
- *  Write information about source file and line number, where one of the
- *  macros Debug(), Info(), Warning(), Error(), Critical() was used.
- *
- *  @param logfile Log file (FILE *).
- *
- *  @note Macro #DEBUG must be defined to enable this.
- */
-#if DEBUG
-# ifdef WINDOWS
-// On Windows we change (for example) '\Projects\dark-oberon\src\dodata.cpp' to
-// 'dodata.cpp'.
-// For some Windows compilers (for example Dev C++) the same thing is done when
-// forward slashes are used instead of backward slashes in pathnames. For
-// example 'src/dodata.cpp' is changed to 'dodata.cpp'.
-#  define LogFileInfo(logfile) \
-     do { \
-       char *file; \
-       file = strrchr(__FILE__, '\\'); \
-       if (!file) file = strrchr(__FILE__, '/'); \
-       if (file) file++; \
-       else file = __FILE__; \
-       fprintf(logfile, "[%13s:%4d] ", file, __LINE__); \
-       fflush (logfile); \
-     } while (0)
-
-# else // on UNIX
-
-#  define LogFileInfo(logfile) \
-     do { \
-       fprintf(logfile, "[%13s:%4d] ", __FILE__, __LINE__); \
-       fflush (logfile); \
-     } while (0)
-
-# endif // #ifdef WINDOWS
-
-#else // not DEBUG
-# define LogFileInfo(logfile)
-#endif // #if DEBUG
-
-
-/**
- *  Log log message to logfile. If #DEBUG is defined, information about
- *  source file and line number, where the Log() was used, is printed using
- *  LogFileInfo().
- *
- *  @param logfile Log file (FILE *).
- *  @param header  Header to be printed (char *).
- *  @param msg     Log message (char *).
- *
- *  @note Macro #LOG_TO_LOGFILES must be defined, to enable logging to
- *        logfiles.
- */
-#define Log_logfile(logfile, header, msg) \
-do { \
-  if (logfile != NULL) { \
-    LogFileInfo(logfile); \
-    fprintf(logfile, "%s ", header); \
-    fprintf(logfile, "%s\n", msg); \
-    fflush(logfile); \
-  } \
-} while (0)
-
-/**
- *  Log log message to logfiles.
- *
- *  @param level   Log level (#LOG_DEBUG, #LOG_INFO, #LOG_WARNING, #LOG_ERROR, #LOG_CRITICAL).
- *  @param header  Header to be printed (char *).
- *  @param msg     Log message (char *).
- *
- *  @note Macro #LOG_TO_LOGFILES must be defined, to enable logging to
- *        logfiles.
- */
-#if LOG_TO_LOGFILES
-# define Log_logfiles(level, header, msg) \
-do { \
-  if (level & ERR_LOG_LEVELS) \
-    Log_logfile(err_log, header, msg); \
-  if (level & FULL_LOG_LEVELS) \
-    Log_logfile(full_log, header, msg); \
-} while (0)
-#else
-# define Log_logfiles(level, header, msg)
-#endif
-
-/**
- *  Log log message to stderr. If #DEBUG is defined, information about
- *  source file and line number, where the Log() was used, is printed using
- *  LogFileInfo().
- *
- *  @param level  Log level (#LOG_DEBUG, #LOG_INFO, #LOG_WARNING, #LOG_ERROR, #LOG_CRITICAL).
- *  @param header Header to be printed (char *).
- *  @param msg    Log message (char *).
- *
- *  @note Macro #LOG_TO_STDERR must be defined, to enable logging to stderr.
- */
-#if LOG_TO_STDERR
-# define Log_stderr(level, header, msg) \
-do { \
-  if (level & STDERR_LOG_LEVELS) { \
-    LogFileInfo(stderr); \
-    fprintf(stderr, "%s ", header); \
-    fprintf(stderr, "%s\n", msg); \
-  } \
-} while (0)
-#else
-# define Log_stderr(level, header, msg)
-#endif
-
 /**
  *  Log a messages with external callback registered with
- *  RegisterLogCallback().
+ *  RegisterLogCallback(). The callback is called immediately by the logging
+ *  thread, so it is serialized with #log_mutex.
  *
  *  @param level   Log level (#LOG_DEBUG, #LOG_INFO, #LOG_WARNING, #LOG_ERROR, #LOG_CRITICAL).
  *  @param header  Header to be printed before message (char *).
@@ -275,20 +179,34 @@ do { \
  *  with external callback.
  */
 #if LOG_TO_EXTERNAL_CALLBACK
-# define Log_callback(level, header, msg) \
+# ifdef NEW_GLFW3
+#  define Log_callback(level, header, msg) \
+do { \
+  if ((level & EXTERNAL_LOG_LEVELS) && log_callback) { \
+    mtx_lock(&log_mutex); \
+    if (log_callback) log_callback (level, header, msg); \
+    mtx_unlock(&log_mutex); \
+  } \
+} while (0)
+# else
+#  define Log_callback(level, header, msg) \
 do { \
-  if (level & EXTERNAL_LOG_LEVELS) { \
+  if ((level & EXTERNAL_LOG_LEVELS) && log_callback) { \
+    if (log_mutex) glfwLockMutex(log_mutex); \
     if (log_callback) log_callback (level, header, msg); \
+    if (log_mutex) glfwUnlockMutex(log_mutex); \
   } \
 } while (0)
+# endif
 #else
 # define Log_callback(level, header, msg)
 #endif
 
 /**
- *  Log a messages. It will be logged to logfiles using Log_logfiles(), @c
- *  stderr using Log_stderr() and with external callback function using
- *  Log_callback().
+ *  Log a messages. It will be logged to logfiles and @c stderr using
+ *  LogWrite() and with external callback function using Log_callback().
+ *  Source file and line number, where the Log() was used, are passed to
+ *  LogWrite(), which prints them if #DEBUG is defined.
  *
  *  @param level   Log level (#LOG_DEBUG, #LOG_INFO, #LOG_WARNING, #LOG_ERROR, #LOG_CRITICAL).
  *  @param header  Header to be printed before message (char *).
@@ -302,35 +220,14 @@ do { \
  *
  *  @see Debug(), Info(), Warning(), Error(), Critical()
  */
-#ifdef NEW_GLFW3
-
 #define Log(level, header, msg) \
 do { \
-  mtx_lock(&log_mutex); \
-  \
-  Log_stderr(level, header, msg); \
-  Log_logfiles(level, header, msg); \
-  Log_callback(level, header, msg); \
+  const char *log_text = (msg); \
   \
-  mtx_unlock(&log_mutex); \
+  LogWrite(level, header, __FILE__, __LINE__, log_text); \
+  Log_callback(level, header, log_text); \
 } while (0)
 
-#else
-
-#define Log(level, header, msg) \
-do { \
-  if (log_mutex) glfwLockMutex(log_mutex); \
-  \
-  Log_stderr(level, header, msg); \
-  Log_logfiles(level, header, msg); \
-  Log_callback(level, header, msg); \
-  \
-  if (log_mutex) glfwUnlockMutex(log_mutex); \
-} while (0)
-
-#endif
-
-
 
 /** Log info messages. It is implemented by the macro Log(). */
 #define Info(msg)       Log(LOG_INFO,     TEXT_INFO,     (msg))
@@ -365,10 +262,14 @@ extern void (*log_callback)(int, const char *, const char *);
 //========================================================================
 
 char *LogMsg(const char *msg, ...);
+void LogWrite(int level, const char *header, const char *file, int line, const char *msg);
 
 bool CreateLogMutex(void);
 void DestroyLogMutex(void);
 
+bool StartLogWriter(void);
+void StopLogWriter(void);
+
 bool OpenLogFiles(void);
 void CloseLogFiles(void);
 
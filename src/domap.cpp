@@ -29,6 +29,7 @@
 
 #include <glfw.h>
 #include <stdlib.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -91,6 +92,19 @@ void TTERR_BASIC::Draw(void)
 }
 
 
+/**
+ *  Draws terrain regardless of active area. Used to compile cached terrain
+ *  blocks.
+ */
+void TTERR_BASIC::DrawStatic(void)
+{
+  if (anim_id < 0) return;
+
+  SetMapPosition(pos.x, pos.y);
+  pitem->Draw(anim_id);
+}
+
+
 /**
  *  ???
  *
@@ -195,44 +209,137 @@ void TMAP_POOLED_LIST::AttackEnemy(TMAP_UNIT *enemy, bool watchers_list)
 //=========================================================================
 
 
-TMAP_SURFACE::TMAP_SURFACE()        //!< Basic constructor.
+/**
+ *  Constructor. Fields are empty, arrays of rarely used data are not
+ *  allocated.
+ */
+TMAP_SURFACE_CHUNK::TMAP_SURFACE_CHUNK()
+{
+  for (int i = 0; i < MAP_SURFACE_CHUNK_FIELDS; i++) {
+    t_id[i] = MAP_EMPTY_SURFACE;
+    unit[i] = ghost[i] = NULL;
+  }
+
+  activity = NULL;
+  aimers = watchers = NULL;
+}
+
+
+/**
+ *  Destructor.
+ */
+TMAP_SURFACE_CHUNK::~TMAP_SURFACE_CHUNK()
 {
-  //TODO
-  int i = 8,j=0;
+  int i;
 
-  t_id = 0;
-  unit = ghost = NULL;
-  activity = NEW TNEURON_VALUE[8];       //<! Every player have his own activity. There should be player_array.GetCount()
-  for (j=0;j<i;j++)
-    activity[j]=0;
+  if (activity) delete[] activity;
+
+  if (aimers) {
+    for (i = 0; i < MAP_SURFACE_CHUNK_FIELDS; i++)
+      if (aimers[i]) delete aimers[i];
+    delete[] aimers;
+  }
 
-  aimers = NEW TMAP_POOLED_LIST(reinterpret_cast<TPOOL<TPOOLED_LIST::TNODE>*>(map.GetAimersPool()));
-  watchers = NEW TMAP_POOLED_LIST(reinterpret_cast<TPOOL<TPOOLED_LIST::TNODE>*>(map.GetWatchersPool()));
+  if (watchers) {
+    for (i = 0; i < MAP_SURFACE_CHUNK_FIELDS; i++)
+      if (watchers[i]) delete watchers[i];
+    delete[] watchers;
+  }
 }
 
 
-TMAP_SURFACE::~TMAP_SURFACE()
+/**
+ *  Creates map surface with empty fields.
+ *
+ *  @param width   Width of the surface. [mapels]
+ *  @param height  Height of the surface. [mapels]
+ *
+ *  @return @c true on success, @c false otherwise.
+ */
+bool TMAP_SURFACE::Create(int width, int height)
 {
-  if (activity) 
-    delete[] activity;
+  Clear();
 
-  delete aimers;
-  delete watchers;
-};
+  chunks_height = (height + MAP_SURFACE_CHUNK_SIZE - 1) >> MAP_SURFACE_CHUNK_SHIFT;
+  chunks_count = ((width + MAP_SURFACE_CHUNK_SIZE - 1) >> MAP_SURFACE_CHUNK_SHIFT) * chunks_height;
+
+  if (!(chunks = NEW TMAP_SURFACE_CHUNK[chunks_count])) {
+    chunks_height = chunks_count = 0;
+    return false;
+  }
+
+  return true;
+}
+
+
+/**
+ *  Deletes map surface.
+ */
+void TMAP_SURFACE::Clear(void)
+{
+  if (chunks) delete[] chunks;
+
+  chunks = NULL;
+  chunks_height = chunks_count = 0;
+}
+
+
+/** @return The method returns the list of units which watch the field.*/
+TMAP_POOLED_LIST* TMAP_SURFACE::GetWatchersList(int x, int y)
+{
+  TMAP_SURFACE_CHUNK *chunk = GetChunk(x, y);
+  int i = GetIndex(x, y);
+
+  if (!chunk->watchers) {
+    chunk->watchers = NEW TMAP_POOLED_LIST*[MAP_SURFACE_CHUNK_FIELDS];
+    for (int j = 0; j < MAP_SURFACE_CHUNK_FIELDS; j++) chunk->watchers[j] = NULL;
+  }
+
+  if (!chunk->watchers[i])
+    chunk->watchers[i] = NEW TMAP_POOLED_LIST(reinterpret_cast<TPOOL<TPOOLED_LIST::TNODE>*>(map.GetWatchersPool()));
+
+  return chunk->watchers[i];
+}
+
+
+/** @return The method returns the list of units which could aim the field.*/
+TMAP_POOLED_LIST* TMAP_SURFACE::GetAimersList(int x, int y)
+{
+  TMAP_SURFACE_CHUNK *chunk = GetChunk(x, y);
+  int i = GetIndex(x, y);
+
+  if (!chunk->aimers) {
+    chunk->aimers = NEW TMAP_POOLED_LIST*[MAP_SURFACE_CHUNK_FIELDS];
+    for (int j = 0; j < MAP_SURFACE_CHUNK_FIELDS; j++) chunk->aimers[j] = NULL;
+  }
+
+  if (!chunk->aimers[i])
+    chunk->aimers[i] = NEW TMAP_POOLED_LIST(reinterpret_cast<TPOOL<TPOOLED_LIST::TNODE>*>(map.GetAimersPool()));
+
+  return chunk->aimers[i];
+}
 
 
 /**
- *  Returns activity of my and enemy units separately.
+ *  Returns activity of my and enemy units on the field separately.
  *
+ *  @param x               X coordinate of the field.
+ *  @param y               Y coordinate of the field.
  *  @param PlayerID        ID of player I want to know his actitivy (I've got his and enemy activity).
  *  @param my_activity     I will have here activity of player with @PlayerID.
  *  @param enemy_activity  Here will be sum of activity of other players.
  */
-void TMAP_SURFACE::GetActivity(const T_SIMPLE PlayerID,  TNEURON_VALUE *my_activity, TNEURON_VALUE *enemy_activity)
+void TMAP_SURFACE::GetActivity(int x, int y, const T_SIMPLE PlayerID,  TNEURON_VALUE *my_activity, TNEURON_VALUE *enemy_activity)
 {
+  TMAP_SURFACE_CHUNK *chunk = GetChunk(x, y);
+  TNEURON_VALUE *activity;
   T_SIMPLE i=0;
   TNEURON_VALUE my = 0, enemy = 0;
 
+  if (!chunk->activity) return;               //<! Nobody was active here.
+
+  activity = chunk->activity + GetIndex(x, y) * PL_MAX_PLAYERS;
+
   for (i=1;i<player_array.GetCount();i++)     //<! For every player. (I don't care abour hyper player's activity)
     if (i == PlayerID)                        //<! If it's me.
       my = activity[i];                       //<! My activity is separately.
@@ -244,16 +351,48 @@ void TMAP_SURFACE::GetActivity(const T_SIMPLE PlayerID,  TNEURON_VALUE *my_activ
 }
 
 /**
- *  Decrease activity counters of all players (so it will not grow to infinity)
+ *  Decrease activity counters of all players on all fields (so it will not
+ *  grow to infinity). Only chunks with some activity are visited.
  *
  *  @param factor     Factor of decreasing.
  */
 void TMAP_SURFACE::DecreaseActivity(T_SIMPLE factor)
 {
+  TNEURON_VALUE *activity;
+  int c, f;
   T_SIMPLE i=0;
 
-  for (i=0;i<player_array.GetCount();i++)         //<! For every player.
-    activity[i] = activity[i]/factor;             //<! Decrease by factor.
+  for (c = 0; c < chunks_count; c++) {
+    if (!(activity = chunks[c].activity)) continue;
+
+    for (f = 0; f < MAP_SURFACE_CHUNK_FIELDS; f++, activity += PL_MAX_PLAYERS)
+      for (i=0;i<player_array.GetCount();i++)       //<! For every player.
+        activity[i] = activity[i]/factor;           //<! Decrease by factor.
+  }
+}
+
+
+/**
+ *  Increase activity counter of the player on the field. Counters of the
+ *  chunk are allocated on the first increase.
+ *
+ *  @param x          X coordinate of the field.
+ *  @param y          Y coordinate of the field.
+ *  @param PlayerID   ID of active player.
+ *  @param added      Added activity.
+ */
+void TMAP_SURFACE::IncreaseActivity(int x, int y, const T_SIMPLE PlayerID, TNEURON_VALUE added)
+{
+  TMAP_SURFACE_CHUNK *chunk = GetChunk(x, y);
+  int i;
+
+  if (!chunk->activity) {
+    chunk->activity = NEW TNEURON_VALUE[MAP_SURFACE_CHUNK_FIELDS * PL_MAX_PLAYERS];   //<! Every player have his own activity.
+    for (i = 0; i < MAP_SURFACE_CHUNK_FIELDS * PL_MAX_PLAYERS; i++)
+      chunk->activity[i] = 0;
+  }
+
+  chunk->activity[GetIndex(x, y) * PL_MAX_PLAYERS + PlayerID] += added;
 }
 
 //=========================================================================
@@ -268,9 +407,13 @@ TMAP_SEGMENT::TMAP_SEGMENT()
   terrf_count = terro_count = 0;
   terrf = NULL;
   terro = NULL;
-  surface = NULL;
   average_surface_difficulty = 0;
-  tex_radar_id = 0;
+  radar_dirty = true;
+
+  chunks = NULL;
+  chunks_width = chunks_count = 0;
+  chunks_dirty = false;
+  chunks_disabled = false;
 }
 
 
@@ -280,8 +423,6 @@ TMAP_SEGMENT::TMAP_SEGMENT()
 TMAP_SEGMENT::~TMAP_SEGMENT()
 {
   Clear();
-
-  if (tex_radar_id) glDeleteTextures(1, &tex_radar_id);
 }
 
 
@@ -317,13 +458,30 @@ void TMAP_SEGMENT::Clear(void)
   terrl.DestroyList();
 
   // surface
-  if (surface) DeleteMapSurface(surface);
-  surface = NULL;
+  surface.Clear();
+
+  ClearChunks();
 
   average_surface_difficulty = 0;
 }
 
 
+/**
+ *  Deletes cached terrain blocks.
+ */
+void TMAP_SEGMENT::ClearChunks(void)
+{
+  if (chunks) {
+    delete[] chunks;
+    chunks = NULL;
+  }
+
+  chunks_width = chunks_count = 0;
+  chunks_dirty = false;
+  chunks_disabled = false;
+}
+
+
 /**
  *  Adds layer to segment.
  *
@@ -350,7 +508,233 @@ void TMAP_SEGMENT::UpdateTerrainId(int x, int y, int width, int height, TTERRAIN
 {
   for (int i = 0; i < width; i++)
     for (int j = 0; j < height; j++)
-      surface[x + i][y + j].t_id = field[i][j];
+      surface.SetTerrainId(x + i, y + j, field[i][j]);
+
+  radar_dirty = true;
+
+  // invalidate cached blocks
+  if (chunks) {
+    for (int i = x / MAP_AREA_SIZE; i <= (x + width - 1) / MAP_AREA_SIZE && i < chunks_width; i++)
+      for (int j = y / MAP_AREA_SIZE; j <= (y + height - 1) / MAP_AREA_SIZE; j++)
+        if (j * chunks_width + i < chunks_count) chunks[j * chunks_width + i].dirty = true;
+
+    chunks_dirty = true;
+  }
+}
+
+
+/**
+ *  Sorts drawn terrain items to blocks by their position. Items of every block
+ *  keep their order from @p items.
+ *
+ *  @param items   Table of terrain items.
+ *  @param count   Count of items.
+ *  @param cwidth  Count of blocks in x coordinate.
+ *  @param first   Index of first item of each block in @p sorted (output,
+ *                 count of blocks + 1 values).
+ *  @param ccount  Count of all blocks.
+ *  @param sorted  Items sorted by blocks (output, at least @p count items).
+ */
+static void SortToChunks(TTERR_BASIC **items, int count, int cwidth, int *first, int ccount, TTERR_BASIC **sorted)
+{
+  int i, c;
+
+  for (c = 0; c <= ccount; c++) first[c] = 0;
+
+  // count items in blocks
+  for (i = 0; i < count; i++)
+    if (items[i]->IsDrawn())
+      first[(items[i]->pos.y / MAP_AREA_SIZE) * cwidth + items[i]->pos.x / MAP_AREA_SIZE + 1]++;
+
+  for (c = 0; c < ccount; c++) first[c + 1] += first[c];
+
+  // place items
+  for (i = 0; i < count; i++)
+    if (items[i]->IsDrawn()) {
+      c = (items[i]->pos.y / MAP_AREA_SIZE) * cwidth + items[i]->pos.x / MAP_AREA_SIZE;
+      sorted[first[c]++] = items[i];
+    }
+
+  // restore starts of blocks
+  for (c = ccount; c > 0; c--) first[c] = first[c - 1];
+  first[0] = 0;
+}
+
+
+/**
+ *  Tests if drawn terrain item reaches out of its block.
+ */
+static bool CrossesChunk(TTERR_BASIC *item)
+{
+  return item->IsDrawn()
+    && ((item->pos.x % MAP_AREA_SIZE) + item->pitem->width > MAP_AREA_SIZE
+    || (item->pos.y % MAP_AREA_SIZE) + item->pitem->height > MAP_AREA_SIZE);
+}
+
+
+/**
+ *  Compiles runs of static items to display lists and remembers animated
+ *  items between them.
+ *
+ *  @param items  Items of the block in drawing order.
+ *  @param count  Count of the items.
+ */
+void TTERR_CHUNK_RUNS::Compile(TTERR_BASIC **items, int count)
+{
+  int i, a;
+
+  Clear();
+
+  for (i = 0; i < count; i++)
+    if (items[i]->IsAnimated()) animated_count++;
+
+  if (!(lists = glGenLists(animated_count + 1))) {
+    animated_count = 0;
+    return;
+  }
+
+  if (animated_count) animated = NEW TTERR_BASIC *[animated_count];
+
+  glNewList(lists, GL_COMPILE);
+
+  for (i = a = 0; i < count; i++) {
+    if (items[i]->IsAnimated()) {
+      glEndList();
+      animated[a++] = items[i];
+      glNewList(lists + a, GL_COMPILE);
+    }
+    else items[i]->DrawStatic();
+  }
+
+  glEndList();
+}
+
+
+/**
+ *  Draws the runs and animated items between them.
+ */
+void TTERR_CHUNK_RUNS::Draw(void)
+{
+  if (!lists) return;
+
+  for (int i = 0; i < animated_count; i++) {
+    glCallList(lists + i);
+    animated[i]->Draw();
+  }
+
+  glCallList(lists + animated_count);
+}
+
+
+/**
+ *  Deletes display lists and table of animated items.
+ */
+void TTERR_CHUNK_RUNS::Clear(void)
+{
+  if (lists) glDeleteLists(lists, animated_count + 1);
+  if (animated) delete[] animated;
+
+  lists = 0;
+  animated = NULL;
+  animated_count = 0;
+}
+
+
+/**
+ *  Compiles display lists of changed terrain blocks. Blocks are created at
+ *  first call after the map is loaded.
+ *
+ *  Blocks are drawn one after another, so items are drawn in order of the map
+ *  file only within their block. If some item reaches out of its block, it
+ *  could be covered by item of next block, which is before it in the file.
+ *  Such terrain is not cached at all and it is drawn item by item. Items of
+ *  shipped maps have size 5 and are aligned to 5 mapels, so they never cross
+ *  borders of blocks of #MAP_AREA_SIZE.
+ */
+void TMAP_SEGMENT::UpdateChunks(void)
+{
+  TLIST<TTERR_LAYER>::TNODE<TTERR_LAYER> *node;
+  TTERR_BASIC **layers, **sorted_frags, **sorted_layers;
+  int *first_frag, *first_layer;
+  int layers_count = 0;
+  TTERR_CHUNK *chunk;
+  int i, c;
+
+  if (chunks_disabled) return;
+
+  if (!chunks) {
+    for (i = 0; i < terrf_count && !chunks_disabled; i++) chunks_disabled = CrossesChunk(terrf[i]);
+    for (node = terrl.GetFirst(); node && !chunks_disabled; node = node->GetNext()) chunks_disabled = CrossesChunk(node->GetPitem());
+
+    if (chunks_disabled) {
+      Info(LogMsg("Terrain of segment %d crosses borders of blocks, it will not be cached", int(this - map.segments)));
+      return;
+    }
+
+    chunks_width = (map.width + MAP_AREA_SIZE - 1) / MAP_AREA_SIZE;
+    chunks_count = chunks_width * ((map.height + MAP_AREA_SIZE - 1) / MAP_AREA_SIZE);
+
+    if (!chunks_count) return;
+
+    chunks = NEW TTERR_CHUNK[chunks_count];
+
+    for (c = 0; c < chunks_count; c++) {
+      chunks[c].dirty = true;
+      chunks[c].empty = true;
+    }
+
+    chunks_dirty = true;
+  }
+
+  if (!chunks_dirty) return;
+
+  // layers to table
+  for (node = terrl.GetFirst(); node; node = node->GetNext()) layers_count++;
+
+  layers = NEW TTERR_BASIC *[layers_count + 1];
+  for (i = 0, node = terrl.GetFirst(); node; node = node->GetNext()) layers[i++] = node->GetPitem();
+
+  sorted_frags = NEW TTERR_BASIC *[terrf_count + 1];
+  sorted_layers = NEW TTERR_BASIC *[layers_count + 1];
+  first_frag = NEW int[chunks_count + 1];
+  first_layer = NEW int[chunks_count + 1];
+
+  SortToChunks((TTERR_BASIC **)terrf, terrf_count, chunks_width, first_frag, chunks_count, sorted_frags);
+  SortToChunks(layers, layers_count, chunks_width, first_layer, chunks_count, sorted_layers);
+
+  for (c = 0, chunk = chunks; c < chunks_count; c++, chunk++) {
+    if (!chunk->dirty) continue;
+
+    chunk->dirty = false;
+    chunk->empty = (first_frag[c] == first_frag[c + 1] && first_layer[c] == first_layer[c + 1]);
+
+    // envelope of the block
+    chunk->x1 = chunk->x2 = (c % chunks_width) * MAP_AREA_SIZE;
+    chunk->y1 = chunk->y2 = (c / chunks_width) * MAP_AREA_SIZE;
+
+    for (i = first_frag[c]; i < first_frag[c + 1]; i++) {
+      TTERR_BASIC *t = sorted_frags[i];
+      if (t->pos.x + t->pitem->width - 1 > chunk->x2) chunk->x2 = t->pos.x + t->pitem->width - 1;
+      if (t->pos.y + t->pitem->height - 1 > chunk->y2) chunk->y2 = t->pos.y + t->pitem->height - 1;
+    }
+    for (i = first_layer[c]; i < first_layer[c + 1]; i++) {
+      TTERR_BASIC *t = sorted_layers[i];
+      if (t->pos.x + t->pitem->width - 1 > chunk->x2) chunk->x2 = t->pos.x + t->pitem->width - 1;
+      if (t->pos.y + t->pitem->height - 1 > chunk->y2) chunk->y2 = t->pos.y + t->pitem->height - 1;
+    }
+
+    // compile lists
+    chunk->frags.Compile(sorted_frags + first_frag[c], first_frag[c + 1] - first_frag[c]);
+    chunk->layers.Compile(sorted_layers + first_layer[c], first_layer[c + 1] - first_layer[c]);
+  }
+
+  delete[] layers;
+  delete[] sorted_frags;
+  delete[] sorted_layers;
+  delete[] first_frag;
+  delete[] first_layer;
+
+  chunks_dirty = false;
 }
 
 
@@ -481,15 +865,44 @@ void TMAP_SEGMENT::Draw(void)
 
 
 /**
- *  Draws units from segment to radar.
+ *  Draws surface of the segment. Static terrain is drawn from cached blocks,
+ *  only animated fragments and layers are drawn one by one between the static
+ *  runs of their block. Terrain, which is not cached, is drawn item by item
+ *  in order of the map file.
+ *
+ *  @param whole  If all blocks should be drawn, not only the blocks in active
+ *                area.
  */
-void TMAP_SEGMENT::DrawSurface(void)
+void TMAP_SEGMENT::DrawSurface(bool whole)
 {
+  TLIST<TTERR_LAYER>::TNODE<TTERR_LAYER> *node;
+  TTERR_CHUNK *chunk;
   int i;
 
+  UpdateChunks();
+
   glColor4f(1.0, 1.0, 1.0, 1.0);
-  for (i = 0; i < terrf_count; i++) if (terrf[i]->IsInActiveArea()) terrf[i]->Draw();
-  terrl.ApplyFunction(&TTERR_LAYER::Draw);
+
+  // terrain is not cached
+  if (!chunks) {
+    for (i = 0; i < terrf_count; i++)
+      if (terrf[i]->IsInActiveArea()) terrf[i]->Draw();
+
+    for (node = terrl.GetFirst(); node; node = node->GetNext())
+      node->GetPitem()->Draw();
+
+    return;
+  }
+
+  // fragments
+  for (i = 0, chunk = chunks; i < chunks_count; i++, chunk++)
+    if (!chunk->empty && (whole || map.active_area.IsInArea(chunk->x1, chunk->y1, chunk->x2 - chunk->x1 + 1, chunk->y2 - chunk->y1 + 1)))
+      chunk->frags.Draw();
+
+  // layers
+  for (i = 0, chunk = chunks; i < chunks_count; i++, chunk++)
+    if (!chunk->empty && (whole || map.active_area.IsInArea(chunk->x1, chunk->y1, chunk->x2 - chunk->x1 + 1, chunk->y2 - chunk->y1 + 1)))
+      chunk->layers.Draw();
 }
 
 
@@ -511,7 +924,7 @@ double TMAP_SEGMENT::CalculateAverageDifficulty(T_SIMPLE width, T_SIMPLE height)
   for (i = 0; i < width; i++)
     for (j = 0; j < height; j++)
     {
-      average_surface_difficulty += scheme.terrain_props[seg][surface[i][j].t_id].difficulty;
+      average_surface_difficulty += scheme.terrain_props[seg][surface.GetTerrainId(i, j)].difficulty;
     }
 
   average_surface_difficulty /= (width*height);
@@ -533,7 +946,7 @@ bool TMAP_SEGMENT::LoadMapSegment()
   sprintf(sec_name, "Segment %d", sid);
   ok = map.file->SelectSection(sec_name, true);
 
-  if (!(map.segments[sid].surface = CreateMapSurface()) || !ok) return false;
+  if (!map.segments[sid].surface.Create(map.width, map.height) || !ok) return false;
   
   if (ok) ok = LoadMapFragments(sid);
   if (ok) ok = LoadMapLayers(sid);
@@ -586,7 +999,7 @@ bool TMAP_SEGMENT::LoadMapFragments(T_BYTE sid)
 
   for (i = 0; i < map.width; i++)
     for (j = 0; j < map.height; j++){
-      if (seg->surface[i][j].t_id == MAP_EMPTY_SURFACE) count_empty_surf++;
+      if (seg->surface.GetTerrainId(i, j) == MAP_EMPTY_SURFACE) count_empty_surf++;
     }
 
   // in case that some fragments are missing
@@ -610,7 +1023,7 @@ bool TMAP_SEGMENT::LoadMapFragments(T_BYTE sid)
       for (;(k < map.width) && (stop_cycle); k++){
         if (l >= map.height) l = 0;
         for (;(l < map.height) && (stop_cycle); l++){
-          if (seg->surface[k][l].t_id == MAP_EMPTY_SURFACE)
+          if (seg->surface.GetTerrainId(k, l) == MAP_EMPTY_SURFACE)
             stop_cycle = false;
         }
       }
@@ -655,7 +1068,7 @@ bool TMAP_SEGMENT::LoadMapFragment(T_BYTE sid, int id)
     // test overlapping fragments
     for (i = x; i < x + scheme.terrf[sid][fid].width - 1; i++)
       for (j = y; j < y + scheme.terrf[sid][fid].height - 1; j++){
-        if (seg->surface[i][j].t_id != MAP_EMPTY_SURFACE){
+        if (seg->surface.GetTerrainId(i, j) != MAP_EMPTY_SURFACE){
           Warning(LogMsg("Map fragment %d located on another fragment in segment %d.", id, sid));
           return true;
         }
@@ -860,6 +1273,9 @@ void TSEG_UNITS::AddUnit(TDRAW_UNIT *unit)
   unit->GetPrevInSegment(id)->SetNextInSegment(id, unit);
   units_count++;
 
+  // dot of the unit must be painted again
+  unit->InvalidateRadar();
+
   // logging
   /*
   if (id == 1) {
@@ -912,6 +1328,9 @@ void TSEG_UNITS::DeleteUnit(TDRAW_UNIT *unit)
 
   units_count--;
 
+  // dot of the unit must be removed from radar
+  unit->InvalidateRadar();
+
   // logging
   /*
   if (id == 1) {
@@ -1038,17 +1457,17 @@ void TSEG_UNITS::Draw(T_BYTE style)
 
 
 /**
- *  Draws units from segment to radar.
+ *  Paints units from segment to radar units image.
  */
-void TSEG_UNITS::DrawToRadar(void)
+void TSEG_UNITS::PaintToRadar(void)
 {
   TDRAW_UNIT *unit;
 
   glfwLockMutex(mutex);
 
-  // draw units
+  // paint units
   for (unit = units->GetNextInSegment(id); unit != units; unit = unit->GetNextInSegment(id)) {
-    unit->DrawToRadar();
+    unit->PaintToRadar();
   }
 
   glfwUnlockMutex(mutex);
@@ -1117,6 +1536,19 @@ bool TWARFOG::Create(void)
     for (j = 0; j < map_all; j++) tex[i][j] = ((j % 4 == 3) ? 255 : 0);
   }
 
+  // textures are uploaded whole at first update
+  tex_segment = radar_tex_segment = -1;
+  dirty.Reset();
+  radar_dirty.Reset();
+
+  try {
+    dirty_lock = NEW TLOCK();
+  }
+  catch (...) {
+    Critical("Could not create mutex");
+    return false;
+  }
+
   return true;
 }
 
@@ -1146,26 +1578,105 @@ void TWARFOG::Clear(void)
     if (tex[i]) delete[] tex[i];
     tex[i] = NULL;
   }
+
+  if (dirty_lock) {
+    delete dirty_lock;
+    dirty_lock = NULL;
+  }
+
+  tex_segment = radar_tex_segment = -1;
+}
+
+
+/**
+ *  Marks warfog fields as changed. Changed fields are uploaded to textures
+ *  in the next Update(). It should be called after the fields are written.
+ *
+ *  @param x1  Left texel of changed area.
+ *  @param y1  Bottom texel of changed area.
+ *  @param x2  Right texel of changed area (inclusive).
+ *  @param y2  Top texel of changed area (inclusive).
+ */
+void TWARFOG::SetDirty(int x1, int y1, int x2, int y2)
+{
+  int map_w = map.width + MAP_AREA_SIZE + 1;
+  int map_h = map.height + MAP_AREA_SIZE + 1;
+
+  if (!dirty_lock) return;
+
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 >= map_w) x2 = map_w - 1;
+  if (y2 >= map_h) y2 = map_h - 1;
+
+  if (x2 < x1 || y2 < y1) return;
+
+  dirty_lock->Lock();
+  dirty.Add(x1, y1, x2, y2);
+  radar_dirty.Add(x1, y1, x2, y2);
+  dirty_lock->Unlock();
 }
 
 
 /**
- *  Fills warfog texture with values from local map segment.
+ *  Uploads rectangle of warfog fields to texture.
+ *
+ *  @param id    Identifier of the texture.
+ *  @param data  Warfog fields.
+ *  @param rect  Uploaded rectangle.
+ */
+void TWARFOG::UploadRect(GLenum id, GLubyte *data, TWARFOG_RECT &rect)
+{
+  int map_w = map.width + MAP_AREA_SIZE + 1;
+
+  glBindTexture(GL_TEXTURE_2D, id);
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, map_w);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x1, rect.y1, rect.x2 - rect.x1 + 1, rect.y2 - rect.y1 + 1,
+                  GL_RGBA, GL_UNSIGNED_BYTE, data + (rect.y1 * map_w + rect.x1) * 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+
+/**
+ *  Fills warfog texture with values from local map segment. Only fields
+ *  changed since the last update are uploaded, whole texture is uploaded
+ *  after the viewed segment is changed.
  */
 void TWARFOG::Update(void)
 {
+  TWARFOG_RECT rect, radar_rect;
+  TWARFOG_RECT whole;
+  int radar_segment = (view_segment == DRW_ALL_SEGMENTS) ? 1 : view_segment;
+  bool radar_visible = radar_panel->IsVisible();
+
+  if (!dirty_lock) return;
+
+  whole.Add(0, 0, map.width + MAP_AREA_SIZE, map.height + MAP_AREA_SIZE);
+
+  dirty_lock->Lock();
+  rect = dirty;
+  dirty.Reset();
+  if (radar_visible) {
+    radar_rect = radar_dirty;
+    radar_dirty.Reset();
+  }
+  dirty_lock->Unlock();
+
   // warfog texture
-  glBindTexture(GL_TEXTURE_2D, tex_id);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, map.width + MAP_AREA_SIZE + 1, map.height + MAP_AREA_SIZE + 1, GL_RGBA, GL_UNSIGNED_BYTE, tex[view_segment]);
+  if (tex_segment != view_segment) {
+    UploadRect(tex_id, tex[view_segment], whole);
+    tex_segment = view_segment;
+  }
+  else if (!rect.IsEmpty()) UploadRect(tex_id, tex[view_segment], rect);
 
   // radar warfog texture
-  if (radar_panel->IsVisible()) {
-    glBindTexture(GL_TEXTURE_2D, radar_tex_id);
-
-    if (view_segment == DRW_ALL_SEGMENTS)
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, map.width + MAP_AREA_SIZE + 1, map.height + MAP_AREA_SIZE + 1, GL_RGBA, GL_UNSIGNED_BYTE, tex[1]);
-    else
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, map.width + MAP_AREA_SIZE + 1, map.height + MAP_AREA_SIZE + 1, GL_RGBA, GL_UNSIGNED_BYTE, tex[view_segment]);
+  if (radar_visible) {
+    if (radar_tex_segment != radar_segment) {
+      UploadRect(radar_tex_id, tex[radar_segment], whole);
+      radar_tex_segment = radar_segment;
+    }
+    else if (!radar_rect.IsEmpty()) UploadRect(radar_tex_id, tex[radar_segment], radar_rect);
   }
 }
 
@@ -1240,6 +1751,81 @@ void TWARFOG::DrawToRadar(void)
 }
 
 
+//=========================================================================
+// struct TWORLD_HASH
+//=========================================================================
+
+/**
+ *  Creates hashes of regions of loaded map.
+ *
+ *  @return @c true on succes, @c false otherwise.
+ */
+bool TWORLD_HASH::Create(void)
+{
+  regions_width = (map.width + MAP_AREA_SIZE - 1) / MAP_AREA_SIZE;
+  regions_count = regions_width * ((map.height + MAP_AREA_SIZE - 1) / MAP_AREA_SIZE);
+
+  regions = NEW unsigned[regions_count];
+  if (regions == NULL) return false;
+
+  memset(regions, 0, regions_count * sizeof(unsigned));
+
+  lock = NEW TLOCK();
+
+  return true;
+}
+
+
+/**
+ *  Clears hashes of regions. Units deleted later do not fold their hashes.
+ */
+void TWORLD_HASH::Clear(void)
+{
+  if (regions) {
+    delete[] regions;
+    regions = NULL;
+  }
+
+  if (lock) {
+    delete lock;
+    lock = NULL;
+  }
+
+  regions_width = regions_count = 0;
+}
+
+
+/**
+ *  Folds hash of unit in or out of the region.
+ *
+ *  @param region  Index of region.
+ *  @param hash    Hash of the unit.
+ */
+void TWORLD_HASH::Fold(int region, unsigned hash)
+{
+  if (!regions || region < 0 || region >= regions_count) return;
+
+  lock->Lock();
+  regions[region] ^= hash;
+  lock->Unlock();
+}
+
+
+/**
+ *  Copies hashes of all regions.
+ *
+ *  @param copy  Array of GetRegionsCount() items.
+ */
+void TWORLD_HASH::GetRegions(unsigned *copy)
+{
+  if (!regions) return;
+
+  lock->Lock();
+  memcpy(copy, regions, regions_count * sizeof(unsigned));
+  lock->Unlock();
+}
+
+
 //=========================================================================
 // struct TMAP
 //=========================================================================
@@ -1282,8 +1868,8 @@ TMAP::TMAP() {
 
 
 void TMAP::InitPools(void) {
-  aimers_pool = NEW TPOOL<TMAP_POOLED_LIST::TNODE>(Sqr(MAP_MAX_SIZE / 2)*DAT_SEGMENTS_COUNT*3, 0, 10000);
-  watchers_pool = NEW TPOOL<TMAP_POOLED_LIST::TNODE>(Sqr(MAP_MAX_SIZE / 2)*DAT_SEGMENTS_COUNT*5, 0, 20000);
+  aimers_pool = NEW TPOOL<TMAP_POOLED_LIST::TNODE>(Sqr(MAP_POOL_SIZE / 2)*DAT_SEGMENTS_COUNT*3, 0, 10000);
+  watchers_pool = NEW TPOOL<TMAP_POOLED_LIST::TNODE>(Sqr(MAP_POOL_SIZE / 2)*DAT_SEGMENTS_COUNT*5, 0, 20000);
 }
 
 
@@ -1308,6 +1894,8 @@ void TMAP::Clear()
   */
   
   war_fog.Clear();
+  world_hash.Clear();
+  radar.Clear();
   
   Initialise();
 }
@@ -1461,7 +2049,7 @@ bool TMAP::IsPositionFree(T_SIMPLE w, T_SIMPLE h, const TPOSITION_3D &pos)
     for (j = pos.y; j < pos.y + h; j++) { //testing through new position
       
       if (!IsInMap(i,j)) return false;   //test, whether the position is in map
-      if (segments[pos.segment].surface[i][j].unit) return false; //test, whether there's any unit standing at the position
+      if (segments[pos.segment].surface.GetUnit(i, j)) return false; //test, whether there's any unit standing at the position
     }
 
   return true;
@@ -1501,6 +2089,35 @@ void TMAP::UpdateActiveArea()
 }
 
 
+/**
+ *  Wakes units and ghosts standing in the rectangle, so their visibility is
+ *  tested in the next frame. It is called from update thread after warfog
+ *  of myself is changed.
+ *
+ *  @param x1  Left field of the rectangle.
+ *  @param y1  Bottom field of the rectangle.
+ *  @param x2  Right field of the rectangle (inclusive).
+ *  @param y2  Top field of the rectangle (inclusive).
+ */
+void TMAP::WakeUnits(int x1, int y1, int x2, int y2)
+{
+  TMAP_UNIT *unit;
+  int i, j, k;
+
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 >= width) x2 = width - 1;
+  if (y2 >= height) y2 = height - 1;
+
+  for (k = 0; k < DAT_SEGMENTS_COUNT; k++)
+    for (i = x1; i <= x2; i++)
+      for (j = y1; j <= y2; j++) {
+        if ((unit = segments[k].surface.GetUnit(i, j))) unit->WakeUp();
+        if ((unit = segments[k].surface.GetGhost(i, j))) unit->WakeUp();
+      }
+}
+
+
 /**
  *  Starts map moving with a key in asked direction.
  *
@@ -1708,34 +2325,18 @@ void TMAP::DrawBorder()
  */
 void TMAP::DrawToRadar()
 {
-  glColor3f(1, 1, 1);
-  GLenum tex_id = 0;
-
   // draw surface texture
-  if (view_segment == DRW_ALL_SEGMENTS) tex_id = segments[1].tex_radar_id;
-  else tex_id = segments[view_segment].tex_radar_id;
-
-  if (tex_id) {
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-
-    glBegin(GL_QUADS);
-      glTexCoord2f(0, 0); glVertex2f(0, 0);
-      glTexCoord2f(1, 0); glVertex2f(DRW_RADAR_SIZE, 0);
-      glTexCoord2f(1, 1); glVertex2f(DRW_RADAR_SIZE, DRW_RADAR_SIZE);
-      glTexCoord2f(0, 1); glVertex2f(0, DRW_RADAR_SIZE);
-    glEnd();
-  }
+  radar.DrawTerrain();
 
   // draw warfog
   war_fog.DrawToRadar();
 
+  // draw units
+  radar.DrawUnits();
+
   glPushMatrix();
   glTranslated(radar.dx, 0, 0);
 
-  // draw units
-  for (int i = 0; i < DAT_SEGMENTS_COUNT; i++)
-    segment_units[i]->DrawToRadar();
-
   // border around map
   glDisable(GL_TEXTURE_2D);  
   glColor3f(0.3f, 0.3f, 0.3f);
@@ -1792,6 +2393,7 @@ void TMAP::DeleteMap()
 bool TMAP::LoadMap(char *name) // load map from file
 {
   TFILE_NAME  mapname;
+  double start_time = glfwGetTime();
 
   bool ok = true;
 
@@ -1806,7 +2408,7 @@ bool TMAP::LoadMap(char *name) // load map from file
 
   strcpy(map.id_name, name);
 
-  if (!(map.file = OpenConfFile(mapname)))
+  if (!(map.file = OpenConfFile(mapname, true)))
     return false;
 
   // info
@@ -1828,6 +2430,7 @@ bool TMAP::LoadMap(char *name) // load map from file
       ok = map.segments[i].LoadMapSegment();
 
     if (ok) ok = map.war_fog.Create();
+    if (ok) ok = map.world_hash.Create();
     if (ok) ok = LoadMapPlayers();
     
   CloseConfFile(map.file);
@@ -1836,11 +2439,10 @@ bool TMAP::LoadMap(char *name) // load map from file
     DeleteMap();
     Error(LogMsg("Error loading map from '%s'", mapname));
   }
+  else Info(LogMsg("Map loaded in %.0f ms", (glfwGetTime() - start_time) * 1000));
 
   radar.dx = GLfloat(map.height) * DRW_RADAR_SIZE / (map.height + map.width);
   radar.zoom = radar.dx / map.height;
-
-  RenderRadarTextures();
      
   return ok;
 }
@@ -2303,42 +2905,347 @@ bool TMAP::LoadMapPlayers()
   return ok;
 }
 
+//=========================================================================
+// Class TRADAR
+//=========================================================================
+
 /**
+ *  Renders terrain of map segment to radar texture. Colour of each texel is
+ *  the radar colour of terrain type of the mapel under the texel, so
+ *  the texture is rendered only from the surface of segment without reading
+ *  back the drawn map.
  *
+ *  @param segment  Segment which is shown in radar.
  */
-void TMAP::RenderRadarTextures()
+void TRADAR::UpdateTerrain(int segment)
 {
-  GLubyte pom_tex[DRW_RADAR_TEX_SIZE * DRW_RADAR_TEX_SIZE * 3];
-  int i;
+  TMAP_SEGMENT *seg = map.segments + segment;
 
-  // set projection
-  for (i = 0; i < DAT_SEGMENTS_COUNT; i++) {
-    glClear(GL_COLOR_BUFFER_BIT);
-    projection.SetProjection(PRO_RENDER_RADAR);
+  if (segment == terrain_segment && !seg->radar_dirty) return;
 
-    // draw map segment
-    map.segments[i].DrawSurface();
+  GLubyte *raster, *dst;
+  GLfloat rx, ry;
+  TTERRAIN_ID t_id;
+  int count = scheme.terrain_segments ? scheme.terrain_segments[segment].max_terrain_id : 0;
+  int x, y, i, j;
 
-    projection.SetProjection(PRO_MENU);
+  if (!seg->surface.IsCreated() || zoom <= 0) return;
 
-    // read image to temp. field
-    glReadPixels(0, 0, DRW_RADAR_TEX_SIZE, DRW_RADAR_TEX_SIZE, GL_RGB, GL_UNSIGNED_BYTE, &pom_tex);
+  raster = NEW GLubyte[DRW_RADAR_TEX_SIZE * DRW_RADAR_TEX_SIZE * 3];
 
-    // generate new texture
-    glGenTextures(1, &map.segments[i].tex_radar_id);
-    glBindTexture(GL_TEXTURE_2D, map.segments[i].tex_radar_id);
+  for (j = 0, dst = raster; j < DRW_RADAR_TEX_SIZE; j++) {
+    ry = (j + 0.5f) * DRW_RADAR_SIZE / DRW_RADAR_TEX_SIZE;
+
+    for (i = 0; i < DRW_RADAR_TEX_SIZE; i++, dst += 3) {
+      rx = (i + 0.5f) * DRW_RADAR_SIZE / DRW_RADAR_TEX_SIZE - dx;
+
+      // inverse to RadarPosition()
+      x = (int)floor((rx + ry) / (2 * zoom));
+      y = (int)floor((ry - rx) / (2 * zoom));
+
+      if (map.IsInMap(x, y) && (t_id = seg->surface.GetTerrainId(x, y)) < count) {
+        dst[0] = scheme.terrain_props[segment][t_id].radar_color[0];
+        dst[1] = scheme.terrain_props[segment][t_id].radar_color[1];
+        dst[2] = scheme.terrain_props[segment][t_id].radar_color[2];
+      }
+      else dst[0] = dst[1] = dst[2] = 0;
+    }
+  }
+
+  seg->radar_dirty = false;
+  terrain_segment = segment;
+
+  if (!terrain_tex_id) {
+    glGenTextures(1, &terrain_tex_id);
+    glBindTexture(GL_TEXTURE_2D, terrain_tex_id);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, DRW_RADAR_TEX_SIZE, DRW_RADAR_TEX_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, (void *)pom_tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, DRW_RADAR_TEX_SIZE, DRW_RADAR_TEX_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, (void *)raster);
+  }
+  else {
+    glBindTexture(GL_TEXTURE_2D, terrain_tex_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, DRW_RADAR_TEX_SIZE, DRW_RADAR_TEX_SIZE, GL_RGB, GL_UNSIGNED_BYTE, (void *)raster);
   }
+
+  delete[] raster;
 }
 
 
-//=========================================================================
-// Class TRADAR
-//=========================================================================
+/**
+ *  Paints units dots in changed tiles of units image and uploads the tiles
+ *  to the texture. Other tiles are not touched.
+ */
+void TRADAR::UpdateUnits(void)
+{
+  bool changed = false;
+  int i, j, first;
+
+  if (!units_raster) {
+    units_raster = NEW GLubyte[DRW_RADAR_TEX_SIZE * DRW_RADAR_TEX_SIZE * 4];
+    InvalidateRect(0, 0, DRW_RADAR_TEX_SIZE, DRW_RADAR_TEX_SIZE);
+  }
+
+  // take changed tiles
+  for (i = 0; i < DRW_RADAR_TILES * DRW_RADAR_TILES / 32; i++)
+    if ((paint_tiles[i] = __sync_fetch_and_and(&units_dirty[i], 0))) changed = true;
+
+  if (!changed) return;
+
+  // clear changed tiles
+  for (i = 0; i < DRW_RADAR_TILES * DRW_RADAR_TILES; i++)
+    if (paint_tiles[i >> 5] & (1u << (i & 31)))
+      for (j = 0; j < DRW_RADAR_TILE_SIZE; j++)
+        memset(units_raster + (((i / DRW_RADAR_TILES) * DRW_RADAR_TILE_SIZE + j) * DRW_RADAR_TEX_SIZE + (i % DRW_RADAR_TILES) * DRW_RADAR_TILE_SIZE) * 4,
+          0, DRW_RADAR_TILE_SIZE * 4);
+
+  // paint units, dots are clipped to changed tiles
+  for (i = 0; i < DAT_SEGMENTS_COUNT; i++)
+    if (map.segment_units[i]) map.segment_units[i]->PaintToRadar();
+
+  if (!units_tex_id) {
+    glGenTextures(1, &units_tex_id);
+    glBindTexture(GL_TEXTURE_2D, units_tex_id);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, DRW_RADAR_TEX_SIZE, DRW_RADAR_TEX_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void *)units_raster);
+    return;
+  }
+
+  // upload runs of changed tiles in every row of tiles
+  glBindTexture(GL_TEXTURE_2D, units_tex_id);
+
+  for (j = 0; j < DRW_RADAR_TILES; j++) {
+    first = -1;
+
+    for (i = 0; i <= DRW_RADAR_TILES; i++) {
+      int t = j * DRW_RADAR_TILES + i;
+
+      if (i < DRW_RADAR_TILES && (paint_tiles[t >> 5] & (1u << (t & 31)))) {
+        if (first < 0) first = i;
+      }
+      else if (first >= 0) {
+        UploadTiles(j, first, i);
+        first = -1;
+      }
+    }
+  }
+}
+
+
+/**
+ *  Uploads tiles of one row from units image to the bound texture.
+ *
+ *  @param row    Row of tiles.
+ *  @param first  First uploaded tile in the row.
+ *  @param last   Tile after the last uploaded one.
+ */
+void TRADAR::UploadTiles(int row, int first, int last)
+{
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, DRW_RADAR_TEX_SIZE);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, first * DRW_RADAR_TILE_SIZE);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, row * DRW_RADAR_TILE_SIZE);
+
+  glTexSubImage2D(GL_TEXTURE_2D, 0, first * DRW_RADAR_TILE_SIZE, row * DRW_RADAR_TILE_SIZE,
+    (last - first) * DRW_RADAR_TILE_SIZE, DRW_RADAR_TILE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, (void *)units_raster);
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
+
+/**
+ *  Marks tiles covering the rectangle as changed. It could be called from
+ *  any thread.
+ *
+ *  @param x1, y1  Left top texel of the rectangle.
+ *  @param x2, y2  Right bottom texel of the rectangle (exclusive).
+ */
+void TRADAR::InvalidateRect(int x1, int y1, int x2, int y2)
+{
+  int i, j, t;
+
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 > DRW_RADAR_TEX_SIZE) x2 = DRW_RADAR_TEX_SIZE;
+  if (y2 > DRW_RADAR_TEX_SIZE) y2 = DRW_RADAR_TEX_SIZE;
+  if (x2 <= x1 || y2 <= y1) return;
+
+  for (j = y1 / DRW_RADAR_TILE_SIZE; j <= (y2 - 1) / DRW_RADAR_TILE_SIZE; j++)
+    for (i = x1 / DRW_RADAR_TILE_SIZE; i <= (x2 - 1) / DRW_RADAR_TILE_SIZE; i++) {
+      t = j * DRW_RADAR_TILES + i;
+      __sync_fetch_and_or(&units_dirty[t >> 5], 1u << (t & 31));
+    }
+}
+
+
+/**
+ *  Updates dot of unit. If the dot differs from the painted one, tiles under
+ *  both of them are marked as changed. The dot is the same rhombus, which
+ *  would be drawn to radar at RadarPosition(@p x, @p y).
+ *
+ *  @param dot    Dot of the unit.
+ *  @param x, y   Position of the unit. [mapels]
+ *  @param w, h   Size of the dot. [radar pixels]
+ *  @param color  Colour of the dot (RGB), @c NULL if unit is not shown.
+ */
+void TRADAR::UpdateDot(TRADAR_DOT *dot, GLfloat x, GLfloat y, GLfloat w, GLfloat h, const GLubyte *color)
+{
+  const GLfloat k = GLfloat(DRW_RADAR_TEX_SIZE) / DRW_RADAR_SIZE;
+
+  // base point in texels
+  GLfloat bx = (zoom * (x - y) + dx) * k;
+  GLfloat by = zoom * (x + y) * k;
+
+  int x1 = (int)floor(bx - h * k);
+  int x2 = (int)ceil(bx + w * k);
+  int y1 = (int)floor(by);
+  int y2 = (int)ceil(by + (w + h) * k);
+
+  if (!color) x1 = y1 = x2 = y2 = 0;
+
+  if (dot->color == color && dot->x == x && dot->y == y && dot->w == w && dot->h == h
+      && dot->x1 == x1 && dot->y1 == y1 && dot->x2 == x2 && dot->y2 == y2) return;
+
+  InvalidateRect(dot->x1, dot->y1, dot->x2, dot->y2);
+
+  dot->x = x; dot->y = y;
+  dot->w = w; dot->h = h;
+  dot->color = color;
+  dot->x1 = x1; dot->y1 = y1;
+  dot->x2 = x2; dot->y2 = y2;
+
+  InvalidateRect(x1, y1, x2, y2);
+}
+
+
+/**
+ *  Marks tiles under the dot as changed. It is used when unit is added to or
+ *  removed from segment.
+ *
+ *  @param dot  Dot of the unit.
+ */
+void TRADAR::InvalidateDot(const TRADAR_DOT *dot)
+{
+  InvalidateRect(dot->x1, dot->y1, dot->x2, dot->y2);
+}
+
+
+/**
+ *  Paints one unit dot to units image. Only texels in tiles painted in the
+ *  actual update are changed.
+ *
+ *  @param dot  Dot of the unit.
+ */
+void TRADAR::PaintDot(const TRADAR_DOT *dot)
+{
+  const GLfloat k = GLfloat(DRW_RADAR_TEX_SIZE) / DRW_RADAR_SIZE;
+
+  if (!dot->color) return;
+
+  // base point in texels
+  GLfloat bx = (zoom * (dot->x - dot->y) + dx) * k;
+  GLfloat by = zoom * (dot->x + dot->y) * k;
+  GLfloat a, b, px, py;
+  GLubyte *dst;
+
+  int x1 = MAX(dot->x1, 0);
+  int y1 = MAX(dot->y1, 0);
+  int x2 = MIN(dot->x2, DRW_RADAR_TEX_SIZE);
+  int y2 = MIN(dot->y2, DRW_RADAR_TEX_SIZE);
+  int i, j, t;
+
+  for (j = y1; j < y2; j++) {
+    py = (j + 0.5f - by) / k;
+
+    for (i = x1; i < x2; i++) {
+      t = (j / DRW_RADAR_TILE_SIZE) * DRW_RADAR_TILES + i / DRW_RADAR_TILE_SIZE;
+      if (!(paint_tiles[t >> 5] & (1u << (t & 31)))) continue;
+
+      px = (i + 0.5f - bx) / k;
+
+      // coordinates along the rhombus edges
+      a = (px + py) / 2;
+      b = (py - px) / 2;
+      if (a < 0 || a > dot->w || b < 0 || b > dot->h) continue;
+
+      dst = units_raster + (j * DRW_RADAR_TEX_SIZE + i) * 4;
+      dst[0] = dot->color[0]; dst[1] = dot->color[1]; dst[2] = dot->color[2]; dst[3] = 255;
+    }
+  }
+}
+
+
+/**
+ *  Draws terrain texture of the shown segment to radar.
+ */
+void TRADAR::DrawTerrain(void)
+{
+  UpdateTerrain((view_segment == DRW_ALL_SEGMENTS) ? 1 : view_segment);
+
+  if (!terrain_tex_id) return;
+
+  glColor3f(1, 1, 1);
+  glBindTexture(GL_TEXTURE_2D, terrain_tex_id);
+
+  glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(0, 0);
+    glTexCoord2f(1, 0); glVertex2f(DRW_RADAR_SIZE, 0);
+    glTexCoord2f(1, 1); glVertex2f(DRW_RADAR_SIZE, DRW_RADAR_SIZE);
+    glTexCoord2f(0, 1); glVertex2f(0, DRW_RADAR_SIZE);
+  glEnd();
+}
+
+
+/**
+ *  Draws units texture to radar. Changed tiles of the texture are updated
+ *  before.
+ */
+void TRADAR::DrawUnits(void)
+{
+  UpdateUnits();
+
+  glColor3f(1, 1, 1);
+  glBindTexture(GL_TEXTURE_2D, units_tex_id);
+
+  glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(0, 0);
+    glTexCoord2f(1, 0); glVertex2f(DRW_RADAR_SIZE, 0);
+    glTexCoord2f(1, 1); glVertex2f(DRW_RADAR_SIZE, DRW_RADAR_SIZE);
+    glTexCoord2f(0, 1); glVertex2f(0, DRW_RADAR_SIZE);
+  glEnd();
+}
+
+
+/**
+ *  Deletes radar textures. They are created again for the next map.
+ */
+void TRADAR::Clear(void)
+{
+  if (terrain_tex_id) {
+    glDeleteTextures(1, &terrain_tex_id);
+    terrain_tex_id = 0;
+  }
+
+  if (units_tex_id) {
+    glDeleteTextures(1, &units_tex_id);
+    units_tex_id = 0;
+  }
+
+  if (units_raster) {
+    delete[] units_raster;
+    units_raster = NULL;
+  }
+
+  terrain_segment = -1;
+
+  for (int i = 0; i < DRW_RADAR_TILES * DRW_RADAR_TILES / 32; i++) units_dirty[i] = paint_tiles[i] = 0;
+}
+
 
 void TRADAR::Draw(void)
 {
@@ -2374,66 +3281,6 @@ void TRADAR::Draw(void)
 }
 
 
-//=========================================================================
-// global methods definition
-//=========================================================================
-
-//=========================================================================
-// MapSurface
-//=========================================================================
-
-/**
- *  Creates map surface - 2 dimensional field of surface information.
- *
- *  @return Pointer to 2D surface.
- */
-TMAP_SURFACE **CreateMapSurface()
-{
-  TMAP_SURFACE **surface = NULL;
-  int i = 0, j = 0;
-
-  bool ok = true;
-
-  if (!(surface = NEW PMAP_SURFACE[map.width]))   // allocating memory
-    ok = false;
-
-  if (ok) for (i = 0; i < map.width && ok; i++) {
-    surface[i] = NULL;
-    if (!(surface[i] = NEW TMAP_SURFACE[map.height])) ok = false;
-  }
-  
-  // setting speciah surface value to detect mapels without fragments
-  for (i = 0; i < map.width; i++)
-    for (j = 0; j < map.height; j++)
-      surface[i][j].t_id = MAP_EMPTY_SURFACE;
-  
-  if (ok)       // whether allocation has been succesful
-    return surface;
-  else {        // allocation failed
-    if (surface) DeleteMapSurface(surface);
-    return NULL;
-  }
-}
-
-
-void DeleteMapSurface(TMAP_SURFACE **surface)
-{
-  if (!surface) return;
-
-  for (int i = 0; i < map.width; i++)
-    if (surface[i]) {
-      for (int j = 0; j < map.height; j++)
-        surface[i][j].Clear();
-      
-      delete [] surface[i];
-      surface[i] = NULL;
-    }
-
-  delete[] surface;
-  surface = NULL;
-}
-
-
 //=========================================================================
 // END
 //=========================================================================
@@ -35,9 +35,13 @@
 class TTERR_BASIC;
 class TTERR_FRAG;
 class TTERR_LAYER;
-struct TMAP_SURFACE;
+struct TMAP_SURFACE_CHUNK;
+struct TTERR_CHUNK_RUNS;
+struct TTERR_CHUNK;
+class TMAP_SURFACE;
 struct TMAP_SEGMENT;
 struct TWARFOG;
+struct TWORLD_HASH;
 class TRADAR;
 class TMAP;
 
@@ -46,11 +50,21 @@ class TMAP;
 //=========================================================================
 
 #define MAP_PATH  (app_path + DATA_DIR "maps/").c_str()  //!< Directory containing maps.
+#define MAP_INDEX_FILE  (user_dir + DATA_DIR "maps.idx").c_str()  //!< Index of maps used in menu.
 
-#define MAP_MAX_SIZE          240   //!< Maximal map width or height.
+#define MAP_MAX_SIZE          1024  //!< Maximal map width or height.
+#define MAP_POOL_SIZE         240   //!< Map width or height, for which pools of aimers and watchers are prepared.
 #define MAP_AREA_SIZE         10    //!< Map area size.
+
+#define MAP_SURFACE_CHUNK_SHIFT   4   //!< Binary logarithm of #MAP_SURFACE_CHUNK_SIZE.
+#define MAP_SURFACE_CHUNK_SIZE    (1 << MAP_SURFACE_CHUNK_SHIFT)   //!< Width and height of chunks of map surface. [mapels]
+#define MAP_SURFACE_CHUNK_FIELDS  (MAP_SURFACE_CHUNK_SIZE * MAP_SURFACE_CHUNK_SIZE)  //!< Count of fields in chunk of map surface.
 #define MAP_MAX_NAME_LENGTH   30    //!< Maximal length of map name.
 
+#define MAP_WORLD_HASH_SETTLE 2.0   //!< Time to wait for late events before hashes of world are sent. [seconds]
+#define MAP_WORLD_HASH_KEEP   30.0  //!< Time to keep hashes of world for comparison with remote ones. [seconds]
+#define MAP_WORLD_HASH_DIFF   8     //!< Maximal count of differing regions, whose units are requested.
+
 #define MAP_MAX_ZOOM          5.0f  //!< Maximal zoom coeficient.
 #define MAP_MIN_ZOOM          0.2f  //!< Minimal zoom coeficient.
 #define MAP_MAX_TERRAIN_DIFF  999   //!< Highest possible terrain difficulty.
@@ -99,6 +113,7 @@ class TMAP;
 #include "cfg.h"
 #include "doalloc.h"
 
+#include "dodraw.h"
 #include "dounits.h"
 #include "doconfig.h"
 
@@ -123,9 +138,14 @@ public:
   TTERR_ITEM *pitem;      //!< Pointer to specific item type.
 
   void Draw(void);
+  void DrawStatic(void);
   void UpdateGraphics(void);
 
   bool IsInActiveArea() { return in_active_area; }
+  /** Returns whether the terrain is animated and can not be cached. */
+  bool IsAnimated() { return pitem->IsAnimated(anim_id); }
+  /** Returns whether the terrain is drawn at all. */
+  bool IsDrawn() { return anim_id >= 0; }
 
   TTERR_BASIC(int tx, int ty, int tz);
 
@@ -162,39 +182,125 @@ public:
 
 
 /**
- *  Map surface.
+ *  Block of #MAP_SURFACE_CHUNK_SIZE x #MAP_SURFACE_CHUNK_SIZE fields of map
+ *  surface. Every characteristic of the fields is stored in its own array
+ *  (fields are ordered by columns), so occupancy tests read only terrain ids
+ *  and units. Activity and lists of aimers and watchers are used only on few
+ *  fields of the map, their arrays are allocated on first use.
  */
-struct TMAP_SURFACE {
-  TTERRAIN_ID t_id;     //!< Terrain id.
-  TMAP_UNIT *unit;      //!< Unit that stays here.
-  TMAP_UNIT *ghost;     //!< Ghost that stays here.
-  TNEURON_VALUE *activity;     //<! Activity of every player.
+struct TMAP_SURFACE_CHUNK {
+  TTERRAIN_ID t_id[MAP_SURFACE_CHUNK_FIELDS];       //!< Terrain ids.
+  TMAP_UNIT *unit[MAP_SURFACE_CHUNK_FIELDS];        //!< Units that stay on fields.
+  TMAP_UNIT *ghost[MAP_SURFACE_CHUNK_FIELDS];       //!< Ghosts that stay on fields.
+
+  TNEURON_VALUE *activity;      //!< Activity of every player on every field. [field * #PL_MAX_PLAYERS + player]
+  TMAP_POOLED_LIST **aimers;    //!< Lists of units which could aim fields.
+  TMAP_POOLED_LIST **watchers;  //!< Lists of units which watch fields.
+
+  TMAP_SURFACE_CHUNK(void);
+  ~TMAP_SURFACE_CHUNK(void);
+};
 
-  TMAP_SURFACE();        //!< Basic constructor.
-  ~TMAP_SURFACE();
 
-  void GetActivity(const T_SIMPLE PlayerID, TNEURON_VALUE *my_activity, TNEURON_VALUE *enemy_activity);
+/**
+ *  Map surface of one segment. Fields are stored in chunks of
+ *  #MAP_SURFACE_CHUNK_SIZE x #MAP_SURFACE_CHUNK_SIZE mapels.
+ *
+ *  @sa TMAP_SURFACE_CHUNK
+ */
+class TMAP_SURFACE {
+public:
+  bool Create(int width, int height);
+  void Clear(void);
+
+  /** Returns @c true if the surface is created. */
+  bool IsCreated(void) { return chunks != NULL; }
+
+  /** Returns terrain id of the field. */
+  TTERRAIN_ID GetTerrainId(int x, int y)
+    { return GetChunk(x, y)->t_id[GetIndex(x, y)]; }
+  /** Sets terrain id of the field. */
+  void SetTerrainId(int x, int y, TTERRAIN_ID t_id)
+    { GetChunk(x, y)->t_id[GetIndex(x, y)] = t_id; }
+
+  /** Returns unit that stays on the field. */
+  TMAP_UNIT *GetUnit(int x, int y)
+    { return GetChunk(x, y)->unit[GetIndex(x, y)]; }
+  /** Sets unit that stays on the field. */
+  void SetUnit(int x, int y, TMAP_UNIT *unit)
+    { GetChunk(x, y)->unit[GetIndex(x, y)] = unit; }
+
+  /** Returns ghost that stays on the field. */
+  TMAP_UNIT *GetGhost(int x, int y)
+    { return GetChunk(x, y)->ghost[GetIndex(x, y)]; }
+  /** Sets ghost that stays on the field. */
+  void SetGhost(int x, int y, TMAP_UNIT *ghost)
+    { GetChunk(x, y)->ghost[GetIndex(x, y)] = ghost; }
+
+  TMAP_POOLED_LIST *GetWatchersList(int x, int y);
+  TMAP_POOLED_LIST *GetAimersList(int x, int y);
+
+  void GetActivity(int x, int y, const T_SIMPLE PlayerID, TNEURON_VALUE *my_activity, TNEURON_VALUE *enemy_activity);
   void DecreaseActivity(T_SIMPLE factor);
-  void IncreaseActivity(const T_SIMPLE PlayerID, TNEURON_VALUE added) {activity[PlayerID] += added;};
+  void IncreaseActivity(int x, int y, const T_SIMPLE PlayerID, TNEURON_VALUE added);
 
-  void Clear() {
-    if (activity) delete [] activity;
-    activity = NULL;
-  }
+  /** Constructor. */
+  TMAP_SURFACE(void) { chunks = NULL; chunks_height = chunks_count = 0; }
+  /** Destructor. */
+  ~TMAP_SURFACE(void) { Clear(); }
 
-  /** @return The method returns the list of units which watch this field.*/
-  TMAP_POOLED_LIST* GetWatchersList() const
-    { return watchers;}
-  /** @return The method returns the list of units which could aim this field.*/
-  TMAP_POOLED_LIST* GetAimersList() const
-    { return aimers;}
-  
 private:
-  TMAP_POOLED_LIST *aimers;
-  TMAP_POOLED_LIST *watchers;
+  /** Returns chunk with the field. */
+  TMAP_SURFACE_CHUNK *GetChunk(int x, int y)
+    { return chunks + (x >> MAP_SURFACE_CHUNK_SHIFT) * chunks_height + (y >> MAP_SURFACE_CHUNK_SHIFT); }
+  /** Returns index of the field in its chunk. */
+  static int GetIndex(int x, int y)
+    { return ((x & (MAP_SURFACE_CHUNK_SIZE - 1)) << MAP_SURFACE_CHUNK_SHIFT) | (y & (MAP_SURFACE_CHUNK_SIZE - 1)); }
+
+  TMAP_SURFACE_CHUNK *chunks;   //!< Chunks ordered by columns.
+  int chunks_height;            //!< Count of chunks in y coordinate.
+  int chunks_count;             //!< Count of all chunks.
 };
 
-typedef TMAP_SURFACE *PMAP_SURFACE;   //!< Pointer to map surface.
+
+/**
+ *  Terrain items of one block drawn in one pass (fragments or layers). Runs
+ *  of static items between animated ones are compiled to display lists, so
+ *  the items are drawn in the same order as they are stored in segment.
+ */
+struct TTERR_CHUNK_RUNS {
+  GLuint lists;             //!< First of display lists with static runs. There is one more list than animated items.
+  TTERR_BASIC **animated;   //!< Animated items, which follow the runs.
+  int animated_count;       //!< Count of animated items.
+
+  void Compile(TTERR_BASIC **items, int count);
+  void Draw(void);
+  void Clear(void);
+
+  /** Constructor. */
+  TTERR_CHUNK_RUNS(void) { lists = 0; animated = NULL; animated_count = 0; }
+  /** Destructor. */
+  ~TTERR_CHUNK_RUNS(void) { Clear(); }
+};
+
+
+/**
+ *  Cached static terrain of one #MAP_AREA_SIZE block of map segment.
+ *  Fragments and layers without animation are compiled to display lists,
+ *  which are called every frame instead of drawing the items one by one.
+ *  Lists do not depend on zoom or map position, they are compiled again only
+ *  when the terrain in the block changes.
+ */
+struct TTERR_CHUNK {
+  TTERR_CHUNK_RUNS frags;   //!< Fragments of the block.
+  TTERR_CHUNK_RUNS layers;  //!< Layers of the block.
+
+  bool dirty;             //!< If display lists must be compiled again.
+  bool empty;             //!< If there is no terrain in the block.
+
+  T_SIMPLE x1, y1;        //!< Envelope of all terrain items of the block. [mapels]
+  T_SIMPLE x2, y2;
+};
 
 
 /**
@@ -208,17 +314,25 @@ struct TMAP_SEGMENT {
   TDRAW_UNIT  **terro;          //!< Filled of pointers to terrain objects.
   TLIST<TTERR_LAYER> terrl;     //!< List of terrain layers.
   
-  TMAP_SURFACE **surface;       //!< Characteristics of map segment surface.
+  TMAP_SURFACE surface;         //!< Characteristics of map segment surface.
+
+  bool radar_dirty;             //!< If surface was changed since the last rendering to radar.
 
-  GLenum tex_radar_id;          //!< Identifiers for radar textures.
+  TTERR_CHUNK *chunks;          //!< Cached static terrain blocks.
+  int chunks_width;             //!< Count of blocks in x coordinate.
+  int chunks_count;             //!< Count of all blocks.
+  bool chunks_dirty;            //!< If some of the blocks must be compiled again.
+  bool chunks_disabled;         //!< If terrain crosses borders of blocks, so it is not cached.
 
   //! Arithmetic average of the difficulty of surface in the segment.
   double average_surface_difficulty;
 
   void Clear(void);
   void Draw(void);
-  void DrawSurface();
+  void DrawSurface(bool whole = false);
   void UpdateGraphics(double time_shift);
+  void UpdateChunks(void);
+  void ClearChunks(void);
 
   void UpdateTerrainId(int x, int y, int width, int height, TTERRAIN_FIELD field);
   bool AddLayer(int lid, int lx, int ly, int lz);
@@ -259,13 +373,33 @@ public:
   void SortUnits();
 
   void Draw(T_BYTE style = DS_NORMAL);
-  void DrawToRadar();
+  void PaintToRadar();
 
   TSEG_UNITS(T_BYTE seg_id);
   ~TSEG_UNITS();
 };
 
 
+/**
+ *  Rectangle of changed warfog fields, that must be uploaded to texture.
+ */
+struct TWARFOG_RECT {
+  int x1, y1;                   //!< Left bottom corner. [texels]
+  int x2, y2;                   //!< Right top corner (inclusive). [texels]
+
+  void Reset() { x1 = y1 = MAP_MAX_SIZE * 2; x2 = y2 = -1; }
+  bool IsEmpty() { return x2 < x1 || y2 < y1; }
+  void Add(int ax1, int ay1, int ax2, int ay2) {
+    if (ax1 < x1) x1 = ax1;
+    if (ay1 < y1) y1 = ay1;
+    if (ax2 > x2) x2 = ax2;
+    if (ay2 > y2) y2 = ay2;
+  }
+
+  TWARFOG_RECT() { Reset(); }
+};
+
+
 /**
  *  Warfog structure.
  */
@@ -288,14 +422,62 @@ struct TWARFOG {
   void Draw(void);
   void DrawToRadar(void);
 
+  void SetDirty(int x1, int y1, int x2, int y2);
+
   TWARFOG() {
     for (int i = 0; i <= DAT_SEGMENTS_COUNT; i++) {
       tex[i] = NULL;
     }
     tex_id = radar_tex_id = 0;
     x1_coord = y1_coord = x2_coord = y2_coord = x3_coord = y3_coord = 0;
+    tex_segment = radar_tex_segment = -1;
+    dirty_lock = NULL;
   }
   ~TWARFOG() { Clear(); }
+
+private:
+  int tex_segment;              //!< Segment which fields are in warfog texture.
+  int radar_tex_segment;        //!< Segment which fields are in radar warfog texture.
+
+  TWARFOG_RECT dirty;           //!< Fields changed since the last upload of warfog texture.
+  TWARFOG_RECT radar_dirty;     //!< Fields changed since the last upload of radar warfog texture.
+  TLOCK *dirty_lock;            //!< Lock for changed fields, they are set from update thread.
+
+  void UploadRect(GLenum id, GLubyte *data, TWARFOG_RECT &rect);
+};
+
+
+/**
+ *  Incremental hash of state of all units in the map. Map is divided into
+ *  regions of #MAP_AREA_SIZE x #MAP_AREA_SIZE mapels and hashes of units are
+ *  XOR-combined into hash of the region, in which the unit stands. Units
+ *  fold their hashes out and in whenever their state changes, so the hashes
+ *  of regions can be compared with remote computers at any time.
+ */
+struct TWORLD_HASH {
+  bool Create(void);
+  void Clear(void);
+
+  void Fold(int region, unsigned hash);
+  void GetRegions(unsigned *copy);
+
+  /** Returns index of region of the position. */
+  int GetRegion(T_SIMPLE x, T_SIMPLE y)
+    { return (y / MAP_AREA_SIZE) * regions_width + x / MAP_AREA_SIZE; }
+  int GetRegionsCount(void) { return regions_count; }   //!< Returns count of regions.
+
+  TWORLD_HASH() {
+    regions = NULL;
+    regions_width = regions_count = 0;
+    lock = NULL;
+  }
+  ~TWORLD_HASH() { Clear(); }
+
+private:
+  unsigned *regions;            //!< Hashes of regions.
+  int regions_width;            //!< Count of regions in one row.
+  int regions_count;            //!< Count of all regions.
+  TLOCK *lock;                  //!< Lock for hashes, they are changed from update thread and read when exchanged.
 };
 
 
@@ -308,17 +490,45 @@ public:
   GLfloat zoom;    //!< Zoom constant for drawing.
 
   void Draw(void);
+  void DrawTerrain(void);
+  void DrawUnits(void);
+  void UpdateDot(TRADAR_DOT *dot, GLfloat x, GLfloat y, GLfloat w, GLfloat h, const GLubyte *color);
+  void InvalidateDot(const TRADAR_DOT *dot);
+  void PaintDot(const TRADAR_DOT *dot);
+  void Clear(void);
   void ToggleHideable() { hideable = !hideable; };
 
   bool IsHideable() { return hideable; };
   bool GetMoving() { return moving; };
   void SetMoving(bool mov) { moving = mov; };
 
-  TRADAR(void) { dx = zoom = 0; moving = false; hideable = true; };
+  TRADAR(void) {
+    dx = zoom = 0; moving = false; hideable = true;
+    terrain_tex_id = units_tex_id = 0;
+    terrain_segment = -1;
+    units_raster = NULL;
+    for (int i = 0; i < DRW_RADAR_TILES * DRW_RADAR_TILES / 32; i++) units_dirty[i] = paint_tiles[i] = 0;
+  };
 
 private:
   bool moving;      //!< True if map is moving by clicking to radar.
   bool hideable;    //!< Radar is hideable together with panel.
+
+  GLenum terrain_tex_id;    //!< Texture with terrain of the shown segment.
+  int terrain_segment;      //!< Segment which terrain is in the texture.
+
+  GLenum units_tex_id;      //!< Texture with units dots.
+  GLubyte *units_raster;    //!< Image of units dots (RGBA).
+
+  /** Bit mask of tiles of units texture, whose dots were changed since the last update. Bits are set atomically. */
+  volatile unsigned int units_dirty[DRW_RADAR_TILES * DRW_RADAR_TILES / 32];
+  /** Bit mask of tiles, which are painted in the actual update. */
+  unsigned int paint_tiles[DRW_RADAR_TILES * DRW_RADAR_TILES / 32];
+
+  void UpdateTerrain(int segment);
+  void UpdateUnits(void);
+  void InvalidateRect(int x1, int y1, int x2, int y2);
+  void UploadTiles(int row, int first, int last);
 };
 
 
@@ -385,6 +595,7 @@ public:
   TSEG_UNITS   *segment_units[DAT_SEGMENTS_COUNT];      //!< Units in segments.
 
   TWARFOG war_fog;              //!< Warfog structure.
+  TWORLD_HASH world_hash;       //!< Hashes of state of units in regions of map.
   TCONF_FILE *file;             //!< Configuration file handler.
 
   TMAP_AREA active_area;        //!< Envelope for active area, that is visible on the screen.
@@ -392,6 +603,7 @@ public:
   void UpdateMoving(double time_shift);
   void UpdateGraphics(double time_shift);
   void UpdateActiveArea();
+  void WakeUnits(int x1, int y1, int x2, int y2);
 
   void Draw();
   void DrawBorder();
@@ -455,7 +667,6 @@ public:
   bool LoadMapSources(int pid);               //!< load sources
   bool LoadMapPlayer(int pid);                //!< set player
   bool LoadMapPlayers();                      //!< load players
-  void RenderRadarTextures();
 
 private:
   void Initialise();
@@ -504,14 +715,6 @@ do { \
 } while (0)
 
 
-//=========================================================================
-// Functions
-//=========================================================================
-
-TMAP_SURFACE **CreateMapSurface();
-void DeleteMapSurface(TMAP_SURFACE **surface);
-
-
 #endif  // __domap_h__
 
 //=========================================================================
@@ -61,12 +61,8 @@
   } while(0)
 
 
-#define SET_RADAR_COLOR \
-  do { \
-    if (player == myself) glColor3f(0, 0.8f, 0); \
-    else if (player == hyper_player) glColor3f(0.8f, 0.8f, 0); \
-    else glColor3f(1, 0.2f, 0.2f); \
-  } while(0)
+/** Radar colours of units of myself, hyper player and other players. */
+static const GLubyte radar_colors[3][3] = {{0, 204, 0}, {204, 204, 0}, {255, 51, 51}};
 
 
 //=========================================================================
@@ -252,6 +248,8 @@ void TMAP_UNIT::SetLife(const float value)
 
   
   if (((int)life) != old_life) {
+    UpdateWorldHash();
+
     // only not remote (local) units send message about change of life
     if (!player_array.IsRemote(this->GetPlayerID())) {
       // send info about unit's actual life to all not local players
@@ -470,35 +468,43 @@ void TMAP_UNIT::Draw(T_BYTE style)
 
 
 /**
- *  Method draws unit into radar.
+ *  Method paints unit into radar units image.
  */
-void TMAP_UNIT::DrawToRadar(void)
+void TMAP_UNIT::PaintToRadar(void)
 {
-  if (!(visible || TestState(US_GHOST))) return;
+  radar.PaintDot(&radar_dot);
+}
+
 
+/**
+ *  Method updates dot of unit in radar after the unit moved, appeared or
+ *  disappeared.
+ */
+void TMAP_UNIT::UpdateRadar(void)
+{
   GLfloat zoom = radar.zoom;
   GLfloat w = pitem->GetWidth() * zoom;
   GLfloat h = pitem->GetHeight() * zoom;
+  const GLubyte *color;
 
   if (w < DRW_MIN_RADAR_SIZE) w = DRW_MIN_RADAR_SIZE;
   if (h < DRW_MIN_RADAR_SIZE) h = DRW_MIN_RADAR_SIZE;
 
-  glPushMatrix();
-  RadarPosition(rpos_x, rpos_y);
-
-  SET_RADAR_COLOR;
+  if (!(visible || TestState(US_GHOST))) color = NULL;
+  else if (player == myself) color = radar_colors[0];
+  else if (player == hyper_player) color = radar_colors[1];
+  else color = radar_colors[2];
 
-  glDisable(GL_TEXTURE_2D);
+  radar.UpdateDot(&radar_dot, rpos_x, rpos_y, w, h, color);
+}
 
-  glBegin(GL_QUADS);
-    glVertex2d(0, 0);
-    glVertex2d(w, w);
-    glVertex2d(w - h, w + h);
-    glVertex2d(-h, h);
-  glEnd();
 
-  glEnable(GL_TEXTURE_2D);
-  glPopMatrix();
+/**
+ *  Method marks dot of unit in radar to be painted again.
+ */
+void TMAP_UNIT::InvalidateRadar(void)
+{
+  radar.InvalidateDot(&radar_dot);
 }
 
 /**
@@ -957,8 +963,6 @@ bool TMAP_UNIT::UpdateGraphics(double time_shift)
 
   if (TestState(US_GHOST)) return false;
 
-  if (burn_animation && burn_animation->IsVisible()) burn_animation->Update(time_shift);
-
   if (!visible && selected) {
     selection->DeleteUnit(this);
   }
@@ -967,6 +971,19 @@ bool TMAP_UNIT::UpdateGraphics(double time_shift)
 }
 
 
+/**
+ *  Advances unit animation and burn animation.
+ *
+ *  @param time_shift  Time shift from the last update of animations.
+ */
+void TMAP_UNIT::UpdateAnimations(double time_shift)
+{
+  TPLAYER_UNIT::UpdateAnimations(time_shift);
+
+  if (!TestState(US_GHOST) && burn_animation && burn_animation->IsVisible()) burn_animation->Update(time_shift);
+}
+
+
 /**
  *  Fires on position included in parameter. Creates new instance of TPROJECTILE class and fills its values.
  *  If the new instance of TPROJECTILE class is successful created returns true otherwise return false.
@@ -1151,7 +1168,11 @@ bool TMAP_UNIT::AddToListOfUnits(TFORCE_UNIT *unit, T_BYTE which_list)
   else if (unit->TestItemType(IT_WORKER))
     GetWorkingUnits().AddNode((TWORKER_UNIT *)unit);
 
-  if (unit->GetPlayer() == myself) myself_units++;
+  // visibility of the unit depends on held units of myself
+  if (unit->GetPlayer() == myself) {
+    myself_units++;
+    WakeUp();
+  }
 
   AcquirePointer();
   unit->SetHeld(true, this, which_list);
@@ -1182,7 +1203,10 @@ void TMAP_UNIT::RemoveFromListOfUnits(TFORCE_UNIT *unit, T_BYTE which_list)
 
   else return;
 
-  if (unit->GetPlayer() == myself) myself_units--;
+  if (unit->GetPlayer() == myself) {
+    myself_units--;
+    WakeUp();
+  }
 
   ReleasePointer();
   unit->SetHeld(false);
@@ -1262,7 +1286,7 @@ bool TMAP_UNIT::AddToMap(bool to_segment, bool set_view)
   // check if another unit is in the map
   for (i = 0; i < GetUnitWidth(); i++)
     for (j = 0; j < GetUnitHeight(); j++)                   
-      if (map.segments[pos.segment].surface[pos.x + i][pos.y + j].unit) 
+      if (map.segments[pos.segment].surface.GetUnit(pos.x + i, pos.y + j)) 
         return false;
 
   if (to_segment) AddToSegments();
@@ -1270,12 +1294,14 @@ bool TMAP_UNIT::AddToMap(bool to_segment, bool set_view)
   for (i = 0; i < GetUnitWidth(); i++)
     for (j = 0; j < GetUnitHeight(); j++)
     {
-      map.segments[pos.segment].surface[pos.x + i][pos.y + j].unit = this;
-      map.segments[pos.segment].surface[pos.x + i][pos.y + j].GetAimersList()->AttackEnemy(this, false);
-      map.segments[pos.segment].surface[pos.x + i][pos.y + j].GetWatchersList()->AttackEnemy(this, true);
+      map.segments[pos.segment].surface.SetUnit(pos.x + i, pos.y + j, this);
+      map.segments[pos.segment].surface.GetAimersList(pos.x + i, pos.y + j)->AttackEnemy(this, false);
+      map.segments[pos.segment].surface.GetWatchersList(pos.x + i, pos.y + j)->AttackEnemy(this, true);
     }
 
   is_in_map = true;
+  UpdateWorldHash();
+  WakeUp();
 
   return true;
 }
@@ -1292,11 +1318,43 @@ void TMAP_UNIT::DeleteFromMap(bool from_segment)
 
   for (i = 0; i < GetUnitWidth(); i++)
     for (j = 0; j < GetUnitHeight(); j++)
-      map.segments[pos.segment].surface[pos.x + i][pos.y + j].unit = NULL;
+      map.segments[pos.segment].surface.SetUnit(pos.x + i, pos.y + j, NULL);
 
   if (selected) selection->DeleteUnit(this);
 
   is_in_map = false;
+  UpdateWorldHash();
+  WakeUp();
+}
+
+
+/**
+ *  Folds changed state of the unit into hash of the world. Position, life,
+ *  state and carried materials are hashed. Units which are not in the map,
+ *  ghosts and local units, which exist only on this computer, are not folded.
+ */
+void TMAP_UNIT::UpdateWorldHash()
+{
+  unsigned hash;
+
+  RemoveWorldHash();
+
+  if (!is_in_map || IsGhost() || !player || unit_id < 0) return;
+
+  // FNV-1a of the fields of unit
+  hash = 2166136261u;
+  hash = (hash ^ unsigned(GetPlayerID())) * 16777619u;
+  hash = (hash ^ unsigned(unit_id)) * 16777619u;
+  hash = (hash ^ unsigned(pos.x)) * 16777619u;
+  hash = (hash ^ unsigned(pos.y)) * 16777619u;
+  hash = (hash ^ unsigned(pos.segment)) * 16777619u;
+  hash = (hash ^ unsigned(life)) * 16777619u;
+  hash = (hash ^ state) * 16777619u;
+  hash = (hash ^ GetMaterialsHash()) * 16777619u;
+
+  world_hash = hash;
+  world_region = map.world_hash.GetRegion(pos.x, pos.y);
+  map.world_hash.Fold(world_region, world_hash);
 }
 
 
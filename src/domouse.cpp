@@ -544,8 +544,8 @@ void TMOUSE::FindOverUnit(int seg)
     // unit is found
     if (map.IsInMap(act_x, act_y)
         && (
-          (((units[count] = map.segments[seg].surface[act_x][act_y].unit)) && (units[count]->IsVisible()))
-          || ((units[count] = map.segments[seg].surface[act_x][act_y].ghost))
+          (((units[count] = map.segments[seg].surface.GetUnit(act_x, act_y))) && (units[count]->IsVisible()))
+          || ((units[count] = map.segments[seg].surface.GetGhost(act_x, act_y)))
         )
         && (units[count] != last_unit)
        )
@@ -698,7 +698,7 @@ bool TMOUSE::RectSelect()
       for (j = b; j < t; j++)
         for (i = l; i < r; i++) {
       
-          unit = map.segments[seg].surface[i][j].unit;
+          unit = map.segments[seg].surface.GetUnit(i, j);
 
           // unit must by my, not selected and moveable
           if (unit && (unit->GetPlayer() == myself) && !unit->GetSelected() 
@@ -27,12 +27,22 @@
 #include "cfg.h"
 #include "doalloc.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 #include <vector>
 
 #ifdef UNIX
 # include <signal.h>
+# include <netinet/tcp.h>
+# include <sys/uio.h>
+# ifdef __linux__
+#  include <sys/epoll.h>
+#  include <sys/ioctl.h>
+#  include <linux/sockios.h>
+# else
+#  include <poll.h>
+# endif
 #endif
 
 #include "dologs.h"
@@ -54,6 +64,17 @@ using std::vector;
 TLOG_MESSAGE socket_error_message;
 
 TPOOL<TNET_MESSAGE> * pool_net_messages;
+TNET_LARGE_POOL * pool_net_large_buffers;
+
+/**
+ *  When @c true, listeners created later receive messages from all
+ *  connections in one reactor thread instead of one thread per connection.
+ *  Reactor is not supported on #WINDOWS.
+ */
+bool net_reactor_mode = false;
+
+/** Properties of simulated network used by talkers. */
+TNET_SIMULATION net_simulation = {0, 0, 0, 0, 0};
 
 
 //=========================================================================
@@ -96,6 +117,56 @@ bool init_sockets (void) {
   return true;
 }
 
+/**
+ *  Disables Nagle's algorithm on the socket, so small messages are sent
+ *  immediately. Messages are already joined into batches by the talker.
+ */
+static void set_no_delay (int fd) {
+#ifdef WINDOWS
+  char yes = 1;
+#else
+  int yes = 1;
+#endif
+
+  if (setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof (yes)) == -1)
+    Warning (SOCKET_ERROR_MESSAGE ("Error setting option TCP_NODELAY"));
+}
+
+/**
+ *  Returns size of data waiting in the system send queue of the socket or -1
+ *  if it can not be found out.
+ */
+static int get_send_queue_depth (int fd) {
+#ifdef __linux__
+  int depth;
+
+  if (ioctl (fd, SIOCOUTQ, &depth) == 0)
+    return depth;
+#endif
+
+  return -1;
+}
+
+/**
+ *  Receives exactly @p size bytes from the socket.
+ *
+ *  @return @c false when the connection was closed or an error occured.
+ */
+static bool recv_all (int fd, T_BYTE *buf, int size) {
+  int len;
+
+  for (int pos = 0; pos < size; pos += len) {
+    if ((len = recv (fd, reinterpret_cast<char*>(buf + pos), size - pos, 0)) <= 0) {
+      if (len == -1)
+        Error (SOCKET_ERROR_MESSAGE ("Listener: recv failed"));
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  *  Ends the work with network sockets.
  *
@@ -137,6 +208,8 @@ TNET_ADDRESS::TNET_ADDRESS (in_addr address, in_port_t port) {
     throw ConnectingErrorException ();
   }
 
+  set_no_delay (fd);
+
   connected = true;
 }
 
@@ -179,18 +252,201 @@ void TNET_ADDRESS::Disconnect () {
 }
 
 
+//=========================================================================
+// TNET_LARGE_POOL
+//=========================================================================
+
+TNET_LARGE_POOL::TNET_LARGE_POOL () {
+  mutex = glfwCreateMutex ();
+}
+
+TNET_LARGE_POOL::~TNET_LARGE_POOL () {
+  for (int i = 0; i < net_large_pool_classes; i++)
+    for (unsigned j = 0; j < free_buffers[i].size (); j++)
+      delete[] free_buffers[i][j];
+
+  glfwDestroyMutex (mutex);
+}
+
+/**
+ *  Returns buffer with at least @p size bytes.
+ *
+ *  @param size     Requested size of the buffer.
+ *  @param capacity Real capacity of the buffer is stored here.
+ */
+T_BYTE *TNET_LARGE_POOL::GetBuffer (int size, int *capacity) {
+  int id = 0;
+  T_BYTE *buffer = NULL;
+
+  for (*capacity = 512; *capacity < size && id < net_large_pool_classes - 1; *capacity <<= 1)
+    id++;
+
+  glfwLockMutex (mutex);
+  if (!free_buffers[id].empty ()) {
+    buffer = free_buffers[id].back ();
+    free_buffers[id].pop_back ();
+  }
+  glfwUnlockMutex (mutex);
+
+  if (!buffer)
+    buffer = NEW T_BYTE[*capacity];
+
+  return buffer;
+}
+
+/**
+ *  Returns buffer got by GetBuffer() back to the pool.
+ */
+void TNET_LARGE_POOL::PutBuffer (T_BYTE *buffer, int capacity) {
+  int id = 0;
+
+  for (int c = 512; c < capacity; c <<= 1)
+    id++;
+
+  glfwLockMutex (mutex);
+  if (int (free_buffers[id].size ()) < net_large_pool_keep) {
+    free_buffers[id].push_back (buffer);
+    buffer = NULL;
+  }
+  glfwUnlockMutex (mutex);
+
+  if (buffer)
+    delete[] buffer;
+}
+
+
 //=========================================================================
 // TNET_MESSAGE
 //=========================================================================
 
 
-TNET_MESSAGE::TNET_MESSAGE() {}
+TNET_MESSAGE::TNET_MESSAGE() {
+  large = NULL;
+  large_size = large_capacity = 0;
+}
+
+TNET_MESSAGE::~TNET_MESSAGE() {
+  ReleaseLarge ();
+}
+
+/**
+ *  Clears the message when it is put back to the pool.
+ */
+void TNET_MESSAGE::Clear(bool all) {
+  ReleaseLarge ();
+
+  TPOOL_ELEMENT::Clear (all);
+}
+
+/**
+ *  Returns buffer of large message back to the pool.
+ */
+void TNET_MESSAGE::ReleaseLarge () {
+  if (large) {
+    pool_net_large_buffers->PutBuffer (large, large_capacity);
+    large = NULL;
+  }
+
+  large_size = large_capacity = 0;
+}
+
+/**
+ *  Puts data to large message. Data of small message are moved to a large
+ *  buffer first.
+ */
+void TNET_MESSAGE::PackLarge (const void *data, int size) {
+  int data_size = large ? large_size : this->size - GetHeaderSize ();
+
+  if (net_large_header_size + data_size + size > max_net_large_message_size) {
+    Critical ("Size of the message too big");
+    throw 0;
+  }
+
+  if (net_large_header_size + data_size + size > large_capacity) {
+    int capacity;
+    T_BYTE *buffer = pool_net_large_buffers->GetBuffer (net_large_header_size + data_size + size, &capacity);
+
+    memcpy (buffer + net_large_header_size, GetData (), data_size);
+
+    if (large)
+      pool_net_large_buffers->PutBuffer (large, large_capacity);
+
+    large = buffer;
+    large_capacity = capacity;
+  }
+
+  memcpy (large + net_large_header_size + data_size, data, size);
+  large_size = data_size + size;
+}
+
+/**
+ *  Returns size of the whole message (including headers), as it is sent
+ *  through network.
+ */
+int TNET_MESSAGE::GetSize () {
+  if (!large)
+    return size;
+
+  return GetFrameHeaderSize (GetFrameHeaderSize (net_frame_16) + large_size <= 0xFFFF ? net_frame_16 : net_frame_32) + large_size;
+}
+
+/**
+ *  Returns pointer to start of the header. Header of large message is written
+ *  just before its data, so the message can be sent as one block.
+ */
+const char *TNET_MESSAGE::GetHeaderStart () {
+  if (!large)
+    return (const char *)&size;
+
+  int frame_size = GetSize ();
+  T_BYTE marker = (frame_size - large_size == GetFrameHeaderSize (net_frame_16)) ? net_frame_16 : net_frame_32;
+  T_BYTE *header = large + net_large_header_size - GetFrameHeaderSize (marker);
+
+  header[0] = marker;
+  header[1] = type;
+  header[2] = subtype;
+  header[3] = dest;
+
+  if (marker == net_frame_16) {
+    unsigned short value = htons (static_cast<unsigned short>(frame_size));
+    memcpy (header + 4, &value, sizeof (value));
+  } else {
+    unsigned int value = htonl (static_cast<unsigned int>(frame_size));
+    memcpy (header + 4, &value, sizeof (value));
+  }
+
+  return reinterpret_cast<const char *>(header);
+}
+
+/**
+ *  Reads size of the whole frame from its header.
+ *
+ *  @param header Header of the frame. It must contain at least
+ *                GetFrameHeaderSize() bytes.
+ */
+int TNET_MESSAGE::GetFrameSize (const T_BYTE *header) {
+  if (header[0] == net_frame_16) {
+    unsigned short value;
+    memcpy (&value, header + 4, sizeof (value));
+    return ntohs (value);
+  }
+
+  if (header[0] == net_frame_32) {
+    unsigned int value;
+    memcpy (&value, header + 4, sizeof (value));
+    return ntohl (value);
+  }
+
+  return header[0];
+}
 
 /**
  *  Creates a message with with type @p type and subtype @p subtype.
  */
 void TNET_MESSAGE::Init_send (T_BYTE type, T_BYTE subtype, T_BYTE dest)
 {
+  ReleaseLarge ();
+
   // Length of the message header size
   this->size = GetHeaderSize ();
 
@@ -210,8 +466,9 @@ void TNET_MESSAGE::Init_send (T_BYTE type, T_BYTE subtype, T_BYTE dest)
  *  @param data    Data of the message including the header.
  */
 void TNET_MESSAGE::Init_receive (in_addr address, in_port_t port, int fd, T_BYTE *data) {
-  /*** FIXME: tu kopirovat iba velkost spravy ***/
-  memcpy (&this->size, data, max_net_message_size);
+  ReleaseLarge ();
+
+  memcpy (&this->size, data, data[0]);
   this->address = address;
   this->port = port;
   this->fd = fd;
@@ -219,6 +476,38 @@ void TNET_MESSAGE::Init_receive (in_addr address, in_port_t port, int fd, T_BYTE
   extract_p = 0;
 }
 
+/**
+ *  Creates a large message from header of a frame received from network. Data
+ *  of the message must be written to the returned buffer.
+ *
+ *  @param address    Address of the sender.
+ *  @param port       Port of the sender.
+ *  @param fd         File descriptor of received message.
+ *  @param header     Header of the frame.
+ *  @param frame_size Size of the whole frame including the header.
+ *
+ *  @return Buffer for data of the message.
+ */
+T_BYTE *TNET_MESSAGE::Init_receive_large (in_addr address, in_port_t port, int fd, const T_BYTE *header, int frame_size) {
+  ReleaseLarge ();
+
+  size = GetHeaderSize ();
+  type = header[1];
+  subtype = header[2];
+  dest = header[3];
+
+  this->address = address;
+  this->port = port;
+  this->fd = fd;
+
+  extract_p = 0;
+
+  large_size = frame_size - GetFrameHeaderSize (header[0]);
+  large = pool_net_large_buffers->GetBuffer (net_large_header_size + large_size, &large_capacity);
+
+  return large + net_large_header_size;
+}
+
 void TNET_MESSAGE::Send (int fd) {
   int len;
   int pos = 0;
@@ -303,6 +592,36 @@ TNET_MESSAGE *TNET_MESSAGE_QUEUE::GetMessage () {
   return ret;
 }
 
+/**
+ *  Gets one message from the queue. When there are no messages in the queue,
+ *  this function waits at most @p timeout seconds for a new message.
+ *
+ *  @return The message or @c NULL, when there is no message or the queue is
+ *          dead.
+ */
+TNET_MESSAGE *TNET_MESSAGE_QUEUE::PollMessage (double timeout) {
+  glfwLockMutex (mutex);
+
+  if (count == 0)
+    glfwWaitCond (is_not_empty, mutex, timeout);
+
+  if (dead || count == 0) {
+    glfwUnlockMutex (mutex);
+    return NULL;
+  }
+
+  TNET_MESSAGE *ret = message[head];
+  message[head] = (TNET_MESSAGE *)1;
+  head = (head + 1) % size;
+  count--;
+
+  glfwUnlockMutex (mutex);
+
+  glfwSignalCond (is_not_full);
+
+  return ret;
+}
+
 /**
  *  Inserts a new message into the queue. When the queue is full, this function
  *  blocks the actual thread and waits until a message is removed from the
@@ -357,6 +676,22 @@ TNET_LISTENER::TNET_LISTENER (int queue_size, in_port_t port) {
 
   on_disconnect = NULL;
 
+#ifdef WINDOWS
+  reactor = false;
+#else
+  reactor = net_reactor_mode;
+#endif
+  reactor_stop = false;
+  reactor_wake[0] = reactor_wake[1] = -1;
+  mutex = glfwCreateMutex ();
+
+#ifndef WINDOWS
+  if (reactor && pipe (reactor_wake) == -1) {
+    Error ("Listener: Could not create pipe for reactor, falling back to threads");
+    reactor = false;
+  }
+#endif
+
   thread = glfwCreateThread (listener_thread_function, this);
 
   if (thread < 0) {
@@ -367,6 +702,19 @@ TNET_LISTENER::TNET_LISTENER (int queue_size, in_port_t port) {
 TNET_LISTENER::~TNET_LISTENER () {
   incoming_messages->Die ();
 
+  glfwLockMutex (mutex);
+  reactor_stop = true;
+  glfwUnlockMutex (mutex);
+
+#ifndef WINDOWS
+  /* Wake the reactor, it would wait for network events until timeout. */
+  if (reactor_wake[1] != -1) {
+    char wake = 0;
+    if (write (reactor_wake[1], &wake, 1) == -1)
+      Warning ("Listener: Could not wake reactor");
+  }
+#endif
+
   shutdown (fd, 2);
   do_close (fd);
 
@@ -377,6 +725,19 @@ TNET_LISTENER::~TNET_LISTENER () {
   if (consumer_thread >= 0)
     glfwWaitThread (consumer_thread, GLFW_WAIT);
 
+  /* Connections which were never registered by the reactor. */
+  for (unsigned i = 0; i < reactor_pending.size (); i++)
+    delete reactor_pending[i];
+
+#ifndef WINDOWS
+  if (reactor_wake[0] != -1) {
+    close (reactor_wake[0]);
+    close (reactor_wake[1]);
+  }
+#endif
+
+  glfwDestroyMutex (mutex);
+
   delete incoming_messages;
 }
 
@@ -425,6 +786,17 @@ void GLFWCALL TNET_LISTENER::listener_thread_function (void *listener_class) {
 
   listen (fd, 10);
 
+#ifndef WINDOWS
+  if (self->reactor) {
+    self->RunReactor ();
+
+    end_sockets ();
+
+    Info ("Listener finished");
+    return;
+  }
+#endif
+
   while (1) {
     struct sockaddr_in remote_addr;
     int new_fd;
@@ -434,6 +806,8 @@ void GLFWCALL TNET_LISTENER::listener_thread_function (void *listener_class) {
       break;
     }
 
+    set_no_delay (new_fd);
+
     self->subthread_fd.push_back (new_fd);
     self->subthread_address.push_back (remote_addr.sin_addr);
 
@@ -488,6 +862,34 @@ void GLFWCALL TNET_LISTENER::listener_accept (void *d) {
       break;
     }
 
+    /* Large frame. */
+    if (*size == net_frame_16 || *size == net_frame_32) {
+      int header_size = TNET_MESSAGE::GetFrameHeaderSize (*size);
+      int frame_size;
+
+      if (!recv_all (fd, buf + 1, header_size - 1))
+        break;
+
+      frame_size = TNET_MESSAGE::GetFrameSize (buf);
+
+      if (frame_size < header_size || frame_size > max_net_large_message_size) {
+        Error ("Listener: Received corrupted message");
+        shutdown (fd, 2);
+        break;
+      }
+
+      TNET_MESSAGE *msg = pool_net_messages->GetFromPool();
+      T_BYTE *msg_data = msg->Init_receive_large (data->address.sin_addr, data->address.sin_port, fd, buf, frame_size);
+
+      if (!recv_all (fd, msg_data, frame_size - header_size)) {
+        pool_net_messages->PutToPool(msg);
+        break;
+      }
+
+      self->incoming_messages->PutMessage (msg);
+      continue;
+    }
+
     do {
       if ((len = recv (fd, reinterpret_cast<char*>(buf + pos), *size - pos, 0)) <= 0) {
         Error (SOCKET_ERROR_MESSAGE ("Listener: recv failed"));
@@ -518,6 +920,17 @@ void TNET_LISTENER::AddListenerByFileDescriptor (in_addr address, in_port_t port
   remote_addr.sin_addr = address;
   memset (remote_addr.sin_zero, '\0', 8);       /* clear the rest of the structure */
 
+  if (reactor) {
+    glfwLockMutex (mutex);
+
+    subthread_fd.push_back (fd);
+    subthread_address.push_back (remote_addr.sin_addr);
+    reactor_pending.push_back (NEW TNET_LISTENER::CONNECTION (fd, remote_addr));
+
+    glfwUnlockMutex (mutex);
+    return;
+  }
+
   TNET_LISTENER::ACCEPT_DATA *data = NEW TNET_LISTENER::ACCEPT_DATA (fd, remote_addr, this);
 
   GLFWthread t;
@@ -531,17 +944,335 @@ void TNET_LISTENER::AddListenerByFileDescriptor (in_addr address, in_port_t port
   subthread_thread.push_back (t);
 }
 
+#ifndef WINDOWS
+
+/**
+ *  Receives messages from all connections in one thread. Connections are
+ *  watched by epoll on Linux and by poll elsewhere. Data are read only when
+ *  they are available and incomplete messages are kept in buffers of the
+ *  connections.
+ *
+ *  @note File descriptors are shared with the talker, which sends in blocking
+ *  mode, so they are not switched to non-blocking mode. Reads use
+ *  @c MSG_DONTWAIT instead.
+ */
+void TNET_LISTENER::RunReactor () {
+  vector<CONNECTION *> connections;
+  unsigned i;
+
+#ifdef __linux__
+  struct epoll_event events[32];
+  struct epoll_event event;
+  int epoll_fd;
+
+  if ((epoll_fd = epoll_create (32)) == -1) {
+    Error (SOCKET_ERROR_MESSAGE ("Listener: Calling epoll_create failed"));
+    return;
+  }
+
+  /* Listening socket has not any connection. */
+  event.events = EPOLLIN;
+  event.data.ptr = NULL;
+  epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd, &event);
+
+  /* Pipe only wakes the reactor, when it should finish. */
+  event.events = EPOLLIN;
+  event.data.ptr = reactor_wake;
+  epoll_ctl (epoll_fd, EPOLL_CTL_ADD, reactor_wake[0], &event);
+#else
+  vector<struct pollfd> poll_fds;
+#endif
+
+  Info ("Listener: Using reactor");
+
+  while (!IsReactorStopped ()) {
+    vector<CONNECTION *> ready;
+    bool accept_ready = false;
+
+    /* Register connections added by other threads. */
+    glfwLockMutex (mutex);
+    for (i = 0; i < reactor_pending.size (); i++) {
+#ifdef __linux__
+      event.events = EPOLLIN;
+      event.data.ptr = reactor_pending[i];
+      epoll_ctl (epoll_fd, EPOLL_CTL_ADD, reactor_pending[i]->fd, &event);
+#endif
+      connections.push_back (reactor_pending[i]);
+    }
+    reactor_pending.clear ();
+    glfwUnlockMutex (mutex);
+
+#ifdef __linux__
+    int count = epoll_wait (epoll_fd, events, 32, net_reactor_timeout);
+
+    for (int j = 0; j < count; j++) {
+      if (events[j].data.ptr == reactor_wake)
+        continue;
+      else if (events[j].data.ptr)
+        ready.push_back (static_cast<CONNECTION *>(events[j].data.ptr));
+      else
+        accept_ready = true;
+    }
+#else
+    poll_fds.resize (connections.size () + 2);
+
+    poll_fds[0].fd = fd;
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = reactor_wake[0];
+    poll_fds[1].events = POLLIN;
+    for (i = 0; i < connections.size (); i++) {
+      poll_fds[i + 2].fd = connections[i]->fd;
+      poll_fds[i + 2].events = POLLIN;
+    }
+
+    int count = poll (&poll_fds[0], poll_fds.size (), net_reactor_timeout);
+
+    if (count > 0) {
+      accept_ready = (poll_fds[0].revents != 0);
+      for (i = 0; i < connections.size (); i++)
+        if (poll_fds[i + 2].revents)
+          ready.push_back (connections[i]);
+    }
+#endif
+
+    if (count == -1 && errno != EINTR) {
+      Error (SOCKET_ERROR_MESSAGE ("Listener: Waiting for network events failed"));
+      break;
+    }
+
+    if (IsReactorStopped ())
+      break;
+
+    for (i = 0; i < ready.size (); i++) {
+      if (ReadConnection (ready[i]))
+        continue;
+
+#ifdef __linux__
+      epoll_ctl (epoll_fd, EPOLL_CTL_DEL, ready[i]->fd, &event);
+#endif
+      connections.erase (std::find (connections.begin (), connections.end (), ready[i]));
+      CloseConnection (ready[i]);
+    }
+
+    if (accept_ready) {
+      CONNECTION *connection = AcceptConnection ();
+
+      if (!connection)
+        break;
+
+#ifdef __linux__
+      event.events = EPOLLIN;
+      event.data.ptr = connection;
+      epoll_ctl (epoll_fd, EPOLL_CTL_ADD, connection->fd, &event);
+#endif
+      connections.push_back (connection);
+    }
+  }
+
+#ifdef __linux__
+  close (epoll_fd);
+#endif
+
+  /* Shutdown all connections. */
+  for (i = 0; i < connections.size (); i++) {
+    shutdown (connections[i]->fd, 2);
+    CloseConnection (connections[i]);
+  }
+}
+
+/**
+ *  Accepts new connection on the listening socket.
+ *
+ *  @return New connection or @c NULL when the listening socket was closed.
+ */
+TNET_LISTENER::CONNECTION *TNET_LISTENER::AcceptConnection () {
+  struct sockaddr_in remote_addr;
+  socklen_t sockaddr_size = sizeof (remote_addr);
+  int new_fd;
+
+  if ((new_fd = accept (fd, (sockaddr *)&remote_addr, &sockaddr_size)) == -1) {
+    Debug (SOCKET_ERROR_MESSAGE ("Listener: Error accepting connection"));
+    return NULL;
+  }
+
+  Debug (LogMsg ("Got connection from: %s", inet_ntoa (remote_addr.sin_addr)));
+
+  set_no_delay (new_fd);
+
+  glfwLockMutex (mutex);
+  subthread_fd.push_back (new_fd);
+  subthread_address.push_back (remote_addr.sin_addr);
+  glfwUnlockMutex (mutex);
+
+  return NEW TNET_LISTENER::CONNECTION (new_fd, remote_addr);
+}
+
+/**
+ *  Reads available data from the connection and puts all complete messages
+ *  into the incoming message queue.
+ *
+ *  @return @c false when the connection was closed or is broken.
+ */
+bool TNET_LISTENER::ReadConnection (CONNECTION *connection) {
+  int len;
+  int pos = 0;
+
+  /* Data of a large message are received directly to the message. */
+  if (connection->large)
+    len = recv (connection->fd, reinterpret_cast<char*>(connection->large_data + connection->large_pos),
+                connection->large_size - connection->large_pos, MSG_DONTWAIT);
+  else
+    len = recv (connection->fd, reinterpret_cast<char*>(connection->buf + connection->size),
+                net_reactor_buffer_size - connection->size, MSG_DONTWAIT);
+
+  if (len == 0) {
+    Debug ("Listener: Remote host closed connection");
+    return false;
+  }
+
+  if (len == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return true;
+
+    Error (SOCKET_ERROR_MESSAGE ("Listener: recv failed"));
+    return false;
+  }
+
+  if (connection->large) {
+    connection->large_pos += len;
+
+    if (connection->large_pos == connection->large_size) {
+      incoming_messages->PutMessage (connection->large);
+      connection->large = NULL;
+    }
+
+    return true;
+  }
+
+  connection->size += len;
+
+  /* The first byte of each message is its size or a mark of large frame. */
+  while (pos < connection->size) {
+    T_BYTE *header = connection->buf + pos;
+    int available = connection->size - pos;
+
+    if (*header == net_frame_16 || *header == net_frame_32) {
+      int header_size = TNET_MESSAGE::GetFrameHeaderSize (*header);
+
+      if (available < header_size)
+        break;
+
+      int frame_size = TNET_MESSAGE::GetFrameSize (header);
+
+      if (frame_size < header_size || frame_size > max_net_large_message_size) {
+        Error ("Listener: Received corrupted message");
+        return false;
+      }
+
+      TNET_MESSAGE *msg = pool_net_messages->GetFromPool();
+      T_BYTE *data = msg->Init_receive_large (connection->address.sin_addr, connection->address.sin_port, connection->fd, header, frame_size);
+      int copied = MIN(available, frame_size) - header_size;
+
+      memcpy (data, header + header_size, copied);
+      pos += header_size + copied;
+
+      if (header_size + copied < frame_size) {
+        /* The rest of the message will be received later (the buffer is empty now). */
+        connection->large = msg;
+        connection->large_data = data;
+        connection->large_pos = copied;
+        connection->large_size = frame_size - header_size;
+        break;
+      }
+
+      incoming_messages->PutMessage (msg);
+      continue;
+    }
+
+    if (*header > available)
+      break;
+
+    if (*header < TNET_MESSAGE::GetHeaderSize ()) {
+      Error ("Listener: Received corrupted message");
+      return false;
+    }
+
+    TNET_MESSAGE *msg = pool_net_messages->GetFromPool();
+    msg->Init_receive(connection->address.sin_addr, connection->address.sin_port, connection->fd, connection->buf + pos);
+    incoming_messages->PutMessage (msg);
+
+    pos += connection->buf[pos];
+  }
+
+  /* Move the incomplete message to the beginning of the buffer. */
+  connection->size -= pos;
+  memmove (connection->buf, connection->buf + pos, connection->size);
+
+  return true;
+}
+
+/**
+ *  Closes the connection and notifies about disconnection.
+ */
+void TNET_LISTENER::CloseConnection (CONNECTION *connection) {
+  /* Talker must not get descriptor of closed connection any more. */
+  glfwLockMutex (mutex);
+
+  for (unsigned i = 0; i < subthread_fd.size (); i++) {
+    if (subthread_fd[i] == connection->fd) {
+      subthread_fd.erase (subthread_fd.begin () + i);
+      subthread_address.erase (subthread_address.begin () + i);
+      break;
+    }
+  }
+
+  glfwUnlockMutex (mutex);
+
+  do_close (connection->fd);
+
+  if (connection->large)
+    pool_net_messages->PutToPool(connection->large);
+
+  if (on_disconnect)
+    on_disconnect (connection->address.sin_addr, connection->address.sin_port);
+
+  delete connection;
+}
+
+/**
+ *  Returns @c true when the reactor should finish.
+ */
+bool TNET_LISTENER::IsReactorStopped () {
+  bool result;
+
+  glfwLockMutex (mutex);
+  result = reactor_stop;
+  glfwUnlockMutex (mutex);
+
+  return result;
+}
+
+#endif
+
 void TNET_LISTENER::ConsumerIsAttached (GLFWthread thread) {
   consumer_thread = thread;
 }
 
 int TNET_LISTENER::GetListenersFileDescriptor (in_addr address) {
+  int result = -1;
+
+  glfwLockMutex (mutex);
+
   for (unsigned i = 0; i < subthread_address.size (); i++) {
-    if (TNET_RESOLVER::NetworkToAscii (subthread_address[i]) == TNET_RESOLVER::NetworkToAscii (address))
-      return subthread_fd[i];
+    if (TNET_RESOLVER::NetworkToAscii (subthread_address[i]) == TNET_RESOLVER::NetworkToAscii (address)) {
+      result = subthread_fd[i];
+      break;
+    }
   }
 
-  return -1;
+  glfwUnlockMutex (mutex);
+
+  return result;
 }
 
 void TNET_LISTENER::RegisterOnDisconnect (void (* f)(in_addr, in_port_t)) {
@@ -575,6 +1306,9 @@ TNET_TALKER::TNET_TALKER (int queue_size, in_addr remote_address,
 void TNET_TALKER::Initialise (int queue_size) {
   outgoing_messages = NEW TNET_MESSAGE_QUEUE (queue_size);
 
+  sent_messages = sent_batches = send_calls = 0;
+  random_seed = static_cast<unsigned int>(glfwGetTime () * 1000);
+
   thread = glfwCreateThread (talker_thread_function, this);
 
   if (thread < 0)
@@ -614,41 +1348,367 @@ void GLFWCALL TNET_TALKER::talker_thread_function (void *talker_class) {
   Info ("Talker running");
 
   TNET_MESSAGE *msg;
+  vector<TNET_BATCH> batches;
+  double deadline, remaining;
+
+  if (net_simulation.IsActive ())
+    Info (LogMsg ("Talker: Simulating network with delay %d ms, jitter %d ms, reorder %d ms, loss %d %%, bandwidth %d kB/s",
+                  net_simulation.delay, net_simulation.jitter, net_simulation.reorder, net_simulation.loss, net_simulation.bandwidth));
+
+  while (1) {
+    /* Wake up when data held back by simulated network should be sent. */
+    if (self->delayed.empty ())
+      msg = self->outgoing_messages->GetMessage ();
+    else
+      msg = self->outgoing_messages->PollMessage (MAX(0, self->delayed[0].due - glfwGetTime ()));
+
+    if (!msg) {
+      if (self->outgoing_messages->IsDead ())
+        break;
+
+      self->SendDelayed ();
+      continue;
+    }
 
-  while ((msg = self->outgoing_messages->GetMessage ()) != NULL) {
     /*
-     * Find out, if the message is destined for all remote addresses, or for
-     * one only (e.g. only for one player).
+     * Collect messages, which come during net_batch_delay, to batches for
+     * each remote side. Full batches are sent immediately.
      */
-    if (msg->GetDest () == 255) {
-      // XXX: namiesto 255 to chce konstantu
-
-      for (unsigned i = 0; i < self->distinct_remote_addresses.size (); i++) {
-        try {
-          int fd = self->distinct_remote_addresses[i]->GetFileDescriptor ();
-          msg->Send (fd);
-        } catch (TNET_MESSAGE::SendError &) {
-          self->distinct_remote_addresses[i]->Disconnect ();
-        }
-      }
-    } else {
-      try {
-        int fd = self->remote_address[msg->GetDest ()]->GetFileDescriptor ();
-        msg->Send (fd);
-      } catch (TNET_MESSAGE::SendError &) {
-        self->remote_address[msg->GetDest ()]->Disconnect ();
-      }
-    }
+    deadline = glfwGetTime () + net_batch_delay;
+
+    do {
+      self->AddToBatches (batches, msg);
+      pool_net_messages->PutToPool(msg);
 
-    pool_net_messages->PutToPool(msg);
+      if ((remaining = deadline - glfwGetTime ()) <= 0)
+        break;
+    } while ((msg = self->outgoing_messages->PollMessage (remaining)) != NULL);
+
+    for (unsigned i = 0; i < batches.size (); i++)
+      self->SendBatch (batches[i]);
+
+    self->send_buffer.clear ();
+
+    self->SendDelayed ();
   }
 
   do_close (fd);
   end_sockets ();
 
+  if (self->sent_batches)
+    Info (LogMsg ("Talker sent %lu messages in %lu batches (%.2f messages per batch, %lu send calls)",
+                  self->sent_messages, self->sent_batches,
+                  double (self->sent_messages) / self->sent_batches, self->send_calls));
+
+  self->LogBatches (batches);
+
   Info ("Talker finished");
 }
 
+/**
+ *  Stores a message into the shared buffer and adds it to batches of all
+ *  remote sides, for which it is destined.
+ */
+void TNET_TALKER::AddToBatches (vector<TNET_BATCH> &batches, TNET_MESSAGE *msg) {
+  int offset = send_buffer.size ();
+  int size = msg->GetSize ();
+
+  send_buffer.insert (send_buffer.end (), msg->GetHeaderStart (), msg->GetHeaderStart () + size);
+
+  /*
+   * Find out, if the message is destined for all remote addresses, or for
+   * one only (e.g. only for one player).
+   */
+  if (msg->GetDest () == 255) {
+    // XXX: namiesto 255 to chce konstantu
+
+    for (unsigned i = 0; i < distinct_remote_addresses.size (); i++) {
+      if (distinct_remote_addresses[i]->Connected ())
+        AddToBatch (batches, distinct_remote_addresses[i], offset, size);
+    }
+  } else if (remote_address[msg->GetDest ()]->Connected ()) {
+    AddToBatch (batches, remote_address[msg->GetDest ()], offset, size);
+  }
+}
+
+/**
+ *  Adds a message stored in the shared buffer at @p offset to the batch for
+ *  remote side @p address. When the message does not fit into the batch, the
+ *  batch is sent first.
+ */
+void TNET_TALKER::AddToBatch (vector<TNET_BATCH> &batches, TNET_ADDRESS *address, int offset, int size) {
+  int fd = address->GetFileDescriptor ();
+  unsigned i;
+
+  for (i = 0; i < batches.size () && batches[i].fd != fd; i++);
+
+  if (i == batches.size ()) {
+    batches.push_back (TNET_BATCH ());
+    batches[i].fd = fd;
+    batches[i].size = 0;
+    batches[i].sent_messages = batches[i].sent_bytes = 0;
+    batches[i].queue_depth = batches[i].max_queue_depth = -1;
+    batches[i].send_time = 0;
+    batches[i].link_free = batches[i].last_due = 0;
+  }
+
+  TNET_BATCH &batch = batches[i];
+
+  /* File descriptor could be reused by a new remote side. */
+  batch.address = address->GetAddress ();
+  batch.port = address->GetPort ();
+
+  if (batch.size + size > net_batch_size)
+    SendBatch (batch);
+
+  batch.offsets.push_back (offset);
+  batch.sizes.push_back (size);
+  batch.size += size;
+}
+
+/**
+ *  Sends all messages of the batch directly from the shared buffer by one
+ *  call of writev() (more calls are needed only if the system sends just a
+ *  part of the data). Messages which follow each other in the shared buffer
+ *  are sent as one block.
+ */
+void TNET_TALKER::SendBatch (TNET_BATCH &batch) {
+  int len;
+  int pos = 0;
+
+  if (!batch.size)
+    return;
+
+  if (net_simulation.IsActive ()) {
+    DelayBatch (batch);
+    return;
+  }
+
+  const T_BYTE *data = &send_buffer[0];
+  double start = glfwGetTime ();
+
+#ifdef WINDOWS
+  /* There is no gathering send in Winsock 1.1, join the messages. */
+  vector<char> joined;
+
+  for (unsigned i = 0; i < batch.offsets.size (); i++)
+    joined.insert (joined.end (), data + batch.offsets[i], data + batch.offsets[i] + batch.sizes[i]);
+
+  do {
+    send_calls++;
+
+    if ((len = send (batch.fd, &joined[pos], batch.size - pos, 0)) == -1) {
+      Debug (SOCKET_ERROR_MESSAGE ("Error sending message"));
+      DisconnectFileDescriptor (batch.fd);
+      break;
+    }
+
+    pos += len;
+  } while (pos != batch.size);
+#else
+  vector<struct iovec> blocks;
+  unsigned first = 0;
+
+  for (unsigned i = 0; i < batch.offsets.size (); i++) {
+    const T_BYTE *message = data + batch.offsets[i];
+
+    if (!blocks.empty () && static_cast<T_BYTE *>(blocks.back ().iov_base) + blocks.back ().iov_len == message)
+      blocks.back ().iov_len += batch.sizes[i];
+    else {
+      struct iovec block;
+
+      block.iov_base = const_cast<T_BYTE *>(message);
+      block.iov_len = batch.sizes[i];
+      blocks.push_back (block);
+    }
+  }
+
+  do {
+    send_calls++;
+
+    if ((len = writev (batch.fd, &blocks[first], blocks.size () - first)) == -1) {
+      Debug (SOCKET_ERROR_MESSAGE ("Error sending message"));
+      DisconnectFileDescriptor (batch.fd);
+      break;
+    }
+
+    pos += len;
+
+    /* Skip blocks which were sent completely. */
+    while (len > 0 && len >= int (blocks[first].iov_len))
+      len -= blocks[first++].iov_len;
+
+    if (len > 0) {
+      blocks[first].iov_base = static_cast<T_BYTE *>(blocks[first].iov_base) + len;
+      blocks[first].iov_len -= len;
+    }
+  } while (pos != batch.size);
+#endif
+
+  batch.send_time += glfwGetTime () - start;
+
+  if (pos == batch.size) {
+    sent_messages += batch.offsets.size ();
+    sent_batches++;
+
+    batch.sent_messages += batch.offsets.size ();
+    batch.sent_bytes += batch.size;
+
+    /* Data waiting in the system queue show that the remote side does not
+     * manage to receive them. */
+    batch.queue_depth = get_send_queue_depth (batch.fd);
+
+    if (batch.queue_depth > batch.max_queue_depth) {
+      if (batch.queue_depth > net_queue_warning_size && batch.max_queue_depth <= net_queue_warning_size)
+        Warning (LogMsg ("Talker: %s:%hu does not manage to receive data, %d bytes are waiting",
+                         TNET_RESOLVER::NetworkToAscii (batch.address).c_str (), batch.port, batch.queue_depth));
+
+      batch.max_queue_depth = batch.queue_depth;
+    }
+  }
+
+  batch.size = 0;
+  batch.offsets.clear ();
+  batch.sizes.clear ();
+}
+
+/**
+ *  Returns random number from interval [0, 1) and updates @p seed. Talker
+ *  doesn't use rand(), so it doesn't change random numbers of the game.
+ */
+static double sim_random (unsigned int &seed) {
+  seed = seed * 1103515245 + 12345;
+
+  return ((seed >> 16) & 0x7FFF) / 32768.0;
+}
+
+/**
+ *  Holds back data of the batch until they would be delivered by simulated
+ *  network. Time of delivery is given by bandwidth of the link to the remote
+ *  side, delay, jitter and retransmission of lost data.
+ */
+void TNET_TALKER::DelayBatch (TNET_BATCH &batch) {
+  const T_BYTE *data = &send_buffer[0];
+  double now = glfwGetTime ();
+  TNET_DELAYED item;
+
+  for (unsigned i = 0; i < batch.offsets.size (); i++)
+    item.data.insert (item.data.end (), data + batch.offsets[i], data + batch.offsets[i] + batch.sizes[i]);
+
+  /* Data wait until the link is free and then they take size / bandwidth. */
+  batch.link_free = MAX(now, batch.link_free);
+  if (net_simulation.bandwidth)
+    batch.link_free += batch.size / (net_simulation.bandwidth * 1024.0);
+
+  item.fd = batch.fd;
+  item.due = batch.link_free + (net_simulation.delay + net_simulation.jitter * sim_random (random_seed)) / 1000;
+
+  /* Lost data are retransmitted after a timeout. */
+  if (net_simulation.loss && sim_random (random_seed) * 100 < net_simulation.loss)
+    item.due += (2 * net_simulation.delay + 200) / 1000.0;
+
+  /* Data can not overtake older data by more than reorder time. */
+  item.due = MAX(item.due, batch.last_due - net_simulation.reorder / 1000.0);
+  batch.last_due = MAX(batch.last_due, item.due);
+
+  /* Keep data sorted by time of delivery. */
+  vector<TNET_DELAYED>::iterator it;
+  for (it = delayed.begin (); it != delayed.end () && it->due <= item.due; it++);
+  delayed.insert (it, item);
+
+  sent_messages += batch.offsets.size ();
+  sent_batches++;
+
+  batch.sent_messages += batch.offsets.size ();
+  batch.sent_bytes += batch.size;
+
+  batch.size = 0;
+  batch.offsets.clear ();
+  batch.sizes.clear ();
+}
+
+/**
+ *  Sends data held back by simulated network, which should be already
+ *  delivered.
+ */
+void TNET_TALKER::SendDelayed () {
+  double now = glfwGetTime ();
+
+  while (!delayed.empty () && delayed[0].due <= now) {
+    int fd = delayed[0].fd;
+
+    if (!SendData (fd, &delayed[0].data[0], delayed[0].data.size ())) {
+      DisconnectFileDescriptor (fd);
+
+      /* Drop other data for the broken remote side. */
+      for (unsigned i = delayed.size (); i-- > 1; )
+        if (delayed[i].fd == fd)
+          delayed.erase (delayed.begin () + i);
+    }
+
+    delayed.erase (delayed.begin ());
+  }
+}
+
+/**
+ *  Sends @p size bytes of @p data to the remote side.
+ *
+ *  @return @c false when sending failed.
+ */
+bool TNET_TALKER::SendData (int fd, const T_BYTE *data, int size) {
+  int len;
+
+  for (int pos = 0; pos < size; pos += len) {
+    send_calls++;
+
+    if ((len = send (fd, reinterpret_cast<const char *>(data) + pos, size - pos, 0)) == -1) {
+      Debug (SOCKET_ERROR_MESSAGE ("Error sending message"));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ *  Logs statistics of sending to each remote side.
+ */
+void TNET_TALKER::LogBatches (vector<TNET_BATCH> &batches) {
+  for (unsigned i = 0; i < batches.size (); i++) {
+    TNET_BATCH &batch = batches[i];
+
+    if (batch.max_queue_depth >= 0)
+      Info (LogMsg ("Talker: %s:%hu got %lu messages (%lu bytes) in %.3f s, maximal send queue depth %d bytes",
+                    TNET_RESOLVER::NetworkToAscii (batch.address).c_str (), batch.port,
+                    batch.sent_messages, batch.sent_bytes, batch.send_time, batch.max_queue_depth));
+    else
+      Info (LogMsg ("Talker: %s:%hu got %lu messages (%lu bytes) in %.3f s",
+                    TNET_RESOLVER::NetworkToAscii (batch.address).c_str (), batch.port,
+                    batch.sent_messages, batch.sent_bytes, batch.send_time));
+  }
+}
+
+/**
+ *  Disconnects the address which uses file descriptor @p fd after an error.
+ */
+void TNET_TALKER::DisconnectFileDescriptor (int fd) {
+  unsigned i;
+
+  for (i = 0; i < distinct_remote_addresses.size (); i++) {
+    if (distinct_remote_addresses[i]->GetFileDescriptor () == fd) {
+      distinct_remote_addresses[i]->Disconnect ();
+      return;
+    }
+  }
+
+  for (i = 0; i < remote_address.size (); i++) {
+    if (remote_address[i]->GetFileDescriptor () == fd) {
+      remote_address[i]->Disconnect ();
+      return;
+    }
+  }
+}
+
 void TNET_TALKER::RemoveAllAddresses () {
   for (unsigned i = 0; i < remote_address.size (); i++)
     delete remote_address[i];
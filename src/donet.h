@@ -74,9 +74,48 @@ typedef unsigned short in_port_t;
 // Constants
 //=========================================================================
 
-/** Maximum size of networking message including headers. */
+/** Maximum size of networking message including headers, which is sent
+ *  with one byte size. Bigger messages are sent in large frames. */
 const int max_net_message_size = 255;
 
+/** Maximum size of large networking message including headers. */
+const int max_net_large_message_size = 16 * 1024 * 1024;
+
+/** Value of the size byte which marks large frame with 16-bit size. */
+const T_BYTE net_frame_16 = 1;
+/** Value of the size byte which marks large frame with 32-bit size. */
+const T_BYTE net_frame_32 = 2;
+
+/** Space reserved for the header at the start of buffer of large message.
+ *  It is enough for the biggest header (with 32-bit size). */
+const int net_large_header_size = 8;
+
+/** Count of capacities of buffers in large message pool. Capacities are
+ *  powers of two from 512 bytes to #max_net_large_message_size. */
+const int net_large_pool_classes = 16;
+
+/** Maximum count of free buffers of one capacity kept in large message pool. */
+const int net_large_pool_keep = 8;
+
+/** Size of the buffer in which talker joins messages for one remote side.
+ *  When the next message does not fit into the buffer, it is sent. */
+const int net_batch_size = 1460;
+
+/** Maximum time for which talker collects messages into batches before it
+ *  sends them. [seconds] */
+const double net_batch_delay = 0.002;
+
+/** Size of data waiting in the system send queue of one remote side, over
+ *  which the remote side is reported as slow. [bytes] */
+const int net_queue_warning_size = 16384;
+
+/** Size of the buffer into which reactor reads data from one connection. */
+const int net_reactor_buffer_size = 4096;
+
+/** Maximum time for which reactor waits for network events before it checks
+ *  new connections and end of the listener. [miliseconds] */
+const int net_reactor_timeout = 100;
+
 
 //=========================================================================
 // Define macros
@@ -104,12 +143,39 @@ const int max_net_message_size = 255;
 #endif
 
 
+//=========================================================================
+// Structures
+//=========================================================================
+
+/**
+ *  Properties of simulated network, through which the talker sends data. It
+ *  allows to test multiplayer on one computer or on localhost with behaviour
+ *  of a real network. Data are sent reliably, as in TCP, so a lost packet
+ *  is simulated by delay of its retransmission.
+ */
+struct TNET_SIMULATION {
+  int delay;        //!< One-way delay. [miliseconds]
+  int jitter;       //!< Maximal random addition to the delay. [miliseconds]
+  int reorder;      //!< Maximal time by which data may overtake data sent before them. [miliseconds]
+  int loss;         //!< Probability of loss of data, which are then retransmitted. [percents]
+  int bandwidth;    //!< Bandwidth to each remote side, 0 for unlimited. [kB/s]
+
+  /** Finds out, if the network is simulated. */
+  bool IsActive ()
+  { return delay || jitter || loss || bandwidth; }
+};
+
+
 //=========================================================================
 // Variables
 //=========================================================================
 
 extern TLOG_MESSAGE socket_error_message;
 
+extern TNET_SIMULATION net_simulation;
+
+extern bool net_reactor_mode;
+
 //=========================================================================
 // TNET_ADDRESS
 //=========================================================================
@@ -147,6 +213,35 @@ private:
 };
 
 
+//=========================================================================
+// TNET_LARGE_POOL
+//=========================================================================
+
+/**
+ *  Pool of variable-size buffers for large network messages. Free buffers
+ *  are kept in lists by their capacity, which is a power of two.
+ *
+ *  @note This class is thread safe.
+ */
+class TNET_LARGE_POOL {
+public:
+  TNET_LARGE_POOL ();
+  ~TNET_LARGE_POOL ();
+
+  T_BYTE *GetBuffer (int size, int *capacity);
+  void PutBuffer (T_BYTE *buffer, int capacity);
+
+private:
+  std::vector<T_BYTE *> free_buffers[net_large_pool_classes]; //!< Free buffers for each capacity.
+
+#ifdef NEW_GLFW3
+  mtx_t mutex;
+#else
+  GLFWmutex mutex;      //!< Pool mutex.
+#endif
+};
+
+
 //=========================================================================
 // TNET_MESSAGE
 //=========================================================================
@@ -154,32 +249,46 @@ private:
 /**
  *  Network message containing one event. One network packet can contain more
  *  messages.
+ *
+ *  Messages up to #max_net_message_size bytes are sent with one byte size in
+ *  the header. When more data are packed, the message moves its data to a
+ *  buffer from large message pool and it is sent in a large frame. The size
+ *  byte of large frame is #net_frame_16 or #net_frame_32 and the header is
+ *  followed by 16-bit or 32-bit size of the whole frame (in network byte
+ *  order).
  */
 struct TNET_MESSAGE : public TPOOL_ELEMENT {
 public:
   class SendError {};
 
-  // XXX: 255
   TNET_MESSAGE();
+  virtual ~TNET_MESSAGE();
+
+  virtual void Clear(bool all);
   
   void Init_send (T_BYTE type, T_BYTE subtype, T_BYTE dest = 255);
   void Init_receive (in_addr address, in_port_t port, int fd, T_BYTE *data);
+  T_BYTE *Init_receive_large (in_addr address, in_port_t port, int fd, const T_BYTE *header, int frame_size);
 
-  T_BYTE GetSize ()     { return size; }
+  int GetSize ();
   T_BYTE GetType ()     { return type; }
   T_BYTE GetSubtype ()  { return subtype; }
   T_BYTE GetDest ()     { return dest; }
 
   void SetDest (T_BYTE dest)  { this->dest = dest; }
 
-  const T_BYTE *GetBuf () { return buf; }
+  /** Returns data of the message without the header. */
+  const T_BYTE *GetBuf () { return GetData (); }
+
+  /** Finds out, if the message is sent in a large frame. */
+  bool IsLarge () { return large != NULL; }
 
   /** Puts @p size of bytes from memory at address @p data into the message. */
   void Pack (const void *data, int size)
   {
-    if (this->size + size > max_net_message_size) {
-      Critical ("Size of the message too big");
-      throw 0;
+    if (large || this->size + size > max_net_message_size) {
+      PackLarge (data, size);
+      return;
     }
     memcpy (&buf[this->size - GetHeaderSize ()], data, size);
     this->size += size;
@@ -188,9 +297,9 @@ public:
   /** Puts a byte into the message. */
   void PackByte (T_BYTE byte)
   { 
-    if (this->size + 1 > max_net_message_size) {
-      Critical ("Size of the message too big");
-      throw 0;
+    if (large || this->size + 1 > max_net_message_size) {
+      PackLarge (&byte, 1);
+      return;
     }
     buf[this->size++ - GetHeaderSize ()] = byte;
   }
@@ -202,29 +311,43 @@ public:
   /** Gets @p size of bytes from message into memory at address @p data. */
   void Extract (void *data, int size)
   {
-    memcpy (data, &buf[extract_p], size);
+    memcpy (data, GetData () + extract_p, size);
     extract_p += size;
   }
 
   /** Gets a byte from the message. */
   T_BYTE ExtractByte ()
-  { return buf[extract_p++]; }
+  { return GetData ()[extract_p++]; }
 
   /** Gets a string from a message. */
   std::string ExtractString ()
   { 
     int old_p = extract_p;
-    const char *char_p = reinterpret_cast<const char *>(&buf[old_p]);
+    const char *char_p = reinterpret_cast<const char *>(GetData () + old_p);
     extract_p += strlen (char_p) + 1;
     return char_p;
   }
 
+  /** Returns count of bytes that were not extracted yet. */
+  int GetRemaining ()
+  { return (large ? large_size : size - GetHeaderSize ()) - extract_p; }
+
   /** Finds out the header size of the message. */
   static int GetHeaderSize ()
   { return 4 * sizeof (T_BYTE); /* size, type, subtype, dest */ }
 
-  /** Returns pointer to start of the header. */
-  const char *GetHeaderStart () { return (const char *)&size; }
+  /** Finds out the header size of the frame, which starts with size byte
+   *  @p marker. */
+  static int GetFrameHeaderSize (T_BYTE marker)
+  {
+    if (marker == net_frame_16) return GetHeaderSize () + 2;
+    if (marker == net_frame_32) return GetHeaderSize () + 4;
+    return GetHeaderSize ();
+  }
+
+  static int GetFrameSize (const T_BYTE *header);
+
+  const char *GetHeaderStart ();
 
   in_addr GetAddress () { return address; }
   in_port_t GetPort ()  { return port; }
@@ -252,6 +375,17 @@ private:
   int fd;
 
   int extract_p;
+
+  T_BYTE *large;        //!< Buffer of large message or @c NULL. Data start after #net_large_header_size bytes.
+  int large_size;       //!< Size of data of large message without headers.
+  int large_capacity;   //!< Capacity of #large buffer.
+
+  /** Returns pointer to data of the message. */
+  T_BYTE *GetData ()
+  { return large ? large + net_large_header_size : buf; }
+
+  void PackLarge (const void *data, int size);
+  void ReleaseLarge ();
 };
 
 
@@ -275,10 +409,15 @@ public:
   ~TNET_MESSAGE_QUEUE ();
 
   TNET_MESSAGE *GetMessage ();
+  TNET_MESSAGE *PollMessage (double timeout);
   void PutMessage (TNET_MESSAGE *message);
 
   void Die ();
 
+  /** Finds out, if the queue is dead. */
+  bool IsDead ()
+  { return dead; }
+
 private:
 #ifdef NEW_GLFW3
 	mtx_t mutex;
@@ -326,6 +465,26 @@ public:
     TNET_LISTENER *self;
   };
 
+  /** Connection handled by the reactor. */
+  struct CONNECTION {
+    CONNECTION (int fd, sockaddr_in address) {
+      this->fd = fd;
+      this->address = address;
+      size = 0;
+      large = NULL;
+    }
+
+    int fd;
+    sockaddr_in address;
+    int size;                                 //!< Size of data in the buffer.
+    T_BYTE buf[net_reactor_buffer_size];      //!< Received data which are not processed yet.
+
+    TNET_MESSAGE *large;    //!< Large message which is being received or @c NULL.
+    T_BYTE *large_data;     //!< Data of the large message.
+    int large_pos;          //!< Count of received bytes of the large message data.
+    int large_size;         //!< Size of the large message data.
+  };
+
   TNET_LISTENER (int queue_size, in_port_t port);
   ~TNET_LISTENER ();
 
@@ -353,6 +512,12 @@ private:
   static void GLFWCALL listener_thread_function (void *listener_class);
   static void GLFWCALL listener_accept (void *d);
 
+  void RunReactor ();
+  CONNECTION *AcceptConnection ();
+  bool ReadConnection (CONNECTION *connection);
+  void CloseConnection (CONNECTION *connection);
+  bool IsReactorStopped ();
+
 #ifdef NEW_GLFW3
 	mtx_t mutex;
 	thrd_t thread;
@@ -360,7 +525,13 @@ private:
 #else
 	GLFWthread thread;    //!< Thread id for listener's thread.
   	GLFWthread consumer_thread;
+  GLFWmutex mutex;      //!< Mutex for connections added to the reactor.
 #endif
+
+  bool reactor;         //!< Whether all connections are handled by one reactor thread.
+  volatile bool reactor_stop;   //!< Reactor should finish. Guarded by #mutex.
+  int reactor_wake[2];  //!< Pipe which wakes the reactor waiting for network events.
+  std::vector<CONNECTION *> reactor_pending;  //!< Connections added by other threads, not registered by the reactor yet.
   
 
   std::vector<int> subthread_fd;
@@ -386,6 +557,40 @@ private:
 // TNET_TALKER
 //=========================================================================
 
+/**
+ *  Data held back by simulated network until time of their delivery.
+ */
+struct TNET_DELAYED {
+  int fd;                     //!< File descriptor of the remote side.
+  double due;                 //!< Time when the data are sent. [seconds]
+  std::vector<T_BYTE> data;   //!< Joined messages.
+};
+
+
+/**
+ *  Messages joined to be sent to one remote side by one call of writev().
+ *  Messages are not copied into the batch, they are stored only once in the
+ *  shared buffer of the talker, even if they are sent to more remote sides.
+ */
+struct TNET_BATCH {
+  int fd;                     //!< File descriptor of the remote side.
+  in_addr address;            //!< Address of the remote side.
+  in_port_t port;             //!< Port of the remote side.
+  int size;                   //!< Size of messages in the batch.
+  std::vector<int> offsets;   //!< Offsets of messages in the shared buffer.
+  std::vector<int> sizes;     //!< Sizes of messages in the shared buffer.
+
+  double link_free;             //!< Time when simulated link is free for next data. [seconds]
+  double last_due;              //!< Time of delivery of the last data on simulated network. [seconds]
+
+  unsigned long sent_messages;  //!< Count of messages sent to the remote side.
+  unsigned long sent_bytes;     //!< Count of bytes sent to the remote side.
+  int queue_depth;              //!< Size of data in the system send queue after the last send or -1 if unknown. [bytes]
+  int max_queue_depth;          //!< Maximum of #queue_depth. [bytes]
+  double send_time;             //!< Time spent by sending to the remote side. [seconds]
+};
+
+
 /**
  *  Class for talker, which is a thread waiting for new messages in outgoing
  *  message queue, packing them into packets and sending them through network
@@ -426,6 +631,24 @@ private:
 
   static void GLFWCALL talker_thread_function (void *talker_class);
 
+  void AddToBatches (std::vector<TNET_BATCH> &batches, TNET_MESSAGE *msg);
+  void AddToBatch (std::vector<TNET_BATCH> &batches, TNET_ADDRESS *address, int offset, int size);
+  void SendBatch (TNET_BATCH &batch);
+  void DisconnectFileDescriptor (int fd);
+  void LogBatches (std::vector<TNET_BATCH> &batches);
+  void DelayBatch (TNET_BATCH &batch);
+  void SendDelayed ();
+  bool SendData (int fd, const T_BYTE *data, int size);
+
+  std::vector<TNET_DELAYED> delayed;  //!< Data held back by simulated network.
+  unsigned int random_seed;           //!< Seed of random numbers for simulated network.
+
+  std::vector<T_BYTE> send_buffer;  //!< Messages collected for all batches, each of them stored once.
+
+  unsigned long sent_messages;  //!< Count of sent messages.
+  unsigned long sent_batches;   //!< Count of sent batches of messages.
+  unsigned long send_calls;     //!< Count of calls of send().
+
 #ifdef NEW_GLFW3
 	thrd_t thread;
 #else
@@ -552,6 +775,7 @@ bool init_sockets (void);
 void end_sockets (void);
 
 extern TPOOL<TNET_MESSAGE> * pool_net_messages;
+extern TNET_LARGE_POOL * pool_net_large_buffers;
 #endif
 
 //=========================================================================
@@ -54,153 +54,6 @@ TPLAYER *myself = NULL;      //!< Pointer to my instance of player structure.
 TPLAYER *hyper_player = NULL;       //!< Pointer to instance of hyper player structure.
 TPLAYER_ARRAY player_array; 
 
-//=========================================================================
-// class THASHTABLE_UNITS
-//=========================================================================
-
-//!< Constructor.
-THASHTABLE_UNITS::THASHTABLE_UNITS(void)
-{
-  for (int i = 0; i < PL_HASHTABLE_UNITS_SIZE; i++)
-    table[i] = NULL;
-}
-
-
-//!< Destructor.
-THASHTABLE_UNITS::~THASHTABLE_UNITS(void)
-{
-  THASH_UNIT * act = NULL, * bef = NULL;
-
-  for (int i = 0; i < PL_HASHTABLE_UNITS_SIZE; i++)
-    if(table[i]){
-      for (bef = table[i], act = bef->next; act != NULL; act = act->next){
-         delete bef;
-         bef = act;
-      }
-      delete bef;
-      table[i] = NULL;
-    }
-}
-
-
-/** 
- *  Add new hash unit to table (if unit is not in table).
- *
- *  @param a_unit_id unique identificator of unit.
- *  @param a_player_unit pointer to added unit.
- *
- *  @sa TPLAYER_UNIT, THASH_UNIT
- */
-void THASHTABLE_UNITS::AddToHashTable(int a_unit_id, TPLAYER_UNIT * a_player_unit)
-{
-  int hash_index;
-  THASH_UNIT * act = NULL, * bef = NULL, * new_unit;
-
-  hash_index = HashFunction(a_unit_id);
-
-  // finds correct place to add new THASH_UNIT
-  for ( act = bef = table[hash_index]; ((act != NULL) && (act->unit_id < a_unit_id)); bef = act, act = act->next );
-
-  // if unit with identificator exists in table, return
-  if ((act) && (act->unit_id == a_unit_id)) return;
-
-  // create new THASH_UNIT and add it to list
-  new_unit = NEW THASH_UNIT(a_unit_id, a_player_unit); 
-
-  #if DEBUG_HASHTABLE_UNITS
-    Debug(LogMsg("ADDED UID1:%d UID2:%d PID:%d", a_unit_id, a_player_unit->GetUnitID(), a_player_unit->GetPlayerID()));
-  #endif
-  
-  new_unit->next = act;
-  
-  // if exists any THASH_UNIT in list
-  if (bef){
-    if (bef == act) //unit is first in list 
-      table[hash_index] = new_unit;
-    else
-      bef->next = new_unit;
-  }
-  else
-    table[hash_index] = new_unit;
-}
-
-/**
- *  Removes THASH_UNIT specified in @param r_player_unit by identificator of unit.
- *  @sa THASH_UNIT
- */
-void THASHTABLE_UNITS::RemoveFromHashTable(int r_unit_id)
-{
-  int hash_index;
-  THASH_UNIT * act = NULL, * bef = NULL;
-
-  hash_index = HashFunction(r_unit_id);
-  
-  // finds removed THASH_UNIT
-  for (act = bef = table[hash_index]; ((act != NULL) && (act->unit_id < r_unit_id)); bef = act, act = act->next );
-
-  // test unit
-  if (act){
-    if (act->unit_id == r_unit_id){ // act will be deleted
-      if (act == bef){ // act id first in list
-        table[hash_index] = act->next;
-        delete act;
-      }
-      else{ // act is not first in list
-        bef->next = act->next;
-        delete act;
-      }
-    }
-  }
-  
-  #if DEBUG_HASHTABLE_UNITS
-    Debug(LogMsg("REMOVED UID:%d PID:??", r_unit_id));
-  #endif
-}
-
-/**
- *  Returns pointer to unit specifird in @param g_unit_id.
- *
- *  If unit with identificator @param g_unit_id does not exists, returns NULL.
- *  @sa TPLAYER_UNIT
- */
-TPLAYER_UNIT * THASHTABLE_UNITS::GetUnitPointer(int g_unit_id)
-{
-  int hash_index;
-  THASH_UNIT * act = NULL, * bef = NULL;
-
-  hash_index = HashFunction(g_unit_id);
-
-  // finds THASH_UNIT
-  for ( act = bef = table[hash_index]; ((act != NULL) && (act->unit_id < g_unit_id)); bef = act, act = act->next );
-
-  // test unit
-  if ((act) && (act->unit_id == g_unit_id)){
-    return act->player_unit;
-  }
-  
-  #if DEBUG_EVENTS || DEBUG_HASHTABLE_UNITS
-    Warning(LogMsg("Does not exist unit with requested unit_id: U:%d", g_unit_id));
-  #endif
-
-  // in case that unit with requested id doesn't exists return NULL
-  return NULL;
-}
-
-/**
- *  Returns identificator of unit specifird in @param g_player_unit.
- *
- *  If unit does not exists, returns 0.
- *  @sa TPLAYER_UNIT
- */
-int THASHTABLE_UNITS::GetUnitID(TPLAYER_UNIT * g_player_unit)
-{
-  if (g_player_unit){
-    return g_player_unit->GetUnitID();
-  }
-  else return 0;
-}
-
-
 //=========================================================================
 // struct TPLAYER
 //=========================================================================
@@ -221,6 +74,8 @@ TPLAYER::TPLAYER()
   player_units_counter = 0;
 
   units = NULL;
+  awake_units = NULL;
+  graphics_time = 0;
 
   energy_in = energy_out = 0;
   food_in = food_out = 0;
@@ -245,6 +100,10 @@ TPLAYER::TPLAYER()
   if ((mutex = glfwCreateMutex ()) == NULL) {
     Critical ("Could not create player mutex");
   }
+
+  if ((awake_mutex = glfwCreateMutex ()) == NULL) {
+    Critical ("Could not create player mutex");
+  }
 }
 
 
@@ -263,6 +122,7 @@ TPLAYER::~TPLAYER(void)
   for (int i = 0; i < SCH_MAX_MATERIALS_COUNT + 2; i++)
     if (need_animation[i]) delete need_animation[i];
 
+  glfwDestroyMutex(awake_mutex);
   glfwDestroyMutex(mutex);
 }
 
@@ -282,6 +142,12 @@ void TPLAYER::AddUnit(TPLAYER_UNIT *punit)
 
   units = punit;
 
+  // new unit is awake
+  glfwLockMutex(awake_mutex);
+  punit->listed = true;
+  glfwUnlockMutex(awake_mutex);
+
+  WakeUnit(punit);
 
   glfwUnlockMutex(mutex);
 }
@@ -299,6 +165,71 @@ void TPLAYER::DeleteUnit(TPLAYER_UNIT *punit)
   if (punit->GetNext()) punit->GetNext()->SetPrev(punit->GetPrev());
   if (punit->GetPrev()) punit->GetPrev()->SetNext(punit->GetNext());
 
+  glfwLockMutex(awake_mutex);
+
+  if (punit->awake) RemoveAwakeUnit(punit);
+  punit->listed = false;
+
+  glfwUnlockMutex(awake_mutex);
+
+  glfwUnlockMutex(mutex);
+}
+
+
+/**
+ *  Marks unit as changed and adds it into player's list of awake units.
+ *  Graphics of awake units is updated in every frame, unit falls asleep
+ *  again, when it is out of active area and it does not change.
+ *  It may be called from any thread.
+ */
+void TPLAYER::WakeUnit(TPLAYER_UNIT *punit)
+{
+  glfwLockMutex(awake_mutex);
+
+  // units not (or no more) in the list of units are not updated
+  if (punit->listed) {
+    punit->changed = true;
+
+    if (!punit->awake) {
+      punit->prev_awake = NULL;
+      punit->next_awake = awake_units;
+      if (awake_units) awake_units->prev_awake = punit;
+      awake_units = punit;
+      punit->awake = true;
+    }
+  }
+
+  glfwUnlockMutex(awake_mutex);
+}
+
+
+/**
+ *  Removes unit from player's list of awake units. Mutex #awake_mutex must
+ *  be locked.
+ */
+void TPLAYER::RemoveAwakeUnit(TPLAYER_UNIT *punit)
+{
+  if (punit == awake_units) awake_units = punit->next_awake;
+  if (punit->next_awake) punit->next_awake->prev_awake = punit->prev_awake;
+  if (punit->prev_awake) punit->prev_awake->next_awake = punit->next_awake;
+
+  punit->next_awake = punit->prev_awake = NULL;
+  punit->awake = false;
+}
+
+
+/**
+ *  Wakes all units of the player. It is used after active area is changed.
+ */
+void TPLAYER::WakeAllUnits(void)
+{
+  TPLAYER_UNIT *unit = NULL;
+
+  glfwLockMutex(mutex);
+
+  for (unit = units; unit; unit = unit->GetNext())
+    WakeUnit(unit);
+
   glfwUnlockMutex(mutex);
 }
 
@@ -317,6 +248,45 @@ void TPLAYER::Disconnect(void)
 }
 
 
+/**
+ *  Appends units of player folded into the region of hash of the world.
+ *
+ *  @param region        Index of region.
+ *  @param region_units  Vector to which units are appended.
+ */
+void TPLAYER::GetRegionUnits(int region, std::vector<TPLAYER_UNIT *> &region_units)
+{
+  TPLAYER_UNIT *unit = NULL;
+
+  glfwLockMutex(mutex);
+
+  for (unit = units; unit; unit = unit->GetNext()) {
+    if (unit->GetWorldRegion() == region)
+      region_units.push_back(unit);
+  }
+
+  glfwUnlockMutex(mutex);
+}
+
+
+/**
+ *  Appends all units of player.
+ *
+ *  @param player_units  Vector to which units are appended.
+ */
+void TPLAYER::GetUnits(std::vector<TPLAYER_UNIT *> &player_units)
+{
+  TPLAYER_UNIT *unit = NULL;
+
+  glfwLockMutex(mutex);
+
+  for (unit = units; unit; unit = unit->GetNext())
+    player_units.push_back(unit);
+
+  glfwUnlockMutex(mutex);
+}
+
+
 void TPLAYER::UpdateGraphics(double time_shift)
 {
   TPLAYER_UNIT *unit = NULL;
@@ -325,19 +295,58 @@ void TPLAYER::UpdateGraphics(double time_shift)
 
   list<TMAP_UNIT *> ghost_list;
   list<TMAP_UNIT *>::const_iterator iter;
+  std::vector<TPLAYER_UNIT *>::const_iterator uiter;
+
+  graphics_time += time_shift;
 
   glfwLockMutex(delete_mutex);
   glfwLockMutex(mutex);
 
-  // units
-  for (unit = units; unit; unit = unit->GetNext()) 
+  // only awake units are updated
+  glfwLockMutex(awake_mutex);
+
+  for (unit = awake_units; unit; unit = unit->next_awake) {
+    unit->changed = false;
+    updated_units.push_back(unit);
+  }
+
+  glfwUnlockMutex(awake_mutex);
+
+  for (uiter = updated_units.begin(); uiter != updated_units.end(); uiter++)
   {
+    unit = *uiter;
+
+    // unit was asleep out of active area, its animations have to be shifted
+    if (unit->sleep_time >= 0) {
+      unit->anim_shift += graphics_time - time_shift - unit->sleep_time;
+      unit->sleep_time = -1;
+    }
+
     if (unit->UpdateGraphics(time_shift)) {
       ghost = ((TMAP_UNIT *)unit)->AcquirePointer();
       if (ghost) ghost_list.push_back(ghost);
     }
+
+    unit->UpdateRadar();
   }
 
+  // units out of active area, which were not changed meanwhile, fall asleep
+  glfwLockMutex(awake_mutex);
+
+  for (uiter = updated_units.begin(); uiter != updated_units.end(); uiter++)
+  {
+    unit = *uiter;
+
+    if (!unit->awake || unit->changed || unit->IsInActiveArea() || unit->IsBusy()) continue;
+
+    RemoveAwakeUnit(unit);
+    unit->sleep_time = graphics_time;
+  }
+
+  glfwUnlockMutex(awake_mutex);
+
+  updated_units.clear();
+
   glfwUnlockMutex(mutex);
   glfwUnlockMutex(delete_mutex);
 
@@ -865,7 +874,7 @@ bool TLOC_MAP::IsNextPositionEmpty(const TPOSITION_3D pos, const int dir, TFORCE
     for (i = pos.x; i < pos.x + size; i++)    //vsechny nove obsazovane policka musime otestovat na nepritomnost jednotek
       for (j = pos.y; j < pos.y + size; j++)
         if ((! ::map.IsInMap(i,j,pos.segment)) 
-          || ((map[pos.segment][i][j].player_id != WLK_EMPTY_FIELD) && (::map.segments[pos.segment].surface[i][j].unit != unit)))
+          || ((map[pos.segment][i][j].player_id != WLK_EMPTY_FIELD) && (::map.segments[pos.segment].surface.GetUnit(i, j) != unit)))
           return false;
   }
   else                                        //move in same segment
@@ -34,8 +34,6 @@
 // Forward declarations
 //=========================================================================
 
-class THASH_UNIT;
-class THASHTABLE_UNITS;
 class TLOC_MAP;
 class TPLAYER;
 class TCOMPUTER_PLAYER;
@@ -49,7 +47,6 @@ class TCOMPUTER_PLAYER;
 #define PL_MAX_SELECTIONS   9
 /** Maximum count of players including hyper player. */
 #define PL_MAX_PLAYERS      8
-#define PL_HASHTABLE_UNITS_SIZE  100
 #define PL_MAX_START_POINTS  32
 
 // area visibility
@@ -76,7 +73,9 @@ class TCOMPUTER_PLAYER;
 #include "doalloc.h"
 
 #include <string>
+#include <vector>
 
+#include "dohashunits.h"
 #include "doipc.h"
 #include "donet.h"
 #include "dowalk.h"
@@ -86,39 +85,6 @@ class TCOMPUTER_PLAYER;
 //=========================================================================
 
 
-/** Node of hash unit. Contians unique identificator of unit and pointer to unit. */
-class THASH_UNIT{
-public:  
-  int unit_id;                  //!< Unique identificator of unit.
-  TPLAYER_UNIT * player_unit;   //!< Pointer to unit.
-  THASH_UNIT * next;            //!< Pointer to next THASH_UNIT for one hash value.
-
-  THASH_UNIT(void) {unit_id = 0; player_unit = NULL; next = NULL;}; //!< Constructor. Only zeroize data.
-  THASH_UNIT(int a_unit_id, TPLAYER_UNIT * a_player_unit) {unit_id = a_unit_id; player_unit = a_player_unit; next = NULL;}; //!< Constructor. Fill data.
-};
-
-/**
- *  Hashtable for quick translation between unit identificator and pointer to unit.
- */
-
-class THASHTABLE_UNITS {
-private:
-  THASH_UNIT * table[PL_HASHTABLE_UNITS_SIZE]; //!< Array of pointers to hash nodes.
-
-  int HashFunction(int h_unit_id) { return ((abs(h_unit_id)) % PL_HASHTABLE_UNITS_SIZE);}; //!< hash function.
-
-public: 
-  TPLAYER_UNIT * GetUnitPointer(int g_unit_id);   // Returns pointer to unit identified by unit_id.
-  int GetUnitID(TPLAYER_UNIT * g_player_unit);    // Returns identificator of unit identified by pointer.
-
-  void AddToHashTable(int a_unit_id, TPLAYER_UNIT * a_player_unit); // Add new hash unit to table.
-  void RemoveFromHashTable(int r_unit_id);                          // Remove hash unit from table.
-
-  THASHTABLE_UNITS(void);   // Constructor.
-  ~THASHTABLE_UNITS(void);  // Destructor.
-};
-
-
 /**
  *  Local map for each player. Contains information about actual state of map
  *  fields in all segments.
@@ -222,9 +188,13 @@ public:
 
   void AddUnit(TPLAYER_UNIT *punit);
   void DeleteUnit(TPLAYER_UNIT *punit);
+  void WakeUnit(TPLAYER_UNIT *punit);
+  void WakeAllUnits(void);
 
   void UpdateGraphics(double time_shift);
   void Disconnect(void);
+  void GetRegionUnits(int region, std::vector<TPLAYER_UNIT *> &region_units);
+  void GetUnits(std::vector<TPLAYER_UNIT *> &player_units);
   
   //!< Increments global units counter of player.
   int IncrementGlobalUnitCounter(){global_unit_counter++; return global_unit_counter;};
@@ -291,6 +261,8 @@ public:
   void DecPlayerUnitsCount();
 
 private:
+  void RemoveAwakeUnit(TPLAYER_UNIT *punit);
+
   T_BYTE player_id;                      //!< Identificator of player.
   
   TLOC_MAP local_map;                    //!< Local map. It includes information: here is warfog, unknown area, known area, etc.
@@ -316,6 +288,16 @@ private:
 #else
 	GLFWmutex mutex;                        //!< Mutex for locking list of units.
 #endif
+
+  TPLAYER_UNIT *awake_units;             //!< List of units, which graphics is updated in every frame.
+  std::vector<TPLAYER_UNIT *> updated_units;  //!< Awake units updated in the current frame.
+  double graphics_time;                  //!< Sum of time shifts of all updates of graphics. [seconds]
+
+#ifdef NEW_GLFW3
+  mtx_t awake_mutex;
+#else
+  GLFWmutex awake_mutex;                 //!< Mutex for locking list of awake units. It is locked after #mutex.
+#endif
   
 };
 
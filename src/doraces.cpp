@@ -46,6 +46,7 @@
 #include "doschemes.h"
 #include "dofight.h"
 #include "domap.h"
+#include "doplayers.h"
 
 
 //=========================================================================
@@ -280,17 +281,18 @@ TFORCE_ITEM::TFORCE_ITEM()
 bool TFORCE_ITEM::IsPositionAvailable(int pos_x, int pos_y, int seg)
 {
   int i,j;
-  TMAP_SURFACE *field = NULL;
+  TMAP_SURFACE *surface = &::map.segments[seg].surface;
+  TTERRAIN_ID t_id;
 
   for (i = pos_x; i < pos_x + GetWidth(); i++)
   {
     for (j = pos_y; j < pos_y + GetHeight(); j++)
     {
       if (!::map.IsInMap(i,j)) return false;   //test, whether the position is in map
-      field = &(::map.segments[seg].surface[i][j]);
-      if (field->unit) return false; //test, whether there's any unit standing at the position
+      if (surface->GetUnit(i, j)) return false; //test, whether there's any unit standing at the position
       
-      if (!moveable[seg].IsMember(field->t_id) && !landable[seg].IsMember(field->t_id)) return false; //test whether unit can move or land there
+      t_id = surface->GetTerrainId(i, j);
+      if (!moveable[seg].IsMember(t_id) && !landable[seg].IsMember(t_id)) return false; //test whether unit can move or land there
     }
   }
 
@@ -344,7 +346,7 @@ unsigned char TFORCE_ITEM::TestPositionFeatures(T_SIMPLE tx, T_SIMPLE ty, T_SIMP
     for (j = ty; j < ty + GetHeight(); j++)
     {
       //test how is field available
-      act_field_tid = ::map.segments[ts].surface[i][j].t_id;
+      act_field_tid = ::map.segments[ts].surface.GetTerrainId(i, j);
       if (! moveable[ts].IsMember(act_field_tid))   //position isn't moveable
         result &= (!RAC_MOVEABLE_POSITION);
       else if (! landable[ts].IsMember(act_field_tid))  //position isn't landable
@@ -415,8 +417,8 @@ bool TSOURCE_ITEM::IsPositionAvailable(int pos_x, int pos_y)
       if (map.IsInMap(x, y)) {
         for (seg = GetExistSegments().min; seg <= GetExistSegments().max; seg++) 
         {
-          tid = map.segments[seg].surface[x][y].t_id;
-          u = map.segments[seg].surface[x][y].unit;
+          tid = map.segments[seg].surface.GetTerrainId(x, y);
+          u = map.segments[seg].surface.GetUnit(x, y);
 
           if (!(buildable[seg].IsMember(tid) && !u)) return false;
         }
@@ -554,13 +556,13 @@ bool TBUILDING_ITEM::IsPositionAvailable(int pos_x, int pos_y, bool test_ancesto
         for (seg = GetExistSegments().min; seg <= GetExistSegments().max; seg++) 
         {
           if (ancestor && test_ancestor){
-            u = map.segments[seg].surface[x][y].unit;
+            u = map.segments[seg].surface.GetUnit(x, y);
             if ((!u) || (u && (u->GetPointerToItem() != ancestor)))
               return false;
           }
           else {
-            tid = map.segments[seg].surface[x][y].t_id;
-            u = map.segments[seg].surface[x][y].unit;
+            tid = map.segments[seg].surface.GetTerrainId(x, y);
+            u = map.segments[seg].surface.GetUnit(x, y);
 
             if (!(buildable[seg].IsMember(tid) && !u)) return false;
           }
@@ -1265,12 +1267,12 @@ bool LoadRacUnit(TCONF_FILE *cf, int id, bool first)
       cf->ReadFloat(&actual->units[id]->burning_y, const_cast<char*>("burning_position"), 20);
     
       // read exist, visible, build and land segments
-      cf->ReadByteRange(&actual->units[id]->GetExistSegments().min, const_cast<char*>("min_exist_segment_id"), 0, DAT_SEGMENTS_COUNT - 1, 0);
-      cf->ReadByteRange(&actual->units[id]->GetExistSegments().max, const_cast<char*>("max_exist_segment_id"), actual->units[id]->GetExistSegments().min, DAT_SEGMENTS_COUNT-1, actual->units[id]->GetExistSegments().min);
+      cf->ReadSimpleRange(&actual->units[id]->GetExistSegments().min, const_cast<char*>("min_exist_segment_id"), 0, DAT_SEGMENTS_COUNT - 1, 0);
+      cf->ReadSimpleRange(&actual->units[id]->GetExistSegments().max, const_cast<char*>("max_exist_segment_id"), actual->units[id]->GetExistSegments().min, DAT_SEGMENTS_COUNT-1, actual->units[id]->GetExistSegments().min);
       
       for (i = 0; i < DAT_SEGMENTS_COUNT; i++){
-        cf->ReadByteRange(&actual->units[id]->visible_segments[i].min, const_cast<char*>("min_max_visible_segment_id"), 0, DAT_SEGMENTS_COUNT - 1, i);
-        cf->ReadByteRange(&actual->units[id]->visible_segments[i].max, const_cast<char*>("min_max_visible_segment_id"), actual->units[id]->visible_segments[i].min, DAT_SEGMENTS_COUNT-1, actual->units[id]->visible_segments[i].min);
+        cf->ReadSimpleRange(&actual->units[id]->visible_segments[i].min, const_cast<char*>("min_max_visible_segment_id"), 0, DAT_SEGMENTS_COUNT - 1, i);
+        cf->ReadSimpleRange(&actual->units[id]->visible_segments[i].max, const_cast<char*>("min_max_visible_segment_id"), actual->units[id]->visible_segments[i].min, DAT_SEGMENTS_COUNT-1, actual->units[id]->visible_segments[i].min);
       }
       
       cf->ReadByteRange(&actual->units[id]->land_segment, const_cast<char*>("land_segment_id"), 0, DAT_SEGMENTS_COUNT - 1, 0);
@@ -1324,9 +1326,9 @@ bool LoadRacUnit(TCONF_FILE *cf, int id, bool first)
         actual->units[id]->GetArmament()->GetOffensive()->SetFeedTime(fval);
 
         // read range of segments where gun can fire
-        cf->ReadByteRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), 0, DAT_SEGMENTS_COUNT - 1, 0);
+        cf->ReadSimpleRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), 0, DAT_SEGMENTS_COUNT - 1, 0);
         actual->units[id]->GetArmament()->GetOffensive()->SetBottomShotableLimit(sval);
-        cf->ReadByteRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), actual->units[id]->GetArmament()->GetOffensive()->GetShotableSegments().min, DAT_SEGMENTS_COUNT - 1, actual->units[id]->GetArmament()->GetOffensive()->GetShotableSegments().min);
+        cf->ReadSimpleRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), actual->units[id]->GetArmament()->GetOffensive()->GetShotableSegments().min, DAT_SEGMENTS_COUNT - 1, actual->units[id]->GetArmament()->GetOffensive()->GetShotableSegments().min);
         actual->units[id]->GetArmament()->GetOffensive()->SetUpperShotableLimit(sval);
 
         // read min and max guns power
@@ -1786,14 +1788,14 @@ bool LoadRacBuilding(TCONF_FILE *cf, int id, bool first)
       cf->ReadFloat(&actual->buildings[id]->burning_y, const_cast<char*>("burning_position"), 20);
     
       // read exist, visible, build and land segments
-      cf->ReadByteRange(&actual->buildings[id]->GetExistSegments().min, const_cast<char*>("exist_segment_id"), 0, DAT_SEGMENTS_COUNT-1, 0);
+      cf->ReadSimpleRange(&actual->buildings[id]->GetExistSegments().min, const_cast<char*>("exist_segment_id"), 0, DAT_SEGMENTS_COUNT-1, 0);
       actual->buildings[id]->GetExistSegments().max = actual->buildings[id]->GetExistSegments().min;
       
       // read vivible segments
       for (i = 0; i < DAT_SEGMENTS_COUNT; i++){
         if (i == actual->buildings[id]->GetExistSegments().max) {
-          cf->ReadByteRange(&actual->buildings[id]->visible_segments[i].min, const_cast<char*>("min_max_visible_segment_id"), 0, DAT_SEGMENTS_COUNT-1, i);
-          cf->ReadByteRange(&actual->buildings[id]->visible_segments[i].max, const_cast<char*>("min_max_visible_segment_id"), actual->buildings[id]->visible_segments[i].min, DAT_SEGMENTS_COUNT-1, actual->buildings[id]->visible_segments[i].min);
+          cf->ReadSimpleRange(&actual->buildings[id]->visible_segments[i].min, const_cast<char*>("min_max_visible_segment_id"), 0, DAT_SEGMENTS_COUNT-1, i);
+          cf->ReadSimpleRange(&actual->buildings[id]->visible_segments[i].max, const_cast<char*>("min_max_visible_segment_id"), actual->buildings[id]->visible_segments[i].min, DAT_SEGMENTS_COUNT-1, actual->buildings[id]->visible_segments[i].min);
         }
         else
           actual->buildings[id]->visible_segments[i].min = actual->buildings[id]->visible_segments[i].max = 0;
@@ -1860,9 +1862,9 @@ bool LoadRacBuilding(TCONF_FILE *cf, int id, bool first)
         actual->buildings[id]->GetArmament()->GetOffensive()->SetFeedTime(fval);
 
         // read range of segments where gun can fire
-        cf->ReadByteRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), 0, DAT_SEGMENTS_COUNT - 1, 0);
+        cf->ReadSimpleRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), 0, DAT_SEGMENTS_COUNT - 1, 0);
         actual->buildings[id]->GetArmament()->GetOffensive()->SetBottomShotableLimit(sval);
-        ok = cf->ReadByteRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), actual->buildings[id]->GetArmament()->GetOffensive()->GetShotableSegments().min, DAT_SEGMENTS_COUNT - 1, actual->buildings[id]->GetArmament()->GetOffensive()->GetShotableSegments().min);
+        ok = cf->ReadSimpleRange(&sval, const_cast<char*>("offensive_shotable_seg_min_max"), actual->buildings[id]->GetArmament()->GetOffensive()->GetShotableSegments().min, DAT_SEGMENTS_COUNT - 1, actual->buildings[id]->GetArmament()->GetOffensive()->GetShotableSegments().min);
         actual->buildings[id]->GetArmament()->GetOffensive()->SetUpperShotableLimit(sval);
 
         // read min and max guns power
@@ -2139,7 +2141,7 @@ bool LoadRacSource(TCONF_FILE *cf, int id, bool first)
       actual->sources[id]->SetMaxHidedUnits(btval);
       
       // read exist segments
-      cf->ReadByteRange(&actual->sources[id]->GetExistSegments().min, const_cast<char*>("exist_segment_id"), 0, DAT_SEGMENTS_COUNT-1, 0);
+      cf->ReadSimpleRange(&actual->sources[id]->GetExistSegments().min, const_cast<char*>("exist_segment_id"), 0, DAT_SEGMENTS_COUNT-1, 0);
       actual->sources[id]->GetExistSegments().max = actual->sources[id]->GetExistSegments().min;
 
       // read build terrain ids
@@ -2325,6 +2327,24 @@ void DeleteRaces(void)
   scheme.race = NULL;
 }
 
+
+/**
+ *  Loads images of one group of textures of races of players in the game,
+ *  which was not drawn yet. It is called in spare time of frames, so textures
+ *  of units are usually ready before the units are drawn for the first time.
+ *
+ *  @param time_left  Time left to the end of the frame. [seconds]
+ *
+ *  @return @c true if some group was loaded.
+ */
+bool PrefetchRacesTextures(double time_left)
+{
+  for (int i = 0; i < player_array.GetCount(); i++)
+    if (players[i]->race && players[i]->race->tex_table.LoadNextGroup(time_left)) return true;
+
+  return false;
+}
+
 /**
  *  Create one instance of TRACE and fill it with default values.
  */
@@ -2383,7 +2403,8 @@ bool LoadRace(char *file_name, bool hyper_player)
   if (hyper_player) sprintf(racname, "%s%s.dat", SCH_PATH, file_name);
   else sprintf(racname, "%s%s/%s.dat", RAC_PATH, file_name, file_name);
 
-  if (!actual->tex_table.Load(racname, config.tex_mag_filter, config.tex_min_filter))
+  // images of texture groups are loaded on first use
+  if (!actual->tex_table.Load(racname, config.tex_mag_filter, config.tex_min_filter, true, true))
     goto error;
 
 #if SOUND
@@ -2398,7 +2419,7 @@ bool LoadRace(char *file_name, bool hyper_player)
 
   Info(LogMsg("Loading race data from '%s'", racname));
 
-  if (!(cf = OpenConfFile(racname)))
+  if (!(cf = OpenConfFile(racname, true)))
     goto error;
 
   if (ok) {
@@ -1022,6 +1022,7 @@ extern TRACE  *races;             // races
 bool LoadRace(char *file_name, bool hyper_player);
 bool LoadRaces(void);
 void DeleteRaces(void);
+bool PrefetchRacesTextures(double time_left);
 int GetItemPrgID(char * usr_id, TMAP_ITEM **table, int count);
 char GetSegmentID(int user_terrID, int to_where);
 bool IsValidForceItem(TFORCE_ITEM* item);           //!< Tests whether it is valid pointer to force item of any race.
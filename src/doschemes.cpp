@@ -507,6 +507,51 @@ bool LoadSchFragments(TCONF_FILE *cf, int sid)
 }
 
 
+/**
+ *  Sets radar colours of terrain types, which have no colour in scheme file.
+ *  The colour is the average colour of fragments textures weighted by count
+ *  of mapels with the terrain type.
+ */
+void SetSchRadarColors(int sid)
+{
+  int count = scheme.terrain_segments[sid].max_terrain_id;
+  unsigned long *sum;
+  TTERRF_ITEM *fragment;
+  TGUI_TEXTURE *tex;
+  TTERRAIN_ID t;
+  int f, a, i, j, c;
+
+  if (!count) return;
+
+  sum = NEW unsigned long[count * 4];
+  memset(sum, 0, count * 4 * sizeof(unsigned long));
+
+  for (f = 0; f < scheme.terrf_count[sid]; f++) {
+    fragment = scheme.terrf[sid] + f;
+    if (!fragment->terrain_field) continue;
+
+    for (a = 0; a < fragment->GetAnimCount(); a++) {
+      if (!(tex = fragment->GetTexture(a))) continue;
+
+      for (i = 0; i < fragment->width; i++)
+        for (j = 0; j < fragment->height; j++) {
+          t = fragment->terrain_field[i][j];
+          if (t >= count) continue;
+
+          for (c = 0; c < 3; c++) sum[t * 4 + c] += tex->average_color[c];
+          sum[t * 4 + 3]++;
+        }
+    }
+  }
+
+  for (t = 0; t < count; t++)
+    if (!scheme.terrain_props[sid][t].has_radar_color && sum[t * 4 + 3])
+      for (c = 0; c < 3; c++) scheme.terrain_props[sid][t].radar_color[c] = (GLubyte)(sum[t * 4 + c] / sum[t * 4 + 3]);
+
+  delete[] sum;
+}
+
+
 //=========================================================================
 // Loading layers
 //=========================================================================
@@ -697,6 +742,15 @@ bool LoadSchTerrainType(TCONF_FILE *cf, int tid, int segment)
     cf->ReadIntGE(&scheme.terrain_props[segment][tid].layer, const_cast<char*>("layer"), 0, 0);
     cf->ReadFloatRange(&fval, const_cast<char*>("difficulty"), 0, 1, 0);
     scheme.terrain_props[segment][tid].difficulty = MIN (MAX (static_cast<unsigned int>(fval * 1000), 1), 999);
+
+    // optional radar colour, otherwise it is computed from fragments textures
+    scheme.terrain_props[segment][tid].has_radar_color = (cf->GetActSection()->GetItem(const_cast<char*>("radar_color"), false) != NULL);
+
+    for (int i = 0; i < 3; i++) {
+      if (scheme.terrain_props[segment][tid].has_radar_color)
+        cf->ReadByteRange(scheme.terrain_props[segment][tid].radar_color + i, const_cast<char*>("radar_color"), 0, 255, SCH_DEF_RADAR_COLOR);
+      else scheme.terrain_props[segment][tid].radar_color[i] = SCH_DEF_RADAR_COLOR;
+    }
   }
  
   cf->UnselectSection();
@@ -731,6 +785,7 @@ bool LoadSchSegment(TCONF_FILE *cf, int sid)
   
   if (ok) ok = CreateHashTable(sid);
   if (ok) ok = LoadSchFragments(cf, sid);
+  if (ok) SetSchRadarColors(sid);
   if (ok) ok = LoadSchLayers(cf, sid);
   if (ok) ok = LoadSchObjects(cf, sid);
   
@@ -787,7 +842,7 @@ bool LoadScheme(TSCHEME_NAME id_name)
 
   strcpy(scheme.id_name, id_name);
 
-  if (!(cf = OpenConfFile(schname))) return false;
+  if (!(cf = OpenConfFile(schname, true))) return false;
 
   if (ok) {
     cf->ReadStr(scheme.name, const_cast<char*>("name"), const_cast<char*>(""), true);
@@ -58,6 +58,8 @@ struct TSCHEME;
 #define SCH_MAX_MATERIALS_COUNT     4     //!< Maximum count kinds of material.
 #define SCH_MAX_MATERIAL_NAME       30    //!< Max. lenght of material name
 
+#define SCH_DEF_RADAR_COLOR         128   //!< Radar colour of terrain without any fragment texture.
+
 #define SchCriticalTable(scheme, table)    Critical(LogMsg("Can not allocate memory for '%s' %s table", scheme.name, table))
 
 //=========================================================================
@@ -92,6 +94,8 @@ struct TTERRAIN_PROPS {
   char name[SCH_ID_MAX_NAME_LENGTH];    //!< Segment name.
   int layer;                            //!< User defined high of terrain.
   unsigned int difficulty;              //!< Difficulty of walking on this terrain.
+  GLubyte radar_color[3];               //!< Colour of terrain in radar (RGB).
+  bool has_radar_color;                 //!< If radar colour is set in scheme file.
 };
 
 
@@ -112,6 +116,17 @@ public:
     if (animation) for (int i = 0; i < anim_count; i++) animation[i]->Update(time_shift);
   }
 
+  /** Returns whether the texture of animation @p anim_id has more frames. */
+  bool IsAnimated(int anim_id) {
+    return animation && anim_id >= 0 && animation[anim_id]->GetTexItem()
+      && animation[anim_id]->GetTexItem()->frames_count > 1;
+  }
+
+  /** Returns texture of animation @p anim_id. */
+  TGUI_TEXTURE *GetTexture(int anim_id) {
+    return (animation && anim_id >= 0 && anim_id < anim_count) ? animation[anim_id]->GetTexItem() : NULL;
+  }
+
   void SetTextures(TTEX_GROUP *group);
   void SetUsed(bool use) { used = use; }
   bool IsUsed() { return used; }
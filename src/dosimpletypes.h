@@ -59,10 +59,11 @@ typedef TTERRAIN_ID **TTERRAIN_FIELD;  //!< Terrain field type - 2D array of TTE
 
 /**
  *  Type used for map metrics (map size, unit size, positions in the map...).
+ *  It is wider than byte, so maps could be larger than 255 mapels.
  *
  *  @warning This type must always remain unsigned!
  */
-typedef T_BYTE T_SIMPLE;
+typedef unsigned short T_SIMPLE;
 
 
 //=========================================================================
@@ -72,7 +73,7 @@ typedef T_BYTE T_SIMPLE;
 /**
  *  Max value of T_SIMPLE type.
  */
-#define MAX_T_SIMPLE 255
+#define MAX_T_SIMPLE 65535
 
 
 /**
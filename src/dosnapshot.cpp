@@ -0,0 +1,441 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file dosnapshot.cpp
+ *
+ *  Binary snapshots of state of units.
+ *
+ *  @date 2026
+ */
+
+//=========================================================================
+// Included files
+//=========================================================================
+
+#include <string.h>
+#include <set>
+
+#ifdef NEW_GLFW3
+#include <glfw3.h>
+#else
+#include <glfw.h>
+#endif
+
+#include "dosnapshot.h"
+#include "dologs.h"
+#include "domap.h"
+#include "dounits.h"
+
+
+//=========================================================================
+// class TSNAPSHOT
+//=========================================================================
+
+/**
+ *  Clears data of the snapshot.
+ */
+void TSNAPSHOT::Clear(void)
+{
+  data.clear();
+  received.clear();
+  received_count = 0;
+  extract_p = 0;
+}
+
+
+/**
+ *  Appends data to the snapshot.
+ */
+void TSNAPSHOT::Pack(const void *src, int size)
+{
+  const T_BYTE *bytes = static_cast<const T_BYTE *>(src);
+
+  data.insert(data.end(), bytes, bytes + size);
+}
+
+
+/**
+ *  Extracts data from the snapshot.
+ *
+ *  @return @c false if the snapshot is shorter than expected.
+ */
+bool TSNAPSHOT::Extract(void *dest, int size)
+{
+  if (extract_p + size > GetSize()) return false;
+
+  memcpy(dest, &data[extract_p], size);
+  extract_p += size;
+
+  return true;
+}
+
+
+/**
+ *  Appends record of the unit to the snapshot.
+ */
+void TSNAPSHOT::PackUnit(TPLAYER_UNIT *unit)
+{
+  TMAP_UNIT *map_unit = static_cast<TMAP_UNIT *>(unit);
+  TPOSITION_3D pos = unit->GetPosition();
+  TSNAPSHOT_UNIT record;
+
+  memset(&record, 0, sizeof(record));
+
+  record.player_id = unit->GetPlayerID();
+  record.unit_id = unit->GetUnitID();
+  record.item_type = unit->GetItemType();
+  record.flags = map_unit->IsInMap() ? SNP_UNIT_IN_MAP : 0;
+  record.x = pos.x;
+  record.y = pos.y;
+  record.segment = pos.segment;
+  record.life = map_unit->GetLife();
+  record.state = unit->GetState();
+
+  switch (record.item_type) {
+  case IT_WORKER:
+    record.material = static_cast<TWORKER_UNIT *>(unit)->GetMaterial();
+    record.material_amount = static_cast<TWORKER_UNIT *>(unit)->GetMaterialAmount();
+    // no break, worker is force unit
+  case IT_FORCE:
+    record.direction = T_BYTE(static_cast<TFORCE_UNIT *>(unit)->GetMoveDirection());
+    break;
+  case IT_SOURCE:
+    record.material_balance = static_cast<TSOURCE_UNIT *>(unit)->GetMaterialBalance();
+    break;
+  }
+
+  // fields are packed one by one, so the format does not depend on padding
+  Pack(&record.player_id, sizeof(record.player_id));
+  Pack(&record.unit_id, sizeof(record.unit_id));
+  Pack(&record.item_type, sizeof(record.item_type));
+  Pack(&record.flags, sizeof(record.flags));
+  Pack(&record.x, sizeof(record.x));
+  Pack(&record.y, sizeof(record.y));
+  Pack(&record.segment, sizeof(record.segment));
+  Pack(&record.direction, sizeof(record.direction));
+  Pack(&record.life, sizeof(record.life));
+  Pack(&record.state, sizeof(record.state));
+  Pack(&record.material, sizeof(record.material));
+  Pack(&record.material_amount, sizeof(record.material_amount));
+  Pack(&record.material_balance, sizeof(record.material_balance));
+}
+
+
+/**
+ *  Captures players local on this computer and all their global units, which
+ *  are not ghosts.
+ *
+ *  @param capture_time  Time of the game, to which all events are processed.
+ *  @note process_mutex must be locked.
+ */
+void TSNAPSHOT::Capture(double capture_time)
+{
+  std::vector<TPLAYER_UNIT *> units;
+  double start_time = glfwGetTime();
+  unsigned magic = SNP_MAGIC;
+  int version = SNP_VERSION;
+  int count = 0, total = 0;
+  int i, j;
+  float stored;
+
+  Clear();
+
+  for (i = 0; i < player_array.GetCount(); i++)
+    if (!player_array.IsRemote(i)) count++;
+
+  Pack(&magic, sizeof(magic));
+  Pack(&version, sizeof(version));
+  Pack(&capture_time, sizeof(capture_time));
+  Pack(&count, sizeof(count));
+
+  for (i = 0; i < player_array.GetCount(); i++) {
+    if (player_array.IsRemote(i)) continue;
+
+    T_BYTE player_id = T_BYTE(i);
+    int counter = players[i]->GetGlobalUnitCounter();
+
+    Pack(&player_id, sizeof(player_id));
+    for (j = 0; j < SCH_MAX_MATERIALS_COUNT; j++) {
+      stored = players[i]->GetStoredMaterial(j);
+      Pack(&stored, sizeof(stored));
+    }
+    Pack(&counter, sizeof(counter));
+
+    // local units exist only on this computer
+    units.clear();
+    players[i]->GetUnits(units);
+
+    for (j = 0; j < int(units.size()); )
+      if (units[j]->GetUnitID() <= 0 || units[j]->IsGhost()) {
+        units[j] = units.back();
+        units.pop_back();
+      }
+      else j++;
+
+    count = int(units.size());
+    Pack(&count, sizeof(count));
+
+    for (j = 0; j < count; j++)
+      PackUnit(units[j]);
+
+    total += count;
+  }
+
+  Info(LogMsg("Snapshot of %d units captured in %.1f ms (%d bytes)", total, (glfwGetTime() - start_time) * 1000, GetSize()));
+}
+
+
+/**
+ *  Returns time of the game, when the snapshot was captured, or -1 if the
+ *  snapshot has unknown format.
+ */
+double TSNAPSHOT::GetTime(void)
+{
+  unsigned magic;
+  int version;
+  double capture_time;
+
+  extract_p = 0;
+
+  if (!Extract(&magic, sizeof(magic)) || magic != SNP_MAGIC
+    || !Extract(&version, sizeof(version)) || version != SNP_VERSION
+    || !Extract(&capture_time, sizeof(capture_time))
+  ) return -1;
+
+  return capture_time;
+}
+
+
+/**
+ *  Applies the record to the replica of the unit. Positions are restored only
+ *  for staying units, moving units are synchronised by their events. State
+ *  of the unit is not restored, because it is driven by events.
+ */
+void TSNAPSHOT::RestoreUnit(TSNAPSHOT_UNIT &record, TPLAYER_UNIT *unit)
+{
+  TMAP_UNIT *map_unit = static_cast<TMAP_UNIT *>(unit);
+  TPOSITION_3D pos = unit->GetPosition();
+
+  // dying units are left to their events
+  if (record.life <= 0 || map_unit->GetLife() <= 0) return;
+
+  if ((record.item_type == IT_FORCE || record.item_type == IT_WORKER)
+    && (record.flags & SNP_UNIT_IN_MAP) && map_unit->IsInMap()
+    && record.state == US_STAY && unit->TestState(US_STAY)
+    && (record.x != pos.x || record.y != pos.y || record.segment != pos.segment)
+    && map.IsInMap(T_SIMPLE(record.x), T_SIMPLE(record.y), T_SIMPLE(record.segment))
+  ) {
+    TFORCE_UNIT *force = static_cast<TFORCE_UNIT *>(unit);
+
+    force->DeleteFromMap(true);
+    force->SetPosition(T_SIMPLE(record.x), T_SIMPLE(record.y), T_SIMPLE(record.segment));
+
+    if (!force->AddToMap(true, true)) {
+      Warning(LogMsg("Snapshot: position [%d,%d,%d] of unit %d of player %d is occupied", record.x, record.y, record.segment, record.unit_id, record.player_id));
+      force->SetPosition(pos);
+      force->AddToMap(true, true);
+    }
+    else force->SetDirections(record.direction);
+  }
+
+  if (int(record.life) != int(map_unit->GetLife()))
+    map_unit->SetLife(record.life);
+
+  if (record.item_type == IT_WORKER) {
+    TWORKER_UNIT *worker = static_cast<TWORKER_UNIT *>(unit);
+
+    if (worker->GetMaterial() != record.material) worker->SetMaterial(record.material);
+    if (worker->GetMaterialAmount() != record.material_amount) worker->SetMaterialAmount(record.material_amount);
+  }
+
+  if (record.item_type == IT_SOURCE)
+    static_cast<TSOURCE_UNIT *>(unit)->SetMaterialBalance(record.material_balance);
+}
+
+
+/**
+ *  Applies the snapshot to players, which are remote on this computer. Units
+ *  missing on one of computers are only logged, because units are created and
+ *  deleted by events of their owners. Replicas, which already processed
+ *  events newer than the snapshot, are left untouched, the snapshot would
+ *  return them to older state. Stored materials are restored only if no unit
+ *  of the player processed newer event.
+ *
+ *  @return @c false if the snapshot is corrupted.
+ *  @note process_mutex must be locked.
+ */
+bool TSNAPSHOT::Restore(void)
+{
+  std::set<TPLAYER_UNIT *> restored;
+  std::vector<TPLAYER_UNIT *> units;
+  TSNAPSHOT_UNIT record;
+  TPLAYER_UNIT *unit;
+  double start_time = glfwGetTime();
+  double capture_time;
+  int players_count, units_count, counter;
+  int missing = 0, extra = 0, newer = 0;
+  float stored[SCH_MAX_MATERIALS_COUNT];
+  T_BYTE player_id;
+  bool apply, player_newer;
+
+  if ((capture_time = GetTime()) < 0) {
+    Warning("Snapshot has unknown format");
+    return false;
+  }
+
+  if (!Extract(&players_count, sizeof(players_count))) goto corrupted;
+
+  for (int i = 0; i < players_count; i++) {
+    if (!Extract(&player_id, sizeof(player_id))
+      || !Extract(stored, sizeof(stored))
+      || !Extract(&counter, sizeof(counter))
+      || !Extract(&units_count, sizeof(units_count))
+      || player_id >= player_array.GetCount()
+    ) goto corrupted;
+
+    // only replicas are restored, local players are owned by this computer
+    apply = player_array.IsRemote(player_id);
+    player_newer = false;
+
+    units.clear();
+    if (apply) players[player_id]->GetUnits(units);
+
+    for (int j = 0; j < int(units.size()) && !player_newer; j++)
+      player_newer = units[j]->last_sync_time_stamp > capture_time;
+
+    if (apply && !player_newer)
+      for (int j = 0; j < SCH_MAX_MATERIALS_COUNT; j++)
+        if (players[player_id]->GetStoredMaterial(j) != stored[j])
+          players[player_id]->SetStoredMaterial(j, stored[j]);
+
+    for (int j = 0; j < units_count; j++) {
+      if (!Extract(&record.player_id, sizeof(record.player_id))
+        || !Extract(&record.unit_id, sizeof(record.unit_id))
+        || !Extract(&record.item_type, sizeof(record.item_type))
+        || !Extract(&record.flags, sizeof(record.flags))
+        || !Extract(&record.x, sizeof(record.x))
+        || !Extract(&record.y, sizeof(record.y))
+        || !Extract(&record.segment, sizeof(record.segment))
+        || !Extract(&record.direction, sizeof(record.direction))
+        || !Extract(&record.life, sizeof(record.life))
+        || !Extract(&record.state, sizeof(record.state))
+        || !Extract(&record.material, sizeof(record.material))
+        || !Extract(&record.material_amount, sizeof(record.material_amount))
+        || !Extract(&record.material_balance, sizeof(record.material_balance))
+      ) goto corrupted;
+
+      if (!apply) continue;
+
+      unit = players[player_id]->hash_table_units.GetUnitPointer(record.unit_id);
+
+      if (!unit || unit->IsGhost()) {
+        Warning(LogMsg("Snapshot: unit %d of player %d at [%d,%d,%d] does not exist here", record.unit_id, record.player_id, record.x, record.y, record.segment));
+        missing++;
+        continue;
+      }
+
+      if (unit->GetItemType() != record.item_type) {
+        Warning(LogMsg("Snapshot: unit %d of player %d has different kind", record.unit_id, record.player_id));
+        continue;
+      }
+
+      restored.insert(unit);
+
+      // events of the unit newer than the snapshot were already processed
+      if (unit->last_sync_time_stamp > capture_time) {
+        newer++;
+        continue;
+      }
+
+      RestoreUnit(record, unit);
+    }
+
+    if (!apply) continue;
+
+    // units, which were not in the snapshot
+    for (int j = 0; j < int(units.size()); j++)
+      if (units[j]->GetUnitID() > 0 && !units[j]->IsGhost() && restored.find(units[j]) == restored.end()) {
+        TPOSITION_3D pos = units[j]->GetPosition();
+
+        Warning(LogMsg("Snapshot: unit %d of player %d at [%d,%d,%d] does not exist on computer of owner", units[j]->GetUnitID(), player_id, pos.x, pos.y, pos.segment));
+        extra++;
+      }
+  }
+
+  Info(LogMsg("Snapshot of %d units restored in %.1f ms (%d bytes), %d missing, %d extra, %d changed later", int(restored.size()) - newer, (glfwGetTime() - start_time) * 1000, GetSize(), missing, extra, newer));
+
+  return true;
+
+corrupted:
+  Warning("Snapshot is corrupted");
+  return false;
+}
+
+
+/**
+ *  Returns chunk of the snapshot.
+ *
+ *  @param index  Index of the chunk.
+ *  @param size   Size of the chunk is returned here.
+ */
+const T_BYTE *TSNAPSHOT::GetChunk(int index, int *size)
+{
+  *size = MIN(SNP_CHUNK_SIZE, GetSize() - index * SNP_CHUNK_SIZE);
+
+  return &data[index * SNP_CHUNK_SIZE];
+}
+
+
+/**
+ *  Adds received chunk to the snapshot. If size of the snapshot differs from
+ *  previous chunks, received data are dropped.
+ *
+ *  @param size        Size of whole snapshot.
+ *  @param index       Index of the chunk.
+ *  @param chunk       Data of the chunk.
+ *  @param chunk_size  Size of the chunk.
+ *
+ *  @return @c false if the chunk does not fit into the snapshot.
+ */
+bool TSNAPSHOT::AddChunk(int size, int index, const T_BYTE *chunk, int chunk_size)
+{
+  if (size <= 0 || size > SNP_MAX_SIZE) return false;
+
+  if (size != GetSize()) {
+    data.assign(size, 0);
+    received.assign(GetChunksCount(), false);
+    received_count = 0;
+  }
+
+  if (index < 0 || index >= GetChunksCount() || chunk_size != MIN(SNP_CHUNK_SIZE, size - index * SNP_CHUNK_SIZE))
+    return false;
+
+  memcpy(&data[index * SNP_CHUNK_SIZE], chunk, chunk_size);
+
+  if (!received[index]) {
+    received[index] = true;
+    received_count++;
+  }
+
+  return true;
+}
+
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
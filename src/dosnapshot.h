@@ -0,0 +1,132 @@
+/*
+ * -------------
+ *  Dark Oberon
+ * -------------
+ *
+ * An advanced strategy game.
+ *
+ * Copyright (C) 2002 - 2005 Valeria Sventova, Jiri Krejsa, Peter Knut,
+ *                           Martin Kosalko, Marian Cerny, Michal Kral
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License (see docs/gpl.txt) as
+ * published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+/**
+ *  @file dosnapshot.h
+ *
+ *  Binary snapshots of state of units.
+ *
+ *  @date 2026
+ */
+
+#ifndef __dosnapshot_h__
+#define __dosnapshot_h__
+
+
+//=========================================================================
+// Forward declarations
+//=========================================================================
+
+struct TSNAPSHOT_UNIT;
+class TSNAPSHOT;
+
+
+//=========================================================================
+// Definitions
+//=========================================================================
+
+#define SNP_MAGIC             0x504E5344  //!< Magic number at the start of snapshot ("DSNP").
+#define SNP_VERSION           2           //!< Version of format of snapshot.
+#define SNP_CHUNK_SIZE        0x10000     //!< Size of chunks, in which snapshot is sent. [bytes]
+#define SNP_MAX_SIZE          0x4000000   //!< Maximum size of received snapshot. [bytes]
+#define SNP_REQUEST_PERIOD    10.0        //!< Minimal time between two requests for snapshot of one player. [seconds]
+
+// TSNAPSHOT_UNIT flags
+#define SNP_UNIT_IN_MAP       1           //!< Unit is in the map.
+
+
+//=========================================================================
+// Included files
+//=========================================================================
+
+#include <vector>
+
+#include "cfg.h"
+#include "doalloc.h"
+
+#include "doplayers.h"
+
+
+//=========================================================================
+// Structures
+//=========================================================================
+
+/**
+ *  Record of one unit in the snapshot.
+ */
+struct TSNAPSHOT_UNIT {
+  T_BYTE player_id;       //!< Owner of the unit.
+  int unit_id;            //!< Identificator of the unit.
+  char item_type;         //!< Type of kind of the unit [IT_...].
+  T_BYTE flags;           //!< Flags of the unit [SNP_UNIT_...].
+  short x, y, segment;    //!< Position of the unit.
+  T_BYTE direction;       //!< Move direction of force unit.
+  float life;             //!< Life of the unit.
+  unsigned state;         //!< State of the unit [US_...].
+  char material;          //!< Material carried by worker unit.
+  float material_amount;  //!< Amount of material carried by worker unit.
+  int material_balance;   //!< Amount of material available in source unit.
+};
+
+
+//=========================================================================
+// Classes
+//=========================================================================
+
+/**
+ *  Binary snapshot of players and their units. It is taken on the computer,
+ *  where players are local, and it is applied to replicas of their units on
+ *  remote computers, after events sent before the snapshot had time to come.
+ *  The snapshot is transfered in chunks of #SNP_CHUNK_SIZE bytes.
+ */
+class TSNAPSHOT {
+public:
+  TSNAPSHOT(void) { Clear(); };   //!< Constructor.
+
+  void Clear(void);
+  void Capture(double capture_time);
+  bool Restore(void);
+  double GetTime(void);
+
+  /** Returns size of the snapshot. [bytes] */
+  int GetSize(void) { return int(data.size()); };
+  /** Returns count of chunks of the snapshot. */
+  int GetChunksCount(void) { return (GetSize() + SNP_CHUNK_SIZE - 1) / SNP_CHUNK_SIZE; };
+  /** Returns true if all chunks of the snapshot were received. */
+  bool IsComplete(void) { return !data.empty() && received_count == GetChunksCount(); };
+
+  const T_BYTE *GetChunk(int index, int *size);
+  bool AddChunk(int size, int index, const T_BYTE *chunk, int chunk_size);
+
+private:
+  void Pack(const void *src, int size);
+  bool Extract(void *dest, int size);
+  void PackUnit(TPLAYER_UNIT *unit);
+  void RestoreUnit(TSNAPSHOT_UNIT &record, TPLAYER_UNIT *unit);
+
+  std::vector<T_BYTE> data;     //!< Data of the snapshot.
+  std::vector<bool> received;   //!< Received chunks of the snapshot.
+  int received_count;           //!< Count of received chunks.
+  int extract_p;                //!< Position of extraction in #data.
+};
+
+
+#endif  // __dosnapshot_h__
+
+//=========================================================================
+// END
+//=========================================================================
+// vim:ts=2:sw=2:et:
@@ -356,7 +356,7 @@ bool TSOURCE_UNIT::AddToMap(bool to_segment, bool set_view)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++)
-          map.segments[k].surface[pos.x + i][pos.y + j].ghost = this;
+          map.segments[k].surface.SetGhost(pos.x + i, pos.y + j, this);
   }
 
   else {
@@ -364,7 +364,7 @@ bool TSOURCE_UNIT::AddToMap(bool to_segment, bool set_view)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++)
-          if (map.segments[k].surface[pos.x + i][pos.y + j].unit) 
+          if (map.segments[k].surface.GetUnit(pos.x + i, pos.y + j)) 
             return false;
 
     // update terrain ID and in each segment of map
@@ -372,10 +372,10 @@ bool TSOURCE_UNIT::AddToMap(bool to_segment, bool set_view)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++)
         {
-          map.segments[k].surface[pos.x + i][pos.y + j].t_id += MAP_BUILDING_COEF;
-          map.segments[k].surface[pos.x + i][pos.y + j].unit = this;
-          map.segments[k].surface[pos.x + i][pos.y + j].GetAimersList()->AttackEnemy(this, false);
-          map.segments[k].surface[pos.x + i][pos.y + j].GetWatchersList()->AttackEnemy(this, true);
+          map.segments[k].surface.SetTerrainId(pos.x + i, pos.y + j, map.segments[k].surface.GetTerrainId(pos.x + i, pos.y + j) + MAP_BUILDING_COEF);
+          map.segments[k].surface.SetUnit(pos.x + i, pos.y + j, this);
+          map.segments[k].surface.GetAimersList(pos.x + i, pos.y + j)->AttackEnemy(this, false);
+          map.segments[k].surface.GetWatchersList(pos.x + i, pos.y + j)->AttackEnemy(this, true);
         }
 
     // updating local maps for each player
@@ -405,7 +405,7 @@ void TSOURCE_UNIT::DeleteFromMap(bool from_segment)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++) {
-          map.segments[k].surface[pos.x + i][pos.y + j].ghost = NULL;
+          map.segments[k].surface.SetGhost(pos.x + i, pos.y + j, NULL);
         }
   }
 
@@ -414,8 +414,8 @@ void TSOURCE_UNIT::DeleteFromMap(bool from_segment)
     for (i = 0; i < GetUnitWidth(); i++)
       for (j = 0; j < GetUnitHeight(); j++)
         for (k = pit->GetExistSegments().min; k <= pit->GetExistSegments().max; k++) {
-          map.segments[k].surface[pos.x + i][pos.y + j].t_id -= MAP_BUILDING_COEF;
-          map.segments[k].surface[pos.x + i][pos.y + j].unit = NULL;
+          map.segments[k].surface.SetTerrainId(pos.x + i, pos.y + j, map.segments[k].surface.GetTerrainId(pos.x + i, pos.y + j) - MAP_BUILDING_COEF);
+          map.segments[k].surface.SetUnit(pos.x + i, pos.y + j, NULL);
         }
 
     // updating local maps for each player
@@ -176,7 +176,13 @@ bool TDRAW_UNIT::UpdateGraphics(double time_shift)
 
   in_active_area = map.active_area.IsInArea(pos.x, pos.y, pitem->GetWidth(), pitem->GetHeight());
 
-  if (animation) animation->Update(time_shift);
+  // animations of units out of active area are not drawn, their time is
+  // applied at once when unit comes back to the area
+  if (in_active_area) {
+    UpdateAnimations(anim_shift + time_shift);
+    anim_shift = 0;
+  }
+  else anim_shift += time_shift;
 
   return false;
 }
@@ -269,6 +275,8 @@ void TDRAW_UNIT::SetPosition(const TPOSITION_3D new_pos)
     }
     pos = new_pos;
     sync_pos = new_pos;
+    UpdateWorldHash();
+    WakeUp();
   }
 }
 
@@ -290,6 +298,8 @@ void TDRAW_UNIT::SetPosition(const T_SIMPLE nx, const T_SIMPLE ny, const T_SIMPL
     }
     pos.SetPosition(nx, ny, ns);
     sync_pos.SetPosition(nx, ny, ns);
+    UpdateWorldHash();
+    WakeUp();
   }
 }
 
@@ -340,6 +350,7 @@ TDRAW_UNIT::TDRAW_UNIT()
   rpos_x = rpos_y = 0.0f;
   visible = false;
   in_active_area = true;
+  anim_shift = 0;
   animation = NULL;
   lieing_down = flying_up = false;
 #if SOUND
@@ -363,6 +374,7 @@ TDRAW_UNIT::TDRAW_UNIT(int p_x, int p_y, int p_z, TDRAW_ITEM* set_item, TTEX_TAB
   rpos_y = static_cast<float>(p_y);
   visible = false;
   in_active_area = true;
+  anim_shift = 0;
   lieing_down = flying_up = false;
 #if SOUND
   snd_played = NULL;
@@ -399,14 +411,21 @@ TPLAYER_UNIT::TPLAYER_UNIT(int set_player, int p_x, int p_y, int p_z, TDRAW_ITEM
 :TDRAW_UNIT(p_x, p_y, p_z, set_item, &(players[set_player])->race->tex_table)
 {
   player = players[set_player];
-  PutState(US_NONE);
+  world_hash = 0;
+  world_region = -1;
 
   prev = NULL;
   next = NULL;
+  next_awake = prev_awake = NULL;
+  listed = awake = changed = false;
+  sleep_time = -1;
+
+  PutState(US_NONE);
 
   sound_request_id = waiting_request_id = 0;
   pevent = NULL;
   last_event_time_stamp = 0;
+  last_sync_time_stamp = 0;
   
   if (new_unit_id != 0) {
     unit_id = new_unit_id;
@@ -435,16 +454,23 @@ TPLAYER_UNIT::TPLAYER_UNIT(int set_player, int p_x, int p_y, int p_z, TDRAW_ITEM
 TPLAYER_UNIT::TPLAYER_UNIT()
 { 
   player = NULL;
-  PutState(US_NONE);
+  world_hash = 0;
+  world_region = -1;
 
   prev = NULL;
   next = NULL;
+  next_awake = prev_awake = NULL;
+  listed = awake = changed = false;
+  sleep_time = -1;
+
+  PutState(US_NONE);
   
   unit_id = 0;  // this is necessary for creaing units in segments
 
   sound_request_id = waiting_request_id = 0;
   pevent = NULL;
   last_event_time_stamp = 0;
+  last_sync_time_stamp = 0;
 
   have_order = false;
 }
@@ -463,12 +489,26 @@ TPLAYER_UNIT::~TPLAYER_UNIT()
     pevent = NULL;
   }
   
+  RemoveWorldHash();
+
   if (player) {
     player->hash_table_units.RemoveFromHashTable(this->unit_id); //remove hash unit
     player->DeleteUnit(this);
   }
 }
 
+
+/**
+ *  Folds hash of the unit out of the hash of the world.
+ */
+void TPLAYER_UNIT::RemoveWorldHash()
+{
+  if (world_region < 0) return;
+
+  map.world_hash.Fold(world_region, world_hash);
+  world_region = -1;
+}
+
 /**
  *  Send request message to owner.
  *
@@ -525,13 +565,38 @@ void TPLAYER_UNIT::SendNetEvent(TEVENT * event, int player_id)
 {
   int size; // size of data block
   char data[128]; // data block
+
+  // events sent while update thread processes events are batched
+  if (SendBatchEvent(event, player_id)) {
+    #if DEBUG_EVENTS
+      Debug(LogMsg("TO B: P:%d U:%d E:%s RQ:%d X:%d Y:%d Z:%d R:%d TS:%f COUNT:%d", event->GetPlayerID(), event->GetUnitID(), EventToString(event->GetEvent()), event->GetRequestID(), event->simple1, event->simple2, event->simple3, event->simple4, event->GetTimeStamp(), queue_events->GetQueueLength()));
+    #endif
+    return;
+  }
   
   TNET_MESSAGE *msg = pool_net_messages->GetFromPool();
-  msg->Init_send(net_protocol_event, 0);
-  size = event->LinearizeEvent(data); //linearize event to data block
+  msg->Init_send(net_protocol_event, event_codec);
+
+  //time stamps are translated by receiver according to clock of this computer
+  msg->PackByte(T_BYTE(player_array.GetMyPlayerID()));
+
+  if (event_codec == EVN_CODEC_COMPACT) {
+    double base_time = event->GetTimeStamp();
+
+    //base time of the message is followed by events linearized relatively to it
+    memcpy(data, &base_time, sizeof(base_time));
+    size = sizeof(base_time);
+    size += event->LinearizeEventCompact(data + size, base_time);
+  }
+  else
+    size = event->LinearizeEvent(data); //linearize event to data block
   
   msg->Pack(data, size);
 
+  net_events_count++;
+  net_events_bytes += sizeof(T_BYTE) + size;
+  net_events_messages++;
+
   //send message
   host->SendMessage(msg, player_id);
 
@@ -554,6 +619,16 @@ T_BYTE TPLAYER_UNIT::GetPlayerID() const
 }
 
 
+/**
+ *  Marks the unit as changed and adds it to the list of awake units of its
+ *  owner, so its graphics is updated in the next frame.
+ */
+void TPLAYER_UNIT::WakeUp()
+{
+  if (player) player->WakeUnit(this);
+}
+
+
 void TPLAYER_UNIT::TestVisibility()
 {
   if (player == myself || show_all) visible = true;
@@ -652,12 +727,12 @@ void TBASIC_UNIT::SetView(bool set)  //sets view to the unit
 
               if (map.IsInMap(i, j)) 
               {
-                if (p_gun != NULL) map.segments[k].surface[i][j].GetWatchersList()->AddNode(this);
-                local_map->map[k][i][j].terrain_id = map.segments[k].surface[i][j].t_id;
+                if (p_gun != NULL) map.segments[k].surface.GetWatchersList(i, j)->AddNode(this);
+                local_map->map[k][i][j].terrain_id = map.segments[k].surface.GetTerrainId(i, j);
 
-                if (map.segments[k].surface[i][j].unit)   //if there's any unit on this field
+                if (map.segments[k].surface.GetUnit(i, j))   //if there's any unit on this field
                 {
-                  int pl_id = map.segments[k].surface[i][j].unit->GetPlayerID();
+                  int pl_id = map.segments[k].surface.GetUnit(i, j)->GetPlayerID();
 
                   if (pl_id == -1)    /////!!! toto je divne lebo GetPlayerID vracia T_BYTE [PPP]
                     local_map->map[k][i][j].player_id = 254;
@@ -671,7 +746,7 @@ void TBASIC_UNIT::SetView(bool set)  //sets view to the unit
             else 
             {
               if (map.IsInMap(i, j))
-                if (p_gun != NULL) map.segments[k].surface[i][j].GetWatchersList()->RemoveNode(this);
+                if (p_gun != NULL) map.segments[k].surface.GetWatchersList(i, j)->RemoveNode(this);
 
               if (local_map->map[k][i][j].state > 0) 
                 local_map->map[k][i][j].state -= 1;
@@ -713,6 +788,11 @@ void TBASIC_UNIT::SetView(bool set)  //sets view to the unit
       } 
     } // for i, j
 
+  if (player == myself) {
+    map.war_fog.SetDirty(x_start + 1, y_start + 1, x_stop, y_stop);
+    map.WakeUnits(x_start, y_start, x_stop - 1, y_stop - 1);
+  }
+
   if (p_gun != NULL) 
   {
     range_min = p_gun->GetRange().min;
@@ -733,9 +813,9 @@ void TBASIC_UNIT::SetView(bool set)  //sets view to the unit
           for (int k = aim_seg_num_max; k >= aim_seg_num_min; k--)
           {
             if (set)
-              map.segments[k].surface[i][j].GetAimersList()->AddNode(this);
+              map.segments[k].surface.GetAimersList(i, j)->AddNode(this);
             else
-              map.segments[k].surface[i][j].GetAimersList()->RemoveNode(this);
+              map.segments[k].surface.GetAimersList(i, j)->RemoveNode(this);
           }
         }
       }
@@ -901,7 +981,7 @@ TMAP_UNIT* TBASIC_UNIT::CheckNeighbourhood(TMAP_UNIT *previous)
       {
         for (int s = top; s >= bottom; s--)
         {
-          TMAP_UNIT *unit = map.segments[s].surface[tx][ty].unit;
+          TMAP_UNIT *unit = map.segments[s].surface.GetUnit(tx, ty);
           if ((unit != NULL) && (unit != previous) && (unit->GetPlayer() != GetPlayer()) && (unit->GetPlayerID() != 0))
           {
             TATTACK_INFO attack_info = armam->IsPossibleAttack(this, unit);   //tests possibility of attack
@@ -916,7 +996,7 @@ TMAP_UNIT* TBASIC_UNIT::CheckNeighbourhood(TMAP_UNIT *previous)
       {
         for (int s = top; s >= bottom; s--)
         {
-          TMAP_UNIT *unit = map.segments[s].surface[tx][ty].unit;
+          TMAP_UNIT *unit = map.segments[s].surface.GetUnit(tx, ty);
           if ((unit != NULL) && (unit != previous) && (unit->GetPlayer() != GetPlayer()) && (unit->GetPlayerID() != 0))
           {
             TATTACK_INFO attack_info = armam->IsPossibleAttack(this, unit);   //tests possibility of attack
@@ -935,7 +1015,7 @@ TMAP_UNIT* TBASIC_UNIT::CheckNeighbourhood(TMAP_UNIT *previous)
       {
         for (int s = top; s >= bottom; s--)
         {
-          TMAP_UNIT *unit = map.segments[s].surface[tx][ty].unit;
+          TMAP_UNIT *unit = map.segments[s].surface.GetUnit(tx, ty);
           if ((unit != NULL) && (unit != previous) && (unit->GetPlayer() != GetPlayer()) && (unit->GetPlayerID() != 0))
           {
             TATTACK_INFO attack_info = armam->IsPossibleAttack(this, unit);   //tests possibility of attack
@@ -950,7 +1030,7 @@ TMAP_UNIT* TBASIC_UNIT::CheckNeighbourhood(TMAP_UNIT *previous)
       {
         for (int s = top; s >= bottom; s--)
         {
-          TMAP_UNIT *unit = map.segments[s].surface[tx][ty].unit;
+          TMAP_UNIT *unit = map.segments[s].surface.GetUnit(tx, ty);
           if ((unit != NULL) && (unit != previous) && (unit->GetPlayer() != GetPlayer()) && (unit->GetPlayerID() != 0))
           {
             TATTACK_INFO attack_info = armam->IsPossibleAttack(this, unit);   //tests possibility of attack
@@ -1088,7 +1168,7 @@ void TPROJECTILE_UNIT::Impact()
     {
       if (::map.IsInMap(r, s) && ((Sqr(i) + Sqr(j)) <= border))
       {
-        TMAP_UNIT* affected = ::map.segments[impact_pos.segment].surface[r][s].unit;
+        TMAP_UNIT* affected = ::map.segments[impact_pos.segment].surface.GetUnit(r, s);
         //field is in the radius of the explosion and there is my unit
         if ((affected != NULL) && (!player_array.IsRemote(affected->GetPlayerID())))
           if (affected->AcquirePointer())
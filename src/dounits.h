@@ -229,13 +229,20 @@ public:
 
   virtual void Draw() { Draw(DS_NORMAL); };
   virtual void Draw(T_BYTE style);
-  virtual void DrawToRadar() {};
+  virtual void PaintToRadar() {};
+  virtual void UpdateRadar() {};
+  virtual void InvalidateRadar() {};
+  /** Marks the unit as changed, its graphics must be updated in the next frame. */
+  virtual void WakeUp() {};
   virtual bool UpdateGraphics(double time_shift);
   virtual void Dead(bool local);                        // The method correctly kills the unit.
 
   virtual void AddToSegments();
   virtual void DeleteFromSegments();
 
+  /** Folds changed state of the unit into hash of the world. */
+  virtual void UpdateWorldHash() {};
+
   TDRAW_ITEM* GetPointerToItem() const        //!< Returns pointer to kind of the unit.
     { return pitem; }; 
   /** Sets pointer to kind of the unit.
@@ -316,6 +323,10 @@ protected:
   bool IsCloserThan(TDRAW_UNIT *unit);
 
   virtual void TestVisibility();
+  /** Advances unit animations. Called only for units in active map area.
+   *  @param time_shift  Time shift from the last update of animations. */
+  virtual void UpdateAnimations(double time_shift)
+    { if (animation) animation->Update(time_shift); };
 
   /** The method sets unit to will be deleted and delete unit. */
   virtual void UnitToDelete(bool lock) { delete this; }
@@ -328,6 +339,7 @@ protected:
   float rpos_x, rpos_y;       //!< Real actual position in map. Need for drawing and textures sorting. [mapels]
 
   bool in_active_area;        //!< If unit is in active map area.
+  double anim_shift;          //!< Time shift of animations which was not applied while unit was out of active area. [seconds]
   bool visible;               //!< Whether unit is seen and drawn.
   bool lieing_down;           //!< Whether unit is lieing down and other units can walk over it. Used in sorting method.
   bool flying_up;             //!< Whether unit is flying up over other units. Used in sorting method.
@@ -352,6 +364,9 @@ public:
   virtual void CreateGhost() {}
   virtual void DestroyGhost() {}
   virtual void Disconnect() {delete this;}
+  virtual void WakeUp();
+  /** Returns @c true if graphics of the unit changes in every frame (e.g. while moving). */
+  virtual bool IsBusy() { return false; }
 
   T_BYTE GetPlayerID() const ;
   TPLAYER* GetPlayer() const { return player; };        //!< Returns pointer to owner of the unit.
@@ -387,7 +402,7 @@ public:
 
   /** Sets state to the value in the parameter.
   * @param putted  New value of the unit state. */
-  void PutState(const unsigned int putted) {state = putted;};
+  void PutState(const unsigned int putted) {state = putted; UpdateWorldHash(); WakeUp();};
   /** Tests state of unit to parameter. If send to test more then one return true when units is in any of the sended states.
   * @param tested State to test. */
   unsigned int GetState() const {return state;};    //!< Returns actual state of the unit.
@@ -396,6 +411,7 @@ public:
   };
 
   double last_event_time_stamp; //!< Timestamp of last processed event of unit.
+  double last_sync_time_stamp;  //!< Timestamp of last processed event of remote unit, including requests.
 
   TPLAYER_UNIT *GetNext() const { return next; }    //!< Returns pointer to next unit in the list of units owned by same player.
   /** Sets pointer to next map unit in the list to value of parameter.
@@ -406,11 +422,22 @@ public:
   * @param new_prev Pointer to previous unit.*/
   void SetPrev(TPLAYER_UNIT *new_prev) { prev = new_prev; }
 
+  unsigned GetWorldHash() const { return world_hash; }    //!< Returns hash of the unit folded into hash of the world.
+  int GetWorldRegion() const { return world_region; }     //!< Returns region of hash of the world, where the unit is folded, or -1.
+  void RemoveWorldHash();
+
 protected:
   TPLAYER *player;    //!< Pointer to instance of the unit owner.
 
   TPLAYER_UNIT *next; //!< Pointer to a next unit in the player list of map units.
   TPLAYER_UNIT *prev; //!< Pointer to a previous unit in the player list of map units.
+  TPLAYER_UNIT *next_awake; //!< Pointer to a next unit in the player list of awake units.
+  TPLAYER_UNIT *prev_awake; //!< Pointer to a previous unit in the player list of awake units.
+
+  bool listed;        //!< If unit is in the player list of map units.
+  bool awake;         //!< If unit is in the player list of awake units.
+  bool changed;       //!< If unit was changed since the last update of its graphics.
+  double sleep_time;  //!< Graphics time of the owner, when unit fell asleep. [seconds, -1 if awake]
 
   int unit_id;        //!< Numeric unique identificator of unit.
   unsigned int state;     //!< Unit state [US_...].
@@ -418,6 +445,9 @@ protected:
   int sound_request_id;   //!< If unit is sending request for sound to itself, sound is played only when it is expected and sill valid.
 
   bool have_order;    //!< If unit has order in this round of AI
+
+  unsigned world_hash;  //!< Hash of the unit folded into hash of the world.
+  int world_region;     //!< Region of hash of the world, where #world_hash is folded. [-1 if not folded]
 };
 
 
@@ -430,13 +460,19 @@ protected:
 class TMAP_UNIT : public TPLAYER_UNIT{
 public:
   virtual void Draw(T_BYTE style);
-  virtual void DrawToRadar();
+  virtual void PaintToRadar();
+  virtual void UpdateRadar();
+  virtual void InvalidateRadar();
+  virtual void UpdateAnimations(double time_shift);
   inline  void DrawBGSelection(T_BYTE style);
   inline  void DrawFGSelection(T_BYTE style);
   virtual void ProcessEvent(TEVENT * proc_event);
   virtual bool UpdateGraphics(double time_shift);
   virtual void Dead(bool local);
   virtual void Disconnect();
+  virtual void UpdateWorldHash();
+  /** Returns hash of materials carried by the unit. */
+  virtual unsigned GetMaterialsHash() { return 0; };
 
   virtual void TestVisibility();
 
@@ -586,6 +622,7 @@ protected:
 
   TPROJECTILE_UNIT *shot; //!< Shoted shot before leaves the barrel.
   TMAP_UNIT *ghost_owner; //!< Owner of this unit in ghost state.
+  TRADAR_DOT radar_dot;   //!< Dot of the unit in radar.
 
   TLIST<TFORCE_UNIT> hided_units;       //!< The list of force units which are hiding.
   TLIST<TWORKER_UNIT> working_units;    //!< The list of force units which are mining or unloading inside the source/building.
@@ -785,6 +822,8 @@ public:
 
   virtual bool UpdateGraphics(double time_shift);
   virtual void ProcessEvent(TEVENT * proc_event);
+  /** Projectile moves in every frame. */
+  virtual bool IsBusy() { return true; }
 
   /** @return The method gets moving direction.*/
   int GetDirection() const
@@ -857,6 +896,7 @@ public:
   virtual void ProcessEvent(TEVENT * proc_event);
   virtual TEVENT* SendEvent(bool n_priority=false, double n_time_stamp=0, int n_event=0, int n_request_id=0, T_SIMPLE n_simple1=0, T_SIMPLE n_simple2=0, T_SIMPLE n_simple3=0, T_SIMPLE n_simple4=0, T_SIMPLE n_simple5=0, T_SIMPLE n_simple6=0, int n_int1=0,int n_int2=0);
   virtual bool UpdateGraphics(double time_shift);
+  virtual bool IsBusy();
   virtual void DrawLine();
   virtual bool StartStaying();
   virtual void ClearActions();
@@ -1090,11 +1130,13 @@ public:
   //! Gets the material type which the unit has mined.
   char GetMaterial() { return mined_material; };
   //! Sets the material type which the unit has mined.
-  void SetMaterial(char material_type) { mined_material = material_type; };
+  void SetMaterial(char material_type) { mined_material = material_type; UpdateWorldHash(); };
   //! Gets the amount of material the unit extracted and is carrying.
   float GetMaterialAmount() { return material_amount; };
   //! Sets the amount of material the unit is carrying.
-  void SetMaterialAmount(float mat_amount) { material_amount = mat_amount ;};
+  void SetMaterialAmount(float mat_amount) { material_amount = mat_amount; UpdateWorldHash(); };
+  //! Returns hash of mined material and its amount.
+  virtual unsigned GetMaterialsHash() { return (unsigned(mined_material) << 24) ^ unsigned(material_amount); };
   //! Finds a new source (when the old one has collapsed).
   
   // help functions to finding new source (FindNewSource() function)
@@ -75,13 +75,15 @@ TA_STAR_ALG::TA_STAR_ALG(char owner)
 
   if (!(star_map = NEW TA_STAR_MAP(map.height, map.width)))  //allocation of map for A* algorithm
     return;
-  if (!(open_set = NEW TSET_FIELD[DAT_SEGMENTS_COUNT*map.width*map.height + 1])) 
+  open_size = close_size = MIN(WLK_SET_SIZE, DAT_SEGMENTS_COUNT*map.width*map.height + 1);
+
+  if (!(open_set = NEW TSET_FIELD[open_size])) 
   {
     delete star_map;
     star_map = NULL;  
     return;
   }
-  if (!(close_set = NEW  TSET_FIELD[DAT_SEGMENTS_COUNT*map.width*map.height + 1]))
+  if (!(close_set = NEW  TSET_FIELD[close_size]))
   {
     delete star_map;
     star_map = NULL;
@@ -107,13 +109,15 @@ TA_STAR_ALG::TA_STAR_ALG()
 
   if (!(star_map = NEW TA_STAR_MAP(map.height, map.width)))  //allocation of map for A* algorithm
     return;
-  if (!(open_set = NEW TSET_FIELD[DAT_SEGMENTS_COUNT*map.width*map.height + 1])) 
+  open_size = close_size = MIN(WLK_SET_SIZE, DAT_SEGMENTS_COUNT*map.width*map.height + 1);
+
+  if (!(open_set = NEW TSET_FIELD[open_size])) 
   {
     delete star_map;
     star_map = NULL;
     return;
   }
-  if (!(close_set = NEW  TSET_FIELD[DAT_SEGMENTS_COUNT*map.width*map.height + 1]))
+  if (!(close_set = NEW  TSET_FIELD[close_size]))
   {
     delete star_map;
     star_map = NULL;
@@ -148,6 +152,45 @@ TA_STAR_ALG::~TA_STAR_ALG()
 }
 
 
+/**
+ *  Enlarges OPEN or CLOSE set twice. Fields of star map, which point to the
+ *  old array, are moved to the new one.
+ *
+ *  @param set    Pointer to the set.
+ *  @param size   Pointer to count of allocated fields of the set.
+ *  @param count  Count of used fields of the set (without zeroth member).
+ *
+ *  @return @c true on success, @c false if there is not enough memory.
+ */
+bool TA_STAR_ALG::GrowSet(TSET_FIELD **set, unsigned int *size, unsigned int count)
+{
+  TSET_FIELD *old_set = *set;
+  TSET_FIELD *new_set;
+  TA_STAR_MAP_FIELD *field;
+  unsigned int i;
+
+  if (!(new_set = NEW TSET_FIELD[*size * 2]))
+    return false;
+
+  new_set[0] = old_set[0];
+
+  for (i = 1; i <= count; i++) {
+    new_set[i] = old_set[i];
+
+    field = &star_map->fields[old_set[i].pos.segment][old_set[i].pos.x][old_set[i].pos.y];
+    if (field->p_heap_fld == old_set + i)
+      field->p_heap_fld = new_set + i;
+  }
+
+  delete []old_set;
+
+  *set = new_set;
+  *size *= 2;
+
+  return true;
+}
+
+
 /**
  *  Inserts new node into the heap OPEN set.
  *
@@ -161,6 +204,10 @@ void TA_STAR_ALG::InsertToOpenSet(TSET_FIELD field)
   int x = field.pos.x, y= field.pos.y, z = field.pos.segment;
   double value = field.value;
 
+  if (open_node_num + 1 >= open_size && !GrowSet(&open_set, &open_size, open_node_num))
+    return;
+
+  star_map->Touch(x, y);
 
   if (!open_node_num) //adding the very firt node to the OPEN set
   {
@@ -271,6 +318,9 @@ void TA_STAR_ALG::InsertToCloseSet(TSET_FIELD * open_min)
 {
   int x = open_min->pos.x, y=open_min->pos.y, z=open_min->pos.segment;  
 
+  if (close_node_num + 1 >= close_size && !GrowSet(&close_set, &close_size, close_node_num))
+    return;
+
   close_node_num++;  
   close_set[close_node_num] = *open_min;
 
@@ -603,7 +653,7 @@ inline bool TA_STAR_ALG::IsOccupiedByMe (int x, int y, int z) {
  *  @note Only for using in function GetAdjacent(). */
 inline bool TA_STAR_ALG::IsUnavailableField (int x, int y, int z, TFORCE_ITEM *type, TLOC_MAP_FIELD ***loc_map) {
   return !type->moveable[z].IsMember(loc_map[z][x][y].terrain_id)
-         && loc_map[z][x][y].terrain_id != LAY_UNAVAILABLE_POSITION;
+         && loc_map[z][x][y].terrain_id != WLK_UNKNOWN_AREA;
 }
 
 
@@ -661,7 +711,7 @@ inline bool TA_STAR_ALG::IsUnavailableField (int x, int y, int z, TFORCE_ITEM *t
  *  @note Only for using in function GetAdjacent(). */
 #define IS_UNLANDABLE_FIELD(x,y,z)      (\
             (! type->landable[(z)].IsMember(loc_map[(z)][(x)][(y)].terrain_id))\
-            && (loc_map[(z)][(x)][(y)].terrain_id != LAY_UNAVAILABLE_POSITION))
+            && (loc_map[(z)][(x)][(y)].terrain_id != WLK_UNKNOWN_AREA))
 
 
 /** Control whether area is landable. Result put into @p a. Difficulty of area is put into @p m.
@@ -1658,8 +1708,8 @@ double TPATH_LIST::CountTime(TFORCE_UNIT *unit)
     for (int i=pos_next.x ; i<pos_next.x + worker->GetUnitWidth(); i++)
        for (int j= pos_next.y  ; j< pos_next.y + worker->GetUnitHeight();j++)
        {
-          hardest = (scheme.terrain_props[pos_next.segment][map.segments[pos_next.segment].surface[pos_next.x][pos_next.y].t_id].difficulty >hardest)?
-             scheme.terrain_props[pos_next.segment][map.segments[pos_next.segment].surface[pos_next.x][pos_next.y].t_id].difficulty:hardest;
+          hardest = (scheme.terrain_props[pos_next.segment][map.segments[pos_next.segment].surface.GetTerrainId(pos_next.x, pos_next.y)].difficulty >hardest)?
+             scheme.terrain_props[pos_next.segment][map.segments[pos_next.segment].surface.GetTerrainId(pos_next.x, pos_next.y)].difficulty:hardest;
        }
         
     speed = static_cast<TFORCE_ITEM*>(unit->GetPointerToItem())->max_speed[pos.segment]*(1.001f - hardest / 1000.0f);
@@ -1827,6 +1877,8 @@ bool TA_STAR_MAP::CreateNewMap(T_SIMPLE w, T_SIMPLE h, T_SIMPLE d)
   depth  = d;
   width  = w;
   height = h;
+  dirty_x1 = dirty_y1 = MAX_T_SIMPLE;
+  dirty_x2 = dirty_y2 = -1;
 
   return true;
 }
@@ -1900,6 +1952,8 @@ TA_STAR_MAP::TA_STAR_MAP(T_SIMPLE w, T_SIMPLE h, T_SIMPLE d)
 {
   fields = NULL; 
   height = width = depth = WLK_SIZE_NOT_SET;
+  dirty_x1 = dirty_y1 = MAX_T_SIMPLE;
+  dirty_x2 = dirty_y2 = -1;
 
   CreateNewMap(w, h, d);
 }
@@ -1915,21 +1969,26 @@ TA_STAR_MAP::~TA_STAR_MAP()
 
 
 /**
- *  Reset auxilliary map for A* algorithm.
+ *  Reset auxilliary map for A* algorithm. Only fields in the envelope of
+ *  fields changed since the last reset are reset, so search of short path
+ *  does not cost the whole map.
  */
 void TA_STAR_MAP::ResetStarMap()
 {
   register int i, j, k;
 
   for (k = 0; k < depth; k++)
-    for (i = 0; i < width; i++)
-      for (j = 0; j < height; j++)
+    for (i = dirty_x1; i <= dirty_x2; i++)
+      for (j = dirty_y1; j <= dirty_y2; j++)
       {
         fields[k][i][j].set_id = WLK_NO_SET;
         fields[k][i][j].p_heap_fld = NULL;
         fields[k][i][j].is_goal = false;
         fields[k][i][j].is_i_am = false;
       }
+
+  dirty_x1 = dirty_y1 = MAX_T_SIMPLE;
+  dirty_x2 = dirty_y2 = -1;
 }
 
 
@@ -1944,7 +2003,7 @@ void TA_STAR_MAP::CreateGoalSet(TPOSITION_3D goal, T_SIMPLE welt)
 {
   TMAP_UNIT *map_unit = NULL;
 
-  map_unit = map.segments[goal.segment].surface[goal.x][goal.y].unit;
+  map_unit = map.segments[goal.segment].surface.GetUnit(goal.x, goal.y);
   if (map_unit)
   {
     TPOSITION_3D u_position = map_unit->GetPosition();
@@ -1952,11 +2011,15 @@ void TA_STAR_MAP::CreateGoalSet(TPOSITION_3D goal, T_SIMPLE welt)
     for (int s = static_cast<TMAP_ITEM*>(map_unit->GetPointerToItem())->GetExistSegments().min; s <= static_cast<TMAP_ITEM*>(map_unit->GetPointerToItem())->GetExistSegments().max; s++)
       for (int i = u_position.x - welt; i <= u_position.x + map_unit->GetUnitWidth() ; i++)
         for (int j = u_position.y - welt; j <= u_position.y + map_unit->GetUnitHeight() ; j++)      
-          if (map.IsInMap(i,j,s))
+          if (map.IsInMap(i,j,s)) {
             fields[s][i][j].is_goal = true;
+            Touch(i, j);
+          }
   } 
-  else
+  else {
     fields[goal.segment][goal.x][goal.y].is_goal = true;
+    Touch(goal.x, goal.y);
+  }
 }
 
 
@@ -1970,8 +2033,10 @@ void TA_STAR_MAP::CreateGoalSetForArea(TPOSITION_3D pos,TFORCE_UNIT *unit,int ar
   for (int i = pos.x - unit->GetPointerToItem()->GetWidth() +1 ; i <= pos.x + area_width -1; i++)
     for (int j= pos.y - unit->GetPointerToItem()->GetHeight() +1 ; j <= pos.y + area_height -1 ;j++)
     {
-          if (map.IsInMap(i,j,pos.segment))
+          if (map.IsInMap(i,j,pos.segment)) {
             fields[pos.segment][i][j].is_goal = true;
+            Touch(i, j);
+          }
     }
 }
 
@@ -1984,8 +2049,10 @@ void TA_STAR_MAP::MarksUnitPosition(TFORCE_UNIT *unit)
 {
   for (int i = unit->GetPosition().x; i < unit->GetPosition().x +unit->GetUnitWidth(); i++)
     for (int j = unit->GetPosition().y; j < unit->GetPosition().y + unit->GetUnitHeight(); j++)      
-      if (map.IsInMap(i,j,unit->GetPosition().segment))
+      if (map.IsInMap(i,j,unit->GetPosition().segment)) {
         fields[unit->GetPosition().segment][i][j].is_i_am = true;
+        Touch(i, j);
+      }
 }
 
 
@@ -62,11 +62,12 @@ struct TNODE_OF_UNITS_LIST;
 #define WLK_BUILDING_PLACED   100
 
 #define WLK_NEIGHBOURS_COUNT  10              //!< Count of neighbours.
+#define WLK_SET_SIZE          4096            //!< Initial count of fields in OPEN and CLOSE sets of A* algorithm. Sets grow when needed.
 
 #define WLK_LANDING_PENALTY   3               //!< Recourse difficulty of the field or landing time -  used as multiple constant.
 
 #define UPP_DIST_BOUNDARY     5               //!< Number of the fields, that can be unit distant from the leader unit, so that it is in the same group
-#define WLK_SIZE_NOT_SET      255             //!< Size of the dimension if the dimension doesn't exist.
+#define WLK_SIZE_NOT_SET      MAX_T_SIMPLE    //!< Size of the dimension if the dimension doesn't exist.
 
 
 //========================================================================
@@ -120,10 +121,10 @@ class TNEAREST_INFO;
  */
 struct TLOC_MAP_FIELD {
 
-  T_SIMPLE state;         //!< Visibility and warfog state. [#WLK_WARFOG, #WLK_UNKNOWN_AREA]
-  T_SIMPLE terrain_id;    //!< Terrain identifier of field.
-  T_SIMPLE player_id;     //!< Inforamtion which units stands on this field.
-  T_SIMPLE guard;         //!< Info wheather my unit is seen by enemy unit.
+  T_BYTE state;           //!< Visibility and warfog state. [#WLK_WARFOG, #WLK_UNKNOWN_AREA]
+  T_BYTE terrain_id;      //!< Terrain identifier of field.
+  T_BYTE player_id;       //!< Inforamtion which units stands on this field.
+  T_BYTE guard;           //!< Info wheather my unit is seen by enemy unit.
 
   /** Structure constructor. Sets default values. */
   TLOC_MAP_FIELD()
@@ -205,7 +206,7 @@ private:
   TA_STAR_MAP(T_SIMPLE width, T_SIMPLE height, T_SIMPLE depth = DAT_SEGMENTS_COUNT);
   /** Constructor which doesn't allocate fields in the map.*/
   TA_STAR_MAP()
-    { fields = NULL; height = width = depth = WLK_SIZE_NOT_SET;};
+    { fields = NULL; height = width = depth = WLK_SIZE_NOT_SET; dirty_x1 = dirty_y1 = MAX_T_SIMPLE; dirty_x2 = dirty_y2 = -1;};
   /** Destructor deletes map if exists.*/
   ~TA_STAR_MAP();
 
@@ -229,11 +230,21 @@ private:
   /** The method marks fields under unit position.*/
   void MarksUnitPosition(TFORCE_UNIT *unit);
 
+  /** The method extends envelope of fields changed since the last reset by the field [x, y].*/
+  void Touch(int x, int y) {
+    if (x < dirty_x1) dirty_x1 = x;
+    if (x > dirty_x2) dirty_x2 = x;
+    if (y < dirty_y1) dirty_y1 = y;
+    if (y > dirty_y2) dirty_y2 = y;
+  }
+
 private:
   TA_STAR_MAP_FIELD ***fields;  //!< Three dimension array of the star map fields. It is map.
   T_SIMPLE height;              //!< The size of the second dimension.
   T_SIMPLE width;               //!< The size of the first dimension.
   T_SIMPLE depth;               //!< The size of the third dimension.
+  int dirty_x1, dirty_y1;       //!< Envelope of fields changed since the last reset. Only these are reset.
+  int dirty_x2, dirty_y2;
   friend class TA_STAR_ALG;
 };
 
@@ -337,8 +348,10 @@ class TA_STAR_ALG {
   TA_STAR_MAP *star_map;                              //!<Pointers to marking map.
   TSET_FIELD *open_set;                               //!<Pointer to set OPEN that is storaged in binary heap.
   unsigned int open_node_num;                         //!<Count of nodes in heap of OPEN set.
+  unsigned int open_size;                             //!<Count of allocated fields of OPEN set.
   TSET_FIELD *close_set;                              //!<Pointer to set CLOSE.
   unsigned int close_node_num;                        //!<Count of nodes in set CLOSE.
+  unsigned int close_size;                            //!<Count of allocated fields of CLOSE set.
   char playerID;                                      //!<Player number
   double unknown[DAT_SEGMENTS_COUNT];                 //!<Array with lowest difficulty of terrain in each segment in map.
   TSET_FIELD closest_goal_field;                      //!<The field, that is closest to the goal; used when whole path form the start to the goal isn't found.
@@ -363,6 +376,8 @@ public:
   TNEAREST_INFO* SearchForNearestBuilding(TNEAREST_INFO* pnearest_info); //!< The method finds nearest building and path to it according to parameter
 
 private:
+  bool GrowSet(TSET_FIELD **set, unsigned int *size, unsigned int count);
+
   /* Functions used in GetAdjacent(). */
   inline unsigned int FieldDifficultyAux (int x, int y, int z, TLOC_MAP_FIELD ***loc_map);
   inline bool IsOccupiedByMe (int x, int y, int z);
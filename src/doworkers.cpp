@@ -218,14 +218,14 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
         // update global map
         for (i = last_ps.x; i < last_ps.x + GetUnitWidth(); i++)
           for (j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
-            map.segments[last_ps.segment].surface[i][j].unit = NULL;   //updating global map - leaving old position
+            map.segments[last_ps.segment].surface.SetUnit(i, j, NULL);   //updating global map - leaving old position
 
         for (i = pos.x; i < pos.x + GetUnitWidth(); i++)
           for (j = pos.y; j < pos.y + GetUnitHeight(); j++)
           {
-            map.segments[pos.segment].surface[i][j].unit = this;   //updating global map - taking up new position
-            map.segments[pos.segment].surface[i][j].GetAimersList()->AttackEnemy(this, false);
-            map.segments[pos.segment].surface[i][j].GetWatchersList()->AttackEnemy(this, true);
+            map.segments[pos.segment].surface.SetUnit(i, j, this);   //updating global map - taking up new position
+            map.segments[pos.segment].surface.GetAimersList(i, j)->AttackEnemy(this, false);
+            map.segments[pos.segment].surface.GetWatchersList(i, j)->AttackEnemy(this, true);
           }
 
         // update local map of all local players
@@ -256,6 +256,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
         T_BYTE old_mined_material = mined_material;
         mined_material = static_cast<TSOURCE_ITEM *>(source->GetPointerToItem())->GetOfferMaterial();
         if (mined_material != old_mined_material) change_mined_material = true;
+        UpdateWorldHash();
       }
     }
 
@@ -425,7 +426,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
           for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
             for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
             {
-              if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+              if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
               {
                 all_moveable = false;
                 break;
@@ -443,8 +444,8 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
       // find out hardest terrain
       for (i = pos.x; i < pos.x + GetUnitWidth(); i++)
         for (j = pos.y; j < pos.y + GetUnitHeight(); j++)
-          hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty > hardest)?
-                    scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][this->pos.y].t_id].difficulty : hardest;
+          hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty > hardest)?
+                    scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, this->pos.y)].difficulty : hardest;
 
       // set speed
       //actual speed in dependence to difficulty of the terrain - terrain with difficulty 500 reduce speed to half
@@ -478,8 +479,8 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
     
     for (i = pos.x; i < (pos.x + GetUnitWidth()); i++)
       for (j = pos.y; j < (pos.y + GetUnitHeight()); j++)   //find hardest terrain
-        hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty > hardest)?
-                  scheme.terrain_props[pos.segment][map.segments[pos.segment].surface[pos.x][pos.y].t_id].difficulty : hardest;
+        hardest = (scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty > hardest)?
+                  scheme.terrain_props[pos.segment][map.segments[pos.segment].surface.GetTerrainId(pos.x, pos.y)].difficulty : hardest;
 
     // set rotation speed
     rotation_speed = itm->GetMaximumRotation(pos.segment)*(1.001f - hardest / 1000.0f);
@@ -898,7 +899,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
         for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
           for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
           {
-            if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+            if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
             {
               all_moveable = false;
               break;
@@ -1089,7 +1090,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
               for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
                 for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
                 {
-                  if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+                  if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
                   {
                     all_moveable = false;
                     break;
@@ -1223,7 +1224,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
                   for (int i = last_ps.x; (i < last_ps.x + GetUnitWidth()); i++)
                     for (int j = last_ps.y; j < last_ps.y + GetUnitHeight(); j++)
                     {
-                      if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface[i][j].t_id)) // it is NOT possible to land and to move here
+                      if (!itm->moveable[last_ps.segment].IsMember(map.segments[last_ps.segment].surface.GetTerrainId(i, j))) // it is NOT possible to land and to move here
                       {
                         all_moveable = false;
                         break;
@@ -1964,6 +1965,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
       if (change_mined_material){
         material_amount = 0;
         change_mined_material = false;
+        UpdateWorldHash();
       }
       
       //test, whaether has enough material or not ; if yes, plann way to nearest_building
@@ -2206,6 +2208,7 @@ void TWORKER_UNIT::ProcessEvent(TEVENT * proc_event)
           
       mined_material = static_cast<TSOURCE_ITEM *>(source->GetPointerToItem())->GetOfferMaterial();
       material_amount += proc_event->int2;
+      UpdateWorldHash();
       
       double time_per_mine = itm->GetMiningTime(mined_material);
       new_time_stamp = proc_event->GetTimeStamp() + (proc_event->int2 * time_per_mine);
@@ -2840,7 +2843,7 @@ TSOURCE_UNIT * TWORKER_UNIT::IsSourceOnPosition(int pos_x, int pos_y)
 
   if (IsSeenByUnit(pos,pos_x, pos_y,GetUnitWidth(),GetUnitHeight(),unit_view) && map.IsInMap(pos_x,pos_y)) 
   {
-    map_unit = map.segments[pos.segment].surface[pos_x][pos_y].unit;
+    map_unit = map.segments[pos.segment].surface.GetUnit(pos_x, pos_y);
     if ((map_unit) && (map_unit->TestItemType(IT_SOURCE)))  //if it is valid source
     {
       source_unit = static_cast<TSOURCE_UNIT*>(map_unit);
@@ -3081,9 +3084,9 @@ bool TWORKER_UNIT::CanBuild(TBUILDING_ITEM *building, TPOSITION pos, bool **buil
         for (seg = building->GetExistSegments().min; seg <= building->GetExistSegments().max; seg++) 
         {
 
-          tid = map.segments[seg].surface[x][y].t_id;
+          tid = map.segments[seg].surface.GetTerrainId(x, y);
           state = GetPlayer()->GetLocalMap()->map[seg][x][y].state;
-          unit = map.segments[seg].surface[x][y].unit;
+          unit = map.segments[seg].surface.GetUnit(x, y);
 
           field_ok = ((state != WLK_UNKNOWN_AREA) || auto_call);
 
@@ -3227,7 +3230,7 @@ TBUILDING_UNIT *TWORKER_UNIT::StartBuild(TBUILDING_ITEM *building, TPOSITION bui
       player->RemoveUnitEnergyFood(building->ancestor->energy, building->ancestor->food);
       ((TBASIC_ITEM *)building->ancestor)->DecreaseActiveUnitCount();  // decrease count of units of this kind
       
-      new_building = static_cast<TBUILDING_UNIT *>(map.segments[building->GetExistSegments().min].surface[build_here.x][build_here.y].unit);
+      new_building = static_cast<TBUILDING_UNIT *>(map.segments[building->GetExistSegments().min].surface.GetUnit(build_here.x, build_here.y));
       new_building->DeleteFromPlayerArray();   //ancestor is deleted from the list of acceptable buildings of player, who owns it
       new_building->ClearActions();
       new_building->SetView(false);
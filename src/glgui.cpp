@@ -27,6 +27,7 @@
 
 
 #include <stdlib.h>
+#include <math.h>
 
 #include "glgui.h"
 
@@ -223,14 +224,17 @@ void SetHoverBox(TGUI_BOX *box)
 
 void TGUI_TEXTURE::DrawFrame(int frame, GLfloat w, GLfloat h)
 {
+  // texture is not created yet
+  if (source) source->LoadTexture(this);
+
   float fvwidth = (float)frame_width / width;    // frame virtual width in texture
   float fvheight = (float)frame_height / height; // frame virtual height in texture
   float fvhalfpix = 0.5f / height;                   // frame virtual size of half of pixel
   float fvx;        // frame virtual x position in texture
   float fvy;        // frame virtual y position in texture
 
-  fvx = fvwidth * (frame % h_count);
-  fvy = fvheight * (v_count - (frame / h_count) - 1);
+  fvx = (float)offset_x / width + fvwidth * (frame % h_count);
+  fvy = (float)offset_y / height + fvheight * (v_count - (frame / h_count) - 1);
 
   glBindTexture(GL_TEXTURE_2D, gl_id);
 
@@ -369,19 +373,23 @@ void TGUI_ANIMATION::Update(double time_shift)
 
   shift_time += time_shift;
 
+  // skip whole loops at once (long shifts of animations which were not drawn)
+  if (loop && shift_time > frame_time * speed_ratio * tex_item->frames_count)
+    shift_time = fmod(shift_time, frame_time * speed_ratio * tex_item->frames_count);
+
   while (shift_time > (frame_time * speed_ratio)) {
     if (reverse) {
       if (act_frame > 0) act_frame--;
       else {
         if (loop) act_frame = tex_item->frames_count - 1;
-        else Pause();
+        else { Pause(); shift_time = 0.0; break; }
       }
     }
     else {
       if (act_frame < tex_item->frames_count - 1) act_frame++;
       else {
         if (loop) act_frame = 0;
-        else Pause();
+        else { Pause(); shift_time = 0.0; break; }
       }
     }
 
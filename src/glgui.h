@@ -33,6 +33,7 @@
 //=========================================================================
 
 class TGUI_TEXTURE;
+class TGUI_TEXTURE_SOURCE;
 class TGUI_ANIMATION;
 class TGUI_BOX;
 class TGUI_LABEL;
@@ -135,6 +136,18 @@ typedef GLfloat *TGUI_COLOR;
 // TTEX_TABLE
 //=========================================================================
 
+/**
+ *  Source of textures, which are created in graphic memory on their first use.
+ */
+class TGUI_TEXTURE_SOURCE {
+public:
+  /** Creates the texture in graphic memory. Called before the texture is drawn. */
+  virtual void LoadTexture(TGUI_TEXTURE *tex) = 0;
+  /** Destructor. */
+  virtual ~TGUI_TEXTURE_SOURCE(void) {};
+};
+
+
 /**
  *  Stores one animated texture.
  */
@@ -142,8 +155,11 @@ class TGUI_TEXTURE {
 public:
   char *id;             //!< Texture string id.
 
-  int width;
-  int height;
+  int width;            //!< Width of the GL texture (whole atlas, if packed). [pixels]
+  int height;           //!< Height of the GL texture (whole atlas, if packed). [pixels]
+
+  int offset_x;         //!< X position of the texture in the GL texture. [pixels]
+  int offset_y;         //!< Y position of the texture in the GL texture. [pixels]
 
   int frame_width;      //!< Width of one frame. [pixels]
   int frame_height;     //!< Height of one frame. [pixels]
@@ -159,24 +175,33 @@ public:
 
   GLenum gl_id;         //!< Texture identifier.
   TGUI_TEX_TYPE type;   //!< Type of texture
+  bool in_atlas;        //!< If texture is packed in atlas. Atlas is owned by textures table.
+
+  GLubyte average_color[3]; //!< Average colour of opaque pixels (RGB).
+
+  TGUI_TEXTURE_SOURCE *source;  //!< Source, which creates the texture on first draw. @c NULL if texture is created.
 
   /** Constructor. */
   TGUI_TEXTURE(void) {
     id = NULL;
     width = height = 0;
+    offset_x = offset_y = 0;
     frame_width = frame_height = 0;
     frames_count = h_count = v_count = 0;
     frame_time = 0.0;
     point_x = point_y = 0;
     gl_id = 0;
     type = GUI_TT_NORMAL;
+    in_atlas = false;
+    average_color[0] = average_color[1] = average_color[2] = 0;
+    source = NULL;
   };
 
   void DrawFrame(int frame) { DrawFrame(frame, GLfloat(frame_width), GLfloat(frame_height)); }
   void DrawFrame(int frame, GLfloat w, GLfloat h);
 
   /** Destructor */
-  ~TGUI_TEXTURE(void) { if (id) delete[] id; glDeleteTextures(1, &gl_id); };
+  ~TGUI_TEXTURE(void) { if (id) delete[] id; if (!in_atlas) glDeleteTextures(1, &gl_id); };
 };
 
 
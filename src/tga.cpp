@@ -32,9 +32,31 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "tga.h"
 
+/**
+ *  Vectorized conversions are used when the compiler generates SSE2 code
+ *  (always on x86-64). SSSE3 and AVX2 paths are used only when they are
+ *  enabled by compiler options, there is no runtime detection. Scalar code is
+ *  used otherwise.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TGA_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(TGA_SSE2) && defined(__SSSE3__)
+#define TGA_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(TGA_SSE2) && defined(__AVX2__)
+#define TGA_AVX2
+#include <immintrin.h>
+#endif
+
 /**
  *  TGA file header information.
  *
@@ -81,19 +103,68 @@ typedef struct {
 #define _TGA_ORIGIN_UR 3      //!< Upper right image origin.
 
 
+/**
+ *  Source of TGA image. It is either a file or a memory buffer.
+ */
+typedef struct {
+  FILE *f;                  //!< File to read from, or @c NULL.
+  const unsigned char *buf; //!< Memory buffer to read from, when #f is @c NULL.
+  int size;                 //!< Size of the memory buffer.
+  int pos;                  //!< Position in the memory buffer.
+} TGA_STREAM;
+
+
+/**
+ *  Reads bytes from TGA source. Bytes behind the end of the memory buffer are
+ *  read as zeros.
+ */
+static void tgaReadBytes(unsigned char *dest, int size, TGA_STREAM *s)
+{
+  int n;
+
+  if (s->f) {
+    fread(dest, size, 1, s->f);
+    return;
+  }
+
+  n = s->size - s->pos;
+  if (n > size) n = size;
+  if (n < 0) n = 0;
+
+  memcpy(dest, s->buf + s->pos, n);
+  if (n < size) memset(dest + n, 0, size - n);
+
+  s->pos += size;
+}
+
+
+/**
+ *  Reads one byte from TGA source.
+ */
+static int tgaReadByte(TGA_STREAM *s)
+{
+  unsigned char c;
+
+  if (s->f) return fgetc(s->f);
+
+  tgaReadBytes(&c, 1, s);
+  return c;
+}
+
+
 /**
  *  Reads a TGA file header and checks that it is valid.
  *
  *  @return @c 1 when the TGA header was valid, @c 0 otherwise.
  */
-static int tgaReadHeader(FILE *f, TGA_HEADER *h)
+static int tgaReadHeader(TGA_STREAM *s, TGA_HEADER *h)
 {
   unsigned char buf[18];
   int pos;
 
   // Read TGA file header from file
-  pos = ftell(f);
-  fread(buf, 18, 1, f);
+  pos = s->f ? ftell(s->f) : s->pos;
+  tgaReadBytes(buf, 18, s);
 
   // Interpret header (endian independent parsing)
   h->idlen         = (int)buf[0];
@@ -121,13 +192,15 @@ static int tgaReadHeader(FILE *f, TGA_HEADER *h)
       (h->bitsperpixel == 8 || h->bitsperpixel == 24 || h->bitsperpixel == 32))
   {
     // Skip the ID field
-    fseek( f, h->idlen, SEEK_CUR );
+    if (s->f) fseek( s->f, h->idlen, SEEK_CUR );
+    else s->pos += h->idlen;
     // Indicate that the TGA header was valid
     return 1;
   }
   else {
     // Restore file position
-    fseek( f, pos, SEEK_SET );
+    if (s->f) fseek( s->f, pos, SEEK_SET );
+    else s->pos = pos;
 
     // Indicate that the TGA header was invalid
     return 0;
@@ -135,10 +208,138 @@ static int tgaReadHeader(FILE *f, TGA_HEADER *h)
 }
 
 
+/**
+ *  Computes final size of the image. When #TGA_RESCALE flag is set, the size
+ *  is rounded up to closest larger @c 2^Nx2^M resolution.
+ */
+static void tgaImageSize(TGA_HEADER *h, int flags, int *width, int *height)
+{
+  int log2;
+
+  // Is the TGA_RESCALE flag set?
+  if (flags & TGA_RESCALE) {
+    // Calculate next larger 2^N width
+    for (log2 = 0, *width = h->width; *width > 1; *width >>= 1, log2++);
+    *width  = (int)1 << log2;
+    if (*width < h->width) *width <<= 1;
+
+    // Calculate next larger 2^M height
+    for (log2 = 0, *height = h->height; *height > 1; *height >>= 1, log2++);
+    *height = (int)1 << log2;
+    if (*height < h->height) *height <<= 1;
+  }
+  else {
+    *width  = h->width;
+    *height = h->height;
+  }
+}
+
+
+/**
+ *  Converts BGR(A) pixels to RGB(A) by swapping the first and the third byte
+ *  of every pixel. Grayscale pixels are not changed.
+ *
+ *  @param pix    Pixel data.
+ *  @param count  Count of pixels.
+ *  @param bpp    Bytes per pixel.
+ */
+static void tgaSwapRedBlue(unsigned char *pix, int count, int bpp)
+{
+  unsigned char tmp;
+  int n = 0;
+
+  if (bpp < 3) return;
+
+  if (bpp == 4) {
+#ifdef TGA_AVX2
+    const __m256i mask_ga = _mm256_set1_epi32(0xFF00FF00);
+    const __m256i mask_r = _mm256_set1_epi32(0x000000FF);
+    __m256i v;
+
+    for (; n + 8 <= count; n += 8, pix += 32) {
+      v = _mm256_loadu_si256((__m256i *)pix);
+      v = _mm256_or_si256(_mm256_and_si256(v, mask_ga),
+          _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask_r),
+                          _mm256_slli_epi32(_mm256_and_si256(v, mask_r), 16)));
+      _mm256_storeu_si256((__m256i *)pix, v);
+    }
+#endif
+#ifdef TGA_SSE2
+    const __m128i mask_ga4 = _mm_set1_epi32(0xFF00FF00);
+    const __m128i mask_r4 = _mm_set1_epi32(0x000000FF);
+    __m128i v4;
+
+    for (; n + 4 <= count; n += 4, pix += 16) {
+      v4 = _mm_loadu_si128((__m128i *)pix);
+      v4 = _mm_or_si128(_mm_and_si128(v4, mask_ga4),
+           _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v4, 16), mask_r4),
+                        _mm_slli_epi32(_mm_and_si128(v4, mask_r4), 16)));
+      _mm_storeu_si128((__m128i *)pix, v4);
+    }
+#endif
+  }
+
+#ifdef TGA_SSSE3
+  // sixteen pixels (three vectors) in one step, pixels 5 and 10 cross vectors
+  if (bpp == 3) {
+    const __m128i s00 = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1);
+    const __m128i s01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1);
+    const __m128i s10 = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i s11 = _mm_setr_epi8(0, -1, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -1, 15);
+    const __m128i s12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1);
+    const __m128i s21 = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i s22 = _mm_setr_epi8(-1, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+    __m128i a, b, c;
+
+    for (; n + 16 <= count; n += 16, pix += 48) {
+      a = _mm_loadu_si128((__m128i *)pix);
+      b = _mm_loadu_si128((__m128i *)(pix + 16));
+      c = _mm_loadu_si128((__m128i *)(pix + 32));
+
+      _mm_storeu_si128((__m128i *)pix, _mm_or_si128(_mm_shuffle_epi8(a, s00), _mm_shuffle_epi8(b, s01)));
+      _mm_storeu_si128((__m128i *)(pix + 16), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, s10), _mm_shuffle_epi8(b, s11)), _mm_shuffle_epi8(c, s12)));
+      _mm_storeu_si128((__m128i *)(pix + 32), _mm_or_si128(_mm_shuffle_epi8(b, s21), _mm_shuffle_epi8(c, s22)));
+    }
+  }
+#endif
+
+  for (; n < count; n++, pix += bpp) {
+    tmp = pix[0];
+    pix[0] = pix[2];
+    pix[2] = tmp;
+  }
+}
+
+
+/**
+ *  Flips the image upside down by swapping whole rows.
+ *
+ *  @return @c 1 on success, @c 0 if there is not enough memory.
+ */
+static int tgaFlipRows(unsigned char *pix, int width, int height, int bpp)
+{
+  int row = width * bpp;
+  unsigned char *tmp, *top, *bottom;
+
+  if (height < 2) return 1;
+  if (!(tmp = (unsigned char *)malloc(row))) return 0;
+
+  for (top = pix, bottom = pix + (height - 1) * row; top < bottom; top += row, bottom -= row) {
+    memcpy(tmp, top, row);
+    memcpy(top, bottom, row);
+    memcpy(bottom, tmp, row);
+  }
+
+  free(tmp);
+
+  return 1;
+}
+
+
 /**
  *  Reads Run-Length Encoded data.
  */
-static void tgaReadRLE(unsigned char *buf, int size, int bpp, FILE *f)
+static void tgaReadRLE(unsigned char *buf, int size, int bpp, TGA_STREAM *s)
 {
   int repcount, bytes, k, n;
   unsigned char pixel[ 4 ];
@@ -148,22 +349,30 @@ static void tgaReadRLE(unsigned char *buf, int size, int bpp, FILE *f)
 
   while (size > 0) {
     // Get repetition count
-    repcount = (unsigned int)fgetc(f);
+    repcount = (unsigned int)tgaReadByte(s);
     bytes = ((repcount & 127) + 1) * bpp;
     if (size < bytes) bytes = size;
 
     // Run-Length packet?
     if (repcount & 128) {
-      for (k = 0; k < bpp; k ++)
-        pixel[ k ] = (unsigned char)fgetc( f );
-      
-      for (n = 0; n < (repcount & 127) + 1; n++)
-        for (k = 0; k < bpp; k++)
-          *buf++ = pixel[k];
+      tgaReadBytes(pixel, bpp, s);
+
+      if (bpp == 1) memset(buf, pixel[0], bytes);
+      else {
+        // copy the pixel once and then double the copied part
+        n = bytes < bpp ? bytes : bpp;
+        memcpy(buf, pixel, n);
+
+        for (; n < bytes; n += k) {
+          k = bytes - n < n ? bytes - n : n;
+          memcpy(buf + n, buf, k);
+        }
+      }
+      buf += bytes;
     }
     else {
       // It's a Raw packet
-      fread( buf, bytes, 1, f );
+      tgaReadBytes( buf, bytes, s );
       buf += bytes;
     }
 
@@ -173,24 +382,24 @@ static void tgaReadRLE(unsigned char *buf, int size, int bpp, FILE *f)
 
 
 /**
- *  Reads a TGA image from a file.
+ *  Reads a TGA image from a source.
  *
- *  @param f      File to read the TGA image from.
+ *  @param s      Source to read the TGA image from.
  *  @param t      Pointer to information structure which will be filled by the
  *                function.
  *  @param flags  Flags. Combination of #TGA_RESCALE and #TGA_ORIGIN_UL.
  *
  *  @return @c 1 on success, @c 0 otherwise.
  */
-int tgaRead(FILE *f, TGA_INFO *t, int flags)
+static int tgaReadStream(TGA_STREAM *s, TGA_INFO *t, int flags)
 {
   TGA_HEADER h;
   unsigned char *cmap, *pix, *data, tmp;
   int cmapsize, pixsize, pixsize2, datasize;
-  int width, height, log2, bpp, bpp2, k, m, n, swapx, swapy;
+  int width, height, bpp, bpp2, k, m, n, swapx, swapy;
 
   // Read TGA header
-  if (!tgaReadHeader(f, &h)) return 0;
+  if (!tgaReadHeader(s, &h)) return 0;
 
   // Is there a colormap?
   cmapsize = (h.cmaptype == TGA_CMAPTYPE_PRESENT ? 1 : 0) * h.cmaplen *
@@ -206,7 +415,7 @@ int tgaRead(FILE *f, TGA_INFO *t, int flags)
     if (cmap == NULL) return 0;
 
     // Read colormap from file
-    fread (cmap, cmapsize, 1, f);
+    tgaReadBytes (cmap, cmapsize, s);
   }
   else cmap = NULL;
 
@@ -232,8 +441,8 @@ int tgaRead(FILE *f, TGA_INFO *t, int flags)
   }
 
   // Read pixel data from file
-  if (h.imagetype >= TGA_IMAGETYPE_CMAP_RLE) tgaReadRLE(pix, pixsize, bpp, f);
-  else fread( pix, pixsize, 1, f );
+  if (h.imagetype >= TGA_IMAGETYPE_CMAP_RLE) tgaReadRLE(pix, pixsize, bpp, s);
+  else tgaReadBytes( pix, pixsize, s );
     
   // If the image origin is not bottom left, re-arrange the pixels
   switch (h._origin) {
@@ -260,13 +469,11 @@ int tgaRead(FILE *f, TGA_INFO *t, int flags)
   } // switch
 
   if ((swapy && !(flags & TGA_ORIGIN_UL)) || (!swapy && (flags & TGA_ORIGIN_UL))) {
-    for (n = 0; n < h.height / 2; n++)
-      for (m = 0; m < h.width; m++)
-        for (k = 0; k < bpp; k++) {
-          tmp = pix[(n * h.width + m) * bpp + k];
-          pix[(n * h.width + m) * bpp + k] = pix[((h.height - 1 - n) * h.width + m) * bpp + k];
-          pix[((h.height - 1 - n) * h.width+m) * bpp + k ] = tmp;
-        }
+    if (!tgaFlipRows(pix, h.width, h.height, bpp)) {
+      free(pix);
+      if (cmap) free(cmap);
+      return 0;
+    }
   }
 
   if (swapx) {
@@ -288,28 +495,10 @@ int tgaRead(FILE *f, TGA_INFO *t, int flags)
   }
 
   // convert BGR to RGB
-  for (n = 0; n < h.height * h.width * bpp2; n += bpp2) {
-    tmp = pix[n];
-    pix[n] = pix[n + 2];
-    pix[n + 2] = tmp;
-  }
+  tgaSwapRedBlue(pix, h.width * h.height, bpp2);
 
-  // Is the TGA_RESCALE flag set?
-  if (flags & TGA_RESCALE) {
-    // Calculate next larger 2^N width
-    for (log2 = 0, width = h.width; width > 1; width >>= 1, log2++);
-    width  = (int)1 << log2;
-    if (width < h.width) width <<= 1;
-
-    // Calculate next larger 2^M height
-    for (log2 = 0, height = h.height; height > 1; height >>= 1, log2++);
-    height = (int)1 << log2;
-    if (height < h.height) height <<= 1;
-  }
-  else {
-    width  = h.width;
-    height = h.height;
-  }
+  // Final size of the image
+  tgaImageSize(&h, flags, &width, &height);
 
   // Do we need to rescale?
   if (width != h.width || height != h.height) {
@@ -324,13 +513,11 @@ int tgaRead(FILE *f, TGA_INFO *t, int flags)
     }
 
     // clear new data (black color, alpha 0)
-    for (n = 0; n < datasize; n++) data[n] = 0;
+    memset(data, 0, datasize);
 
     // copy pixel data
     for (m = 0; m < h.height; m++)
-      for (n = 0; n < h.width * bpp2; n++) {
-        data[(m)* (width * bpp2) + n] = pix[m * (h.width * bpp2) + n];
-      }
+      memcpy(data + m * width * bpp2, pix + m * h.width * bpp2, h.width * bpp2);
 
     // Set pointer to image data in TGA information
     t->data = data;
@@ -362,6 +549,86 @@ int tgaRead(FILE *f, TGA_INFO *t, int flags)
 }
 
 
+/**
+ *  Reads a TGA image from a file.
+ *
+ *  @param f      File to read the TGA image from.
+ *  @param t      Pointer to information structure which will be filled by the
+ *                function.
+ *  @param flags  Flags. Combination of #TGA_RESCALE and #TGA_ORIGIN_UL.
+ *
+ *  @return @c 1 on success, @c 0 otherwise.
+ */
+int tgaRead(FILE *f, TGA_INFO *t, int flags)
+{
+  TGA_STREAM s = {f, NULL, 0, 0};
+
+  return tgaReadStream(&s, t, flags);
+}
+
+
+/**
+ *  Reads a TGA image from a memory buffer. It does not use any shared state,
+ *  so more images could be decoded in parallel threads.
+ *
+ *  @param buf    Buffer with the whole TGA image.
+ *  @param size   Size of the buffer.
+ *  @param t      Pointer to information structure which will be filled by the
+ *                function.
+ *  @param flags  Flags. Combination of #TGA_RESCALE and #TGA_ORIGIN_UL.
+ *
+ *  @return @c 1 on success, @c 0 otherwise.
+ */
+int tgaReadMemory(const unsigned char *buf, int size, TGA_INFO *t, int flags)
+{
+  TGA_STREAM s = {NULL, buf, size, 0};
+
+  return tgaReadStream(&s, t, flags);
+}
+
+
+/**
+ *  Reads only header of a TGA image from a memory buffer. Sizes and pixel
+ *  format of the image are filled same as by tgaReadMemory(), but pixels are
+ *  not decoded and @c t->data is set to @c NULL.
+ *
+ *  @param buf    Buffer with the TGA image (at least its header).
+ *  @param size   Size of the buffer.
+ *  @param t      Pointer to information structure which will be filled by the
+ *                function.
+ *  @param flags  Flags. Combination of #TGA_RESCALE and #TGA_ORIGIN_UL.
+ *
+ *  @return @c 1 when the header was valid, @c 0 otherwise.
+ */
+int tgaReadInfo(const unsigned char *buf, int size, TGA_INFO *t, int flags)
+{
+  TGA_STREAM s = {NULL, buf, size, 0};
+  TGA_HEADER h;
+  int bpp2;
+
+  if (!tgaReadHeader(&s, &h)) return 0;
+
+  // Bytes per pixel (expanded pixels - not colormap indeces)
+  if (h.cmaptype == TGA_CMAPTYPE_PRESENT && h.cmaplen > 0 && h.cmapentrysize > 0) bpp2 = (h.cmapentrysize + 7) / 8;
+  else bpp2 = (h.bitsperpixel + 7) / 8;
+
+  tgaImageSize(&h, flags, &t->width, &t->height);
+  t->original_width = h.width;
+  t->original_height = h.height;
+  t->bytesperpixel = bpp2;
+  t->data = NULL;
+
+  switch (bpp2) {
+  default:
+  case 1: t->pixformat = TGA_PIXFMT_GRAY; break;
+  case 3: t->pixformat = TGA_PIXFMT_RGB; break;
+  case 4: t->pixformat = TGA_PIXFMT_RGBA; break;
+  }
+
+  return 1;
+}
+
+
 //========================================================================
 // END
 //========================================================================
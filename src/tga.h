@@ -77,6 +77,8 @@ typedef struct {
 //========================================================================
 
 int tgaRead(FILE *f, TGA_INFO *t, int flags);
+int tgaReadMemory(const unsigned char *buf, int size, TGA_INFO *t, int flags);
+int tgaReadInfo(const unsigned char *buf, int size, TGA_INFO *t, int flags);
 
 #endif // __tga_h_
 